@@ -0,0 +1,564 @@
+#include "../include/disk_fs.h"
+#include "../include/ftl_model.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+/**
+ * 基准测试程序：基于libdiskfs.so运行参数化负载，输出JSON格式结果
+ * 负载类型：顺序/随机读写（多种IO大小）、创建/删除风暴、元数据查找、混合读写
+ * 说明：DiskFS本身不是线程安全的，多线程时所有调用经同一把互斥锁串行化，
+ *       统计的延迟包含锁等待时间（即调用方实际感受到的延迟）
+ */
+
+const size_t MAX_FILE_BYTES = 16 * BLOCK_SIZE;  // 单文件最大字节数（16个直接块）
+
+/**
+ * @brief 基准测试参数（命令行可配置）
+ */
+struct BenchConfig
+{
+    std::string image = "bench_disk.img";  // 基准测试专用磁盘文件
+    std::string workload = "all";          // 负载名称（all表示全部）
+    int threads = 1;                       // 并发线程数
+    int ops = 2000;                        // 每个线程执行的操作数
+    int files_per_thread = 4;              // 每个线程使用的数据文件数
+    int read_ratio = 70;                   // 混合负载中读操作所占百分比
+    unsigned seed = 42;                    // 随机数种子
+    std::string device = "none";           // 设备时序模型（none/hdd/ssd/ftl/ftl-cb）
+    std::string sched = "none";            // I/O调度策略（none/noop/clook/deadline）
+    bool log_layout = false;               // 是否以日志结构布局格式化
+    std::string fill = "fresh";            // 数据文件填充方式（fresh/aged/defrag）
+    std::string data = "fill";             // 写入内容（fill单字节重复/text日志文本/random随机数据）
+    bool compress = false;                 // 数据文件是否压缩存放
+    bool dedup = false;                    // 是否以块去重格式化
+    std::string csum = "off";              // 块校验和范围（off/meta/data）
+    std::vector<size_t> io_sizes;          // 读写负载的IO大小列表
+};
+
+/**
+ * @brief 单个负载的测试结果
+ */
+struct BenchResult
+{
+    std::string workload;   // 负载名称
+    size_t io_size;         // IO大小（字节，非读写负载为0）
+    int threads;            // 线程数
+    uint64_t ops;           // 完成的操作总数
+    uint64_t bytes;         // 传输的字节总数
+    uint64_t errors;        // 失败的操作数
+    double seconds;         // 总耗时（秒）
+    double sim_seconds;     // 设备模型下的模拟耗时（秒，未设置模型时为0）
+    std::string ftl;        // FTL模型的统计（JSON片段，未使用FTL时为空）
+    uint64_t p50, p99, p999;  // 延迟分位数（纳秒）
+};
+
+/**
+ * @brief 丢弃所有输出的流缓冲区（负载执行期间屏蔽库内的提示信息）
+ */
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+};
+
+/**
+ * @brief 线程共享的测试上下文
+ */
+struct BenchContext
+{
+    DiskFS* disk;
+    std::mutex disk_mutex;                  // 串行化对DiskFS的访问
+    std::vector<std::vector<int>> files;    // 每个线程的数据文件inode列表
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static uint64_t elapsed_ns(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+/**
+ * @brief 从已排序的延迟样本中取分位数
+ */
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double p)
+{
+    if (sorted.empty()) return 0;
+    size_t idx = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+/**
+ * @brief 按--data生成写入内容：fill为单字节重复，text为模拟的日志行（约4倍可压缩），random不可压缩
+ */
+static std::vector<char> make_payload(const std::string& kind, size_t len, unsigned seed)
+{
+    std::vector<char> buf(len, (char)('a' + seed % 26));
+    if (kind == "text") {
+        std::string lines;
+        std::mt19937 rng(seed);
+        static const char* const levels[] = {"INFO", "WARN", "DEBUG"};
+        while (lines.size() < len) {
+            char line[128];
+            snprintf(line, sizeof(line), "2026-10-18 %02u:%02u:%02u %s worker-%u request id=%u status=%u latency=%ums\n",
+                     (unsigned)(rng() % 24), (unsigned)(rng() % 60), (unsigned)(rng() % 60), levels[rng() % 3],
+                     (unsigned)(rng() % 8), (unsigned)(rng() % 100000), rng() % 8 ? 200u : 500u, (unsigned)(rng() % 300));
+            lines += line;
+        }
+        memcpy(buf.data(), lines.data(), len);
+    } else if (kind == "random") {
+        std::mt19937 rng(seed);
+        for (auto& c : buf) c = (char)rng();
+    }
+    return buf;
+}
+
+/**
+ * @brief 每个线程的执行结果（延迟样本与计数）
+ */
+struct ThreadResult
+{
+    std::vector<uint64_t> latencies;
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+};
+
+/**
+ * @brief 单线程负载函数类型：tid为线程编号，rng为线程私有随机数发生器
+ */
+typedef void (*WorkloadFn)(BenchContext& ctx, const BenchConfig& cfg, size_t io_size,
+                           int tid, std::mt19937_64& rng, ThreadResult& out);
+
+/**
+ * @brief 读写类负载的公共实现
+ * @param sequential true表示顺序访问，false表示随机访问
+ * @param read_pct 读操作百分比（100为纯读，0为纯写）
+ */
+static void run_rw(BenchContext& ctx, const BenchConfig& cfg, size_t io_size, int tid,
+                   std::mt19937_64& rng, ThreadResult& out, bool sequential, int read_pct)
+{
+    const std::vector<int>& files = ctx.files[tid];
+    std::vector<char> buf = make_payload(cfg.data, io_size, tid);
+    size_t slots = MAX_FILE_BYTES / io_size;  // 每个文件可容纳的IO次数
+    uint64_t cursor = 0;
+
+    for (int i = 0; i < cfg.ops; i++) {
+        int inode;
+        off_t offset;
+        if (sequential) {
+            inode = files[(cursor / slots) % files.size()];
+            offset = (off_t)((cursor % slots) * io_size);
+            cursor++;
+        } else {
+            inode = files[rng() % files.size()];
+            offset = (off_t)((rng() % slots) * io_size);
+        }
+        bool is_read = (int)(rng() % 100) < read_pct;
+
+        Clock::time_point start = Clock::now();
+        int ret;
+        {
+            std::lock_guard<std::mutex> lock(ctx.disk_mutex);
+            if (is_read) {
+                ret = ctx.disk->read_file(inode, buf.data(), io_size, offset);
+            } else {
+                ret = ctx.disk->write_file(inode, buf.data(), io_size, offset);
+            }
+        }
+        out.latencies.push_back(elapsed_ns(start));
+        if (ret < 0) {
+            out.errors++;
+        } else {
+            out.bytes += ret;
+        }
+    }
+}
+
+static void wl_seq_read(BenchContext& c, const BenchConfig& cfg, size_t s, int t, std::mt19937_64& r, ThreadResult& o)
+{
+    run_rw(c, cfg, s, t, r, o, true, 100);
+}
+
+static void wl_seq_write(BenchContext& c, const BenchConfig& cfg, size_t s, int t, std::mt19937_64& r, ThreadResult& o)
+{
+    run_rw(c, cfg, s, t, r, o, true, 0);
+}
+
+static void wl_rand_read(BenchContext& c, const BenchConfig& cfg, size_t s, int t, std::mt19937_64& r, ThreadResult& o)
+{
+    run_rw(c, cfg, s, t, r, o, false, 100);
+}
+
+static void wl_rand_write(BenchContext& c, const BenchConfig& cfg, size_t s, int t, std::mt19937_64& r, ThreadResult& o)
+{
+    run_rw(c, cfg, s, t, r, o, false, 0);
+}
+
+static void wl_mixed(BenchContext& c, const BenchConfig& cfg, size_t s, int t, std::mt19937_64& r, ThreadResult& o)
+{
+    run_rw(c, cfg, s, t, r, o, false, cfg.read_ratio);
+}
+
+/**
+ * @brief 创建/删除风暴：每次操作创建文件、写入一个块、再删除
+ */
+static void wl_create_delete(BenchContext& ctx, const BenchConfig& cfg, size_t, int tid,
+                             std::mt19937_64&, ThreadResult& out)
+{
+    char payload[BLOCK_SIZE];
+    memset(payload, 'c', sizeof(payload));
+
+    for (int i = 0; i < cfg.ops; i++) {
+        char name[MAX_FILENAME];
+        snprintf(name, sizeof(name), "cd_%d_%d", tid, i);
+
+        Clock::time_point start = Clock::now();
+        bool ok;
+        {
+            std::lock_guard<std::mutex> lock(ctx.disk_mutex);
+            int inode = ctx.disk->create_file(name);
+            ok = inode != -1 &&
+                 ctx.disk->write_file(inode, payload, sizeof(payload), 0) == (int)sizeof(payload) &&
+                 ctx.disk->delete_file(name);
+        }
+        out.latencies.push_back(elapsed_ns(start));
+        if (ok) {
+            out.bytes += sizeof(payload);
+        } else {
+            out.errors++;
+        }
+    }
+}
+
+/**
+ * @brief 元数据查找：按文件名打开、查询文件大小、偶尔列出目录
+ */
+static void wl_metadata(BenchContext& ctx, const BenchConfig& cfg, size_t, int tid,
+                        std::mt19937_64& rng, ThreadResult& out)
+{
+    for (int i = 0; i < cfg.ops; i++) {
+        char name[MAX_FILENAME];
+        snprintf(name, sizeof(name), "bench_%d_%d", tid, (int)(rng() % cfg.files_per_thread));
+
+        Clock::time_point start = Clock::now();
+        bool ok;
+        {
+            std::lock_guard<std::mutex> lock(ctx.disk_mutex);
+            int inode = ctx.disk->open_file(name);
+            ok = inode != -1 && ctx.disk->get_file_size(inode) >= 0;
+            if (i % 16 == 0) {
+                ok = ok && !ctx.disk->list_files().empty();
+            }
+        }
+        out.latencies.push_back(elapsed_ns(start));
+        if (!ok) out.errors++;
+    }
+}
+
+/**
+ * @brief 负载描述：名称、实现函数、是否按IO大小参数化
+ */
+struct WorkloadDesc
+{
+    const char* name;
+    WorkloadFn fn;
+    bool sized;
+};
+
+static const WorkloadDesc WORKLOADS[] = {
+    {"seq_write", wl_seq_write, true},
+    {"seq_read", wl_seq_read, true},
+    {"rand_write", wl_rand_write, true},
+    {"rand_read", wl_rand_read, true},
+    {"mixed", wl_mixed, true},
+    {"create_delete", wl_create_delete, false},
+    {"metadata", wl_metadata, false},
+};
+
+/**
+ * @brief 格式化并挂载磁盘，为每个线程创建并预填充数据文件
+ * fill为aged时按块轮流写入所有文件，模拟长期使用后数据块相互穿插的镜像；defrag再对其做一次碎片整理
+ * @return 准备成功返回true
+ */
+static bool prepare_disk(BenchContext& ctx, const BenchConfig& cfg)
+{
+    DiskFS& disk = *ctx.disk;
+    if (disk.isMounted()) disk.unmount();
+    disk.set_dedup(cfg.dedup);
+    disk.set_checksums(cfg.csum == "off" ? 0 : cfg.csum == "meta" ? CSUM_META : CSUM_META | CSUM_DATA);
+    if (!disk.format(cfg.log_layout) || !disk.mount()) return false;
+    if (cfg.compress && !disk.set_compress(true)) return false;
+
+    std::vector<char> fill = make_payload(cfg.data, MAX_FILE_BYTES, 'f' - 'a');
+    std::vector<int> all;
+    ctx.files.assign(cfg.threads, std::vector<int>());
+    for (int t = 0; t < cfg.threads; t++) {
+        for (int f = 0; f < cfg.files_per_thread; f++) {
+            char name[MAX_FILENAME];
+            snprintf(name, sizeof(name), "bench_%d_%d", t, f);
+            int inode = disk.create_file(name);
+            if (inode == -1) return false;
+            if (cfg.fill == "fresh" && disk.write_file(inode, fill.data(), fill.size(), 0) != (int)fill.size()) return false;
+            ctx.files[t].push_back(inode);
+            all.push_back(inode);
+        }
+    }
+    if (cfg.fill == "fresh") return true;
+
+    for (size_t off = 0; off < fill.size(); off += BLOCK_SIZE) {
+        for (int inode : all) {
+            if (disk.write_file(inode, fill.data(), BLOCK_SIZE, (off_t)off) != BLOCK_SIZE) return false;
+        }
+    }
+    return cfg.fill == "aged" || disk.defrag() >= 0;
+}
+
+/**
+ * @brief 以指定线程数运行一个负载，汇总延迟分位数和吞吐
+ */
+static BenchResult run_workload(BenchContext& ctx, const BenchConfig& cfg,
+                                const WorkloadDesc& wl, size_t io_size)
+{
+    std::vector<ThreadResult> results(cfg.threads);
+    std::vector<std::thread> workers;
+    ctx.disk->set_device_model(cfg.device);  // 重置虚拟时钟，只统计负载本身
+    ctx.disk->set_scheduler(cfg.sched);
+
+    Clock::time_point start = Clock::now();
+    for (int t = 0; t < cfg.threads; t++) {
+        workers.push_back(std::thread([&, t]() {
+            std::mt19937_64 rng(cfg.seed + t);
+            results[t].latencies.reserve(cfg.ops);
+            wl.fn(ctx, cfg, io_size, t, rng, results[t]);
+        }));
+    }
+    for (auto& w : workers) w.join();
+    double seconds = elapsed_ns(start) / 1e9;
+
+    BenchResult r;
+    r.workload = wl.name;
+    r.io_size = wl.sized ? io_size : 0;
+    r.threads = cfg.threads;
+    r.bytes = 0;
+    r.errors = 0;
+    r.seconds = seconds;
+    ctx.disk->set_scheduler("none");  // 派发剩余请求，计入模拟耗时
+    r.sim_seconds = ctx.disk->virtual_time_ns() / 1e9;
+    const FtlModel* ftl = dynamic_cast<const FtlModel*>(ctx.disk->device_model());
+    if (ftl) {
+        uint32_t min_erase, max_erase;
+        double avg_erase;
+        ftl->erase_range(min_erase, max_erase, avg_erase);
+        char buf[256];
+        snprintf(buf, sizeof(buf),
+                 ", \"ftl\": {\"write_amp\": %.3f, \"gc_runs\": %llu, \"gc_stall_ms\": %.3f, "
+                 "\"erases\": %llu, \"erase_max\": %u}",
+                 ftl->write_amplification(), (unsigned long long)ftl->stats().gc_runs,
+                 ftl->stats().gc_stall_ns / 1e6, (unsigned long long)ftl->stats().erases, max_erase);
+        r.ftl = buf;
+    }
+    ctx.disk->set_device_model("none");
+
+    std::vector<uint64_t> all;
+    for (const auto& tr : results) {
+        all.insert(all.end(), tr.latencies.begin(), tr.latencies.end());
+        r.bytes += tr.bytes;
+        r.errors += tr.errors;
+    }
+    r.ops = all.size();
+    std::sort(all.begin(), all.end());
+    r.p50 = percentile(all, 0.50);
+    r.p99 = percentile(all, 0.99);
+    r.p999 = percentile(all, 0.999);
+    return r;
+}
+
+/**
+ * @brief 将结果输出为JSON
+ */
+static void print_json(std::ostream& os, const BenchConfig& cfg, const std::vector<BenchResult>& results)
+{
+    os << "{\n";
+    os << "  \"block_size\": " << BLOCK_SIZE << ",\n";
+    os << "  \"threads\": " << cfg.threads << ",\n";
+    os << "  \"ops_per_thread\": " << cfg.ops << ",\n";
+    os << "  \"device\": \"" << cfg.device << "\",\n";
+    os << "  \"sched\": \"" << cfg.sched << "\",\n";
+    os << "  \"layout\": \"" << (cfg.log_layout ? "log" : "inplace") << "\",\n";
+    os << "  \"fill\": \"" << cfg.fill << "\",\n";
+    os << "  \"data\": \"" << cfg.data << "\",\n";
+    os << "  \"compress\": " << (cfg.compress ? "true" : "false") << ",\n";
+    os << "  \"dedup\": " << (cfg.dedup ? "true" : "false") << ",\n";
+    os << "  \"csum\": \"" << cfg.csum << "\",\n";
+    os << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        double ops_s = r.seconds > 0 ? r.ops / r.seconds : 0;
+        double mb_s = r.seconds > 0 ? r.bytes / r.seconds / (1024 * 1024) : 0;
+        char sim[160] = "";
+        if (cfg.device != "none") {
+            snprintf(sim, sizeof(sim), ", \"sim_seconds\": %.6f, \"sim_ops_per_sec\": %.1f, \"sim_mb_per_sec\": %.2f",
+                     r.sim_seconds, r.sim_seconds > 0 ? r.ops / r.sim_seconds : 0,
+                     r.sim_seconds > 0 ? r.bytes / r.sim_seconds / (1024 * 1024) : 0);
+        }
+        char line[640];
+        snprintf(line, sizeof(line),
+                 "    {\"workload\": \"%s\", \"io_size\": %zu, \"threads\": %d, \"ops\": %llu, "
+                 "\"errors\": %llu, \"seconds\": %.6f, \"ops_per_sec\": %.1f, \"mb_per_sec\": %.2f, "
+                 "\"latency_ns\": {\"p50\": %llu, \"p99\": %llu, \"p999\": %llu}%s%s}%s\n",
+                 r.workload.c_str(), r.io_size, r.threads, (unsigned long long)r.ops,
+                 (unsigned long long)r.errors, r.seconds, ops_s, mb_s,
+                 (unsigned long long)r.p50, (unsigned long long)r.p99, (unsigned long long)r.p999,
+                 sim, r.ftl.c_str(), i + 1 < results.size() ? "," : "");
+        os << line;
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+static void print_usage(const char* prog)
+{
+    std::cerr << "用法: " << prog << " [选项]\n"
+              << "  --image <文件>        基准测试磁盘文件（默认bench_disk.img）\n"
+              << "  --workload <名称>     all/seq_write/seq_read/rand_write/rand_read/mixed/create_delete/metadata\n"
+              << "  --threads <N>         并发线程数（默认1）\n"
+              << "  --ops <N>             每线程操作数（默认2000）\n"
+              << "  --io-sizes <列表>     逗号分隔的IO大小（默认512,4096,16384,65536）\n"
+              << "  --read-ratio <百分比> 混合负载的读比例（默认70）\n"
+              << "  --seed <N>            随机数种子（默认42）\n"
+              << "  --device <模型>       设备时序模型none/hdd/ssd/ftl/ftl-cb（额外报告模拟耗时）\n"
+              << "  --sched <策略>        I/O调度策略none/noop/clook/deadline\n"
+              << "  --layout <布局>       磁盘布局inplace/log（log为日志结构布局）\n"
+              << "  --fill <方式>         数据文件填充fresh/aged/defrag（aged逐块交替写入各文件，defrag为aged后再整理）\n"
+              << "  --data <内容>         写入内容fill/text/random（text为可压缩的日志文本，random不可压缩）\n"
+              << "  --compress <on|off>   数据文件按簇压缩存放\n"
+              << "  --dedup <on|off>      以块去重格式化（相同内容的块只存一份）\n"
+              << "  --csum <off|meta|data> 块校验和范围（meta只校验元数据，data同时校验数据块）\n";
+}
+
+/**
+ * @brief 解析命令行参数
+ * @return 参数合法返回true
+ */
+static bool parse_args(int argc, char* argv[], BenchConfig& cfg)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        std::string val = argv[++i];
+        if (arg == "--image") {
+            cfg.image = val;
+        } else if (arg == "--workload") {
+            cfg.workload = val;
+        } else if (arg == "--threads") {
+            cfg.threads = atoi(val.c_str());
+        } else if (arg == "--ops") {
+            cfg.ops = atoi(val.c_str());
+        } else if (arg == "--read-ratio") {
+            cfg.read_ratio = atoi(val.c_str());
+        } else if (arg == "--device") {
+            if (val != "none" && val != "hdd" && val != "ssd" && val != "ftl" && val != "ftl-cb") return false;
+            cfg.device = val;
+        } else if (arg == "--layout") {
+            if (val != "inplace" && val != "log") return false;
+            cfg.log_layout = val == "log";
+        } else if (arg == "--fill") {
+            if (val != "fresh" && val != "aged" && val != "defrag") return false;
+            cfg.fill = val;
+        } else if (arg == "--data") {
+            if (val != "fill" && val != "text" && val != "random") return false;
+            cfg.data = val;
+        } else if (arg == "--compress") {
+            if (val != "on" && val != "off") return false;
+            cfg.compress = val == "on";
+        } else if (arg == "--dedup") {
+            if (val != "on" && val != "off") return false;
+            cfg.dedup = val == "on";
+        } else if (arg == "--csum") {
+            if (val != "off" && val != "meta" && val != "data") return false;
+            cfg.csum = val;
+        } else if (arg == "--sched") {
+            if (val != "none" && val != "noop" && val != "clook" && val != "deadline") return false;
+            cfg.sched = val;
+        } else if (arg == "--seed") {
+            cfg.seed = (unsigned)strtoul(val.c_str(), nullptr, 10);
+        } else if (arg == "--io-sizes") {
+            std::istringstream iss(val);
+            std::string item;
+            while (std::getline(iss, item, ',')) {
+                size_t sz = strtoul(item.c_str(), nullptr, 10);
+                if (sz == 0 || sz > MAX_FILE_BYTES) return false;
+                cfg.io_sizes.push_back(sz);
+            }
+        } else {
+            return false;
+        }
+    }
+    if (cfg.io_sizes.empty()) {
+        cfg.io_sizes = {512, 4096, 16384, 65536};
+    }
+    // 根目录仅一个数据块，目录项有限，线程数×文件数不能超过目录容量
+    size_t dir_capacity = BLOCK_SIZE / sizeof(DirEntry) - 1;
+    return cfg.threads > 0 && cfg.ops > 0 && cfg.read_ratio >= 0 && cfg.read_ratio <= 100 &&
+           (size_t)(cfg.threads * (cfg.files_per_thread + 1)) <= dir_capacity;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchConfig cfg;
+    if (!parse_args(argc, argv, cfg)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    DiskFS disk(cfg.image);
+    BenchContext ctx;
+    ctx.disk = &disk;
+
+    // 负载执行期间屏蔽库内部的提示输出，避免干扰JSON结果
+    NullBuffer null_buf;
+    std::streambuf* old_out = std::cout.rdbuf(&null_buf);
+    std::streambuf* old_err = std::cerr.rdbuf(&null_buf);
+
+    std::vector<BenchResult> results;
+    bool ok = true;
+    for (const auto& wl : WORKLOADS) {
+        if (cfg.workload != "all" && cfg.workload != wl.name) continue;
+        std::vector<size_t> sizes = wl.sized ? cfg.io_sizes : std::vector<size_t>(1, 0);
+        for (size_t io_size : sizes) {
+            // 每个负载都在全新格式化的磁盘上运行，保证结果可比
+            if (!prepare_disk(ctx, cfg)) {
+                ok = false;
+                break;
+            }
+            results.push_back(run_workload(ctx, cfg, wl, io_size));
+        }
+        if (!ok) break;
+    }
+    disk.unmount();
+
+    std::cout.rdbuf(old_out);
+    std::cerr.rdbuf(old_err);
+
+    if (!ok) {
+        std::cerr << "基准测试准备失败：无法格式化或填充磁盘 " << cfg.image << "\n";
+        return 1;
+    }
+    if (results.empty()) {
+        std::cerr << "未知负载: " << cfg.workload << "\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+    print_json(std::cout, cfg, results);
+    return 0;
+}
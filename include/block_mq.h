@@ -0,0 +1,171 @@
+#ifndef BLOCK_MQ_H
+#define BLOCK_MQ_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 多队列块层（blkmq，仿NVMe/blk-mq，仅单镜像，不与条带化、冷热分层同时使用）
+ * - 软件队列：每个提交I/O的线程第一次提交时登记一个软件队列，包含一个提交环与一个完成环，
+ *   两者都是单生产者单消费者的无锁环（提交环由该线程写、硬件队列线程读，完成环相反）
+ * - 硬件队列：可配置个数，每个硬件队列一个工作线程并持有自己的镜像文件描述符（pread/pwrite）；
+ *   软件队列按登记顺序轮流绑定到硬件队列，不同线程的小块随机I/O不经过任何共享锁
+ * - 批量提交：一次提交多个请求时全部入环后只唤醒一次工作线程；工作线程每次从一个软件队列
+ *   最多取MQ_DISPATCH_BATCH个请求再轮到下一个，完成后按批唤醒提交线程
+ * - 线程退出时把自己的软件队列还给块层（线程局部缓存的槽位被覆盖时也一样），之后登记的线程复用，
+ *   软件队列数只随同时提交的线程数增长；同时提交的线程超过软件队列上限时，多出的线程
+ *   不经过环，直接在0号硬件队列的描述符上同步pread/pwrite
+ * - DiskFS的块读写（raw_read/raw_write）与调度器派发（flush_io一次提交全部合并后的写）都经过这里
+ */
+
+const uint32_t MQ_MAX_HW_QUEUES = 16;      // 硬件队列数上限
+const uint32_t MQ_MAX_SW_QUEUES = 64;      // 软件队列数上限
+const uint32_t MQ_DEFAULT_DEPTH = 128;     // 每个环的默认深度（向上取2的幂）
+const uint32_t MQ_DISPATCH_BATCH = 16;     // 工作线程每次从一个软件队列取出的最大请求数
+const uint32_t MQ_SPIN = 256;              // 休眠前的自旋检查次数
+
+/**
+ * @brief 单生产者单消费者无锁环
+ */
+template <typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing(uint32_t depth) : slots(round_up(depth)), mask(slots.size() - 1), head(0), tail(0) {}
+
+    bool push(const T& v)  // 仅生产者调用；满时返回false
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = v;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& v)  // 仅消费者调用；空时返回false
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        v = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+private:
+    std::vector<T> slots;
+    uint32_t mask;
+    std::atomic<uint32_t> head;   // 消费者位置
+    char pad[64];                 // head与tail分属不同缓存行，避免两端相互失效
+    std::atomic<uint32_t> tail;   // 生产者位置
+
+    static size_t round_up(uint32_t n)
+    {
+        size_t size = 2;
+        while (size < n) size <<= 1;
+        return size;
+    }
+};
+
+/**
+ * @brief 一个块I/O请求
+ */
+struct MqRequest
+{
+    uint64_t offset;          // 镜像内的字节偏移
+    char* buf;
+    size_t len;
+    bool is_write;
+};
+
+/**
+ * @brief 硬件队列统计
+ */
+struct MqQueueStats
+{
+    uint64_t requests;        // 完成的请求数
+    uint64_t bytes;           // 读写字节数
+    uint64_t dispatches;      // 工作线程从软件队列取批的次数
+    uint64_t wakeups;         // 工作线程被唤醒的次数
+    uint64_t errors;          // 失败的请求数
+};
+
+/**
+ * @brief 多队列块层
+ */
+class BlockMq
+{
+public:
+    BlockMq(uint32_t hw_queues, uint32_t depth);
+    ~BlockMq();
+
+    bool open(const std::string& path, bool read_only);  // 打开各硬件队列的描述符并启动工作线程
+    bool read(uint64_t pos, char* buffer, size_t len);
+    bool write(uint64_t pos, const char* buffer, size_t len);
+    // 从调用线程的软件队列批量提交并等待全部完成；任一请求失败返回false
+    bool submit(const MqRequest* reqs, size_t count);
+
+    uint32_t hw_queue_count() const { return hw.size(); }
+    uint32_t sw_queue_count() const { return sw_count.load(); }  // 已建立的软件队列数（含已归还待复用的）
+    uint32_t ring_depth() const { return depth; }
+    MqQueueStats queue_stats(uint32_t q) const;
+    uint64_t batched_submits() const { return batches.load(); }  // 一次提交多个请求的次数
+
+private:
+    struct Completion
+    {
+        bool ok;
+    };
+
+    struct HwQueue;
+
+    struct SwQueue
+    {
+        SwQueue(uint32_t depth) : sq(depth), cq(depth), waiting(false) {}
+        SpscRing<MqRequest> sq;       // 提交环：提交线程 -> 工作线程
+        SpscRing<Completion> cq;      // 完成环：工作线程 -> 提交线程
+        std::mutex wait_mutex;        // 只用于休眠等待
+        std::condition_variable wait_cv;
+        std::atomic<bool> waiting;    // 提交线程正在休眠等待完成
+        HwQueue* hwq;                 // 绑定的硬件队列（归还后保持绑定，复用时不变）
+    };
+
+    struct HwQueue
+    {
+        HwQueue() : fd(-1), sleeping(false) {}
+        int fd;
+        std::thread worker;
+        SwQueue* sws[MQ_MAX_SW_QUEUES];   // 绑定到本队列的软件队列
+        std::atomic<uint32_t> sw_count{0};
+        std::mutex sleep_mutex;
+        std::condition_variable sleep_cv;
+        std::atomic<bool> sleeping;
+        std::atomic<uint64_t> requests{0}, bytes{0}, dispatches{0}, wakeups{0}, errors{0};
+    };
+
+    uint32_t depth;
+    uint64_t instance_id;             // 区分实例，线程局部的软件队列缓存据此失效
+    std::vector<HwQueue*> hw;
+    SwQueue* sws[MQ_MAX_SW_QUEUES];
+    std::atomic<uint32_t> sw_count;
+    std::vector<SwQueue*> free_sws;   // 已退出线程归还的软件队列（register_mutex保护）
+    std::mutex register_mutex;
+    std::atomic<bool> stopping;
+    std::atomic<uint64_t> batches;
+
+    friend struct LocalQueueCache;
+
+    SwQueue* local_queue();            // 调用线程的软件队列（首次调用时登记或复用归还的队列）
+    void reap(SwQueue* sw, size_t& outstanding, bool& ok);  // 收取完成项，没有时自旋后休眠
+    void worker_loop(HwQueue* q);
+    void close_all();
+};
+
+#endif // BLOCK_MQ_H
@@ -0,0 +1,30 @@
+#ifndef BULK_IO_H
+#define BULK_IO_H
+
+#include <cstdint>
+
+/**
+ * 主机文件批量导入/导出
+ * - 导入流水线分三级：多个读线程把主机文件整块读入缓冲池，分配线程创建文件（分配inode与目录项），
+ *   写线程把整个文件一次写入；级间用有界队列连接，缓冲池大小固定，内存占用与文件数量无关
+ * - 导出反向：读级按文件整块读出，多个写线程并行写主机文件
+ * - DiskFS不是线程安全的，导入时分配级与写级通过同一把锁串行访问文件系统，并行的是主机侧I/O；
+ *   整个导入处于一个I/O批次内，开启调度器时块写可跨文件合并
+ * - 根目录是单层的：导入目录树时相对路径中的'/'替换为'_'，名称过长或超过单文件上限（16块）的文件跳过并计入失败
+ */
+
+/**
+ * @brief 导入/导出统计
+ */
+struct BulkStats
+{
+    uint64_t files;           // 成功的文件数
+    uint64_t bytes;           // 成功传输的字节数
+    uint64_t failed;          // 失败或跳过的文件数
+    uint32_t threads;         // 主机侧工作线程数
+    double seconds;           // 耗时（秒）
+};
+
+void print_bulk_stats(const char* what, const BulkStats& st);  // 打印统计
+
+#endif // BULK_IO_H
@@ -0,0 +1,124 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * 块校验和（format时选择）
+ * - CRC32C：x86-64上运行时检测，支持AVX-512 VPCLMULQDQ时用4个512位累加器做无进位乘法折叠，
+ *   只有SSE4.2时把4KB块拆成三段交错计算以隐藏crc32指令的延迟、三段结果用启动时预算的移位表合并；
+ *   ARMv8在编译器启用CRC扩展时使用crc32c指令；否则使用8路查表
+ * - 覆盖范围：超级块（自带校验字段）、块位图与inode位图、每个inode；选择data时还覆盖数据区的每个块
+ * - 校验和保存在数据区末尾预留的校验表中（按块号、inode编号下标），干净卸载时写入并标记为干净；
+ *   挂载后立即清除干净标记，批次结束时累计改动较多就把变化的页写出（仍不干净）。改写磁盘表中仍有效的项之前，
+ *   先把表中该项标为无效并写出所在页，再写块本身，所以异常退出后加载的表里只有准确的项：
+ *   其余校验和沿用，只有最近一次写出后改写过的块与inode在首次读取时按读到的内容重新登记；
+ *   表自身校验失败（如写表时中断）才丢弃全部旧值
+ * - 内核（crc32c.cpp）与本模块由Makefile按-O2编译，不受默认的不优化构建影响：4KB块约60ns（vpclmulqdq），
+ *   约200ns（sse4.2）；读路径上通过的比对按批计入stats
+ * - 读块与读inode时比对校验和，不符时读取失败并计数（stats中的csum_errors）
+ */
+
+const char CSUM_MAGIC[8] = "SIMCRC1";
+const uint32_t CSUM_META = 0x1;  // 校验元数据（超级块、位图、inode）
+const uint32_t CSUM_DATA = 0x2;  // 同时校验数据区的块
+
+/**
+ * @brief 计算CRC32C（crc为之前部分的结果，首次传0，可分段连续计算）
+ */
+uint32_t crc32c(uint32_t crc, const void* data, size_t len);
+
+/**
+ * @brief 查表实现的CRC32C（与crc32c结果相同，用于校验加速实现）
+ */
+uint32_t crc32c_portable(uint32_t crc, const void* data, size_t len);
+
+/**
+ * @brief 运行时选中的CRC32C实现名称（"vpclmulqdq"、"sse4.2"、"armv8-crc"或"table"）
+ */
+const char* crc32c_impl();
+
+/**
+ * @brief 校验表头（位于校验表第一块的开头）
+ */
+struct CsumHeader
+{
+    char magic[8];            // "SIMCRC1"
+    uint32_t clean;           // 1表示干净卸载后写入；挂载后清零
+    uint32_t mode;            // CSUM_META | CSUM_DATA
+    uint32_t block_count;     // 块校验和项数（等于总块数）
+    uint32_t inode_count;     // inode校验和项数
+    uint32_t checksum;        // 表头之后全部内容的CRC32C
+    uint32_t reserved;
+};
+
+/**
+ * @brief 校验统计
+ */
+struct CsumStats
+{
+    bool from_checkpoint;     // 校验和是否来自磁盘上的校验表
+    bool unclean;             // 校验表不是干净卸载时写入的（沿用其中仍有效的项）
+    uint64_t verified;        // 比对通过的读次数（块与inode）
+    uint64_t errors;          // 比对不符的次数
+    uint64_t adopted;         // 没有有效校验和、首次读取时登记的次数
+    uint64_t updated;         // 写入时更新校验和的次数
+    uint64_t intents;         // 改写前在磁盘表中标无效的写出次数
+    uint64_t saves;           // 挂载期间写出校验表的次数
+};
+
+/**
+ * @brief 校验和的内存状态（按块号与inode编号下标，不做I/O）
+ */
+class ChecksumTable
+{
+public:
+    ChecksumTable(uint32_t mode, uint32_t total_blocks, uint32_t total_inodes);
+    ~ChecksumTable();  // 未计入的比对次数补记到stats
+
+    uint32_t mode;
+    CsumStats st;
+    uint32_t unreported;  // 已通过、尚未计入stats的比对次数（读路径上按批计入）
+    uint32_t changes;     // 上次写出校验表后的改动次数
+
+    // 磁盘上校验表的副本（只读挂载时为空）：项改动时若副本中仍有效，就在副本中标为无效并记下所在位置，
+    // 对应的块写出之前先写出这些页
+    std::vector<char> image;
+
+    void set_block(uint32_t block_num, const char* data, size_t len);
+    bool check_block(uint32_t block_num, const char* data, size_t len);  // 不符返回false；没有有效值时登记
+    void set_inode(uint32_t inode_num, const char* data, size_t len);
+    bool check_inode(uint32_t inode_num, const char* data, size_t len);
+    void invalidate_block(uint32_t block_num)
+    {
+        block_valid[block_num] = 0;
+        touch(block_valid_pos(block_num));
+    }
+    void invalidate_all();
+
+    size_t table_bytes() const;  // 序列化后的字节数（含表头）
+    void save(std::vector<char>& out, bool clean) const;
+    bool load(const std::vector<char>& in);  // 表头与内容校验通过时加载（干净与否记入st）
+
+    bool has_intents() const { return !stale.empty(); }
+    void take_intents(std::vector<uint32_t>& pages, size_t page_size);  // 重算副本的表头，取出待写的页（表头页在最后）
+    void replace_image(std::vector<char>& next);                        // 整表写出后换上新副本
+
+    static size_t table_bytes(uint32_t total_blocks, uint32_t total_inodes);
+
+private:
+    std::vector<uint32_t> block_crc;
+    std::vector<uint32_t> inode_crc;
+    std::vector<uint8_t> block_valid;
+    std::vector<uint8_t> inode_valid;
+    std::vector<size_t> stale;  // 副本中已标无效、尚未写出的位置
+
+    size_t block_valid_pos(uint32_t block_num) const;
+    size_t inode_valid_pos(uint32_t inode_num) const;
+    void touch(size_t pos);
+    bool check(uint32_t& crc, uint8_t& valid, size_t pos, const char* data, size_t len);
+};
+
+#endif // CHECKSUM_H
@@ -1,19 +1,49 @@
 #ifndef COMMAND_PARSER_H
 #define COMMAND_PARSER_H
 
+#include <istream>
 #include <string>
 #include <vector>
 #include "disk_fs.h"
 
+/**
+ * @brief 脚本执行选项
+ */
+struct ScriptOptions
+{
+    bool timing;              // 每条命令后输出一行耗时列
+    bool stop_on_error;       // 遇到失败的命令立即停止
+    bool echo;                // 执行前回显命令
+};
+
+/**
+ * @brief 脚本执行统计
+ */
+struct ScriptStats
+{
+    uint64_t lines;           // 已读取的行数（含空行与注释）
+    uint64_t commands;        // 已执行的命令数
+    uint64_t failed;          // 失败的命令数
+    uint64_t first_error;     // 第一条失败命令的行号（0表示没有）
+    double seconds;           // 耗时（秒）
+};
+
 class CommandParser {
 private:
     DiskFS& disk;
+    std::vector<std::string> tokens;   // 当前命令的参数（跨命令复用存储）
+    std::vector<size_t> token_end;     // 各参数在命令行中的结束位置
+    bool quit;                         // 执行过exit命令
+
+    void tokenize(const std::string& line);
 
 public:
-    CommandParser(DiskFS& disk_fs) : disk(disk_fs) {}
+    CommandParser(DiskFS& disk_fs) : disk(disk_fs), quit(false) {}
 
-    bool execute_command(const std::string& command_line);
+    bool execute_command(const std::string& command_line);  // 成功返回true
+    bool run_script(std::istream& in, const ScriptOptions& opt, ScriptStats& st);  // 非交互执行脚本
+    bool exit_requested() const { return quit; }
     void print_help() const;
 };
 
-#endif // COMMAND_PARSER_H
\ No newline at end of file
+#endif // COMMAND_PARSER_H
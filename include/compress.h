@@ -0,0 +1,86 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 透明数据压缩（按文件开启，超级块记录新建文件的默认值）
+ * - 文件数据按簇（16块=64KB逻辑数据）压缩，使用LZ4块格式的快速编码器（内置实现，无外部依赖）
+ * - 压缩的簇在inode块指针中占用簇首的若干个连续槽位，第一块以ClusterHeader开头，其余槽位为0；
+ *   占用槽位数少于簇逻辑长度所需块数即表示该簇已压缩，压缩后省不下整块的簇按原样存放，与普通文件相同
+ * - 读取只解压涉及的簇，解压结果放入LRU簇缓存；写入对涉及的簇做读-改-写并重新压缩，同时更新缓存
+ * - 单文件上限为16个直接块，即每个文件恰好一个簇；簇大小与块指针的对应关系按通用方式实现
+ */
+
+const uint32_t COMPRESS_CLUSTER_BLOCKS = 16;                            // 每簇块数
+const uint32_t COMPRESS_CLUSTER_BYTES = COMPRESS_CLUSTER_BLOCKS * 4096;  // 每簇逻辑字节数（64KB）
+const uint32_t COMPRESS_CACHE_CLUSTERS = 64;                            // 簇缓存容量（簇数，最多4MB）
+const uint32_t CLUSTER_MAGIC = 0x315A4C43;                              // "CLZ1"
+const uint8_t INODE_COMPRESSED = 0x01;                                  // Inode::flags：数据按簇压缩存储
+
+/**
+ * @brief 压缩簇头（位于压缩簇第一块的开头，其后紧跟压缩数据）
+ */
+struct ClusterHeader
+{
+    uint32_t magic;           // CLUSTER_MAGIC
+    uint32_t comp_len;        // 压缩数据字节数
+};
+
+/**
+ * @brief 压缩统计
+ */
+struct CompressStats
+{
+    uint64_t clusters_packed; // 压缩存放的簇写入次数
+    uint64_t clusters_raw;    // 原样存放的簇写入次数（压缩后省不下一块）
+    uint64_t logical_bytes;   // 写入簇的逻辑字节数
+    uint64_t stored_bytes;    // 写入簇实际占用的字节数（整块计）
+    uint64_t cache_hits;      // 簇缓存命中次数
+    uint64_t cache_misses;    // 读取压缩簇时未命中缓存（需解压）的次数
+};
+
+/**
+ * @brief LZ4块格式压缩
+ * @return 压缩后字节数；输出超过cap（数据不可压缩）时返回0
+ */
+size_t lz_compress(const char* src, size_t len, char* dst, size_t cap);
+
+/**
+ * @brief LZ4块格式解压，输出必须恰好为out_len字节
+ * @return 数据完整且长度一致返回true；数据损坏返回false
+ */
+bool lz_decompress(const char* src, size_t len, char* dst, size_t out_len);
+
+/**
+ * @brief 解压后簇的LRU缓存（键为inode编号与簇号，不做I/O）
+ */
+class ClusterCache
+{
+public:
+    explicit ClusterCache(size_t capacity);
+
+    const std::vector<char>* lookup(uint32_t inode_num, uint32_t cluster);  // 命中时移到最近使用端
+    void insert(uint32_t inode_num, uint32_t cluster, const char* data, size_t len);
+    void erase(uint32_t inode_num, uint32_t cluster);
+    void invalidate(uint32_t inode_num);  // 丢弃文件的全部簇
+    void clear();
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        std::vector<char> data;
+    };
+    size_t capacity;
+    std::list<Entry> lru;     // 头部为最近使用
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+
+    static uint64_t make_key(uint32_t inode_num, uint32_t cluster) { return ((uint64_t)inode_num << 32) | cluster; }
+};
+
+#endif // COMPRESS_H
@@ -0,0 +1,95 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 内联块去重（format时选择）
+ * - write_file写入的每个整块先计算指纹（四路并行的64位哈希，编译器可向量化），在内存指纹索引中查找；
+ *   命中且内容逐字节相同时只增加该块的引用计数、让块指针指向它，不再分配和写盘
+ * - 每个数据块有引用计数：删除与覆盖写减少引用，降到0才释放；覆盖被共享的块时写时复制到新块，
+ *   覆盖独占的块时原地写并更新指纹，内容未变的覆盖直接跳过
+ * - 指纹与引用计数持久化在数据区末尾预留的去重表中，干净卸载时整体写入；挂载后立即清除干净标记，
+ *   异常退出后的下一次挂载由inode块指针重建引用计数并重新计算指纹
+ * - 只有普通文件的数据块参与去重；目录块与压缩文件的块不登记指纹
+ * - 以cow格式化时只维护引用计数、不计算指纹，供文件克隆与快照（见snapshot.h）写时复制
+ */
+
+const char DEDUP_MAGIC[8] = "SIMDDP1";
+const uint32_t DEDUP_INLINE = 0x1;  // 写入时按内容去重（未设置时去重表只维护引用计数）
+
+/**
+ * @brief 去重表头（位于去重表第一块的开头，其后紧跟每个数据块一项DedupEntry）
+ */
+struct DedupHeader
+{
+    char magic[8];            // "SIMDDP1"
+    uint32_t clean;           // 1表示干净卸载后写入；挂载后清零
+    uint32_t checksum;        // 全部表项的FNV-1a校验和
+    uint32_t entry_count;     // 表项数（等于数据区块数）
+    uint32_t reserved;
+};
+
+/**
+ * @brief 去重表项（按数据区相对块号下标）
+ */
+struct DedupEntry
+{
+    uint64_t fingerprint;     // 块内容指纹（has_fp为1时有效）
+    uint32_t refs;            // 引用计数（0表示空闲）
+    uint32_t has_fp;          // 是否登记了指纹
+};
+
+/**
+ * @brief 去重统计
+ */
+struct DedupStats
+{
+    bool from_checkpoint;     // 引用计数与指纹是否来自干净卸载时写入的去重表
+    uint64_t hashed;          // 计算指纹的块写数
+    uint64_t dup_hits;        // 与已有块共享而省去的块写数
+    uint64_t unchanged;       // 内容未变而跳过的覆盖写数
+    uint64_t cow_breaks;      // 覆盖共享块时的写时复制次数
+    uint64_t collisions;      // 指纹相同但内容不同的次数
+};
+
+/**
+ * @brief 计算一个块的指纹（len须为32的倍数）
+ */
+uint64_t block_fingerprint(const char* data, size_t len);
+
+/**
+ * @brief 去重的内存状态：引用计数、指纹与指纹索引（不做I/O）
+ */
+class DedupIndex
+{
+public:
+    DedupIndex(uint32_t data_start, uint32_t data_blocks);
+
+    uint32_t data_start;
+    std::vector<DedupEntry> entries;
+    DedupStats st;
+
+    int find(uint64_t fp) const;                   // 按指纹查找块号，未找到返回-1
+    uint32_t refs(uint32_t block) const { return entries[block - data_start].refs; }
+    void add_ref(uint32_t block) { entries[block - data_start].refs++; }
+    uint32_t drop_ref(uint32_t block);             // 返回剩余引用数
+    void set_allocated(uint32_t block, bool used); // 位图分配/释放时调用：引用计数置1或0，清除指纹
+    void record(uint32_t block, uint64_t fp);      // 登记块的指纹
+    void forget(uint32_t block);                   // 清除块的指纹
+    void rebuild_index();                          // 由表项重建指纹索引
+
+    uint64_t logical_blocks() const;   // 全部引用数之和（去重前需要的块数）
+    uint64_t physical_blocks() const;  // 引用数不为0的块数
+    size_t memory_bytes() const;       // 表项与指纹索引占用的内存（估算）
+
+    static uint32_t checksum(const DedupEntry* entries, size_t count);
+
+private:
+    std::unordered_map<uint64_t, uint32_t> index;  // 指纹 -> 块号（同一指纹只登记一个块）
+};
+
+#endif // DEDUP_H
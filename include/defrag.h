@@ -0,0 +1,62 @@
+#ifndef DEFRAG_H
+#define DEFRAG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * 碎片报告与在线整理
+ * - 块分配总是取编号最小的空闲块，长期使用后文件的数据块会与其他文件穿插，顺序读退化为逐块寻道
+ * - 报告：每个文件的区段（块号连续的一段）数与平均区段长度，以及空闲空间的区段数与最大连续空闲区
+ * - 整理：为碎片化文件找一段足够长的连续空闲区，按文件内顺序复制数据后一次性改写inode的块指针，
+ *   再释放旧块；inode写入是切换点，之前失败时文件仍指向旧块，数据不会丢失
+ * - 每次调用可限定搬移块数（I/O预算），整理从上次停下的inode继续，前台操作可在两次调用之间执行
+ */
+
+/**
+ * @brief 单个文件的碎片情况
+ */
+struct FileFrag
+{
+    std::string name;         // 文件名
+    uint32_t inode_num;       // inode编号
+    uint32_t blocks;          // 已分配的数据块数
+    uint32_t extents;         // 区段数（1表示完全连续）
+};
+
+/**
+ * @brief 整个磁盘的碎片报告
+ */
+struct FragReport
+{
+    std::vector<FileFrag> files;
+    uint32_t file_blocks;       // 所有文件的数据块总数
+    uint32_t file_extents;      // 所有文件的区段总数
+    uint32_t fragmented_files;  // 区段数大于1的文件数
+    uint32_t free_blocks;       // 空闲数据块数
+    uint32_t free_extents;      // 空闲区段数
+    uint32_t largest_free;      // 最大连续空闲块数
+
+    double avg_run() const { return file_extents ? (double)file_blocks / file_extents : 0.0; }
+    // 空闲空间碎片度：1 - 最大连续空闲区/空闲总量（0表示空闲空间完全连续）
+    double free_fragmentation() const { return free_blocks ? 1.0 - (double)largest_free / free_blocks : 0.0; }
+};
+
+/**
+ * @brief 整理统计（累计）
+ */
+struct DefragStats
+{
+    uint64_t files_moved;     // 被重新放置的文件数
+    uint64_t blocks_moved;    // 搬移的数据块数
+    uint64_t skipped;         // 找不到足够长连续空闲区而跳过的文件数
+    uint64_t passes;          // 完整扫描一遍所有文件的次数
+};
+
+/**
+ * @brief 计算块指针数组的区段数（跳过未分配的0指针）
+ */
+uint32_t count_extents(const uint32_t* blocks, uint32_t count);
+
+#endif // DEFRAG_H
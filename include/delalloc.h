@@ -0,0 +1,56 @@
+#ifndef DELALLOC_H
+#define DELALLOC_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/**
+ * 延迟块分配（delalloc，不用于去重/引用计数模式与压缩文件）
+ * - 写入尚未分配物理块的文件块时不查找空闲块、不改位图，只在内存中建立脏页，并从空闲计数中预留一块；
+ *   同一块的后续写入直接改脏页，读取也由脏页服务
+ * - 回写时按文件把全部脏页一次分配：优先紧接文件已有的最后一块，其次第一段足够长的连续空闲区，
+ *   都没有时按空闲区顺序拼接；整批只改写一次位图块与超级块，再按块顺序写入数据、写回一次inode
+ * - 删除文件时丢弃它的脏页，短命文件从不分配物理块；截断时丢弃新长度之后的脏页
+ * - 回写时机：卸载、delalloc flush/off、脏页超过DELALLOC_MAX_PAGES，以及碎片报告、整理、一致性检查
+ *   与压缩转换之前（这些操作直接检查块指针）；崩溃时尚未回写的脏页丢失，与主机页缓存的语义相同
+ */
+
+const uint32_t DELALLOC_MAX_PAGES = 1024;  // 脏页上限（4MB），超过时写入结束后整体回写
+
+/**
+ * @brief 延迟分配统计（累计）
+ */
+struct DelallocStats
+{
+    uint64_t pages;           // 建立的脏页数（每页预留一块）
+    uint64_t rewrites;        // 写入已有脏页的次数（没有再次预留）
+    uint64_t dropped;         // 删除或截断文件时丢弃、从未分配物理块的页数
+    uint64_t flushes;         // 回写次数
+    uint64_t allocated;       // 回写时分配的块数
+    uint64_t runs;            // 回写时分配出的连续区段数
+    uint64_t meta_writes;     // 回写时写入位图块与超级块的次数（逐块分配时每块2次）
+};
+
+/**
+ * @brief 尚未分配物理块的脏页：inode编号 -> 文件内块序号 -> 页内容
+ */
+class DelallocCache
+{
+public:
+    DelallocCache() : reserved(0), st() {}
+
+    // 取得脏页，不存在时在仍有未预留空闲块的前提下新建（内容清零）；空闲块已全部预留返回nullptr
+    char* get(uint32_t inode_num, uint32_t block_idx, uint32_t free_blocks);
+    const char* find(uint32_t inode_num, uint32_t block_idx) const;
+    uint32_t drop(uint32_t inode_num);  // 丢弃文件的全部脏页并释放预留，返回页数
+    uint32_t clear();                   // 丢弃所有文件的脏页并释放预留（卸载时回写失败的页），返回页数
+    // 截断：丢弃块序号不小于keep_blocks的脏页，tail非0时把第keep_blocks-1页从tail起清零，返回丢弃的页数
+    uint32_t truncate(uint32_t inode_num, uint32_t keep_blocks, uint32_t tail);
+
+    std::map<uint32_t, std::map<uint32_t, std::vector<char>>> files;
+    uint32_t reserved;        // 已预留的块数（等于脏页数）
+    DelallocStats st;
+};
+
+#endif // DELALLOC_H
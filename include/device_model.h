@@ -0,0 +1,115 @@
+#ifndef DEVICE_MODEL_H
+#define DEVICE_MODEL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * 设备时序模型：为块层的每次I/O计算模拟服务时间
+ * - HddModel：按寻道距离计算寻道时间，加上旋转延迟和按磁道计算的传输时间
+ * - SsdModel：多通道并行，页读/页编程延迟，各通道按虚拟时间排队
+ * - FtlModel：在SSD时序上增加闪存转换层（映射、垃圾回收、磨损均衡），见ftl_model.h
+ * 模型只计算时间，不改变数据的存储方式
+ */
+
+/**
+ * @brief I/O方向
+ */
+enum DeviceOp
+{
+    DEV_READ,
+    DEV_WRITE
+};
+
+/**
+ * @brief 设备模型接口
+ */
+class DeviceModel
+{
+public:
+    virtual ~DeviceModel() {}
+
+    virtual const char* name() const = 0;
+    virtual std::string describe() const = 0;  // 模型参数的文字描述
+
+    /**
+     * @brief 计算一次I/O的服务时间
+     * @param op I/O方向
+     * @param offset 起始字节偏移
+     * @param length 字节数
+     * @param now_ns 请求到达时的虚拟时间（纳秒，用于通道排队）
+     * @return 从到达到完成的模拟时间（纳秒）
+     */
+    virtual uint64_t service(DeviceOp op, uint64_t offset, uint64_t length, uint64_t now_ns) = 0;
+
+    /**
+     * @brief 通知设备一段地址的数据已不再使用（TRIM），默认忽略
+     */
+    virtual void discard(uint64_t offset, uint64_t length) { (void)offset; (void)length; }
+
+    /**
+     * @brief 模型内部统计的文字报告（每行以两个空格缩进），无统计时返回空串
+     */
+    virtual std::string report() const { return std::string(); }
+
+    /**
+     * @brief 根据名称创建模型（"hdd"、"ssd"、"ftl"或"ftl-cb"）
+     * param为可选参数（HDD转速/SSD通道数/FTL预留空间百分比，0表示默认）
+     * @return 成功返回新模型（调用方负责释放）；名称未知返回nullptr
+     */
+    static DeviceModel* create(const std::string& kind, uint32_t param);
+};
+
+/**
+ * @brief 机械硬盘模型
+ */
+class HddModel : public DeviceModel
+{
+public:
+    /**
+     * @param rpm 转速（转/分钟）
+     * @param track_bytes 每个磁道的字节数（决定传输速率：每转传输一个磁道）
+     * @param capacity 磁盘容量（字节，用于计算满行程寻道）
+     */
+    HddModel(uint32_t rpm, uint64_t track_bytes, uint64_t capacity);
+
+    const char* name() const override { return "hdd"; }
+    std::string describe() const override;
+    uint64_t service(DeviceOp op, uint64_t offset, uint64_t length, uint64_t now_ns) override;
+
+private:
+    uint64_t track_bytes;
+    uint64_t total_tracks;
+    uint64_t rotation_ns;      // 旋转一周的时间
+    uint64_t seek_min_ns;      // 相邻磁道寻道时间
+    uint64_t seek_max_ns;      // 满行程寻道时间
+    uint64_t head_pos;         // 上次I/O结束位置（字节）
+};
+
+/**
+ * @brief 固态硬盘模型
+ */
+class SsdModel : public DeviceModel
+{
+public:
+    /**
+     * @param channels 并行通道数（页按页号轮流分布到各通道）
+     * @param read_ns 单页读取延迟
+     * @param program_ns 单页编程（写入）延迟
+     * @param page_bytes 页大小
+     */
+    SsdModel(uint32_t channels, uint64_t read_ns, uint64_t program_ns, uint64_t page_bytes);
+
+    const char* name() const override { return "ssd"; }
+    std::string describe() const override;
+    uint64_t service(DeviceOp op, uint64_t offset, uint64_t length, uint64_t now_ns) override;
+
+private:
+    uint64_t read_ns;
+    uint64_t program_ns;
+    uint64_t page_bytes;
+    std::vector<uint64_t> busy_until;  // 各通道空闲时刻（虚拟时间）
+};
+
+#endif // DEVICE_MODEL_H
@@ -0,0 +1,39 @@
+#ifndef DISK_CLIENT_H
+#define DISK_CLIENT_H
+
+#include <string>
+#include <vector>
+#include "disk_protocol.h"
+
+/**
+ * @brief 守护进程客户端：接口与DiskFS的文件操作一致，每次调用同步等待应答
+ * 一个DiskClient对象只能由一个线程使用；多线程各自建立连接
+ */
+class DiskClient
+{
+public:
+    DiskClient();
+    ~DiskClient();
+
+    bool connect_to(const std::string& socket_path);  // 连接守护进程
+    void disconnect();
+    bool is_connected() const { return fd >= 0; }
+
+    bool ping();
+    bool set_class(const std::string& qos_class);     // 切换本连接的QoS类别
+    int create_file(const std::string& filename);     // 返回inode编号，失败返回-1
+    int open_file(const std::string& filename);       // 返回inode编号，失败返回-1
+    bool delete_file(const std::string& filename);
+    int read_file(uint32_t inode_num, char* buffer, uint32_t size, uint32_t offset);         // 返回读取字节数，失败返回-1
+    int write_file(uint32_t inode_num, const char* buffer, uint32_t size, uint32_t offset);  // 返回写入字节数，失败返回-1
+    std::vector<DirEntry> list_files();
+
+private:
+    int fd;
+    uint32_t next_id;
+
+    // 发送请求并接收应答；payload为应答负载，连接出错返回false
+    bool call(DaemonRequest& req, const char* data, int32_t& status, std::vector<char>& payload);
+};
+
+#endif // DISK_CLIENT_H
@@ -5,6 +5,26 @@
 #include <cstdint>
 #include <fstream>
 #include <vector>
+#include <memory>
+#include "io_stats.h"
+#include "io_trace.h"
+#include "device_model.h"
+#include "io_scheduler.h"
+#include "log_fs.h"
+#include "defrag.h"
+#include "fsck.h"
+#include "meta_cache.h"
+#include "bulk_io.h"
+#include "stripe.h"
+#include "compress.h"
+#include "dedup.h"
+#include "checksum.h"
+#include "snapshot.h"
+#include "tier.h"
+#include "shared_meta.h"
+#include "block_mq.h"
+#include "delalloc.h"
+#include "image_pack.h"
 
 // 常量定义
 const int BLOCK_SIZE = 4096;               // 磁盘块大小（4KB，常见的块大小选择）
@@ -23,6 +43,8 @@ struct Inode
     uint32_t blocks[16];     // 数据块指针数组（直接块，最多16个块）
     uint8_t type;            // 类型：1表示文件，2表示目录
     uint8_t used;            // 使用状态：1表示已使用，0表示未使用
+    uint8_t flags;           // 标志位：INODE_COMPRESSED表示数据按簇压缩存储（见compress.h）
+    uint16_t unwritten;      // 未写入位图：第i位表示blocks[i]由fallocate预留、尚未写入，读出为0（占用原有填充字节）
     time_t create_time;      // 创建时间（时间戳）
     time_t modify_time;      // 最后修改时间（时间戳）
 };
@@ -54,6 +76,18 @@ struct SuperBlock
     uint32_t inode_bitmap;   // inode位图起始块号（管理inode分配）
     uint32_t inode_start;    // inode区起始块号
     uint32_t data_start;     // 数据区起始块号
+    uint32_t stripe_count;   // 条带成员数（0或1表示单镜像）
+    uint32_t stripe_unit;    // 条带单元（块）
+    uint32_t compress;       // 新建文件是否默认压缩（1压缩）
+    uint32_t dedup_start;    // 去重表起始块号（位于数据区之后）
+    uint32_t dedup_blocks;   // 去重表占用的块数（0表示未启用去重）
+    uint32_t csum_mode;      // 校验范围（CSUM_META | CSUM_DATA，0表示未启用校验）
+    uint32_t csum_start;     // 校验表起始块号（位于数据区之后）
+    uint32_t csum_blocks;    // 校验表占用的块数
+    uint32_t dedup_flags;    // DEDUP_INLINE：写入时按内容去重（否则去重表只维护引用计数）
+    uint32_t snap_block;     // 快照目录块号（启用引用计数时预留，0表示不支持快照）
+    uint32_t tier_fast_blocks;  // 快速层块数（0表示不分层）
+    uint32_t sb_checksum;    // 超级块自身的CRC32C（计算时此字段按0处理）
 };
 
 /**
@@ -71,6 +105,54 @@ private:
     std::string disk_path;   // 磁盘文件路径
     SuperBlock super_block;  // 超级块（内存中的副本）
     bool is_mounted;         // 挂载状态：true表示已挂载
+    IoTracer tracer;         // I/O追踪器（默认关闭）
+    std::unique_ptr<DeviceModel> device;  // 设备时序模型（为空表示按主机速度完成）
+    bool device_realtime;    // true：按模拟时间真实等待；false：只推进虚拟时钟
+    uint64_t virtual_ns;     // 设备模型的虚拟时钟（纳秒）
+    IoScheduler scheduler;   // I/O调度器（默认不排队）
+    uint32_t batch_depth;    // 当前批次嵌套深度（>0时块写进入调度队列）
+    std::unique_ptr<LogState> log;  // 日志结构布局的状态（为空表示原地更新布局）
+    uint32_t defrag_cursor;  // 在线整理下次开始检查的inode编号
+    DefragStats defrag_st;   // 在线整理统计
+    std::unique_ptr<MetaCache> meta;  // 快速挂载的元数据副本与目录索引（为空表示未启用，日志布局不使用）
+    std::unique_ptr<StripeSet> stripe;  // 条带化后端（为空表示单镜像，直接读写disk_file）
+    std::vector<std::string> stripe_members;  // 下次格式化使用的其余成员路径
+    uint32_t stripe_unit_blocks;              // 下次格式化使用的条带单元（块）
+    ClusterCache cluster_cache;  // 解压后的簇缓存
+    CompressStats compress_st;   // 压缩统计
+    std::unique_ptr<DedupIndex> dedup;  // 块去重状态（为空表示未启用）
+    bool dedup_on_format;               // 下次格式化是否启用去重
+    bool cow_on_format;                 // 下次格式化是否启用块引用计数（克隆与快照）
+    std::vector<SnapEntry> snapshots;   // 快照目录（启用引用计数时有SNAP_MAX个槽位）
+    std::vector<Inode> snap_view;       // 只读挂载快照时的inode表（为空表示挂载的是当前文件系统）
+    bool read_only;                     // 只读挂载：拒绝一切修改，卸载时不写回
+    std::unique_ptr<ChecksumTable> csum;  // 块校验和（为空表示未启用）
+    uint32_t csum_on_format;              // 下次格式化的校验范围
+    std::unique_ptr<TierSet> tier;        // 冷热分层后端（为空表示不分层）
+    std::unique_ptr<DeviceModel> tier_device;  // 快速层的设备模型（设置了设备模型时按SSD计时）
+    std::string tier_fast_path;           // 下次格式化使用的快速层路径
+    uint32_t tier_fast_size;              // 下次格式化使用的快速层块数
+    uint32_t tier_migrate_ms;             // 后台迁移间隔（毫秒，0表示不启动后台线程）
+    std::unique_ptr<SharedMeta> shared;   // 共享只读挂载的跨进程元数据段（为空表示未使用）
+    int image_lock_fd;                    // 持有镜像flock的描述符（-1表示未加锁）
+    std::unique_ptr<BlockMq> mq;          // 多队列块层（为空表示直接读写disk_file）
+    uint32_t mq_queues;                   // 挂载时启用的硬件队列数（0表示不启用）
+    uint32_t mq_depth;                    // 每个软件队列的环深度
+    std::unique_ptr<DelallocCache> delalloc;  // 延迟分配的脏页（为空表示写入时立即分配）
+
+    /**
+     * @brief 批次守卫：公共操作内的块写在操作结束时统一派发
+     */
+    class IoBatch
+    {
+    public:
+        explicit IoBatch(DiskFS& fs) : fs(fs), open(true) { fs.begin_batch(); }
+        ~IoBatch() { if (open) fs.end_batch(); }
+        bool end() { open = false; return fs.end_batch(); }  // 提前结束批次，返回派发是否成功
+    private:
+        DiskFS& fs;
+        bool open;
+    };
 
     // 计算各区域在磁盘中的位置（字节偏移量）
     uint32_t get_super_block_pos() { return 0; }  // 超级块固定在0位置
@@ -86,10 +168,106 @@ private:
     int find_free_inode();  // 查找空闲inode
 
     bool write_super_block(); // 辅助函数：将内存中的超级块写回磁盘（保证数据一致性）
+    bool region_io(uint32_t first, uint32_t count, std::vector<char>& buf, bool is_write);  // 读写连续多块（原地布局一次I/O）
+
+    // 底层字节读写（所有磁盘文件访问的唯一入口，设备模型在此计时）
+    bool raw_read(uint64_t pos, char* buffer, size_t len);
+    bool raw_write(uint64_t pos, const char* buffer, size_t len);
+    void account_device(DeviceOp op, uint64_t pos, size_t len, size_t fast_len = 0);  // fast_len：由快速层服务的字节数
+
+    // inode读写（内部使用）
+    bool read_inode(uint32_t inode_num, Inode& inode);
+    bool write_inode(uint32_t inode_num, const Inode& inode);
 
     // 块读写操作（内部使用，读写指定块）
     bool read_block(uint32_t block_num, char* buffer);   // 读取块
+    bool load_block(uint32_t block_num, char* buffer);   // 读取块（不计数、不校验）
     bool write_block(uint32_t block_num, const char* buffer);  // 写入块
+    bool flush_io();  // 派发调度队列中的全部写请求
+    void discard_block(uint32_t block_num);  // 通知设备模型块已释放（TRIM）
+
+    // 日志结构布局（见log_fs.h）
+    bool log_read_block(uint32_t block_num, char* buffer);
+    bool log_write_block(uint32_t block_num, const char* buffer);
+    bool log_read_inode(uint32_t inode_num, Inode& inode);
+    bool log_write_inode(uint32_t inode_num, const Inode& inode);
+    bool log_flush();       // 写缓冲追加到日志（必要时先清理）
+    bool log_append();      // 写缓冲按段顺序写到日志头部
+    bool log_checkpoint();  // 写检查点
+    bool log_load();        // 挂载时加载最新检查点
+    bool log_clean(uint32_t count);  // 清理最多count个段
+
+    // 碎片整理（见defrag.h）
+    bool read_block_bitmap(std::vector<uint8_t>& bitmap);  // 读取整个块位图
+    int relocate_file(uint32_t inode_num);  // 把文件搬到一段连续空闲区，返回搬移块数（0跳过，-1失败）
+
+    // 快速挂载（见meta_cache.h）
+    bool meta_attach(bool preload);  // 挂载时加载检查点或重建索引，按需预读
+    bool meta_detach();              // 卸载时写入挂载检查点
+    int find_entry(const std::string& name);  // 按文件名查找inode（优先使用目录索引）
+
+    // 条带化（见stripe.h）
+    bool stripe_create();  // 格式化时创建条带集并写入条带表
+    bool stripe_attach();  // 挂载时按超级块与条带表重新组装条带集
+
+    // 冷热分层（见tier.h）
+    bool tier_create(bool log_structured);  // 格式化时创建分层集并写入分层信息
+    bool tier_attach();    // 挂载时打开快速层并重新读取超级块
+    bool tier_detach();    // 卸载时写入干净表头与引导副本
+
+    // 跨进程共享只读挂载（见shared_meta.h）
+    bool mount_image(bool preload, bool read_only, bool shared_meta);  // mount的主体（已加锁）
+    bool shared_attach();  // 映射或构建共享元数据段
+    bool lock_image(bool exclusive);  // 对镜像加flock（不等待）
+    void unlock_image();
+
+    // 多队列块层（见block_mq.h）
+    bool mq_attach();      // 按配置启动硬件队列工作线程
+
+    // 延迟块分配（见delalloc.h）
+    bool alloc_blocks(uint32_t goal, uint32_t want, std::vector<uint32_t>& out,
+                      DelallocStats* st = nullptr);  // 一次分配一批块（st非空时累计区段数与元数据写入次数）
+    bool delalloc_flush_file(uint32_t inode_num);
+
+    // 透明压缩（见compress.h）
+    bool read_cluster(uint32_t inode_num, const Inode& inode, uint32_t cluster, uint32_t size, uint32_t from,
+                      uint32_t len, char* out);
+    bool write_cluster(uint32_t inode_num, Inode& inode, uint32_t cluster, const char* data, uint32_t size);
+    int compressed_read(uint32_t inode_num, const Inode& inode, char* buffer, size_t size, off_t offset);
+    int compressed_write(uint32_t inode_num, Inode& inode, const char* buffer, size_t size, off_t offset);
+
+    // 块去重（见dedup.h）
+    void dedup_create();   // 格式化时预留去重表
+    bool dedup_attach();   // 挂载时加载或重建去重表
+    bool dedup_detach();   // 卸载时写入去重表
+    bool dedup_store(uint32_t& slot, const char* buffer);  // 按内容写入文件的一个块
+    void release_block(uint32_t block_num);  // 文件不再引用某块（去重模式下按引用计数释放）
+    bool release_blocks(const std::vector<uint32_t>& blocks);  // 批量释放，每个位图块与超级块只写一次
+
+    // 块校验和（见checksum.h）
+    void csum_create();    // 格式化时预留校验表
+    bool csum_attach();    // 挂载时加载校验表
+    bool csum_detach();    // 卸载时写入校验表
+    bool csum_save(bool clean);  // 写出校验表中变化的页
+    bool csum_write_intents();   // 块写出前写出已标无效的校验表页
+    bool csum_sync();            // 批次结束时按改动量写出校验表
+    bool csum_write_pages(const std::vector<char>& table, const std::vector<uint32_t>& pages);
+    bool csum_covers(uint32_t block_num) const;
+    bool csum_verify_block(uint32_t block_num, const char* buffer);
+    bool csum_verify_inode(uint32_t inode_num, const Inode& inode);
+    void csum_report() const;  // 攒下的校验通过次数计入stats
+    void csum_seal_super();   // 写出超级块前更新校验字段
+    bool csum_check_super();  // 挂载时校验超级块
+
+    // 克隆与快照（见snapshot.h）
+    bool reject_read_only(const char* op) const;  // 只读挂载时报告并返回true
+    bool snap_check(const char* op) const;        // 已挂载、可写且启用了引用计数时返回true
+    bool snap_attach();    // 挂载时加载快照目录
+    bool snap_save();      // 写入快照目录
+    int snap_find(const std::string& name) const;
+    bool snap_load(const SnapEntry& snap, std::vector<Inode>& table);  // 读取快照的inode表
+    bool snap_refs(std::vector<uint32_t>& counts);  // 累加快照持有的块引用（按数据区相对下标）
+    bool read_inode_table(std::vector<Inode>& table);  // 读取当前的整个inode区
 
 public:
     /**
@@ -104,8 +282,9 @@ public:
     ~DiskFS();
 
     // 磁盘操作
-    bool format();    // 格式化磁盘（初始化文件系统）
-    bool mount();     // 挂载磁盘（加载文件系统）
+    bool format(bool log_structured = false);  // 格式化磁盘（log_structured为true时使用日志结构布局）
+    bool mount(bool preload = false, bool read_only = false, bool shared = false);  // 挂载磁盘（preload为true时预读全部元数据；shared为true时只读挂载并使用跨进程共享的元数据）
+    bool mount_snapshot(const std::string& name);  // 只读挂载快照
     bool unmount();   // 卸载磁盘（保存并关闭）
 
     // 文件操作
@@ -119,8 +298,114 @@ public:
     // 信息查询
     void print_info();                // 打印磁盘信息
     bool isMounted() const { return is_mounted; }  // 判断是否已挂载
+    bool is_read_only() const { return read_only; }
 
     int get_file_size(int inode_num); // 新增：获取文件大小
+
+    // 统计信息（进程级计数器与延迟直方图，见io_stats.h）
+    StatsSnapshot get_stats() const;  // 获取统计快照
+    void reset_stats();               // 清零统计
+    void print_stats() const;         // 打印I/O计数与操作延迟分布
+
+    // I/O追踪（二进制追踪文件，可用replay_disk回放）
+    bool start_trace(const std::string& path);  // 开始追踪
+    uint64_t stop_trace();                      // 停止追踪，返回写入的记录数
+    bool is_tracing() const { return tracer.enabled(); }
+
+    // 设备时序模型（HDD/SSD延迟仿真，见device_model.h）
+    bool set_device_model(const std::string& kind, uint32_t param = 0, bool realtime = false);
+    const DeviceModel* device_model() const { return device.get(); }
+    uint64_t virtual_time_ns() const { return virtual_ns; }  // 虚拟时钟（累计模拟服务时间）
+
+    // I/O调度（写请求排队、排序与合并，见io_scheduler.h）
+    bool set_scheduler(const std::string& name, uint32_t max_depth = 0);
+    const SchedStats& scheduler_stats() const { return scheduler.stats(); }
+    void print_scheduler_stats() const;
+    void begin_batch();  // 开始批次：之后的块写排队，直到最外层end_batch
+    bool end_batch();    // 结束批次并派发
+
+    // 日志结构布局
+    bool is_log_structured() const { return log != nullptr; }
+    const LogStats* log_stats() const { return log ? &log->st : nullptr; }
+    const LogState* log_state() const { return log.get(); }
+    uint32_t clean_segments(uint32_t count);  // 手动清理段，返回清理的段数
+    void print_log_info() const;
+
+    // 碎片报告与在线整理
+    FragReport frag_report();       // 统计各文件与空闲空间的区段
+    void print_frag_report();
+    int defrag(const std::string& name = "", uint32_t budget = 0);  // 整理指定文件或全部文件（budget为本次最多搬移块数，0不限），返回搬移块数
+    const DefragStats& defrag_stats() const { return defrag_st; }
+
+    // 一致性检查（见fsck.h）
+    bool fsck(FsckReport& rep, bool repair = false, uint32_t threads = 0);  // repair为true时就地修复
+
+    // 快速挂载
+    const MetaStats* meta_stats() const { return meta ? &meta->st : nullptr; }
+    void print_meta_info() const;
+
+    // 条带化：members为0号镜像之外的成员路径（为空表示单镜像），在下次format时生效
+    bool set_stripe(const std::vector<std::string>& members, uint32_t unit_blocks);
+    const StripeSet* stripe_set() const { return stripe.get(); }
+    void print_stripe_info() const;
+
+    // 冷热分层：fast_path为空表示不分层，在下次format时生效；migrate_ms在挂载时生效
+    bool set_tier(const std::string& fast_path, uint32_t fast_blocks, uint32_t migrate_ms = TIER_MIGRATE_MS);
+    const TierSet* tier_set() const { return tier.get(); }
+    int tier_migrate();  // 立即执行一轮迁移，返回提升的块数
+    void print_tier_info() const;
+
+    // 跨进程共享只读挂载：mount(false, true, true)
+    const SharedMeta* shared_meta() const { return shared.get(); }
+    void print_shared_info() const;
+
+    // 多队列块层：hw_queues为0表示关闭；挂载时生效，已挂载时立即切换
+    bool set_block_mq(uint32_t hw_queues, uint32_t depth = MQ_DEFAULT_DEPTH);
+    const BlockMq* block_mq() const { return mq.get(); }
+    void print_mq_info() const;
+
+    // 延迟块分配：写入时只预留空闲计数，回写时一次分配连续区段
+    bool set_delalloc(bool on);
+    bool delalloc_flush(int inode_num = -1);  // 回写脏页（-1表示全部文件）
+    const DelallocCache* delalloc_cache() const { return delalloc.get(); }
+    void print_delalloc_info() const;
+
+    // 透明压缩：set_compress设置新建文件的默认值，compress_file转换已有文件
+    bool set_compress(bool on);
+    bool compress_file(const std::string& name, bool on);
+    const CompressStats& compress_stats() const { return compress_st; }
+    void print_compress_info() const;
+
+    // 块去重与块引用计数：在下次format时生效（set_dedup同时启用引用计数）
+    void set_dedup(bool on);
+    void set_cow(bool on);
+    bool is_deduplicated() const { return dedup && (super_block.dedup_flags & DEDUP_INLINE); }
+    bool is_refcounted() const { return dedup != nullptr; }
+    const DedupIndex* dedup_index() const { return dedup.get(); }
+    void print_dedup_info() const;
+
+    // 块校验和：mode为0、CSUM_META或CSUM_META|CSUM_DATA，在下次format时生效
+    void set_checksums(uint32_t mode);
+    const ChecksumTable* checksum_table() const { return csum.get(); }
+    void print_csum_info() const;
+
+    // 写时复制的文件克隆与快照（需启用块引用计数）
+    int clone_file(const std::string& src, const std::string& dst);  // 返回新文件的inode，失败返回-1
+    bool snapshot_create(const std::string& name);
+    bool snapshot_delete(const std::string& name);
+    bool snapshot_rollback(const std::string& name);
+    std::vector<SnapEntry> list_snapshots() const;
+
+    // 主机文件批量导入/导出（见bulk_io.h）
+    bool import_path(const std::string& host_path, const std::string& dest, BulkStats& st, uint32_t threads = 0);
+    bool export_path(const std::string& src, const std::string& host_path, BulkStats& st, uint32_t threads = 0);
+
+    // 截断与预分配：truncate_file返回释放的块数，fallocate_file返回新预留的块数，失败返回-1
+    int truncate_file(int inode_num, uint32_t new_size);
+    int fallocate_file(int inode_num, uint32_t offset, uint32_t len);
+
+    // 紧凑镜像打包（见image_pack.h）：只导出元数据与已分配的块，导入见import_image
+    bool export_image(const std::string& pack_path, bool compress, PackStats& st);
 };
 
 #endif // DISK_FS_H
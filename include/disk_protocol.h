@@ -0,0 +1,67 @@
+#ifndef DISK_PROTOCOL_H
+#define DISK_PROTOCOL_H
+
+#include <cstdint>
+#include "disk_fs.h"
+
+/**
+ * 守护进程与客户端之间的二进制协议（Unix域套接字，本机字节序）
+ * - 请求：DaemonRequest头 + length字节负载（仅WRITE携带负载）
+ * - 应答：DaemonResponse头 + length字节负载（READ返回数据，LIST返回DaemonListEntry数组）
+ * - 同一连接上的请求按发送顺序应答，id原样带回
+ */
+
+const uint32_t DAEMON_MAGIC = 0x314B5344;             // "DSK1"
+const uint32_t DAEMON_MAX_PAYLOAD = 16 * BLOCK_SIZE;  // 单次请求/应答负载上限（单文件上限）
+
+/**
+ * @brief 请求类型
+ */
+enum DaemonOp
+{
+    DOP_PING = 1,      // 空操作，用于探测连接
+    DOP_CREATE,        // 创建文件：name -> inode
+    DOP_OPEN,          // 打开文件：name -> inode
+    DOP_DELETE,        // 删除文件：name -> 0
+    DOP_READ,          // 读取：inode/offset/length -> 读取字节数 + 数据
+    DOP_WRITE,         // 写入：inode/offset/length + 数据 -> 写入字节数
+    DOP_LIST,          // 列出文件 -> 文件数 + DaemonListEntry数组
+    DOP_SET_CLASS      // 切换本连接的QoS类别：name -> 0，类别不存在返回-1
+};
+
+/**
+ * @brief 请求头
+ */
+struct DaemonRequest
+{
+    uint32_t magic;           // DAEMON_MAGIC
+    uint16_t op;              // DaemonOp
+    uint16_t reserved;
+    uint32_t id;              // 客户端请求编号，应答中原样带回
+    uint32_t inode;           // READ/WRITE的inode编号
+    uint32_t offset;          // READ/WRITE的文件内偏移
+    uint32_t length;          // READ的请求字节数；WRITE的负载字节数
+    char name[MAX_FILENAME];  // CREATE/OPEN/DELETE的文件名；SET_CLASS的类别名
+};
+
+/**
+ * @brief 应答头
+ */
+struct DaemonResponse
+{
+    uint32_t magic;           // DAEMON_MAGIC
+    uint32_t id;              // 对应请求的id
+    int32_t status;           // 与DiskFS接口返回值一致，失败为-1
+    uint32_t length;          // 负载字节数
+};
+
+/**
+ * @brief LIST应答中的一项
+ */
+struct DaemonListEntry
+{
+    uint32_t inode_num;
+    char name[MAX_FILENAME];
+};
+
+#endif // DISK_PROTOCOL_H
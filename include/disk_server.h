@@ -0,0 +1,120 @@
+#ifndef DISK_SERVER_H
+#define DISK_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "disk_protocol.h"
+#include "qos.h"
+
+/**
+ * 本机多客户端守护进程
+ * - 挂载一次镜像，通过Unix域套接字为多个客户端服务（协议见disk_protocol.h）
+ * - 事件循环（epoll）负责接受连接、读取并切分请求、发送应答；不做文件系统操作
+ * - 工作线程池从请求队列一次取走所有排队请求（最多DAEMON_MAX_BATCH个），
+ *   在一个I/O批次内执行，多个客户端的块写一起交给调度器排序合并
+ * - DiskFS不是线程安全的，工作线程持同一把锁、按取出顺序执行批次，同一连接同一类别的应答保持请求顺序；
+ *   统计与唤醒在锁外进行，完成的应答经eventfd唤醒事件循环发送
+ * - 请求按连接所属的QoS类别排队（见qos.h），取批次时由QosScheduler按权重与限流决定顺序；
+ *   连接默认属于"default"类别，用DOP_SET_CLASS切换
+ */
+
+const uint32_t DAEMON_MAX_BATCH = 64;  // 一个批次最多包含的请求数
+
+/**
+ * @brief 守护进程统计
+ */
+struct ServerStats
+{
+    uint64_t connections;     // 累计接受的连接数
+    uint64_t requests;        // 执行的请求数
+    uint64_t failed;          // 返回失败的请求数
+    uint64_t batches;         // 执行的批次数
+    uint64_t max_batch;       // 最大批次的请求数
+    uint64_t protocol_errors; // 因协议错误关闭的连接数
+};
+
+class DiskServer
+{
+public:
+    /**
+     * @param disk 已挂载的文件系统
+     * @param socket_path Unix域套接字路径（已存在时先删除）
+     * @param workers 工作线程数（0表示按CPU核数，最多8个）
+     */
+    DiskServer(DiskFS& disk, const std::string& socket_path, uint32_t workers = 0);
+    ~DiskServer();
+
+    bool set_qos(const std::vector<QosClassConfig>& classes);  // 配置QoS类别（start之前调用）
+    bool start();   // 监听套接字并启动工作线程
+    void run();     // 运行事件循环，直到stop()
+    void stop();    // 请求停止（可在信号处理函数或其他线程中调用）
+
+    ServerStats stats();
+    void print_stats();
+
+private:
+    struct Job
+    {
+        uint64_t conn;              // 连接编号
+        uint32_t cls;               // QoS类别
+        uint64_t bytes;             // 读写字节数（QoS计费）
+        uint64_t enqueue_ns;        // 入队时间
+        DaemonRequest req;
+        std::vector<char> payload;
+    };
+    struct Reply
+    {
+        uint64_t conn;
+        std::vector<char> data;     // 应答头 + 负载
+    };
+    struct Connection
+    {
+        int fd;
+        std::vector<char> in;       // 未切分的请求字节
+        std::vector<char> out;      // 未发送的应答字节
+        size_t out_pos;
+        uint32_t cls;               // 当前QoS类别
+    };
+
+    DiskFS& disk;
+    std::string socket_path;
+    uint32_t worker_count;
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;                    // eventfd：应答就绪或请求停止
+    std::atomic<bool> stopping;
+
+    std::map<uint64_t, Connection> conns;  // 仅事件循环线程访问
+    uint64_t next_conn;
+
+    std::mutex job_mutex;
+    std::condition_variable job_cv;
+    QosScheduler qos;                          // job_mutex保护
+    std::vector<std::deque<Job>> class_jobs;   // 各QoS类别的请求队列（job_mutex保护）
+    std::mutex reply_mutex;
+    std::vector<Reply> replies;
+    std::mutex fs_mutex;
+    std::condition_variable fs_cv;
+    uint64_t next_batch;            // 下一个取出的批次序号（job_mutex保护）
+    uint64_t exec_batch;            // 下一个允许执行的批次序号（fs_mutex保护）
+    std::mutex stats_mutex;
+    ServerStats st;
+    std::vector<std::thread> workers;
+
+    void worker_loop();
+    void execute(const Job& job, Reply& reply);
+    void accept_clients();
+    bool read_client(uint64_t id, Connection& c);
+    bool flush_client(uint64_t id, Connection& c);
+    void deliver_replies();
+    void close_client(uint64_t id);
+};
+
+#endif // DISK_SERVER_H
@@ -0,0 +1,55 @@
+#ifndef FSCK_H
+#define FSCK_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 一致性检查（fsck）
+ * - 以大块顺序读读入整个inode区与两张位图，inode区按范围切分给多个线程并行扫描，
+ *   每个线程生成自己的块引用位图，合并时按64位字做与/或运算和popcount，统计跨线程的重复引用
+ * - 根目录的有效目录项决定哪些inode是活的；活inode的块指针决定哪些数据块被引用
+ * - 重建的引用位图与盘上位图逐字比较：盘上已用但无人引用的为孤儿，被引用但盘上空闲的为缺失
+ * - 修复时写回重建的位图与超级块计数，清除越界与重复的块指针、指向无效inode的目录项，并对孤儿块发discard
+ * - 去重与引用计数模式下块可被多次引用（克隆、快照）：不检查重复引用，改为逐块比较实际引用数与去重表的引用计数，修复时按实际引用数重写
+ */
+
+/**
+ * @brief 检查结果
+ */
+struct FsckReport
+{
+    uint32_t threads;           // 扫描使用的线程数
+    uint32_t inodes_scanned;    // 扫描的inode数
+    uint32_t live_inodes;       // 被目录引用的有效inode数（含根目录）
+    uint32_t referenced_blocks; // 被有效inode引用的数据块数
+    uint32_t bad_pointers;      // 超出数据区的块指针
+    uint32_t dup_blocks;        // 重复引用（同一块被多次引用时多出的引用数）
+    uint32_t refcount_errors;   // 去重模式下引用计数与实际引用数不符的块
+    uint32_t orphan_blocks;     // 位图已用但没有inode引用
+    uint32_t missing_blocks;    // 被引用但位图为空闲
+    uint32_t orphan_inodes;     // 位图已用但没有目录项引用
+    uint32_t missing_inodes;    // 被目录项引用但位图为空闲
+    uint32_t dangling_entries;  // 指向未使用inode的目录项
+    uint32_t sb_free_blocks;    // 超级块记录的空闲块数
+    uint32_t sb_free_inodes;    // 超级块记录的空闲inode数
+    uint32_t free_blocks;       // 由引用位图算出的空闲块数
+    uint32_t free_inodes;       // 由引用位图算出的空闲inode数
+    bool repaired;              // 是否已就地修复
+    double seconds;             // 检查耗时（秒）
+
+    uint32_t errors() const
+    {
+        return bad_pointers + dup_blocks + refcount_errors + orphan_blocks + missing_blocks + orphan_inodes + missing_inodes +
+               dangling_entries + (sb_free_blocks != free_blocks) + (sb_free_inodes != free_inodes);
+    }
+};
+
+// 位图字运算（按64位字处理，nbits之后的位忽略）
+uint64_t bitmap_popcount(const uint64_t* words, size_t nbits);
+// 统计只在a中置位的位数与只在b中置位的位数
+void bitmap_diff(const uint64_t* a, const uint64_t* b, size_t nbits, uint32_t& only_a, uint32_t& only_b);
+
+void print_fsck_report(const FsckReport& rep);  // 打印检查结果
+
+#endif // FSCK_H
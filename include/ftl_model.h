@@ -0,0 +1,96 @@
+#ifndef FTL_MODEL_H
+#define FTL_MODEL_H
+
+#include "device_model.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * 闪存转换层（FTL）模型：在SSD时序之上模拟逻辑页到物理页的映射
+ * - 写入总是追加到当前开放擦除块，覆盖写只使旧物理页失效
+ * - 空闲擦除块不足时前台垃圾回收：选出受害块，搬移有效页后擦除（GC停顿计入本次写的服务时间）
+ * - 受害块选择：贪心（有效页最少）或成本-收益（(1-u)/2u×年龄）
+ * - 磨损均衡：分配空闲块时取擦除次数最少的块；擦除次数差超过阈值时回收最冷的块（静态均衡）
+ * 只模拟元数据和时间，数据仍按逻辑地址原地保存在磁盘文件中
+ */
+
+/**
+ * @brief 垃圾回收受害块选择策略
+ */
+enum FtlGcPolicy
+{
+    FTL_GC_GREEDY,        // 有效页最少的块
+    FTL_GC_COST_BENEFIT   // 成本-收益：兼顾回收量与数据冷热
+};
+
+/**
+ * @brief FTL统计
+ */
+struct FtlStats
+{
+    uint64_t host_pages;      // 主机写入的页数
+    uint64_t flash_pages;     // 实际编程的页数（主机写 + GC搬移）
+    uint64_t gc_runs;         // 垃圾回收次数（每回收一个块计一次）
+    uint64_t gc_moved;        // GC搬移的有效页数
+    uint64_t gc_stall_ns;     // GC造成的前台停顿（纳秒）
+    uint64_t erases;          // 擦除次数
+    uint64_t wl_moves;        // 静态磨损均衡触发的回收次数
+    uint64_t trimmed;         // 被discard的页数
+};
+
+/**
+ * @brief 带FTL的固态硬盘模型
+ */
+class FtlModel : public DeviceModel
+{
+public:
+    /**
+     * @param logical_bytes 逻辑容量（字节）
+     * @param op_percent 预留空间（over-provisioning）占逻辑容量的百分比
+     * @param policy GC受害块选择策略
+     */
+    FtlModel(uint64_t logical_bytes, uint32_t op_percent, FtlGcPolicy policy);
+
+    const char* name() const override { return policy == FTL_GC_GREEDY ? "ftl" : "ftl-cb"; }
+    std::string describe() const override;
+    std::string report() const override;
+    uint64_t service(DeviceOp op, uint64_t offset, uint64_t length, uint64_t now_ns) override;
+    void discard(uint64_t offset, uint64_t length) override;
+
+    const FtlStats& stats() const { return st; }
+    double write_amplification() const;  // 实际编程页数 / 主机写入页数
+    void erase_range(uint32_t& min_erase, uint32_t& max_erase, double& avg_erase) const;
+
+private:
+    void program_page(uint32_t lpn);   // 把逻辑页写入当前开放块
+    uint32_t take_free_block();        // 取擦除次数最少的空闲块
+    int pick_victim();                 // 按策略选择GC受害块
+    uint64_t collect();                // 回收一个块，返回耗时
+
+    static const uint32_t PAGES_PER_BLOCK = 64;  // 每个擦除块的页数（256KB）
+    static const uint32_t GC_RESERVE = 2;        // 空闲块不多于此数时触发GC
+    static const uint32_t WL_THRESHOLD = 32;     // 静态磨损均衡的擦除次数差阈值
+
+    FtlGcPolicy policy;
+    uint32_t op_percent;
+    uint32_t logical_pages;
+    uint32_t physical_blocks;
+    uint64_t read_ns;
+    uint64_t program_ns;
+    uint64_t erase_ns;
+
+    std::vector<int32_t> l2p;            // 逻辑页 -> 物理页（-1表示未映射）
+    std::vector<int32_t> p2l;            // 物理页 -> 逻辑页（-1表示无效）
+    std::vector<uint32_t> blk_valid;     // 各块有效页数
+    std::vector<uint32_t> blk_written;   // 各块已编程页数
+    std::vector<uint32_t> blk_erase;     // 各块擦除次数
+    std::vector<uint64_t> blk_stamp;     // 各块最后写入序号（成本-收益策略的年龄）
+    std::vector<uint32_t> free_blocks;   // 空闲块列表
+    int32_t active;                      // 当前开放块（-1表示无）
+    uint64_t write_seq;
+    std::vector<uint64_t> busy_until;    // 各通道空闲时刻（虚拟时间）
+    FtlStats st;
+};
+
+#endif // FTL_MODEL_H
@@ -0,0 +1,66 @@
+#ifndef IMAGE_PACK_H
+#define IMAGE_PACK_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * 紧凑镜像打包（export-image / import-image，仅单镜像的原地布局）
+ * - 导出只包含元数据区（超级块、位图、inode区）、块位图中已分配的数据块与数据区之后的预留区
+ *   （快照目录、去重表、校验表）；按内存中的块位图找出已分配的连续区段，每次顺序读PACK_READ_BLOCKS块
+ * - 包文件：包头 + 块索引（每项记录起始块、原始长度、在包中的偏移、存放长度与CRC32C）+ 数据；
+ *   数据按PACK_CHUNK_BLOCKS块切分，可选LZ4块格式压缩，压缩后不变小的部分原样存放
+ * - 导入按包头记录的大小建立稀疏镜像，只写入索引中的块（其余为空洞，读出为0），逐项校验CRC32C；
+ *   先写入"<目标>.tmp"，全部校验通过并fsync后再rename替换目标，失败时原镜像不变；
+ *   导入时对已有的目标镜像加独占flock，镜像正被挂载时拒绝
+ */
+
+const char PACK_MAGIC[8] = "SIMPAK1";
+const uint32_t PACK_CHUNK_BLOCKS = 16;   // 每个索引项的块数（压缩单位，64KB）
+const uint32_t PACK_READ_BLOCKS = 256;   // 导出时一次顺序读的块数（1MB）
+const uint32_t PACK_COMPRESSED = 0x1;    // PackHeader::flags：数据按索引项压缩
+
+/**
+ * @brief 包头（位于包文件开头，其后紧跟chunk_count个索引项）
+ */
+struct PackHeader
+{
+    char magic[8];            // "SIMPAK1"
+    uint32_t flags;           // PACK_COMPRESSED
+    uint32_t block_size;      // 块大小
+    uint64_t image_size;      // 原镜像文件字节数（导入时按此大小建立稀疏文件）
+    uint32_t chunk_count;     // 索引项数
+    uint32_t checksum;        // 包头（此字段按0计算）与索引的CRC32C
+};
+
+/**
+ * @brief 块索引项
+ */
+struct PackChunk
+{
+    uint32_t start_block;     // 起始块号
+    uint32_t raw_len;         // 原始字节数
+    uint64_t offset;          // 数据在包文件中的偏移
+    uint32_t stored_len;      // 存放字节数（等于raw_len表示原样存放）
+    uint32_t crc;             // 原始数据的CRC32C
+};
+
+/**
+ * @brief 打包统计
+ */
+struct PackStats
+{
+    uint64_t image_bytes;     // 镜像文件字节数
+    uint64_t blocks;          // 打包的块数
+    uint64_t pack_bytes;      // 包文件字节数
+    uint32_t runs;            // 连续区段数
+    uint32_t chunks;          // 索引项数
+    uint32_t read_ios;        // 导出时的顺序读次数
+    double seconds;           // 耗时（秒）
+};
+
+// 由包文件重建稀疏镜像（不需要挂载）
+bool import_image(const std::string& pack_path, const std::string& image_path, PackStats& st);
+void print_pack_stats(const char* what, const PackStats& st);
+
+#endif // IMAGE_PACK_H
@@ -0,0 +1,103 @@
+#ifndef IO_SCHEDULER_H
+#define IO_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/**
+ * I/O调度层：位于文件系统逻辑与磁盘文件之间的块写请求队列
+ * - 写请求先进入队列（同一块的重复写被吸收），批次结束或队列满时统一派发
+ * - 派发时按策略排序，并把块号相邻的请求合并为一次大的连续写
+ * - 读请求命中队列时直接返回队列中的最新数据
+ * - 派发失败时flush_io/end_batch返回false，write_file、unmount等排空队列的操作随之报告失败
+ * - 只有整块写（数据块、位图、目录块）进入队列；inode与超级块的写不排队、直接落盘，
+ *   因此批次内元数据可能先于排队的数据块落盘（顺序放宽，类似不带日志的ext2），
+ *   崩溃时inode可能指向尚未写入的块；需要严格顺序时关闭调度器（sched none）
+ */
+
+/**
+ * @brief 调度策略
+ */
+enum SchedPolicy
+{
+    IOSCHED_NONE,      // 不排队，直接写盘（默认）
+    IOSCHED_NOOP,      // 先进先出，只合并到达顺序上相邻的请求
+    IOSCHED_CLOOK,     // 电梯算法（C-LOOK）：从上次位置起按块号递增派发，到头后回绕
+    IOSCHED_DEADLINE   // 截止时间：超时的写先派发，其余按C-LOOK；读请求不等待排队的写
+};
+
+/**
+ * @brief 派发单元：一段连续块的合并写
+ */
+struct IoRun
+{
+    uint32_t start;           // 起始块号
+    uint32_t count;           // 连续块数
+    std::vector<char> data;   // count×BLOCK_SIZE字节的数据
+};
+
+/**
+ * @brief 调度统计
+ */
+struct SchedStats
+{
+    uint64_t queued;        // 进入队列的写请求数
+    uint64_t absorbed;      // 被后续同块写覆盖的请求数
+    uint64_t merged;        // 合并进相邻请求的请求数
+    uint64_t dispatched;    // 实际派发的I/O次数
+    uint64_t read_hits;     // 读请求命中队列的次数
+    uint64_t expired;       // deadline策略下超时派发的请求数
+    uint64_t drains;        // 派发批次数
+    uint64_t depth_sum;     // 各批次派发时的队列深度之和（用于平均队列深度）
+    uint64_t max_depth;     // 最大队列深度
+};
+
+/**
+ * @brief I/O调度器
+ */
+class IoScheduler
+{
+public:
+    IoScheduler();
+
+    void set_policy(SchedPolicy policy, uint32_t max_depth);
+    SchedPolicy policy() const { return pol; }
+    bool enabled() const { return pol != IOSCHED_NONE; }
+    bool reads_bypass() const { return pol == IOSCHED_DEADLINE; }  // 读是否优先于排队的写
+    bool empty() const { return pending.empty(); }
+    size_t depth() const { return pending.size(); }
+
+    void queue_write(uint32_t block, const char* data);   // 写请求入队
+    bool lookup(uint32_t block, char* out);               // 读请求查队列（命中时拷贝数据）
+    void cancel(uint32_t block);                          // 丢弃某块未派发的写（块已被释放）
+    bool should_dispatch() const;                         // 队列满或有请求超时
+    void drain(std::vector<IoRun>& runs);                 // 按策略排序、合并并清空队列
+
+    const SchedStats& stats() const { return st; }
+    void reset_stats();
+    static const char* policy_name(SchedPolicy policy);
+
+private:
+    struct Pending
+    {
+        uint64_t seq;             // 到达序号
+        uint64_t deadline_ns;     // 截止时间（steady_clock）
+        std::vector<char> data;
+    };
+
+    void append_run(std::vector<IoRun>& runs, uint32_t block, const Pending& req);
+
+    SchedPolicy pol;
+    uint32_t max_depth;                  // 队列深度上限，达到后立即派发
+    uint32_t max_merge;                  // 单次合并的最大块数
+    uint64_t write_expire_ns;            // deadline策略下写请求的超时时间
+    uint64_t next_seq;
+    uint64_t oldest_deadline;            // 队列中最早的截止时间
+    uint32_t head;                       // 上次派发结束的块号（C-LOOK起点）
+    std::map<uint32_t, Pending> pending; // 按块号排序的待派发写请求
+    SchedStats st;
+};
+
+#endif // IO_SCHEDULER_H
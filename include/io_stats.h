@@ -0,0 +1,127 @@
+#ifndef IO_STATS_H
+#define IO_STATS_H
+
+#include <cstdint>
+#include <chrono>
+
+/**
+ * I/O统计模块：进程级的计数器与延迟直方图
+ * - 每个线程独占一份计数槽，只有所属线程写入（无锁、无原子RMW），读取时汇总所有线程
+ * - 编译时定义DISKFS_NO_STATS可将所有统计代码完全编译掉（make STATS=0）
+ */
+
+/**
+ * @brief 被统计延迟的公共操作
+ */
+enum StatOp
+{
+    STAT_OP_FORMAT,
+    STAT_OP_MOUNT,
+    STAT_OP_UNMOUNT,
+    STAT_OP_CREATE,
+    STAT_OP_OPEN,
+    STAT_OP_READ,
+    STAT_OP_WRITE,
+    STAT_OP_DELETE,
+    STAT_OP_LIST,
+    STAT_OP_STAT,
+    STAT_OP_TRUNCATE,
+    STAT_OP_FALLOCATE,
+    STAT_OP_COUNT
+};
+
+/**
+ * @brief I/O计数器
+ */
+enum StatCounter
+{
+    STAT_BLOCK_READS,     // 块读取次数
+    STAT_BLOCK_WRITES,    // 块写入次数
+    STAT_BYTES_READ,      // 读取的字节数
+    STAT_BYTES_WRITTEN,   // 写入的字节数
+    STAT_BITMAP_SCANS,    // 位图扫描次数（查找空闲块/inode）
+    STAT_CACHE_HITS,      // 缓存命中次数
+    STAT_CACHE_MISSES,    // 缓存未命中次数
+    STAT_DEVICE_NS,       // 设备模型累计的模拟服务时间（纳秒）
+    STAT_CSUM_VERIFIED,   // 读时校验和比对通过的次数
+    STAT_CSUM_ERRORS,     // 读时校验和不符的次数
+    STAT_COUNTER_COUNT
+};
+
+// HDR风格的对数-线性直方图：每个2的幂区间细分为2^HIST_SUB_BITS个子桶（相对误差≤12.5%）
+const int HIST_SUB_BITS = 3;
+const int HIST_SUB_BUCKETS = 1 << HIST_SUB_BITS;
+const int HIST_BUCKETS = 64 * HIST_SUB_BUCKETS;
+
+/**
+ * @brief 延迟直方图（单位：纳秒）
+ */
+struct LatencyHistogram
+{
+    uint64_t buckets[HIST_BUCKETS];  // 各桶的样本数
+    uint64_t count;                  // 样本总数
+    uint64_t sum_ns;                 // 样本总和（用于计算平均值）
+
+    static int bucket_index(uint64_t ns);      // 计算样本所在的桶
+    static uint64_t bucket_upper(int idx);     // 桶的上界（分位数按上界报告）
+    uint64_t percentile(double p) const;       // 计算分位数（p取0~1）
+    uint64_t max() const;                      // 最大样本所在桶的上界
+};
+
+/**
+ * @brief 统计快照：某一时刻所有线程计数的汇总
+ */
+struct StatsSnapshot
+{
+    uint64_t counters[STAT_COUNTER_COUNT];
+    LatencyHistogram latency[STAT_OP_COUNT];         // 实际耗时
+    LatencyHistogram device_latency[STAT_OP_COUNT];  // 设备模型下的模拟服务时间
+};
+
+const char* stat_op_name(int op);            // 操作名称（如"create_file"）
+const char* stat_counter_name(int counter);  // 计数器名称（如"block_reads"）
+
+/**
+ * @brief 统计入口：记录计数与延迟，生成快照
+ */
+class IoStats
+{
+public:
+    static void add(StatCounter counter, uint64_t n);     // 累加计数器
+    static void record(StatOp op, uint64_t ns);           // 记录一次操作延迟
+    static void add_device_time(uint64_t ns);             // 累加当前操作的模拟服务时间
+    static void set_device_enabled(bool enabled);         // 是否按操作记录模拟服务时间
+    static void snapshot(StatsSnapshot& out);             // 汇总所有线程的统计（减去重置基线）
+    static void reset();                                  // 以当前值为基线清零
+};
+
+#ifndef DISKFS_NO_STATS
+
+/**
+ * @brief 操作计时器：构造时开始计时，析构时记录延迟
+ * 仅最外层操作被记录（如create_file内部调用list_files不会重复计数）
+ */
+class OpTimer
+{
+public:
+    explicit OpTimer(StatOp op);
+    ~OpTimer();
+
+private:
+    StatOp op;
+    bool outermost;
+    uint64_t device_start;  // 开始时本线程已累计的模拟服务时间
+    std::chrono::steady_clock::time_point start;
+};
+
+#define STATS_ADD(counter, n) IoStats::add((counter), (n))
+#define STATS_OP_TIMER(op) OpTimer stats_op_timer_(op)
+
+#else
+
+#define STATS_ADD(counter, n) ((void)0)
+#define STATS_OP_TIMER(op) ((void)0)
+
+#endif // DISKFS_NO_STATS
+
+#endif // IO_STATS_H
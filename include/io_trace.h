@@ -0,0 +1,141 @@
+#ifndef IO_TRACE_H
+#define IO_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+/**
+ * I/O追踪模块：记录块读写与公共文件操作，生成紧凑的二进制追踪文件
+ * 文件格式：TraceHeader + 若干TraceRecord（小端，定长24字节）
+ * 记录先写入线程私有缓冲区，缓冲区满后交给后台线程异步写盘
+ */
+
+const char TRACE_MAGIC[8] = "SIMTRC1";  // 追踪文件标识
+const uint32_t TRACE_VERSION = 2;       // 追踪文件格式版本（2：线程编号扩为16位）
+const uint32_t TRACE_NO_INODE = 0xFFFFFFFF;  // 记录不关联任何inode
+const uint16_t TRACE_THREAD_OVERFLOW = 0xFFFF;  // 一次追踪中登记的线程超过65535个时，其余线程共用此编号
+
+/**
+ * @brief 追踪记录的操作类型
+ */
+enum TraceOp
+{
+    TRACE_BLOCK_READ = 1,   // 块读取（block为块号）
+    TRACE_BLOCK_WRITE,      // 块写入（block为块号）
+    TRACE_CREATE,           // 创建文件（inode为新文件的inode）
+    TRACE_OPEN,             // 打开文件
+    TRACE_READ,             // 读文件（block为字节偏移，length为请求字节数）
+    TRACE_WRITE,            // 写文件（block为字节偏移，length为请求字节数）
+    TRACE_DELETE,           // 删除文件
+    TRACE_LIST,             // 列出目录
+    TRACE_TRUNCATE,         // 截断或扩展文件（block为新长度）
+    TRACE_FALLOCATE         // 预分配（block为字节偏移，length为字节数）
+};
+
+/**
+ * @brief 追踪文件头
+ */
+struct TraceHeader
+{
+    char magic[8];          // 追踪文件标识（"SIMTRC1"）
+    uint32_t version;       // 格式版本
+    uint32_t record_size;   // 每条记录的字节数（用于校验）
+};
+
+/**
+ * @brief 追踪记录（定长24字节）
+ */
+struct TraceRecord
+{
+    uint64_t timestamp_ns;  // 相对于追踪开始的时间（纳秒）；文件操作为操作开始时间
+    uint32_t block;         // 块操作为块号；文件读写为字节偏移
+    uint32_t length;        // 字节数
+    uint32_t inode;         // 关联的inode（块操作为所属公共操作的inode）
+    uint8_t op;             // 操作类型（TraceOp）
+    uint8_t reserved;       // 保留（对齐）
+    uint16_t thread;        // 发起记录的线程编号（按登记顺序分配，见TRACE_THREAD_OVERFLOW）
+};
+
+/**
+ * @brief I/O追踪器：线程私有缓冲 + 后台异步落盘
+ */
+class IoTracer
+{
+public:
+    IoTracer();
+    ~IoTracer();
+
+    bool start(const std::string& path);  // 开始追踪，写入文件头
+    void stop();                          // 停止追踪，刷出所有缓冲区并关闭文件
+    bool enabled() const { return active.load(std::memory_order_relaxed); }
+
+    // 追加一条记录：record取当前时间，record_at使用调用方给出的时间（如操作开始时刻）
+    void record(uint8_t op, uint32_t block, uint32_t length, uint32_t inode);
+    void record_at(uint8_t op, uint32_t block, uint32_t length, uint32_t inode, uint64_t timestamp_ns);
+    uint64_t now_ns() const;              // 当前相对时间
+    uint64_t records_written() const { return written.load(std::memory_order_relaxed); }
+
+    static uint32_t current_inode();      // 当前线程正在执行的公共操作所属inode
+
+private:
+    friend class TraceScope;
+
+    struct ThreadBuffer
+    {
+        std::mutex lock;                  // 仅在停止追踪时与汇总线程竞争
+        std::vector<TraceRecord> records;
+        uint16_t thread_id;
+    };
+
+    ThreadBuffer& local_buffer();
+    void enqueue(std::vector<TraceRecord>& batch);
+    void flush_loop();
+
+    std::atomic<bool> active;
+    std::atomic<uint64_t> written;
+    uint64_t generation;                  // 每次start递增，使线程局部缓存失效
+    uint64_t epoch_ns;                    // 追踪开始时刻（steady_clock）
+    FILE* out;
+
+    std::mutex buffers_lock;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+    std::mutex queue_lock;
+    std::condition_variable queue_cv;
+    std::deque<std::vector<TraceRecord>> queue;
+    bool stopping;
+    std::thread flusher;
+};
+
+/**
+ * @brief 公共操作的追踪范围：构造时记下开始时间并设置当前inode，析构时写入一条记录
+ * 范围内发生的块读写记录会关联到该inode
+ */
+class TraceScope
+{
+public:
+    TraceScope(IoTracer& tracer, uint8_t op, int inode, uint32_t offset, uint32_t length);
+    ~TraceScope();
+
+    void set_inode(int inode);  // 操作过程中才确定inode时（如create_file）更新
+
+private:
+    IoTracer& tracer;
+    bool active;
+    uint8_t op;
+    uint32_t inode;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t saved_inode;
+    uint64_t start_ns;
+};
+
+#endif // IO_TRACE_H
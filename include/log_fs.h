@@ -0,0 +1,112 @@
+#ifndef LOG_FS_H
+#define LOG_FS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/**
+ * 日志结构布局（format时选择）：镜像被组织为只追加的段日志
+ * - 0号块为超级块；随后是两个交替写入的检查点区；其余空间按段（64块）组成日志
+ * - 块（位图、目录、数据）与inode都不再有固定位置：写入先进入内存段缓冲，批次结束或缓冲满时
+ *   作为一次连续写追加到日志头部；inode按42个一块打包写入
+ * - inode映射（imap）记录每个inode在日志中的位置，块映射记录每个逻辑块在日志中的位置，
+ *   文件系统逻辑（位图分配、Inode::blocks）仍使用逻辑块号，与原地布局完全相同
+ * - 检查点保存两张映射表、段年龄表与超级块计数，卸载、清理后以及每写满若干段时写入；
+ *   挂载时选取序号最大且校验通过的检查点（不做前滚恢复，最后一个检查点之后的写入在崩溃后丢失）
+ * - 段清理器按成本-收益选择利用率低、数据冷的段，把其中仍有效的块与inode重新追加到日志后回收该段
+ */
+
+const char LOG_FS_MAGIC[8] = "SIMLFS1";            // 日志布局的超级块标识（原地布局为"SIMFSv1"）
+const uint32_t LOG_SEG_BLOCKS = 64;                 // 每段块数（256KB）
+const uint32_t LOG_UNMAPPED = 0xFFFFFFFFu;          // 映射表中的"未写入"
+const uint32_t LOG_INODES_PER_BLOCK = 4096 / 96;    // 每个日志inode块容纳的inode数（42）
+const uint32_t LOG_LOW_WATER = 4;                   // 干净段不多于此数时在写入前强制清理
+const uint32_t LOG_IDLE_WATER = 16;                 // 批次结束时干净段少于此数则顺带清理一段
+const uint32_t LOG_CKPT_INTERVAL = 16;              // 每写满多少段写一次检查点
+
+/**
+ * @brief 检查点头（位于检查点区第一个块，其后紧跟imap、块映射与段年龄表）
+ */
+struct LogCheckpoint
+{
+    char magic[8];            // "SIMCKP1"
+    uint64_t seq;             // 检查点序号（越大越新）
+    uint64_t write_seq;       // 日志写入序号（段年龄的时钟）
+    uint32_t head_seg;        // 日志头所在段
+    uint32_t head_off;        // 日志头在段内的块偏移
+    uint32_t checksum;        // 头部其余字段与映射表的FNV-1a校验和
+    uint32_t reserved;
+    char super_block[128];    // 检查点时刻的超级块（含空闲计数）
+};
+
+/**
+ * @brief 日志统计
+ */
+struct LogStats
+{
+    uint64_t appends;         // 追加写次数（每次为一段连续写）
+    uint64_t blocks_written;  // 追加的块数（含inode块）
+    uint64_t segments;        // 写满的段数
+    uint64_t cleaned;         // 清理回收的段数
+    uint64_t cleaner_moved;   // 清理器搬移的块与inode数
+    uint64_t checkpoints;     // 检查点次数
+};
+
+/**
+ * @brief 日志布局的内存状态（映射表、段使用情况与写缓冲），不做I/O
+ */
+class LogState
+{
+public:
+    LogState(uint32_t total_blocks, uint32_t total_inodes);
+
+    // 布局
+    uint32_t ckpt_blocks;             // 每个检查点区的块数
+    uint32_t log_start;               // 日志起始块号（按段对齐）
+    uint32_t segments;                // 段数
+
+    // 映射表（持久化到检查点）
+    std::vector<uint32_t> imap;       // inode -> 日志地址（块号×64+槽位）
+    std::vector<uint32_t> block_map;  // 逻辑块 -> 日志块号
+    std::vector<uint64_t> seg_age;    // 各段最后写入时的write_seq
+    uint64_t ckpt_seq;
+    uint64_t write_seq;
+    uint32_t head_seg;
+    uint32_t head_off;
+
+    // 由映射表重建的反向信息
+    std::vector<int32_t> owner;       // 日志块 -> 逻辑块（-1无效，-2 inode块）
+    std::vector<uint32_t> seg_live;   // 各段有效字节数
+    std::vector<uint8_t> seg_pending; // 自上次检查点以来才变空的段（检查点前不能重用）
+
+    // inode缓存（imap常驻内存，inode内容读过或写过一次后也常驻，读inode不再访问日志）
+    std::vector<char> inode_cache;    // total_inodes×INODE_SIZE字节
+    std::vector<uint8_t> inode_cached;
+
+    // 写缓冲
+    std::map<uint32_t, std::vector<char>> pending_blocks;
+    std::map<uint32_t, std::vector<char>> pending_inodes;
+
+    bool super_dirty;                 // 超级块计数已变化，待下次检查点保存
+    bool cleaning;                    // 清理进行中（避免递归清理）
+    uint32_t segs_since_ckpt;
+    LogStats st;
+
+    void rebuild();                                   // 由映射表重建owner与seg_live
+    void set_block(uint32_t logical, uint32_t phys);  // 更新块映射（phys为LOG_UNMAPPED表示丢弃）
+    void set_inode(uint32_t inode_num, uint32_t addr);
+    uint32_t clean_segments() const;                  // 可用的干净段数
+    int next_clean_segment() const;                   // 下一个可写的干净段（-1表示没有）
+    int pick_victim() const;                          // 成本-收益选择清理段
+    size_t pending_size() const;                      // 缓冲落盘需要的块数
+
+    static const int32_t OWNER_NONE = -1;
+    static const int32_t OWNER_INODE = -2;
+
+private:
+    void kill(uint32_t phys, uint32_t bytes);         // 旧位置失效
+};
+
+#endif // LOG_FS_H
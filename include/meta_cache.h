@@ -0,0 +1,108 @@
+#ifndef META_CACHE_H
+#define META_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * 快速挂载（仅原地布局）
+ * - 预读：挂载时用一次顺序读把位图与inode区（在磁盘上连续）读入内存，再读入根目录块；
+ *   之后这些元数据的读取直接命中内存，写入同时更新内存副本并照常写盘（写穿透）
+ * - 目录索引：文件名哈希 -> (目录项槽位, inode)，open/create查找文件名不再扫描目录
+ * - 分配提示：最小空闲数据块与最小空闲inode的下界，分配时从提示处开始扫描位图
+ * - 挂载检查点：干净卸载时把目录索引与分配提示写入0号块超级块之后的空闲区域；
+ *   下次挂载若检查点有效且标记为干净，直接加载而不必重建。挂载后立即清除干净标记，
+ *   崩溃或异常退出后的下一次挂载会回退到重建
+ */
+
+const char MOUNT_CKPT_MAGIC[8] = "SIMMNT1";
+const uint32_t MOUNT_CKPT_OFFSET = 512;       // 挂载检查点在0号块内的字节偏移（超级块之后）
+const uint32_t MOUNT_CKPT_MAX_ENTRIES = 128;  // 目录索引项上限（不少于根目录块的目录项数）
+
+/**
+ * @brief 目录索引项
+ */
+struct DirIndexEntry
+{
+    uint32_t hash;            // 文件名哈希（FNV-1a）
+    uint32_t slot;            // 目录项在根目录块中的下标
+    uint32_t inode_num;       // 对应的inode编号
+};
+
+/**
+ * @brief 挂载检查点（位于0号块的MOUNT_CKPT_OFFSET处）
+ */
+struct MountCheckpoint
+{
+    char magic[8];            // "SIMMNT1"
+    uint32_t clean;           // 1表示干净卸载后写入；挂载后清零
+    uint32_t checksum;        // 除checksum外全部字段的FNV-1a校验和
+    uint64_t mount_count;     // 累计挂载次数
+    uint32_t dir_block;       // 根目录块号
+    uint32_t block_hint;      // 最小空闲数据块下标的下界（相对数据区）
+    uint32_t inode_hint;      // 最小空闲inode编号的下界
+    uint32_t entry_count;     // 目录索引项数
+    DirIndexEntry entries[MOUNT_CKPT_MAX_ENTRIES];
+};
+
+/**
+ * @brief 快速挂载统计
+ */
+struct MetaStats
+{
+    bool preloaded;           // 是否预读了元数据
+    bool from_checkpoint;     // 目录索引与分配提示是否来自挂载检查点
+    uint64_t preload_bytes;   // 预读字节数
+    uint64_t preload_ios;     // 预读I/O次数
+    uint64_t block_hits;      // 块读命中内存副本的次数
+    uint64_t inode_hits;      // inode读命中内存副本的次数
+    uint64_t index_hits;      // 文件名查找命中目录索引的次数
+};
+
+/**
+ * @brief 挂载期间的元数据内存副本、目录索引与分配提示（不做I/O）
+ */
+class MetaCache
+{
+public:
+    /**
+     * @param first_block 预读区起始块（块位图）
+     * @param inode_start inode区起始块
+     * @param end_block 预读区结束块（数据区起始，不含）
+     */
+    MetaCache(uint32_t first_block, uint32_t inode_start, uint32_t end_block);
+
+    uint32_t first_block;
+    uint32_t inode_start;
+    uint32_t end_block;
+    std::vector<char> region;         // [first_block, end_block)的内存副本（预读后有效）
+    uint32_t dir_block;               // 根目录块号（0表示未知）
+    std::vector<char> dir_data;       // 根目录块的内存副本（预读后有效）
+    uint32_t block_hint;
+    uint32_t inode_hint;
+    uint64_t mount_count;
+    MetaStats st;
+
+    bool lookup_block(uint32_t block_num, char* buffer);          // 命中返回true
+    void update_block(uint32_t block_num, const char* buffer);    // 写穿透：更新内存副本与目录索引
+    bool lookup_inode(uint32_t inode_num, char* buffer, size_t len);
+    void update_inode(uint32_t inode_num, const char* buffer, size_t len);
+
+    void index_dir(const char* dir);  // 由根目录块重建目录索引
+    // 按文件名查找：候选项需用目录块内容确认（哈希可能冲突），返回槽位，未找到返回-1
+    int find(const std::string& name, const char* dir, uint32_t& inode_num);
+
+    void save(MountCheckpoint& ckpt) const;  // 生成检查点（不含magic/clean/checksum）
+    void load(const MountCheckpoint& ckpt);  // 从检查点恢复目录索引与分配提示
+
+    static uint32_t name_hash(const char* name);
+    static uint32_t checksum(const MountCheckpoint& ckpt);
+
+private:
+    std::unordered_multimap<uint32_t, DirIndexEntry> index;
+};
+
+#endif // META_CACHE_H
@@ -0,0 +1,113 @@
+#ifndef QOS_H
+#define QOS_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "io_stats.h"
+
+/**
+ * 按I/O类别的服务质量控制（守护进程中使用，不做I/O）
+ * - 每个类别有权重和可选的IOPS/带宽上限；0号类别"default"总是存在
+ * - 上限用令牌桶实现：令牌不足时该类别的请求暂缓派发，允许透支一个请求，长期速率严格等于上限
+ * - 类别之间用起始时间公平排队（SFQ）：请求入队时打上虚拟起始/结束标签，
+ *   代价为字节数加固定的单次操作代价，除以权重；派发时选起始标签最小且未被限流的类别
+ * - 同一类别内先进先出；按类别统计请求数、字节数、被限流次数与排队+执行延迟
+ */
+
+const uint64_t QOS_OP_COST = 4096;     // 每个请求的固定代价（字节），使元数据操作也参与公平分配
+const double QOS_BURST_SECONDS = 0.1;  // 令牌桶容量：上限速率下100ms的量
+
+/**
+ * @brief 类别配置
+ */
+struct QosClassConfig
+{
+    std::string name;
+    uint32_t weight;          // 权重（≥1）
+    uint64_t iops_limit;      // 每秒请求数上限（0表示不限）
+    uint64_t bytes_limit;     // 每秒字节数上限（0表示不限）
+};
+
+/**
+ * @brief 类别统计
+ */
+struct QosClassStats
+{
+    uint64_t requests;        // 完成的请求数
+    uint64_t bytes;           // 完成的读写字节数
+    uint64_t throttled;       // 因令牌不足而延后派发的请求数（每个请求最多计一次）
+    LatencyHistogram latency; // 入队到完成的延迟
+};
+
+/**
+ * @brief 令牌桶（rate为0表示不限）
+ */
+class TokenBucket
+{
+public:
+    TokenBucket() : rate(0), burst(0), tokens(0), last_ns(0) {}
+    explicit TokenBucket(uint64_t rate);
+
+    bool ready(uint64_t now_ns);                  // 令牌余额为正时可以派发
+    void take(uint64_t amount);                   // 扣除令牌（可透支）
+    uint64_t wait_ns(uint64_t now_ns);            // 余额回正还需等待的时间
+
+private:
+    double rate;              // 每秒补充的令牌数
+    double burst;             // 桶容量
+    double tokens;            // 当前余额
+    uint64_t last_ns;         // 上次补充的时间
+
+    void refill(uint64_t now_ns);
+};
+
+/**
+ * @brief 多类别加权公平调度器：只决定下一个请求出自哪个类别，请求本身由调用者按类别排队
+ */
+class QosScheduler
+{
+public:
+    QosScheduler();
+    explicit QosScheduler(const std::vector<QosClassConfig>& classes);  // 未配置"default"时自动加在0号
+
+    int find_class(const std::string& name) const;  // 未找到返回-1
+    size_t class_count() const { return classes.size(); }
+    const QosClassConfig& config(uint32_t cls) const { return classes[cls].cfg; }
+    const QosClassStats& stats(uint32_t cls) const { return classes[cls].st; }
+
+    void enqueue(uint32_t cls, uint64_t bytes);  // 记录一个入队请求（bytes为读写字节数）
+    // 选择下一个派发的类别并扣除令牌；没有可派发的请求返回-1，若因限流则wait_ns为最短等待时间
+    int dequeue(uint64_t now_ns, uint64_t& wait_ns);
+    void complete(uint32_t cls, uint64_t bytes, uint64_t latency_ns);  // 记录一个完成的请求
+    size_t queued() const { return total_queued; }
+
+    void print_stats() const;
+
+private:
+    struct Tag
+    {
+        uint64_t bytes;
+        double start;         // 虚拟起始标签
+        bool throttled;       // 已计入throttled（队首请求可能被多次轮询）
+    };
+    struct ClassState
+    {
+        QosClassConfig cfg;
+        TokenBucket iops;
+        TokenBucket bandwidth;
+        std::deque<Tag> tags;
+        double last_finish;   // 最后一个入队请求的虚拟结束标签
+        QosClassStats st;
+    };
+
+    std::vector<ClassState> classes;
+    double vtime;             // 虚拟时间：最近派发请求的起始标签
+    size_t total_queued;
+};
+
+// 解析类别配置，如"interactive:8,bulk:1:500:20"（名称:权重[:IOPS上限[:MB/s上限]]）
+bool parse_qos_spec(const std::string& spec, std::vector<QosClassConfig>& out);
+
+#endif // QOS_H
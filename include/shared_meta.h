@@ -0,0 +1,108 @@
+#ifndef SHARED_META_H
+#define SHARED_META_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "meta_cache.h"
+
+/**
+ * 跨进程共享只读挂载（mount shared，仅原地布局）
+ * - 多个分析进程只读挂载同一镜像时，位图、inode区、根目录块与按哈希排序的目录索引放在一个POSIX共享内存段中，
+ *   由第一个挂载的进程读盘构建，之后的进程映射同一段直接使用：N个读者的元数据内存与挂载耗时约等于一个
+ * - 共享段按镜像文件的设备号与inode号命名，段头记录镜像指纹（超级块CRC32C、文件大小与修改时间），
+ *   指纹不符时（镜像在两次共享挂载之间被修改过）重新构建；构建与挂载登记在段上加flock，读取不加锁
+ * - 读取按序号校验（seqlock）：构建期间序号为奇数；读者复制数据前后序号不变且等于挂载时的值才采用，
+ *   序号变化说明挂载后段被重建（有不遵守锁的写者），改从磁盘读取并计数
+ * - 与写者互斥：可写挂载与格式化对镜像加独占flock，只读挂载加共享flock，存在共享读者时写者被拒绝，
+ *   反之亦然；可写挂载成功后删除旧的共享段
+ */
+
+const char SHARED_MAGIC[8] = "SIMSHM1";
+const uint32_t SHARED_READ_RETRIES = 64;   // 读到正在构建的段时的最大重试次数
+
+/**
+ * @brief 共享段头（其后依次为元数据区副本与根目录块副本）
+ */
+struct SharedHeader
+{
+    char magic[8];                    // "SIMSHM1"（构建完成后写入）
+    std::atomic<uint32_t> seq;        // 序号：偶数表示内容稳定，奇数表示正在构建
+    std::atomic<uint32_t> attaches;   // 累计挂载的读者数
+    uint64_t stamp;                   // 镜像指纹
+    uint32_t first_block;             // 元数据区起始块（块位图）
+    uint32_t inode_start;             // inode区起始块
+    uint32_t end_block;               // 元数据区结束块（数据区起始，不含）
+    uint32_t dir_block;               // 根目录块号
+    uint32_t entry_count;             // 目录索引项数
+    uint32_t builds;                  // 构建次数
+    DirIndexEntry entries[MOUNT_CKPT_MAX_ENTRIES];  // 目录索引（按哈希升序）
+};
+
+/**
+ * @brief 共享只读挂载统计（本进程）
+ */
+struct SharedStats
+{
+    bool built;               // 本进程挂载时构建了共享段（否则复用其他进程构建的段）
+    uint64_t block_hits;      // 块读命中共享段的次数
+    uint64_t inode_hits;      // inode读命中共享段的次数
+    uint64_t index_hits;      // 文件名查找命中共享目录索引的次数
+    uint64_t retries;         // 遇到正在构建的段而重试的次数
+    uint64_t stale;           // 段在挂载后被重建、改从磁盘读取的次数
+};
+
+/**
+ * @brief 映射到本进程的共享元数据段
+ */
+class SharedMeta
+{
+public:
+    /**
+     * @param block_size 块大小
+     * @param first_block 元数据区起始块
+     * @param inode_start inode区起始块
+     * @param end_block 元数据区结束块（不含）
+     */
+    SharedMeta(uint32_t block_size, uint32_t first_block, uint32_t inode_start, uint32_t end_block);
+    ~SharedMeta();
+
+    // 读盘填充元数据区与根目录块，返回根目录块号；失败返回false
+    typedef std::function<bool(char* region, char* dir, uint32_t& dir_block)> Loader;
+
+    // 打开（必要时创建）共享段；段无效或指纹不符时调用loader构建
+    bool attach(const std::string& name, uint64_t stamp, const Loader& loader);
+    bool lookup_block(uint32_t block_num, char* buffer);
+    bool lookup_inode(uint32_t inode_num, char* buffer, size_t len);
+    // 按文件名查找：找到返回目录项槽位，不存在返回-1，段已失效返回-2（调用方改从磁盘查找）
+    int find(const std::string& name, uint32_t& inode_num);
+
+    const std::string& name() const { return seg_name; }
+    size_t bytes() const { return seg_size; }
+    uint32_t readers() const { return header ? header->attaches.load() : 0; }
+    SharedStats st;
+
+    static std::string segment_name(const std::string& image_path);  // 镜像不存在返回空串
+    static void remove(const std::string& image_path);                // 删除镜像对应的共享段
+
+private:
+    uint32_t block_size;
+    uint32_t first_block;
+    uint32_t inode_start;
+    uint32_t end_block;
+    std::string seg_name;
+    int fd;
+    size_t seg_size;
+    SharedHeader* header;
+    char* region;             // 元数据区副本
+    char* dir;                // 根目录块副本
+    uint32_t attach_seq;      // 挂载时的序号
+
+    bool begin_read(uint32_t& seq);
+    bool end_read(uint32_t seq);
+    bool read_consistent(const char* src, char* out, size_t len);
+};
+
+#endif // SHARED_META_H
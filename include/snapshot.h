@@ -0,0 +1,45 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+
+/**
+ * 写时复制的文件克隆与快照（需以cow或dedup格式化，依赖去重表中的块引用计数，见dedup.h）
+ * - clone：新文件复制源文件的块指针，每个数据块引用加1，不读写数据；之后任一方覆盖共享块时
+ *   write_file写时复制到新块（压缩文件的簇同样在写入时复制）
+ * - snapshot create：把整个inode区与根目录块复制到新分配的数据块，快照对所有文件的数据块各持有一个引用，
+ *   数据本身不复制；快照目录（名称、时间、元数据块号）保存在数据区之后预留的一块中，创建/删除后立即写入
+ * - snapshot rollback：当前的inode区与根目录换成快照的副本，只调整引用计数，不复制数据；快照本身保留
+ * - mount snapshot：只读挂载快照，inode从快照的inode表读取，文件名在快照的根目录副本中查找
+ * - 异常退出后重建引用计数、以及fsck统计引用时，快照持有的块（元数据块与其inode表引用的数据块）一并计入
+ */
+
+const char SNAP_MAGIC[8] = "SIMSNP1";
+const uint32_t SNAP_MAX = 16;                                // 快照数上限
+const uint32_t SNAP_NAME_LEN = 28;                           // 快照名长度（含终止符）
+const uint32_t SNAP_INODE_BLOCKS = 24;                       // inode区的块数（1024个inode × 96字节）
+const uint32_t SNAP_META_BLOCKS = SNAP_INODE_BLOCKS + 1;     // 每个快照的元数据块：inode区副本 + 根目录副本
+
+/**
+ * @brief 快照目录项
+ */
+struct SnapEntry
+{
+    char name[SNAP_NAME_LEN];         // 快照名
+    uint32_t valid;                   // 1表示槽位在用
+    uint32_t files;                   // 创建时的文件数
+    int64_t create_time;              // 创建时间（时间戳）
+    uint32_t meta[SNAP_META_BLOCKS];  // 前SNAP_INODE_BLOCKS块为inode区副本，最后一块为根目录副本
+};
+
+/**
+ * @brief 快照目录（占一块，位于超级块snap_block处）
+ */
+struct SnapCatalog
+{
+    char magic[8];                    // "SIMSNP1"
+    uint32_t reserved[2];
+    SnapEntry entries[SNAP_MAX];
+};
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,118 @@
+#ifndef STRIPE_H
+#define STRIPE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 多镜像条带化后端
+ * - 逻辑地址空间按条带单元（若干块）轮流分布到N个成员文件：
+ *   第s个单元位于成员 s%N 的第 s/N 个单元处；0号成员即DiskFS构造时给出的镜像文件
+ * - 超级块记录条带数与单元大小，0号块内的条带表记录其余成员的路径与条带集编号；
+ *   每个成员文件在数据区之后有一个标签（集编号、成员序号），挂载时据此校验成员是否配套
+ * - 跨多个成员的读写拆成按成员的子I/O，由各成员的工作线程并行执行（pread/pwrite）；
+ *   只落在一个成员上的I/O在调用线程直接执行
+ */
+
+const char STRIPE_MAGIC[8] = "SIMSTR1";
+const uint32_t STRIPE_TABLE_OFFSET = 2560;  // 条带表在0号块内的字节偏移（挂载检查点之后）
+const uint32_t STRIPE_MAX_MEMBERS = 8;      // 成员文件数上限
+const uint32_t STRIPE_PATH_MAX = 160;       // 成员路径最大长度（含终止符）
+
+/**
+ * @brief 条带表（位于0号块的STRIPE_TABLE_OFFSET处）
+ */
+struct StripeTable
+{
+    char magic[8];            // "SIMSTR1"
+    uint32_t count;           // 成员数
+    uint32_t unit_blocks;     // 条带单元（块）
+    uint64_t set_id;          // 条带集编号（格式化时生成）
+    char paths[STRIPE_MAX_MEMBERS][STRIPE_PATH_MAX];  // 各成员路径（0号成员为空，使用挂载时给出的路径）
+};
+
+/**
+ * @brief 成员标签（位于每个成员文件的数据区之后）
+ */
+struct StripeLabel
+{
+    char magic[8];            // "SIMSTR1"
+    uint64_t set_id;          // 所属条带集
+    uint32_t index;           // 成员序号
+    uint32_t count;           // 成员数
+    uint32_t unit_blocks;     // 条带单元（块）
+    uint32_t reserved;
+};
+
+/**
+ * @brief 条带集：打开的成员文件与并行I/O
+ */
+class StripeSet
+{
+public:
+    /**
+     * @param block_size 块大小
+     * @param unit_blocks 条带单元（块）
+     * @param total_blocks 逻辑总块数（决定每个成员的数据区大小）
+     */
+    StripeSet(uint32_t block_size, uint32_t unit_blocks, uint64_t total_blocks);
+    ~StripeSet();
+
+    // 打开全部成员；create为true时创建并设置文件大小、写入标签，否则校验标签
+    bool open(const std::vector<std::string>& paths, uint64_t set_id, bool create);
+    bool read(uint64_t pos, char* buffer, size_t len);
+    bool write(uint64_t pos, const char* buffer, size_t len);
+
+    uint32_t count() const { return (uint32_t)members.size(); }
+    uint32_t unit_blocks() const { return unit; }
+    uint64_t member_bytes() const { return member_size; }
+    uint64_t parallel_ios() const { return parallel; }   // 拆分到多个成员并行执行的I/O数
+    uint64_t member_ios(uint32_t i) const { return members[i]->ios; }
+    const std::string& member_path(uint32_t i) const { return members[i]->path; }
+
+private:
+    struct Segment
+    {
+        uint64_t offset;      // 成员内偏移
+        char* buf;
+        size_t len;
+    };
+    struct Member
+    {
+        int fd;
+        std::string path;
+        uint64_t ios;                 // 子I/O数
+        std::thread worker;
+        std::deque<std::vector<Segment>> tasks;
+        std::vector<Segment> pending; // 本次拆分到该成员的子I/O
+    };
+
+    uint32_t block_size;
+    uint32_t unit;
+    uint64_t unit_bytes;
+    uint64_t total_blocks;
+    uint64_t member_size;     // 每个成员的数据区字节数（open时按成员数计算）
+    uint64_t parallel;
+    std::vector<Member*> members;
+
+    std::mutex mutex;
+    std::condition_variable task_cv;
+    std::condition_variable done_cv;
+    bool writing;             // 当前并行批次的方向（mutex保护）
+    size_t outstanding;       // 未完成的成员任务数
+    bool failed;              // 本批次是否有子I/O失败
+    bool stopping;
+
+    bool io(uint64_t pos, char* buffer, size_t len, bool is_write);
+    bool run_segments(int fd, const std::vector<Segment>& segs, bool is_write);
+    void worker_loop(Member* m);
+    void close_all();
+};
+
+#endif // STRIPE_H
@@ -0,0 +1,140 @@
+#ifndef TIER_H
+#define TIER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 冷热分层后端（仅原地布局，不与条带化同时使用）
+ * - 快速层文件（tmpfs/NVMe上的小文件）与容量层文件（DiskFS构造时给出的镜像）组成一个逻辑地址空间
+ * - 元数据区（超级块、两张位图、inode区）与根目录块固定在快速层，容量层不保存它们的最新内容；
+ *   容量层的0号块只在格式化结束与卸载时写入一份引导副本，挂载时据此找到快速层
+ * - 其余数据块按访问热度（每次读写加1，每轮迁移后减半）在两层之间迁移：快速层有固定数量的槽位，
+ *   热块提升到空闲槽位，槽位用尽时替换明显更冷的驻留块；驻留块的写只写快速层，降级时写回容量层
+ * - 槽位映射在每次迁移时立即写入快速层的映射表，异常退出后照常使用（热度从0重新统计）
+ * - 后台迁移线程按间隔执行迁移，也可用tier migrate立即执行一轮；块被释放时直接腾出其槽位
+ * - 设置了设备模型时，快速层上的I/O按SSD模型计时，容量层按设置的模型计时；后台迁移不计入前台时钟
+ */
+
+const char TIER_MAGIC[8] = "SIMTIR1";
+const uint32_t TIER_INFO_OFFSET = 3864;      // 分层信息在0号块内的字节偏移（条带表之后）
+const uint32_t TIER_PATH_MAX = 200;          // 快速层路径最大长度（含终止符）
+const uint32_t TIER_PROMOTE_HEAT = 4;        // 提升到快速层所需的最低热度
+const uint32_t TIER_MOVES_PER_PASS = 64;     // 每轮最多迁移的块数
+const uint32_t TIER_MIGRATE_MS = 200;        // 后台迁移的默认间隔（毫秒，0表示不启动后台线程）
+
+/**
+ * @brief 分层信息（位于0号块的TIER_INFO_OFFSET处）
+ */
+struct TierInfo
+{
+    char magic[8];            // "SIMTIR1"
+    uint64_t set_id;          // 分层集编号（格式化时生成，与快速层表头一致）
+    char fast_path[TIER_PATH_MAX];
+};
+
+/**
+ * @brief 快速层映射表头（位于快速层固定区之后，其后紧跟每个槽位一项：驻留的块号，0表示空闲）
+ */
+struct TierHeader
+{
+    char magic[8];            // "SIMTIR1"
+    uint64_t set_id;
+    uint32_t clean;           // 1表示干净卸载后写入；挂载后清零（为0时全部驻留块按脏块处理）
+    uint32_t pinned_blocks;   // 固定在快速层的块数（逻辑块[0, pinned_blocks)）
+    uint32_t slots;           // 热块槽位数
+    uint32_t reserved;
+};
+
+/**
+ * @brief 分层统计
+ */
+struct TierStats
+{
+    uint64_t fast_ios;        // 快速层子I/O数
+    uint64_t slow_ios;        // 容量层子I/O数
+    uint64_t data_accesses;   // 数据块访问次数（块为单位，不含固定区）
+    uint64_t data_hits;       // 其中由快速层服务的次数
+    uint64_t promotions;      // 提升到快速层的块数
+    uint64_t demotions;       // 降级回容量层的块数
+    uint64_t writebacks;      // 降级时写回容量层的块数
+    uint64_t passes;          // 迁移轮数
+};
+
+/**
+ * @brief 分层集：两个后端文件、槽位映射、访问热度与后台迁移线程
+ */
+class TierSet
+{
+public:
+    /**
+     * @param block_size 块大小
+     * @param total_blocks 逻辑总块数
+     * @param pinned_blocks 固定在快速层的块数
+     * @param fast_blocks 快速层总块数（固定区 + 映射表 + 槽位）
+     */
+    TierSet(uint32_t block_size, uint32_t total_blocks, uint32_t pinned_blocks, uint32_t fast_blocks);
+    ~TierSet();
+
+    // 打开两层文件；create为true时创建快速层并写入空映射表，否则校验表头并加载映射
+    bool open(const std::string& capacity_path, const std::string& fast_path, uint64_t set_id, bool create,
+              bool read_only);
+    // fast_len返回由快速层服务的字节数
+    bool read(uint64_t pos, char* buffer, size_t len, size_t& fast_len);
+    bool write(uint64_t pos, const char* buffer, size_t len, size_t& fast_len);
+    void discard(uint32_t block);                 // 块被释放：清零热度并腾出槽位
+    uint32_t migrate(uint32_t max_moves);         // 执行一轮迁移，返回迁移的块数
+    void start_migrator(uint32_t interval_ms);    // 启动后台迁移线程
+    bool close(bool clean);                       // 停止迁移线程；clean时写入干净表头与0号块的引导副本
+
+    const std::string& fast_path() const { return fast_file; }
+    uint32_t pinned() const { return pinned_blocks; }
+    uint32_t slot_count() const { return (uint32_t)slot_block.size(); }
+    uint32_t resident() const;
+    bool recovered() const { return !loaded_clean; }  // 映射表不是干净卸载时写入的
+    TierStats stats() const;
+
+    static bool layout(uint32_t pinned_blocks, uint32_t fast_blocks, uint32_t block_size, uint32_t& table_blocks,
+                       uint32_t& slots);  // 计算映射表块数与槽位数，快速层太小返回false
+
+private:
+    uint32_t block_size;
+    uint32_t total_blocks;
+    uint32_t pinned_blocks;
+    uint32_t fast_blocks;
+    uint32_t table_blocks;
+    int slow_fd;
+    int fast_fd;
+    std::string fast_file;
+    uint64_t set_id;
+    bool loaded_clean;
+    bool read_only;
+
+    std::vector<uint32_t> slot_block;   // 槽位 -> 驻留块号（0表示空闲）
+    std::vector<uint8_t> slot_dirty;    // 槽位内容是否比容量层新
+    std::vector<int32_t> block_slot;    // 块号 -> 槽位（-1表示在容量层）
+    std::vector<uint16_t> heat;         // 块号 -> 访问热度
+    std::vector<uint32_t> free_slots;
+    TierStats st;
+
+    mutable std::mutex mutex;           // 保护以上全部状态与两层文件的I/O
+    std::thread migrator;
+    std::mutex thread_mutex;
+    std::condition_variable thread_cv;
+    bool stopping;
+
+    bool io(uint64_t pos, char* buffer, size_t len, bool is_write, size_t& fast_len);
+    uint64_t slot_pos(uint32_t slot) const;
+    bool save_slot(uint32_t slot);
+    bool save_header(bool clean);
+    bool move_block(int from_fd, uint64_t from, int to_fd, uint64_t to);
+    void migrator_loop(uint32_t interval_ms);
+    void stop_migrator();
+};
+
+#endif // TIER_H
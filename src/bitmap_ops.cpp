@@ -16,6 +16,7 @@ bool DiskFS::set_block_bitmap(uint32_t block_num, bool used) {
     if (block_num < super_block.data_start || block_num >= data_end) {
         return false; // 块编号超出数据区范围，无效
     }
+    if (dedup) dedup->set_allocated(block_num, used);  // 去重：分配时引用计数置1，释放时清零
 
     // 2. 计算目标块在数据区的相对索引（数据区第0块对应idx=0）
     uint32_t idx = block_num - super_block.data_start;
@@ -67,6 +68,7 @@ bool DiskFS::set_block_bitmap(uint32_t block_num, bool used) {
         if (is_currently_used) {
             super_block.free_blocks++;
         }
+        if (meta && idx < meta->block_hint) meta->block_hint = idx;  // 分配提示保持为最小空闲块的下界
     }
 
     // 7. 将更新后的块位图块写回磁盘
@@ -147,6 +149,7 @@ bool DiskFS::set_inode_bitmap(uint32_t inode_num, bool used)
         if (is_currently_used) {
             super_block.free_inodes++;
         }
+        if (meta && inode_num < meta->inode_hint) meta->inode_hint = inode_num;
     }
 
     // 7. 将更新后的inode位图块写回磁盘
@@ -166,10 +169,12 @@ bool DiskFS::set_inode_bitmap(uint32_t inode_num, bool used)
 /**
  * @brief 查找第一个空闲的数据块（从块位图中寻找未使用的块）
  * @return 找到的空闲块编号；无空闲块或IO失败返回-1
- * 遍历块位图，返回第一个位为0（空闲）的块编号
+ * 遍历块位图，返回第一个位为0（空闲）的块编号；有分配提示时从提示处开始（提示之前没有空闲块）
  */
 int DiskFS::find_free_block() {
     char buffer[BLOCK_SIZE];  // 存储块位图数据的缓冲区
+    STATS_ADD(STAT_BITMAP_SCANS, 1);
+    if (delalloc && super_block.free_blocks <= delalloc->reserved) return -1;  // 剩余空闲块已被脏页预留
 
     // 读取块位图所在的块（简化为1个块）
     if (!read_block(super_block.block_bitmap, buffer)) return -1;
@@ -177,16 +182,18 @@ int DiskFS::find_free_block() {
     uint32_t total_data_blocks = super_block.data_blocks;  // 总数据块数（从超级块获取）
     
     // 遍历位图的每一位，寻找第一个空闲块（位为0）
-    for (uint32_t i = 0; i < total_data_blocks; i++) {
+    for (uint32_t i = meta ? meta->block_hint : 0; i < total_data_blocks; i++) {
         uint32_t byte = i / 8;    // 计算当前索引对应的字节
         uint8_t bit = i % 8;      // 计算当前索引对应的位
 
         // 若位为0，说明该块空闲
         if (!(buffer[byte] & (1 << bit))) {
+            if (meta) meta->block_hint = i;
             // 转换为绝对块编号（相对索引 + 数据区起始块号）
             return super_block.data_start + i;
         }
     }
+    if (meta) meta->block_hint = total_data_blocks;
     return -1;  // 没有找到空闲块
 }
 
@@ -196,14 +203,17 @@ int DiskFS::find_free_block() {
  * 遍历inode位图（支持跨多个块），返回第一个位为0（空闲）的inode编号
  */
 int DiskFS::find_free_inode() {
+    STATS_ADD(STAT_BITMAP_SCANS, 1);
+
     // 1. 计算关键参数
     uint32_t bits_per_block = BLOCK_SIZE * 8;  // 每个块能存储的inode数（1字节=8位）
     // 动态计算inode位图总块数（也可从超级块添加inode_bitmap_size字段直接获取）
     uint32_t inode_bitmap_size = (super_block.total_inodes + bits_per_block - 1) / bits_per_block;
     char buffer[BLOCK_SIZE];
+    uint32_t hint = meta ? meta->inode_hint : 0;  // 提示之前没有空闲inode
 
     // 2. 遍历所有inode位图块
-    for (uint32_t bm_block_idx = 0; bm_block_idx < inode_bitmap_size; bm_block_idx++) {
+    for (uint32_t bm_block_idx = hint / bits_per_block; bm_block_idx < inode_bitmap_size; bm_block_idx++) {
         // 当前inode位图块的实际磁盘块号（起始块 + 索引）
         uint32_t target_bm_block = super_block.inode_bitmap + bm_block_idx;
         
@@ -224,7 +234,8 @@ int DiskFS::find_free_inode() {
                 }
 
                 // 检查当前位是否为0（空闲inode）
-                if (!(buffer[byte] & (1 << bit))) {
+                if (global_inode_num >= hint && !(buffer[byte] & (1 << bit))) {
+                    if (meta) meta->inode_hint = global_inode_num;
                     return global_inode_num;  // 返回找到的第一个空闲inode编号
                 }
             }
@@ -0,0 +1,392 @@
+#include "../include/block_mq.h"
+#include "../include/disk_fs.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <unistd.h>
+
+static std::atomic<uint64_t> next_instance_id(1);
+
+/**
+ * @brief 存活的块层实例（编号 -> 实例）：线程退出时据此把软件队列还给仍存在的实例
+ * 有意不析构，主线程的线程局部缓存在静态对象析构之后仍可能访问
+ */
+static std::mutex& registry_mutex()
+{
+    static std::mutex* m = new std::mutex();
+    return *m;
+}
+
+static std::map<uint64_t, BlockMq*>& registry()
+{
+    static std::map<uint64_t, BlockMq*>* r = new std::map<uint64_t, BlockMq*>();
+    return *r;
+}
+
+struct LocalQueueSlot
+{
+    uint64_t owner;           // 实例编号（0表示空槽）
+    void* queue;
+};
+const uint32_t MQ_LOCAL_SLOTS = 4;
+
+/**
+ * @brief 线程局部的软件队列缓存：按实例编号记住本线程在各块层实例上使用的软件队列
+ * 槽位用完时轮换覆盖，被覆盖的队列与线程退出时缓存中的队列都还给所属实例（实例已销毁时忽略）
+ */
+struct LocalQueueCache
+{
+    LocalQueueSlot slots[MQ_LOCAL_SLOTS];
+    uint32_t next;
+
+    LocalQueueCache() : slots(), next(0) {}
+    ~LocalQueueCache()
+    {
+        for (uint32_t i = 0; i < MQ_LOCAL_SLOTS; i++) give_back(slots[i]);
+    }
+
+    // 加锁顺序：registry_mutex -> 实例的register_mutex
+    static void give_back(LocalQueueSlot& slot)
+    {
+        if (slot.owner == 0) return;
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        auto it = registry().find(slot.owner);
+        if (it != registry().end()) {
+            BlockMq* mq = it->second;
+            std::lock_guard<std::mutex> reg(mq->register_mutex);
+            mq->free_sws.push_back((BlockMq::SwQueue*)slot.queue);
+        }
+        slot.owner = 0;
+        slot.queue = nullptr;
+    }
+};
+static thread_local LocalQueueCache local_cache;
+
+/**
+ * @brief 在一个描述符上完整地读写一段（处理短读写与EINTR）
+ */
+static bool transfer(int fd, uint64_t offset, char* buf, size_t len, bool is_write)
+{
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = is_write ? pwrite(fd, buf + done, len - done, offset + done)
+                             : pread(fd, buf + done, len - done, offset + done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+BlockMq::BlockMq(uint32_t hw_queues, uint32_t depth)
+    : depth(2), instance_id(next_instance_id.fetch_add(1)), sw_count(0), stopping(false), batches(0)
+{
+    while (this->depth < depth) this->depth <<= 1;  // 与SpscRing的实际容量一致
+    if (hw_queues == 0) hw_queues = 1;
+    if (hw_queues > MQ_MAX_HW_QUEUES) hw_queues = MQ_MAX_HW_QUEUES;
+    for (uint32_t i = 0; i < hw_queues; i++) hw.push_back(new HwQueue());
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    registry()[instance_id] = this;
+}
+
+BlockMq::~BlockMq()
+{
+    {
+        // 先注销，之后退出的线程不再归还队列到本实例
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        registry().erase(instance_id);
+    }
+    close_all();
+    for (HwQueue* q : hw) delete q;
+    for (uint32_t i = 0; i < sw_count.load(); i++) delete sws[i];
+}
+
+/**
+ * @brief 为每个硬件队列打开镜像文件并启动工作线程
+ * @param path 镜像文件路径
+ * @param read_only 只读打开
+ * @return 全部打开成功返回true
+ */
+bool BlockMq::open(const std::string& path, bool read_only)
+{
+    for (HwQueue* q : hw) {
+        q->fd = ::open(path.c_str(), (read_only ? O_RDONLY : O_RDWR) | O_CLOEXEC);
+        if (q->fd < 0) {
+            std::cerr << "多队列块层：打开 " << path << " 失败（" << strerror(errno) << "）" << std::endl;
+            close_all();
+            return false;
+        }
+    }
+    for (HwQueue* q : hw) q->worker = std::thread(&BlockMq::worker_loop, this, q);
+    return true;
+}
+
+/**
+ * @brief 停止工作线程并关闭描述符（环中不会有未完成的请求：提交调用总是等到全部完成才返回）
+ */
+void BlockMq::close_all()
+{
+    stopping.store(true);
+    for (HwQueue* q : hw) {
+        {
+            std::lock_guard<std::mutex> lock(q->sleep_mutex);
+            q->sleep_cv.notify_all();
+        }
+        if (q->worker.joinable()) q->worker.join();
+        if (q->fd >= 0) ::close(q->fd);
+        q->fd = -1;
+    }
+}
+
+/**
+ * @brief 取得调用线程的软件队列：优先复用已退出线程归还的队列，否则登记新队列并按登记顺序轮流绑定到硬件队列
+ * @return 软件队列；同时使用的队列已达上限时返回nullptr（调用方直接同步读写）
+ */
+BlockMq::SwQueue* BlockMq::local_queue()
+{
+    for (uint32_t i = 0; i < MQ_LOCAL_SLOTS; i++) {
+        if (local_cache.slots[i].owner == instance_id) return (SwQueue*)local_cache.slots[i].queue;
+    }
+    LocalQueueSlot& slot = local_cache.slots[local_cache.next];
+    local_cache.next = (local_cache.next + 1) % MQ_LOCAL_SLOTS;
+    LocalQueueCache::give_back(slot);  // 被覆盖的队列还给所属实例（本线程此时不在那个实例的提交中）
+
+    SwQueue* sw;
+    {
+        std::lock_guard<std::mutex> lock(register_mutex);
+        if (!free_sws.empty()) {
+            sw = free_sws.back();
+            free_sws.pop_back();
+        } else {
+            uint32_t n = sw_count.load();
+            if (n == MQ_MAX_SW_QUEUES) return nullptr;
+            sw = new SwQueue(depth);
+            HwQueue* q = hw[n % hw.size()];
+            sw->hwq = q;
+            sws[n] = sw;
+            uint32_t bound = q->sw_count.load();
+            q->sws[bound] = sw;
+            q->sw_count.store(bound + 1, std::memory_order_release);  // 工作线程看到计数时指针已写好
+            sw_count.store(n + 1);
+        }
+    }
+    slot.owner = instance_id;
+    slot.queue = sw;
+    return sw;
+}
+
+bool BlockMq::read(uint64_t pos, char* buffer, size_t len)
+{
+    MqRequest req = {pos, buffer, len, false};
+    return submit(&req, 1);
+}
+
+bool BlockMq::write(uint64_t pos, const char* buffer, size_t len)
+{
+    MqRequest req = {pos, const_cast<char*>(buffer), len, true};
+    return submit(&req, 1);
+}
+
+/**
+ * @brief 从调用线程的软件队列批量提交请求并等待全部完成
+ * 请求尽量一次全部入环、只唤醒一次工作线程；在途请求数不超过环深度，超出部分等前面的完成后再入环
+ * @param reqs 请求数组
+ * @param count 请求数
+ * @return 全部成功返回true
+ */
+bool BlockMq::submit(const MqRequest* reqs, size_t count)
+{
+    if (count == 0) return true;
+    SwQueue* sw = local_queue();
+    if (!sw) {
+        // 同时提交的线程超过软件队列上限：在0号硬件队列的描述符上同步读写（pread/pwrite本身线程安全）
+        HwQueue* q = hw[0];
+        bool ok = true;
+        for (size_t i = 0; i < count; i++) {
+            bool done = transfer(q->fd, reqs[i].offset, reqs[i].buf, reqs[i].len, reqs[i].is_write);
+            q->requests++;
+            q->bytes += reqs[i].len;
+            if (!done) {
+                q->errors++;
+                ok = false;
+            }
+        }
+        return ok;
+    }
+    if (count > 1) batches++;
+
+    size_t next = 0, outstanding = 0;
+    bool ok = true;
+    while (next < count || outstanding > 0) {
+        size_t pushed = 0;
+        while (next < count && outstanding < depth && sw->sq.push(reqs[next])) {
+            next++;
+            outstanding++;
+            pushed++;
+        }
+        if (pushed > 0) {
+            // 入环（release）与读取休眠标志之间需要全序，配合工作线程的检查避免丢失唤醒
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            HwQueue* q = sw->hwq;
+            if (q->sleeping.load()) {
+                std::lock_guard<std::mutex> lock(q->sleep_mutex);
+                q->sleep_cv.notify_one();
+            }
+        }
+        reap(sw, outstanding, ok);
+    }
+    return ok;
+}
+
+/**
+ * @brief 从完成环收取至少一个完成项：先自旋检查，仍没有则休眠等待工作线程唤醒
+ */
+void BlockMq::reap(SwQueue* sw, size_t& outstanding, bool& ok)
+{
+    uint32_t spins = 0;
+    for (;;) {
+        Completion c;
+        bool got = false;
+        while (sw->cq.pop(c)) {
+            got = true;
+            outstanding--;
+            if (!c.ok) ok = false;
+        }
+        if (got) return;
+        if (++spins < MQ_SPIN) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sw->wait_mutex);
+        sw->waiting.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sw->cq.empty()) sw->wait_cv.wait(lock);
+        sw->waiting.store(false);
+        spins = 0;
+    }
+}
+
+/**
+ * @brief 硬件队列工作线程：轮流从绑定的软件队列各取一批请求执行，完成项写回对应的完成环；
+ * 全部为空时自旋一段时间后休眠，直到有请求入环或块层关闭
+ */
+void BlockMq::worker_loop(HwQueue* q)
+{
+    uint32_t idle = 0;
+    for (;;) {
+        bool did = false;
+        uint32_t n = q->sw_count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < n; i++) {
+            SwQueue* sw = q->sws[i];
+            MqRequest r;
+            uint32_t taken = 0;
+            while (taken < MQ_DISPATCH_BATCH && sw->sq.pop(r)) {
+                Completion c = {transfer(q->fd, r.offset, r.buf, r.len, r.is_write)};
+                q->requests++;
+                q->bytes += r.len;
+                if (!c.ok) q->errors++;
+                while (!sw->cq.push(c)) std::this_thread::yield();  // 在途数不超过环深度，不会长时间满
+                taken++;
+            }
+            if (taken == 0) continue;
+            did = true;
+            q->dispatches++;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sw->waiting.load()) {
+                std::lock_guard<std::mutex> lock(sw->wait_mutex);
+                sw->wait_cv.notify_one();
+            }
+        }
+        if (did) {
+            idle = 0;
+            continue;
+        }
+        if (stopping.load()) return;
+        if (++idle < MQ_SPIN) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(q->sleep_mutex);
+        q->sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool pending = false;
+        n = q->sw_count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < n && !pending; i++) pending = !q->sws[i]->sq.empty();
+        if (!pending && !stopping.load()) {
+            q->sleep_cv.wait(lock);
+            q->wakeups++;
+        }
+        q->sleeping.store(false);
+        idle = 0;
+    }
+}
+
+MqQueueStats BlockMq::queue_stats(uint32_t q) const
+{
+    MqQueueStats s;
+    memset(&s, 0, sizeof(s));
+    if (q >= hw.size()) return s;
+    const HwQueue* h = hw[q];
+    s.requests = h->requests.load();
+    s.bytes = h->bytes.load();
+    s.dispatches = h->dispatches.load();
+    s.wakeups = h->wakeups.load();
+    s.errors = h->errors.load();
+    return s;
+}
+
+/**
+ * @brief 设置多队列块层（挂载时生效；已挂载时立即切换，切换前派发已排队的写）
+ * @param hw_queues 硬件队列数（0表示关闭，回到单个文件流）
+ * @param depth 每个软件队列的环深度
+ * @return 参数有效且（已挂载时）切换成功返回true
+ */
+bool DiskFS::set_block_mq(uint32_t hw_queues, uint32_t depth)
+{
+    if (hw_queues > MQ_MAX_HW_QUEUES || depth == 0) {
+        std::cerr << "多队列块层：硬件队列数应为0~" << MQ_MAX_HW_QUEUES << "，队列深度应大于0" << std::endl;
+        return false;
+    }
+    mq_queues = hw_queues;
+    mq_depth = depth;
+    if (!is_mounted) return true;
+    if (!flush_io()) return false;
+    mq.reset();
+    return mq_attach();
+}
+
+/**
+ * @brief 挂载时按配置启动多队列块层；条带化与冷热分层有各自的后端，不叠加
+ * @return 未配置或启动成功返回true
+ */
+bool DiskFS::mq_attach()
+{
+    if (mq_queues == 0) return true;
+    if (stripe || tier) {
+        std::cerr << "多队列块层只支持单镜像（条带化、冷热分层时不启用）" << std::endl;
+        return false;
+    }
+    disk_file.flush();  // 之后的读写经各硬件队列自己的描述符
+    mq.reset(new BlockMq(mq_queues, mq_depth));
+    if (!mq->open(disk_path, read_only)) {
+        mq.reset();
+        return false;
+    }
+    return true;
+}
+
+void DiskFS::print_mq_info() const
+{
+    if (!mq) return;
+    std::cout << "多队列块层:\n";
+    std::cout << "  硬件队列: " << mq->hw_queue_count() << "，软件队列: " << mq->sw_queue_count() << "，环深度: "
+              << mq->ring_depth() << "，批量提交: " << mq->batched_submits() << " 次\n";
+    for (uint32_t i = 0; i < mq->hw_queue_count(); i++) {
+        MqQueueStats s = mq->queue_stats(i);
+        std::cout << "  队列" << i << ": 请求 " << s.requests << "（" << s.bytes / 1024 << "KB），取批 " << s.dispatches
+                  << "，唤醒 " << s.wakeups << "，失败 " << s.errors << "\n";
+    }
+}
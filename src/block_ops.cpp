@@ -1,16 +1,163 @@
 #include "../include/disk_fs.h"
 #include <iostream>
+#include <thread>
+#include <chrono>
 
 
+/**
+ * @brief 按字节偏移从磁盘文件读取数据（块层最底层的读入口）
+ * @param pos 起始字节偏移
+ * @param buffer 接收数据的缓冲区
+ * @param len 读取字节数
+ * @return 读取成功返回true；IO失败返回false
+ * 所有对磁盘文件的读取（块、inode、超级块）都经过这里，设备模型在此计算服务时间
+ */
+bool DiskFS::raw_read(uint64_t pos, char* buffer, size_t len)
+{
+    if (stripe) {
+        account_device(DEV_READ, pos, len);
+        return stripe->read(pos, buffer, len);
+    }
+    if (tier) {
+        size_t fast_len = 0;
+        bool ok = tier->read(pos, buffer, len, fast_len);
+        account_device(DEV_READ, pos, len, fast_len);
+        return ok;
+    }
+    if (mq) {
+        account_device(DEV_READ, pos, len);
+        return mq->read(pos, buffer, len);
+    }
+    disk_file.clear();  // 清除上次操作遗留的错误状态，避免影响本次IO
+    disk_file.seekg(pos);
+    disk_file.read(buffer, len);
+    account_device(DEV_READ, pos, len);
+    return disk_file.good();
+}
+
+/**
+ * @brief 按字节偏移向磁盘文件写入数据（块层最底层的写入口）
+ * @param pos 起始字节偏移
+ * @param buffer 待写入的数据
+ * @param len 写入字节数
+ * @return 写入成功返回true；IO失败返回false
+ */
+bool DiskFS::raw_write(uint64_t pos, const char* buffer, size_t len)
+{
+    if (stripe) {
+        account_device(DEV_WRITE, pos, len);
+        return stripe->write(pos, buffer, len);
+    }
+    if (tier) {
+        size_t fast_len = 0;
+        bool ok = tier->write(pos, buffer, len, fast_len);
+        account_device(DEV_WRITE, pos, len, fast_len);
+        return ok;
+    }
+    if (mq) {
+        account_device(DEV_WRITE, pos, len);
+        return mq->write(pos, buffer, len);
+    }
+    disk_file.clear();
+    disk_file.seekp(pos);
+    disk_file.write(buffer, len);
+    account_device(DEV_WRITE, pos, len);
+    return disk_file.good();
+}
+
+/**
+ * @brief 按设备模型计算一次IO的模拟服务时间，推进虚拟时钟
+ * 实时模式下调用线程按模拟时间真实等待；冷热分层时快速层上的部分按快速层的模型计时
+ */
+void DiskFS::account_device(DeviceOp op, uint64_t pos, size_t len, size_t fast_len)
+{
+    if (!device) return;
+    uint64_t ns = 0;
+    if (len > fast_len) ns += device->service(op, pos, len - fast_len, virtual_ns);
+    if (fast_len > 0 && tier_device) ns += tier_device->service(op, pos, fast_len, virtual_ns + ns);
+    virtual_ns += ns;
+    IoStats::add_device_time(ns);
+    if (device_realtime) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+    }
+}
 
 /**
  * @brief 辅助函数：将内存中的超级块写回磁盘（保证数据一致性）
  */
-bool DiskFS::write_super_block() 
+bool DiskFS::write_super_block()
+{
+    if (log) {
+        log->super_dirty = true;  // 日志布局下超级块计数随检查点保存，不原地写
+        return true;
+    }
+    csum_seal_super();
+    return raw_write(0, (char*)&super_block, sizeof(SuperBlock)); // 超级块固定在磁盘0号位置
+}
+
+/**
+ * @brief 读写连续的多个块（去重表、校验表等整体读写的区域）
+ * @param buf 读时按count块调整大小；写时须至少count块
+ * @return 成功返回true
+ * 原地布局一次大块I/O完成，不经过调度队列与校验；日志布局逐块经映射读写
+ */
+bool DiskFS::region_io(uint32_t first, uint32_t count, std::vector<char>& buf, bool is_write)
 {
-    disk_file.seekp(0); // 超级块固定在磁盘0号位置
-    disk_file.write((char*)&super_block, sizeof(SuperBlock));
-    return disk_file.good(); // 检查写入是否成功
+    if (!is_write) buf.resize((size_t)count * BLOCK_SIZE);
+    if (!log) {
+        uint64_t pos = (uint64_t)first * BLOCK_SIZE;
+        size_t len = (size_t)count * BLOCK_SIZE;
+        return is_write ? raw_write(pos, buf.data(), len) : raw_read(pos, buf.data(), len);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        char* block = buf.data() + (size_t)i * BLOCK_SIZE;
+        if (!(is_write ? log_write_block(first + i, block) : log_read_block(first + i, block))) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 读取inode
+ * @param inode_num 目标inode编号
+ * @param inode 接收inode数据
+ * @return 读取成功返回true；编号无效或IO失败返回false
+ */
+bool DiskFS::read_inode(uint32_t inode_num, Inode& inode)
+{
+    if (inode_num >= super_block.total_inodes) return false;
+    if (!snap_view.empty()) {
+        inode = snap_view[inode_num];  // 只读挂载的快照（inode表读入时已按块校验）
+        return true;
+    }
+    bool ok;
+    if (log) {
+        ok = log_read_inode(inode_num, inode);
+    } else if (shared && shared->lookup_inode(inode_num, (char*)&inode, sizeof(Inode))) {
+        ok = true;  // 共享只读挂载：跨进程共享的inode表
+    } else if (meta && meta->lookup_inode(inode_num, (char*)&inode, sizeof(Inode))) {
+        ok = true;
+    } else {
+        ok = raw_read(get_inode_pos(inode_num), (char*)&inode, sizeof(Inode));
+    }
+    return ok && (!csum || csum_verify_inode(inode_num, inode));
+}
+
+/**
+ * @brief 写入inode
+ * @param inode_num 目标inode编号
+ * @param inode 待写入的inode数据
+ * @return 写入成功返回true；编号无效或IO失败返回false
+ */
+bool DiskFS::write_inode(uint32_t inode_num, const Inode& inode)
+{
+    if (inode_num >= super_block.total_inodes) return false;
+    if (csum) {
+        csum->set_inode(inode_num, (const char*)&inode, sizeof(Inode));
+        if (!csum_write_intents()) return false;
+    }
+    if (log) return log_write_inode(inode_num, inode);
+    if (meta) meta->update_inode(inode_num, (const char*)&inode, sizeof(Inode));
+    return raw_write(get_inode_pos(inode_num), (const char*)&inode, sizeof(Inode));
 }
 
 
@@ -18,18 +165,47 @@ bool DiskFS::write_super_block()
  * @brief 从磁盘读取一个完整的块
  * @param block_num 目标块的编号（0~总块数-1）
  * @param buffer 接收数据的缓冲区（必须预先分配BLOCK_SIZE大小的空间）
- * @return 读取成功返回true；块编号无效或IO失败返回false
+ * @return 读取成功返回true；块编号无效、IO失败或校验和不符返回false
  * 块是磁盘IO的基本单位，所有磁盘读写都以块为单位进行
  */
 bool DiskFS::read_block(uint32_t block_num, char* buffer) {
     // 检查块编号是否有效（必须小于总块数）
     if (block_num >= super_block.total_blocks) return false;
-    
-    // 计算块在磁盘文件中的起始字节位置（块编号 × 块大小）
-    uint32_t pos = block_num * BLOCK_SIZE;
-    disk_file.seekg(pos);  // 将文件读指针定位到目标块的起始位置
-    disk_file.read(buffer, BLOCK_SIZE);  // 读取整个块的数据到缓冲区
-    return disk_file.good();  // 返回IO操作状态（true表示成功）
+
+    STATS_ADD(STAT_BLOCK_READS, 1);
+    STATS_ADD(STAT_BYTES_READ, BLOCK_SIZE);
+    if (tracer.enabled()) tracer.record(TRACE_BLOCK_READ, block_num, BLOCK_SIZE, IoTracer::current_inode());
+
+    if (!load_block(block_num, buffer)) return false;
+    return !csum || !csum_covers(block_num) || csum_verify_block(block_num, buffer);
+}
+
+/**
+ * @brief 按布局取得块内容：日志映射、元数据副本、调度队列或磁盘文件
+ */
+bool DiskFS::load_block(uint32_t block_num, char* buffer)
+{
+    if (log) return log_read_block(block_num, buffer);
+    if (shared && shared->lookup_block(block_num, buffer)) {
+        STATS_ADD(STAT_CACHE_HITS, 1);
+        return true;
+    }
+    if (meta) {
+        // 预读的元数据块（位图、根目录）总是最新的（写穿透），直接返回
+        if (meta->lookup_block(block_num, buffer)) {
+            STATS_ADD(STAT_CACHE_HITS, 1);
+            return true;
+        }
+        STATS_ADD(STAT_CACHE_MISSES, 1);
+    }
+    if (scheduler.enabled()) {
+        if (scheduler.lookup(block_num, buffer)) return true;  // 队列中有更新的数据
+        // noop/clook下读请求排在已排队的写之后；deadline下读优先，不等待写
+        if (!scheduler.reads_bypass() && !flush_io()) return false;
+    }
+
+    // 块在磁盘文件中的起始字节位置 = 块编号 × 块大小
+    return raw_read((uint64_t)block_num * BLOCK_SIZE, buffer, BLOCK_SIZE);
 }
 
 /**
@@ -41,11 +217,61 @@ bool DiskFS::read_block(uint32_t block_num, char* buffer) {
 bool DiskFS::write_block(uint32_t block_num, const char* buffer) {
     // 检查块编号是否有效
     if (block_num >= super_block.total_blocks) return false;
-    
-    // 计算块在磁盘文件中的起始字节位置
-    uint32_t pos = block_num * BLOCK_SIZE;
-    disk_file.seekp(pos);  // 将文件写指针定位到目标块的起始位置
-    disk_file.write(buffer, BLOCK_SIZE);  // 将缓冲区数据写入整个块
-    return disk_file.good();  // 返回IO操作状态
+
+    STATS_ADD(STAT_BLOCK_WRITES, 1);
+    STATS_ADD(STAT_BYTES_WRITTEN, BLOCK_SIZE);
+    if (tracer.enabled()) tracer.record(TRACE_BLOCK_WRITE, block_num, BLOCK_SIZE, IoTracer::current_inode());
+
+    if (csum && csum_covers(block_num)) csum->set_block(block_num, buffer, BLOCK_SIZE);
+    if (log) return csum_write_intents() && log_write_block(block_num, buffer);
+    if (meta) meta->update_block(block_num, buffer);
+
+    // 调度器开启且处于批次内时先排队，批次结束或队列满/超时时派发（派发前写出校验表中标无效的页）
+    if (scheduler.enabled() && batch_depth > 0) {
+        scheduler.queue_write(block_num, buffer);
+        return !scheduler.should_dispatch() || flush_io();
+    }
+    if (!csum_write_intents()) return false;
+    return raw_write((uint64_t)block_num * BLOCK_SIZE, buffer, BLOCK_SIZE);
+}
+
+/**
+ * @brief 释放数据块时通知块层：丢弃该块未派发的写，并向设备模型发出discard
+ * @param block_num 已释放的块编号
+ */
+void DiskFS::discard_block(uint32_t block_num)
+{
+    if (scheduler.enabled()) scheduler.cancel(block_num);
+    if (csum) csum->invalidate_block(block_num);  // 块内容不再有意义，下次写入时重新登记
+    if (log) {
+        log->pending_blocks.erase(block_num);
+        log->set_block(block_num, LOG_UNMAPPED);  // 日志中的旧副本失效，清理时不再搬移
+        return;
+    }
+    if (tier) tier->discard(block_num);  // 腾出快速层槽位
+    if (device) device->discard((uint64_t)block_num * BLOCK_SIZE, BLOCK_SIZE);
 }
 
+/**
+ * @brief 设置设备时序模型
+ * @param kind "hdd"、"ssd"、"ftl"、"ftl-cb"或"none"（关闭模型）
+ * @param param 模型参数（HDD为转速，SSD为通道数，FTL为预留空间百分比，0表示默认值）
+ * @param realtime true表示按模拟时间真实等待；false只推进虚拟时钟
+ * @return 设置成功返回true；模型名称未知返回false
+ */
+bool DiskFS::set_device_model(const std::string& kind, uint32_t param, bool realtime)
+{
+    if (kind == "none") {
+        device.reset();
+        device_realtime = false;
+        IoStats::set_device_enabled(false);
+        return true;
+    }
+    DeviceModel* model = DeviceModel::create(kind, param);
+    if (!model) return false;
+    device.reset(model);
+    device_realtime = realtime;
+    virtual_ns = 0;
+    IoStats::set_device_enabled(true);
+    return true;
+}
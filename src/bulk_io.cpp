@@ -0,0 +1,383 @@
+#include "../include/bulk_io.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <dirent.h>
+#include <iostream>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+
+namespace {
+
+const size_t BULK_FILE_BYTES = 16 * BLOCK_SIZE;  // 单文件上限（16个直接块），也是一次主机读写的大小
+const uint32_t BULK_MAX_THREADS = 8;
+
+/**
+ * @brief 有界阻塞队列（流水线级间通道）
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this]() { return items.size() < capacity; });
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+    }
+
+    // 队列关闭且为空时返回false
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this]() { return !items.empty() || closed; });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    bool closed;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+};
+
+/**
+ * @brief 固定数量、固定大小的缓冲池；取不到缓冲时阻塞，限制在途数据量
+ */
+class BufferPool
+{
+public:
+    BufferPool(size_t count, size_t size) : storage(count * size)
+    {
+        for (size_t i = 0; i < count; i++) free_list.push_back(&storage[i * size]);
+    }
+
+    char* acquire()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this]() { return !free_list.empty(); });
+        char* buf = free_list.back();
+        free_list.pop_back();
+        return buf;
+    }
+
+    void release(char* buf)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        free_list.push_back(buf);
+        available.notify_one();
+    }
+
+private:
+    std::vector<char> storage;
+    std::vector<char*> free_list;
+    std::mutex mutex;
+    std::condition_variable available;
+};
+
+/**
+ * @brief 流水线中的一个文件
+ */
+struct BulkItem
+{
+    std::string name;         // 模拟磁盘中的文件名
+    std::string host_path;    // 主机文件路径
+    char* buf;                // 缓冲池中的缓冲区
+    size_t size;              // 文件大小
+    int inode;                // 模拟磁盘中的inode
+};
+
+uint32_t worker_count(uint32_t threads)
+{
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    return std::max(1u, std::min(threads, BULK_MAX_THREADS));
+}
+
+/**
+ * @brief 收集主机路径下的普通文件（递归目录，跳过符号链接等特殊文件）
+ * @param name 模拟磁盘中的文件名（目录时为前缀，目录层级以'_'连接）
+ */
+bool collect_host_files(const std::string& path, const std::string& name, std::vector<BulkItem>& out)
+{
+    struct stat sb;
+    if (lstat(path.c_str(), &sb) != 0) return false;
+    if (S_ISREG(sb.st_mode)) {
+        BulkItem item = {name, path, nullptr, (size_t)sb.st_size, -1};
+        out.push_back(item);
+        return true;
+    }
+    if (!S_ISDIR(sb.st_mode)) return true;
+
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return false;
+    std::vector<std::string> children;
+    while (struct dirent* de = readdir(dir)) {
+        std::string child = de->d_name;
+        if (child != "." && child != "..") children.push_back(child);
+    }
+    closedir(dir);
+    std::sort(children.begin(), children.end());  // 导入顺序与目录遍历顺序无关
+    for (const auto& child : children) {
+        collect_host_files(path + "/" + child, name.empty() ? child : name + "_" + child, out);
+    }
+    return true;
+}
+
+std::string base_name(const std::string& path)
+{
+    std::string p = path;
+    while (p.size() > 1 && p.back() == '/') p.pop_back();
+    size_t slash = p.rfind('/');
+    return slash == std::string::npos ? p : p.substr(slash + 1);
+}
+
+} // namespace
+
+/**
+ * @brief 把主机文件或目录树导入根目录
+ * @param host_path 主机文件或目录
+ * @param dest 导入单个文件时为目标文件名，导入目录时为文件名前缀（为空时分别取主机文件名/不加前缀）
+ * @param st 输出统计
+ * @param threads 主机读线程数（0表示按CPU核数，最多8个）
+ * @return 主机路径不可访问或未挂载返回false；单个文件的失败计入st.failed
+ */
+bool DiskFS::import_path(const std::string& host_path, const std::string& dest, BulkStats& st, uint32_t threads)
+{
+    st = BulkStats();
+    if (!isMounted()) {
+        std::cerr << "导入失败：磁盘未挂载" << std::endl;
+        return false;
+    }
+    if (reject_read_only("导入")) return false;
+    struct stat sb;
+    if (stat(host_path.c_str(), &sb) != 0) {
+        std::cerr << "导入失败：无法访问 " << host_path << std::endl;
+        return false;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<BulkItem> jobs;
+    collect_host_files(host_path, S_ISDIR(sb.st_mode) ? dest : (dest.empty() ? base_name(host_path) : dest), jobs);
+
+    st.threads = worker_count(threads);
+    size_t depth = st.threads * 2;
+    BufferPool pool(depth, BULK_FILE_BYTES);
+    BoundedQueue<BulkItem> read_q(depth), alloc_q(depth);
+    std::mutex fs_mutex;  // 分配级与写级共用：文件系统同一时刻只有一个线程访问
+    std::atomic<size_t> next(0);
+    std::atomic<uint64_t> failed(0), files(0), bytes(0);
+
+    auto fail = [&](const BulkItem& item, const char* why) {
+        std::lock_guard<std::mutex> lock(fs_mutex);
+        std::cerr << "导入 " << item.host_path << " 失败：" << why << std::endl;
+        failed++;
+    };
+
+    // 整个导入是一个批次，在启动任何线程之前建立：begin_batch/end_batch不加锁，
+    // 不能与分配级、写级在create_file、write_file内部建立的批次并发修改批次深度与调度队列
+    std::unique_ptr<IoBatch> batch(new IoBatch(*this));
+
+    // 读级：整块读入主机文件
+    std::vector<std::thread> readers;
+    for (uint32_t t = 0; t < st.threads; t++) {
+        readers.push_back(std::thread([&]() {
+            for (size_t i = next++; i < jobs.size(); i = next++) {
+                BulkItem item = jobs[i];
+                if (item.name.empty() || item.name.size() >= (size_t)MAX_FILENAME) {
+                    fail(item, "文件名过长");
+                    continue;
+                }
+                if (item.size > BULK_FILE_BYTES) {
+                    fail(item, "超过单文件上限");
+                    continue;
+                }
+                FILE* in = fopen(item.host_path.c_str(), "rb");
+                if (!in) {
+                    fail(item, "无法打开");
+                    continue;
+                }
+                item.buf = pool.acquire();
+                item.size = fread(item.buf, 1, BULK_FILE_BYTES, in);
+                bool too_big = fgetc(in) != EOF;  // 统计后文件又变大
+                fclose(in);
+                if (too_big) {
+                    pool.release(item.buf);
+                    fail(item, "超过单文件上限");
+                    continue;
+                }
+                read_q.push(item);
+            }
+        }));
+    }
+
+    // 分配级：创建文件（分配inode与目录项）
+    std::thread allocator([&]() {
+        BulkItem item;
+        while (read_q.pop(item)) {
+            {
+                std::lock_guard<std::mutex> lock(fs_mutex);
+                item.inode = create_file(item.name);
+            }
+            if (item.inode == -1) {
+                pool.release(item.buf);
+                fail(item, "创建文件失败");
+                continue;
+            }
+            alloc_q.push(item);
+        }
+        alloc_q.close();
+    });
+
+    // 写级：整个文件一次写入
+    std::thread writer([&]() {
+        BulkItem item;
+        while (alloc_q.pop(item)) {
+            int written;
+            {
+                std::lock_guard<std::mutex> lock(fs_mutex);
+                written = item.size ? write_file(item.inode, item.buf, item.size, 0) : 0;
+            }
+            pool.release(item.buf);
+            if (written != (int)item.size) {
+                fail(item, "写入失败");
+                continue;
+            }
+            files++;
+            bytes += item.size;
+        }
+    });
+
+    for (auto& r : readers) r.join();
+    read_q.close();
+    allocator.join();
+    writer.join();
+    batch.reset();  // 全部线程结束后才派发队列
+
+    st.files = files;
+    st.bytes = bytes;
+    st.failed = failed;
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+/**
+ * @brief 把根目录中的文件导出到主机
+ * @param src 文件名；为空或"*"时导出全部文件，此时host_path为目录（不存在则创建）
+ * @param host_path 主机目标路径；导出单个文件且host_path是已有目录时写到该目录下
+ * @param st 输出统计
+ * @param threads 主机写线程数（0表示按CPU核数，最多8个）
+ * @return 未挂载、源文件不存在或主机目录无法创建返回false；单个文件的失败计入st.failed
+ */
+bool DiskFS::export_path(const std::string& src, const std::string& host_path, BulkStats& st, uint32_t threads)
+{
+    st = BulkStats();
+    if (!isMounted()) {
+        std::cerr << "导出失败：磁盘未挂载" << std::endl;
+        return false;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    struct stat sb;
+    bool host_is_dir = stat(host_path.c_str(), &sb) == 0 && S_ISDIR(sb.st_mode);
+    std::vector<BulkItem> jobs;
+    if (src.empty() || src == "*") {
+        if (!host_is_dir && mkdir(host_path.c_str(), 0755) != 0) {
+            std::cerr << "导出失败：无法创建目录 " << host_path << std::endl;
+            return false;
+        }
+        for (const auto& entry : list_files()) {
+            BulkItem item = {entry.name, host_path + "/" + entry.name, nullptr, 0, (int)entry.inode_num};
+            jobs.push_back(item);
+        }
+    } else {
+        int inode = open_file(src);
+        if (inode == -1) {
+            std::cerr << "导出失败：" << src << " 不存在" << std::endl;
+            return false;
+        }
+        BulkItem item = {src, host_is_dir ? host_path + "/" + src : host_path, nullptr, 0, inode};
+        jobs.push_back(item);
+    }
+
+    st.threads = worker_count(threads);
+    size_t depth = st.threads * 2;
+    BufferPool pool(depth, BULK_FILE_BYTES);
+    BoundedQueue<BulkItem> write_q(depth);
+    std::mutex err_mutex;
+    std::atomic<uint64_t> failed(0), files(0), bytes(0);
+
+    // 写级：多个线程并行写主机文件
+    std::vector<std::thread> writers;
+    for (uint32_t t = 0; t < st.threads; t++) {
+        writers.push_back(std::thread([&]() {
+            BulkItem item;
+            while (write_q.pop(item)) {
+                FILE* out = fopen(item.host_path.c_str(), "wb");
+                bool ok = out && fwrite(item.buf, 1, item.size, out) == item.size;
+                ok = out && fclose(out) == 0 && ok;
+                pool.release(item.buf);
+                if (!ok) {
+                    std::lock_guard<std::mutex> lock(err_mutex);
+                    std::cerr << "导出 " << item.name << " 失败：无法写入 " << item.host_path << std::endl;
+                    failed++;
+                    continue;
+                }
+                files++;
+                bytes += item.size;
+            }
+        }));
+    }
+
+    // 读级（调用线程）：整块读出文件
+    for (auto& item : jobs) {
+        item.buf = pool.acquire();
+        int n = read_file(item.inode, item.buf, BULK_FILE_BYTES, 0);
+        if (n < 0) {
+            pool.release(item.buf);
+            std::lock_guard<std::mutex> lock(err_mutex);
+            std::cerr << "导出 " << item.name << " 失败：读取失败" << std::endl;
+            failed++;
+            continue;
+        }
+        item.size = (size_t)n;
+        write_q.push(item);
+    }
+    write_q.close();
+    for (auto& w : writers) w.join();
+
+    st.files = files;
+    st.bytes = bytes;
+    st.failed = failed;
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void print_bulk_stats(const char* what, const BulkStats& st)
+{
+    double mb = st.bytes / (1024.0 * 1024.0);
+    std::cout << what << "完成: " << st.files << " 个文件，" << st.bytes / 1024 << " KB，失败 " << st.failed << "，"
+              << st.threads << "线程，耗时 " << st.seconds * 1000 << " ms";
+    if (st.seconds > 0) std::cout << "（" << mb / st.seconds << " MB/s）";
+    std::cout << "\n";
+}
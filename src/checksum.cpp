@@ -0,0 +1,387 @@
+#include "../include/checksum.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const uint32_t CSUM_STATS_BATCH = 64;     // 通过的比对攒够多少次计入一次stats
+const uint32_t CSUM_SAVE_CHANGES = 1024;  // 批次结束时改动达到多少次写出一次校验表
+
+}  // namespace
+
+ChecksumTable::ChecksumTable(uint32_t mode, uint32_t total_blocks, uint32_t total_inodes)
+    : mode(mode), st(), unreported(0), changes(0), block_crc(total_blocks, 0), inode_crc(total_inodes, 0), block_valid(total_blocks, 0),
+      inode_valid(total_inodes, 0)
+{
+}
+
+ChecksumTable::~ChecksumTable()
+{
+    STATS_ADD(STAT_CSUM_VERIFIED, unreported);
+}
+
+void ChecksumTable::set_block(uint32_t block_num, const char* data, size_t len)
+{
+    block_crc[block_num] = crc32c(0, data, len);
+    block_valid[block_num] = 1;
+    touch(block_valid_pos(block_num));
+    st.updated++;
+}
+
+bool ChecksumTable::check_block(uint32_t block_num, const char* data, size_t len)
+{
+    return check(block_crc[block_num], block_valid[block_num], block_valid_pos(block_num), data, len);
+}
+
+void ChecksumTable::set_inode(uint32_t inode_num, const char* data, size_t len)
+{
+    inode_crc[inode_num] = crc32c(0, data, len);
+    inode_valid[inode_num] = 1;
+    touch(inode_valid_pos(inode_num));
+    st.updated++;
+}
+
+bool ChecksumTable::check_inode(uint32_t inode_num, const char* data, size_t len)
+{
+    return check(inode_crc[inode_num], inode_valid[inode_num], inode_valid_pos(inode_num), data, len);
+}
+
+// 序列化后有效标记的位置：表头、块校验和、inode校验和、块有效标记、inode有效标记依次存放
+size_t ChecksumTable::block_valid_pos(uint32_t block_num) const
+{
+    return sizeof(CsumHeader) + (block_crc.size() + inode_crc.size()) * sizeof(uint32_t) + block_num;
+}
+
+size_t ChecksumTable::inode_valid_pos(uint32_t inode_num) const
+{
+    return block_valid_pos((uint32_t)block_valid.size()) + inode_num;
+}
+
+/**
+ * @brief 项即将改动：磁盘副本中仍有效时标为无效，记下位置等待写出
+ */
+void ChecksumTable::touch(size_t pos)
+{
+    changes++;
+    if (pos < image.size() && image[pos]) {
+        image[pos] = 0;
+        stale.push_back(pos);
+    }
+}
+
+void ChecksumTable::take_intents(std::vector<uint32_t>& pages, size_t page_size)
+{
+    pages.clear();
+    for (size_t pos : stale) pages.push_back((uint32_t)(pos / page_size));
+    stale.clear();
+    std::sort(pages.begin(), pages.end());
+    pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+    if (!pages.empty() && pages[0] == 0) pages.erase(pages.begin());
+    pages.push_back(0);  // 表头最后写：中途退出时整表校验不过，退回丢弃全部旧值
+
+    CsumHeader hdr;
+    memcpy(&hdr, image.data(), sizeof(hdr));
+    hdr.clean = 0;
+    hdr.checksum = crc32c(0, image.data() + sizeof(CsumHeader), table_bytes() - sizeof(CsumHeader));
+    memcpy(image.data(), &hdr, sizeof(hdr));
+    st.intents++;
+}
+
+void ChecksumTable::replace_image(std::vector<char>& next)
+{
+    image.swap(next);
+    stale.clear();
+    changes = 0;
+    st.saves++;
+}
+
+bool ChecksumTable::check(uint32_t& crc, uint8_t& valid, size_t pos, const char* data, size_t len)
+{
+    uint32_t c = crc32c(0, data, len);
+    bool ok = true;
+    if (!valid) {
+        crc = c;
+        valid = 1;
+        touch(pos);  // 磁盘表中可能还留着该项改动前的旧值
+        st.adopted++;
+    } else if (c != crc) {
+        st.errors++;
+        ok = false;
+    } else {
+        st.verified++;
+    }
+    return ok;
+}
+
+void ChecksumTable::invalidate_all()
+{
+    std::fill(block_valid.begin(), block_valid.end(), 0);
+    std::fill(inode_valid.begin(), inode_valid.end(), 0);
+}
+
+size_t ChecksumTable::table_bytes(uint32_t total_blocks, uint32_t total_inodes)
+{
+    return sizeof(CsumHeader) + ((size_t)total_blocks + total_inodes) * (sizeof(uint32_t) + sizeof(uint8_t));
+}
+
+size_t ChecksumTable::table_bytes() const
+{
+    return table_bytes((uint32_t)block_crc.size(), (uint32_t)inode_crc.size());
+}
+
+void ChecksumTable::save(std::vector<char>& out, bool clean) const
+{
+    out.assign(table_bytes(), 0);
+    char* p = out.data() + sizeof(CsumHeader);
+    memcpy(p, block_crc.data(), block_crc.size() * sizeof(uint32_t));
+    p += block_crc.size() * sizeof(uint32_t);
+    memcpy(p, inode_crc.data(), inode_crc.size() * sizeof(uint32_t));
+    p += inode_crc.size() * sizeof(uint32_t);
+    memcpy(p, block_valid.data(), block_valid.size());
+    p += block_valid.size();
+    memcpy(p, inode_valid.data(), inode_valid.size());
+
+    CsumHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CSUM_MAGIC, sizeof(hdr.magic));
+    hdr.clean = clean ? 1 : 0;
+    hdr.mode = mode;
+    hdr.block_count = (uint32_t)block_crc.size();
+    hdr.inode_count = (uint32_t)inode_crc.size();
+    hdr.checksum = crc32c(0, out.data() + sizeof(CsumHeader), out.size() - sizeof(CsumHeader));
+    memcpy(out.data(), &hdr, sizeof(hdr));
+}
+
+bool ChecksumTable::load(const std::vector<char>& in)
+{
+    if (in.size() < table_bytes()) return false;
+    CsumHeader hdr;
+    memcpy(&hdr, in.data(), sizeof(hdr));
+    size_t payload = table_bytes() - sizeof(CsumHeader);
+    if (memcmp(hdr.magic, CSUM_MAGIC, sizeof(hdr.magic)) != 0 || hdr.mode != mode ||
+        hdr.block_count != block_crc.size() || hdr.inode_count != inode_crc.size() ||
+        hdr.checksum != crc32c(0, in.data() + sizeof(CsumHeader), payload)) {
+        return false;
+    }
+    const char* p = in.data() + sizeof(CsumHeader);
+    memcpy(block_crc.data(), p, block_crc.size() * sizeof(uint32_t));
+    p += block_crc.size() * sizeof(uint32_t);
+    memcpy(inode_crc.data(), p, inode_crc.size() * sizeof(uint32_t));
+    p += inode_crc.size() * sizeof(uint32_t);
+    memcpy(block_valid.data(), p, block_valid.size());
+    p += block_valid.size();
+    memcpy(inode_valid.data(), p, inode_valid.size());
+    st.unclean = hdr.clean != 1;
+    return true;
+}
+
+/**
+ * @brief 设置下次格式化的校验范围（0关闭，CSUM_META或CSUM_META|CSUM_DATA）
+ */
+void DiskFS::set_checksums(uint32_t mode)
+{
+    csum_on_format = mode;
+}
+
+/**
+ * @brief 格式化时在数据区末尾预留校验表（按set_checksums的配置），超级块记录其位置
+ */
+void DiskFS::csum_create()
+{
+    csum.reset();
+    super_block.csum_mode = super_block.csum_start = super_block.csum_blocks = 0;
+    if (!csum_on_format) return;
+    size_t bytes = ChecksumTable::table_bytes(super_block.total_blocks, super_block.total_inodes);
+    uint32_t blocks = (uint32_t)((bytes + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    super_block.data_blocks -= blocks;
+    super_block.free_blocks = super_block.data_blocks;
+    super_block.csum_mode = csum_on_format | CSUM_META;
+    super_block.csum_start = super_block.data_start + super_block.data_blocks;
+    super_block.csum_blocks = blocks;
+    csum.reset(new ChecksumTable(super_block.csum_mode, super_block.total_blocks, super_block.total_inodes));
+}
+
+/**
+ * @brief 挂载时加载校验表；表自身校验失败时丢弃旧值，之后首次读到的块重新登记。
+ *        不干净的表沿用其中仍有效的项（异常退出前改写过的项已在表中标为无效）。
+ *        之后写入清除了干净标记的表头（只读挂载不写）
+ */
+bool DiskFS::csum_attach()
+{
+    csum.reset();
+    if (super_block.csum_mode == 0) return true;
+    csum.reset(new ChecksumTable(super_block.csum_mode, super_block.total_blocks, super_block.total_inodes));
+    std::vector<char> table((size_t)super_block.csum_blocks * BLOCK_SIZE);
+    if (!region_io(super_block.csum_start, super_block.csum_blocks, table, false)) {
+        csum.reset();
+        return false;
+    }
+    csum->st.from_checkpoint = csum->load(table);
+    if (!csum->st.from_checkpoint) {
+        std::cerr << "校验表自身校验失败，已丢弃旧校验和（之后首次读取时重新登记）" << std::endl;
+    } else if (csum->st.unclean) {
+        std::cerr << "校验表不是干净卸载时写入的，沿用其中有效的校验和（异常退出前改写过的块首次读取时重新登记）"
+                  << std::endl;
+    }
+    if (read_only) return true;
+
+    // 磁盘副本从读到的表开始：表有效时只有表头页需要重写
+    if (csum->st.from_checkpoint) csum->image.swap(table);
+    return csum_save(false);
+}
+
+/**
+ * @brief 卸载（以及格式化结束）时写入完整的校验表并标记为干净
+ */
+bool DiskFS::csum_detach()
+{
+    if (!csum) return true;
+    bool ok = csum_save(true);
+    csum.reset();
+    return ok;
+}
+
+/**
+ * @brief 按内存中的校验和写出校验表，只写与磁盘副本不同的页，表头页最后写
+ * @param clean 是否标记为干净（卸载时）
+ */
+bool DiskFS::csum_save(bool clean)
+{
+    std::vector<char> next;
+    csum->save(next, clean);
+    next.resize((size_t)super_block.csum_blocks * BLOCK_SIZE, 0);
+    std::vector<uint32_t> pages;
+    for (uint32_t i = 1; i < super_block.csum_blocks; i++) {
+        size_t off = (size_t)i * BLOCK_SIZE;
+        if (csum->image.size() != next.size() || memcmp(csum->image.data() + off, next.data() + off, BLOCK_SIZE) != 0) {
+            pages.push_back(i);
+        }
+    }
+    pages.push_back(0);
+    bool ok = csum_write_pages(next, pages);
+    csum->replace_image(next);
+    return ok;
+}
+
+/**
+ * @brief 写出磁盘副本中已标无效的页：块写出之前调用，保证异常退出后表中不留过期的有效项
+ */
+bool DiskFS::csum_write_intents()
+{
+    if (!csum || !csum->has_intents()) return true;
+    std::vector<uint32_t> pages;
+    csum->take_intents(pages, BLOCK_SIZE);
+    return csum_write_pages(csum->image, pages);
+}
+
+/**
+ * @brief 批次结束时调用：上次写出后改动较多就把校验表写出（不标记干净），
+ *        让异常退出后需要重新登记的项保持在少数
+ */
+bool DiskFS::csum_sync()
+{
+    if (!csum || read_only || csum->changes < CSUM_SAVE_CHANGES) return true;
+    return csum_save(false);
+}
+
+bool DiskFS::csum_write_pages(const std::vector<char>& table, const std::vector<uint32_t>& pages)
+{
+    std::vector<char> page(BLOCK_SIZE);
+    bool ok = true;
+    for (uint32_t p : pages) {
+        memcpy(page.data(), table.data() + (size_t)p * BLOCK_SIZE, BLOCK_SIZE);
+        ok = region_io(super_block.csum_start + p, 1, page, true) && ok;
+    }
+    if (!ok) std::cerr << "写入校验表失败" << std::endl;
+    return ok;
+}
+
+/**
+ * @brief 块是否受校验：位图块总是受校验，数据区的块在选择data时受校验
+ * （inode区按inode单独校验；超级块自带校验字段；校验表与去重表不在范围内）
+ */
+bool DiskFS::csum_covers(uint32_t block_num) const
+{
+    if (block_num >= super_block.block_bitmap && block_num < super_block.inode_start) return true;
+    return (csum->mode & CSUM_DATA) && block_num >= super_block.data_start &&
+           block_num < super_block.data_start + super_block.data_blocks;
+}
+
+/**
+ * @brief 比对读到的块，不符时计数并报告
+ * 通过的比对攒够一批才计入stats：每块调一次计数函数在默认构建下的开销与CRC本身相当
+ */
+bool DiskFS::csum_verify_block(uint32_t block_num, const char* buffer)
+{
+    uint64_t verified = csum->st.verified;
+    if (csum->check_block(block_num, buffer, BLOCK_SIZE)) {
+        if (csum->st.verified != verified && ++csum->unreported == CSUM_STATS_BATCH) csum_report();
+        return true;
+    }
+    STATS_ADD(STAT_CSUM_ERRORS, 1);
+    std::cerr << "校验和不符：块 " << block_num << std::endl;
+    return false;
+}
+
+bool DiskFS::csum_verify_inode(uint32_t inode_num, const Inode& inode)
+{
+    uint64_t verified = csum->st.verified;
+    if (csum->check_inode(inode_num, (const char*)&inode, sizeof(Inode))) {
+        if (csum->st.verified != verified && ++csum->unreported == CSUM_STATS_BATCH) csum_report();
+        return true;
+    }
+    STATS_ADD(STAT_CSUM_ERRORS, 1);
+    std::cerr << "校验和不符：inode " << inode_num << std::endl;
+    return false;
+}
+
+/**
+ * @brief 把攒下的通过次数计入stats（读取或清零统计前也调用）
+ */
+void DiskFS::csum_report() const
+{
+    if (!csum || csum->unreported == 0) return;
+    STATS_ADD(STAT_CSUM_VERIFIED, csum->unreported);
+    csum->unreported = 0;
+}
+
+/**
+ * @brief 写出超级块前更新其校验字段（启用校验时）
+ */
+void DiskFS::csum_seal_super()
+{
+    if (super_block.csum_mode == 0) return;
+    super_block.sb_checksum = 0;
+    super_block.sb_checksum = crc32c(0, &super_block, sizeof(SuperBlock));
+}
+
+/**
+ * @brief 挂载时校验刚读入的超级块
+ */
+bool DiskFS::csum_check_super()
+{
+    if (super_block.csum_mode == 0) return true;
+    uint32_t saved = super_block.sb_checksum;
+    super_block.sb_checksum = 0;
+    uint32_t c = crc32c(0, &super_block, sizeof(SuperBlock));
+    super_block.sb_checksum = saved;
+    if (c == saved) return true;
+    STATS_ADD(STAT_CSUM_ERRORS, 1);
+    std::cerr << "校验和不符：超级块" << std::endl;
+    return false;
+}
+
+void DiskFS::print_csum_info() const
+{
+    if (!csum) return;
+    const CsumStats& st = csum->st;
+    std::cout << "块校验和:\n";
+    std::cout << "  范围: " << ((csum->mode & CSUM_DATA) ? "元数据+数据" : "元数据") << "，CRC32C实现: " << crc32c_impl()
+              << "，校验表 " << super_block.csum_blocks << " 块（"
+              << (!st.from_checkpoint ? "已重置" : st.unclean ? "沿用异常退出前写出的" : "来自干净卸载") << "）\n";
+    std::cout << "  读校验: 通过 " << st.verified << "，不符 " << st.errors << "，首次登记 " << st.adopted
+              << "；写更新 " << st.updated << "，改写前标无效 " << st.intents << " 次，写出校验表 " << st.saves
+              << " 次\n";
+}
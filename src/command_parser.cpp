@@ -1,50 +1,153 @@
 #include "../include/command_parser.h"
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
 #include <iostream>
-#include <sstream>
+#include <stdexcept>
 #include <vector>
 
 void CommandParser::print_help() const {
     std::cout << "磁盘模拟文件系统命令:\n";
-    std::cout << "  format      - 格式化磁盘\n";
-    std::cout << "  mount       - 挂载磁盘\n";
+    std::cout << "  format [log] [cow|dedup] [csum [data]] [tier <快速层文件> <块数>] [stripe <单元块数> <成员文件>...] - 格式化磁盘（log：日志结构布局；cow：块引用计数，支持克隆与快照；dedup：块去重（含cow）；csum：元数据校验和，data同时校验数据；tier：冷热分层，元数据与热块放在快速层；stripe：条带化到多个镜像）\n";
+    std::cout << "  mount [preload|ro|shared] | mount snapshot <快照名> - 挂载磁盘（preload：预读全部元数据；ro：只读；shared：只读并与其他进程共享元数据缓存；snapshot：只读挂载快照）\n";
     std::cout << "  umount      - 卸载磁盘\n";
     std::cout << "  info        - 显示磁盘信息\n";
     std::cout << "  create <文件名> - 创建文件\n";
     std::cout << "  open <文件名>   - 打开文件(获取inode)\n";
     std::cout << "  read <inode> <大小> - 读取文件\n";
     std::cout << "  write <inode> <内容> - 写入文件\n";
+    std::cout << "  truncate <inode> <大小> - 截断或扩展文件（缩短时整批释放尾部块）\n";
+    std::cout << "  fallocate <inode> <偏移> <长度> - 预分配一段连续空间（未写入部分读出为0）\n";
     std::cout << "  delete <文件名> - 删除文件\n";
     std::cout << "  ls          - 列出文件\n";
+    std::cout << "  stats [reset] - 显示I/O统计与操作延迟（reset清零）\n";
+    std::cout << "  trace start <文件> | trace stop - 开始/停止I/O追踪\n";
+    std::cout << "  device <hdd|ssd|ftl|ftl-cb|none> [参数] [realtime] - 设置设备时序模型\n";
+    std::cout << "  sched <noop|clook|deadline|none> [队列深度] - 设置I/O调度策略\n";
+    std::cout << "  batch begin | batch end - 开始/结束批量提交\n";
+    std::cout << "  clean [段数] - 清理日志段（仅日志结构布局）\n";
+    std::cout << "  frag        - 显示文件与空闲空间的碎片报告\n";
+    std::cout << "  defrag [文件名|*] [块预算] - 在线碎片整理（块预算为本次最多搬移块数）\n";
+    std::cout << "  fsck [check|fix] [线程数] - 一致性检查（fix就地修复位图、计数与坏指针）\n";
+    std::cout << "  import <主机路径> [目标名] [线程数] - 导入主机文件或目录（目录树展平为'_'连接的文件名）\n";
+    std::cout << "  export <文件名|*> <主机路径> [线程数] - 导出文件到主机（*导出全部文件到目录）\n";
+    std::cout << "  compress [文件名] <on|off> - 设置新建文件是否默认压缩，或转换指定文件的存储方式\n";
+    std::cout << "  clone <源文件> <新文件> - 写时复制克隆文件（共享数据块，只写元数据）\n";
+    std::cout << "  snapshot create|delete|rollback <快照名> | snapshot list - 创建/删除/回滚/列出快照\n";
+    std::cout << "  tier [migrate] - 显示冷热分层状态，或立即执行一轮热块迁移\n";
+    std::cout << "  blkmq [<硬件队列数>|off] [队列深度] - 启用/关闭多队列块层（不带参数显示各队列统计）\n";
+    std::cout << "  delalloc [on|off|flush] - 启用/关闭延迟块分配，或立即回写脏页（不带参数显示状态）\n";
     std::cout << "  help        - 显示帮助\n";
     std::cout << "  exit        - 退出\n";
 }
 
-bool CommandParser::execute_command(const std::string& command_line) {
-    std::istringstream iss(command_line);
-    std::vector<std::string> tokens;
-    std::string token;
-    while (iss >> token) {
-        tokens.push_back(token);
+/**
+ * @brief 按空白切分命令行，复用tokens/token_end的已有存储
+ * 脚本中大多数参数较短，落在std::string的内联缓冲内，稳定状态下逐条命令不再分配内存
+ */
+void CommandParser::tokenize(const std::string& line) {
+    size_t count = 0;
+    size_t i = 0;
+    while (true) {
+        while (i < line.size() && std::isspace((unsigned char)line[i])) i++;
+        if (i == line.size()) break;
+        size_t start = i;
+        while (i < line.size() && !std::isspace((unsigned char)line[i])) i++;
+        if (count == tokens.size()) {
+            tokens.emplace_back();
+            token_end.push_back(0);
+        }
+        tokens[count].assign(line, start, i - start);
+        token_end[count] = i;
+        count++;
     }
+    tokens.resize(count);
+    token_end.resize(count);
+}
+
+bool CommandParser::execute_command(const std::string& command_line) {
+    tokenize(command_line);
     if (tokens.empty()) return true;
 
     if (tokens[0] == "format") {
-        if (disk.format()) {
+        bool log_structured = tokens.size() >= 2 && tokens[1] == "log";
+        size_t pos = log_structured ? 2 : 1;
+        bool dedup = false;
+        bool cow = false;
+        uint32_t csum = 0;
+        std::string fast_path;
+        uint32_t fast_blocks = 0;
+        for (; pos < tokens.size() && tokens[pos] != "stripe"; pos++) {
+            if (tokens[pos] == "dedup") {
+                dedup = true;
+            } else if (tokens[pos] == "cow") {
+                cow = true;
+            } else if (tokens[pos] == "csum") {
+                csum |= CSUM_META;
+                if (pos + 1 < tokens.size() && tokens[pos + 1] == "data") {
+                    csum |= CSUM_DATA;
+                    pos++;
+                }
+            } else if (tokens[pos] == "tier") {
+                if (pos + 2 >= tokens.size()) {
+                    std::cout << "用法: format ... tier <快速层文件> <块数>\n";
+                    return false;
+                }
+                fast_path = tokens[pos + 1];
+                fast_blocks = (uint32_t)std::stoul(tokens[pos + 2]);
+                pos += 2;
+            } else {
+                std::cout << "未知的格式化选项: " << tokens[pos] << "\n";
+                return false;
+            }
+        }
+        std::vector<std::string> members;
+        uint32_t unit = 0;
+        if (pos < tokens.size() && tokens[pos] == "stripe") {
+            if (pos + 2 >= tokens.size()) {
+                std::cout << "用法: format [log] [cow|dedup] [csum [data]] stripe <单元块数> <成员文件>...\n";
+                return false;
+            }
+            unit = (uint32_t)std::stoul(tokens[pos + 1]);
+            members.assign(tokens.begin() + pos + 2, tokens.end());
+        }
+        if (!disk.set_stripe(members, unit)) return false;
+        if (!disk.set_tier(fast_path, fast_blocks)) return false;
+        disk.set_dedup(dedup);
+        disk.set_cow(cow);
+        disk.set_checksums(csum);
+        if (disk.format(log_structured)) {
             std::cout << "格式化成功\n";
         } else {
             std::cout << "格式化失败\n";
+            return false;
         }
     } else if (tokens[0] == "mount") {
-        if (disk.mount()) {
+        if (tokens.size() >= 2 && tokens[1] == "snapshot") {
+            if (tokens.size() < 3) {
+                std::cout << "用法: mount snapshot <快照名>\n";
+                return false;
+            }
+            if (!disk.mount_snapshot(tokens[2])) {
+                std::cout << "挂载快照失败\n";
+                return false;
+            }
+            std::cout << "已只读挂载快照 " << tokens[2] << "\n";
+        } else if (disk.mount(tokens.size() >= 2 && tokens[1] == "preload",
+                              tokens.size() >= 2 && (tokens[1] == "ro" || tokens[1] == "shared"),
+                              tokens.size() >= 2 && tokens[1] == "shared")) {
             std::cout << "挂载成功\n";
         } else {
             std::cout << "挂载失败\n";
+            return false;
         }
     } else if (tokens[0] == "umount") {
         if (disk.unmount()) {
             std::cout << "卸载成功\n";
         } else {
             std::cout << "卸载失败\n";
+            return false;
         }
     } else if (tokens[0] == "info") {
         disk.print_info();
@@ -58,6 +161,7 @@ bool CommandParser::execute_command(const std::string& command_line) {
             std::cout << "创建文件成功，inode: " << inode << "\n";
         } else {
             std::cout << "创建文件失败\n";
+            return false;
         }
     } else if (tokens[0] == "open") {
         if (tokens.size() < 2) {
@@ -69,6 +173,7 @@ bool CommandParser::execute_command(const std::string& command_line) {
             std::cout << "文件打开成功，inode: " << inode << "\n";
         } else {
             std::cout << "文件不存在\n";
+            return false;
         }
     } else if (tokens[0] == "read") {
         if (tokens.size() < 3) {
@@ -84,10 +189,12 @@ bool CommandParser::execute_command(const std::string& command_line) {
             std::cout << "读取成功，" << bytes_read << "字节:\n" << buffer << "\n";
         } else if (bytes_read == 0) {
             std::cout << "文件为空或已到末尾\n";
-        } else {
-            std::cout << "读取失败\n";
         }
         delete[] buffer;
+        if (bytes_read < 0) {
+            std::cout << "读取失败\n";
+            return false;
+        }
     } else if (tokens[0] == "write") {
         if (tokens.size() < 2) {
             std::cout << "用法: write <inode> <内容>\n";
@@ -95,8 +202,7 @@ bool CommandParser::execute_command(const std::string& command_line) {
         }
         int inode = std::stoi(tokens[1]);
         std::string content;
-        size_t pos = command_line.find(tokens[0]) + tokens[0].size();
-        pos = command_line.find(tokens[1], pos) + tokens[1].size();
+        size_t pos = token_end[1];
         if (pos < command_line.size()) {
             content = command_line.substr(pos + 1);
         }
@@ -105,6 +211,31 @@ bool CommandParser::execute_command(const std::string& command_line) {
             std::cout << "写入成功，" << bytes_written << "字节\n";
         } else {
             std::cout << "写入失败\n";
+            return false;
+        }
+    } else if (tokens[0] == "truncate") {
+        if (tokens.size() < 3) {
+            std::cout << "用法: truncate <inode> <大小>\n";
+            return false;
+        }
+        int freed = disk.truncate_file(std::stoi(tokens[1]), std::stoul(tokens[2]));
+        if (freed >= 0) {
+            std::cout << "截断成功，释放 " << freed << " 个块\n";
+        } else {
+            std::cout << "截断失败\n";
+            return false;
+        }
+    } else if (tokens[0] == "fallocate") {
+        if (tokens.size() < 4) {
+            std::cout << "用法: fallocate <inode> <偏移> <长度>\n";
+            return false;
+        }
+        int reserved = disk.fallocate_file(std::stoi(tokens[1]), std::stoul(tokens[2]), std::stoul(tokens[3]));
+        if (reserved >= 0) {
+            std::cout << "预分配成功，新预留 " << reserved << " 个块\n";
+        } else {
+            std::cout << "预分配失败\n";
+            return false;
         }
     } else if (tokens[0] == "delete") {
         if (tokens.size() < 2) {
@@ -115,6 +246,7 @@ bool CommandParser::execute_command(const std::string& command_line) {
             std::cout << "删除文件成功\n";
         } else {
             std::cout << "删除文件失败\n";
+            return false;
         }
     } else if (tokens[0] == "ls") {
         std::vector<DirEntry> entries = disk.list_files();
@@ -124,15 +256,270 @@ bool CommandParser::execute_command(const std::string& command_line) {
                 std::cout << "  " << entry.name << " (inode: " << entry.inode_num << ")\n";
             }
         }
+    } else if (tokens[0] == "stats") {
+        if (tokens.size() >= 2 && tokens[1] == "reset") {
+            disk.reset_stats();
+            std::cout << "统计已清零\n";
+        } else {
+            disk.print_stats();
+        }
+    } else if (tokens[0] == "trace") {
+        if (tokens.size() >= 3 && tokens[1] == "start") {
+            if (disk.start_trace(tokens[2])) {
+                std::cout << "开始追踪，写入 " << tokens[2] << "\n";
+            } else {
+                std::cout << "开始追踪失败（已在追踪或文件无法创建）\n";
+                return false;
+            }
+        } else if (tokens.size() >= 2 && tokens[1] == "stop") {
+            std::cout << "追踪已停止，共写入 " << disk.stop_trace() << " 条记录\n";
+        } else {
+            std::cout << "用法: trace start <文件> | trace stop\n";
+            return false;
+        }
+    } else if (tokens[0] == "device") {
+        if (tokens.size() < 2) {
+            const DeviceModel* model = disk.device_model();
+            std::cout << "设备模型: " << (model ? model->describe() : std::string("none")) << "\n";
+            if (model) std::cout << model->report();
+            return true;
+        }
+        uint32_t param = 0;
+        bool realtime = false;
+        for (size_t i = 2; i < tokens.size(); i++) {
+            if (tokens[i] == "realtime") {
+                realtime = true;
+            } else {
+                param = (uint32_t)std::stoul(tokens[i]);
+            }
+        }
+        if (disk.set_device_model(tokens[1], param, realtime)) {
+            std::cout << "设备模型已设置为 " << tokens[1] << "\n";
+        } else {
+            std::cout << "未知设备模型，可选: hdd [转速] | ssd [通道数] | ftl/ftl-cb [预留%] | none\n";
+            return false;
+        }
+    } else if (tokens[0] == "sched") {
+        if (tokens.size() < 2) {
+            disk.print_scheduler_stats();
+            return true;
+        }
+        uint32_t depth = tokens.size() >= 3 ? (uint32_t)std::stoul(tokens[2]) : 0;
+        if (disk.set_scheduler(tokens[1], depth)) {
+            std::cout << "I/O调度策略已设置为 " << tokens[1] << "\n";
+        } else {
+            std::cout << "未知调度策略，可选: noop | clook | deadline | none\n";
+            return false;
+        }
+    } else if (tokens[0] == "batch") {
+        if (tokens.size() >= 2 && tokens[1] == "begin") {
+            disk.begin_batch();
+            std::cout << "批量提交开始\n";
+        } else if (tokens.size() >= 2 && tokens[1] == "end") {
+            if (!disk.end_batch()) {
+                std::cout << "批量提交失败\n";
+                return false;
+            }
+            std::cout << "批量提交完成\n";
+        } else {
+            std::cout << "用法: batch begin | batch end\n";
+            return false;
+        }
+    } else if (tokens[0] == "clean") {
+        if (!disk.is_log_structured()) {
+            std::cout << "当前不是日志结构布局（使用format log格式化）\n";
+            return false;
+        }
+        uint32_t count = tokens.size() >= 2 ? (uint32_t)std::stoul(tokens[1]) : 1;
+        std::cout << "已清理 " << disk.clean_segments(count) << " 个段\n";
+    } else if (tokens[0] == "frag") {
+        disk.print_frag_report();
+    } else if (tokens[0] == "defrag") {
+        std::string name = tokens.size() >= 2 && tokens[1] != "*" ? tokens[1] : "";
+        uint32_t budget = tokens.size() >= 3 ? (uint32_t)std::stoul(tokens[2]) : 0;
+        int moved = disk.defrag(name, budget);
+        if (moved < 0) {
+            std::cout << "碎片整理失败\n";
+            return false;
+        }
+        std::cout << "碎片整理完成，搬移 " << moved << " 块\n";
+    } else if (tokens[0] == "fsck") {
+        bool repair = tokens.size() >= 2 && tokens[1] == "fix";
+        uint32_t threads = tokens.size() >= 3 ? (uint32_t)std::stoul(tokens[2]) : 0;
+        FsckReport rep;
+        if (!disk.fsck(rep, repair, threads)) {
+            std::cout << "一致性检查失败\n";
+            return false;
+        }
+        print_fsck_report(rep);
+    } else if (tokens[0] == "import" || tokens[0] == "export") {
+        bool is_import = tokens[0] == "import";
+        if (tokens.size() < (is_import ? 2u : 3u)) {
+            std::cout << (is_import ? "用法: import <主机路径> [目标名] [线程数]\n"
+                                    : "用法: export <文件名|*> <主机路径> [线程数]\n");
+            return false;
+        }
+        std::string dest = is_import && tokens.size() >= 3 ? tokens[2] : "";
+        uint32_t threads = tokens.size() >= 4 ? (uint32_t)std::stoul(tokens[3]) : 0;
+        BulkStats st;
+        bool ok = is_import ? disk.import_path(tokens[1], dest, st, threads)
+                            : disk.export_path(tokens[1], tokens[2], st, threads);
+        if (!ok) {
+            std::cout << (is_import ? "导入失败\n" : "导出失败\n");
+            return false;
+        }
+        print_bulk_stats(is_import ? "导入" : "导出", st);
+    } else if (tokens[0] == "compress") {
+        const std::string& mode = tokens.size() >= 2 ? tokens.back() : "";
+        if ((tokens.size() != 2 && tokens.size() != 3) || (mode != "on" && mode != "off")) {
+            std::cout << "用法: compress [文件名] <on|off>\n";
+            return false;
+        }
+        bool ok = tokens.size() == 2 ? disk.set_compress(mode == "on") : disk.compress_file(tokens[1], mode == "on");
+        if (!ok) {
+            std::cout << "设置压缩失败\n";
+            return false;
+        }
+        std::cout << (tokens.size() == 2 ? "新建文件默认" : "文件 " + tokens[1] + " 已改为")
+                  << (mode == "on" ? "压缩" : "不压缩") << "\n";
+    } else if (tokens[0] == "clone") {
+        if (tokens.size() < 3) {
+            std::cout << "用法: clone <源文件> <新文件>\n";
+            return false;
+        }
+        int inode = disk.clone_file(tokens[1], tokens[2]);
+        if (inode == -1) {
+            std::cout << "克隆失败\n";
+            return false;
+        }
+        std::cout << "克隆成功，inode: " << inode << "\n";
+    } else if (tokens[0] == "snapshot") {
+        const std::string& sub = tokens.size() >= 2 ? tokens[1] : "";
+        if (sub == "list") {
+            std::vector<SnapEntry> snaps = disk.list_snapshots();
+            std::cout << "快照数: " << snaps.size() << "\n";
+            for (const auto& snap : snaps) {
+                char when[32];
+                time_t t = (time_t)snap.create_time;
+                strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&t));
+                std::cout << "  " << snap.name << "  " << when << "  文件数 " << snap.files << "\n";
+            }
+            return true;
+        }
+        if (tokens.size() < 3 || (sub != "create" && sub != "delete" && sub != "rollback")) {
+            std::cout << "用法: snapshot create|delete|rollback <快照名> | snapshot list\n";
+            return false;
+        }
+        bool ok = sub == "create" ? disk.snapshot_create(tokens[2])
+                  : sub == "delete" ? disk.snapshot_delete(tokens[2])
+                                    : disk.snapshot_rollback(tokens[2]);
+        if (!ok) {
+            std::cout << "快照操作失败\n";
+            return false;
+        }
+        std::cout << "快照 " << tokens[2] << (sub == "create" ? " 已创建" : sub == "delete" ? " 已删除" : " 已回滚") << "\n";
+    } else if (tokens[0] == "tier") {
+        if (tokens.size() >= 2 && tokens[1] == "migrate") {
+            int moved = disk.tier_migrate();
+            if (moved < 0) {
+                std::cout << "迁移失败\n";
+                return false;
+            }
+            std::cout << "本轮提升 " << moved << " 块到快速层\n";
+        } else if (disk.tier_set()) {
+            disk.print_tier_info();
+        } else {
+            std::cout << "未启用冷热分层\n";
+        }
+    } else if (tokens[0] == "blkmq") {
+        if (tokens.size() < 2) {
+            if (disk.block_mq()) {
+                disk.print_mq_info();
+            } else {
+                std::cout << "未启用多队列块层\n";
+            }
+            return true;
+        }
+        uint32_t queues = tokens[1] == "off" ? 0 : (uint32_t)std::stoul(tokens[1]);
+        uint32_t depth = tokens.size() >= 3 ? (uint32_t)std::stoul(tokens[2]) : MQ_DEFAULT_DEPTH;
+        if (!disk.set_block_mq(queues, depth)) {
+            std::cout << "多队列块层设置失败\n";
+            return false;
+        }
+        if (queues == 0) {
+            std::cout << "多队列块层已关闭\n";
+        } else {
+            std::cout << "多队列块层: " << queues << " 个硬件队列，环深度 " << depth << "\n";
+        }
+    } else if (tokens[0] == "delalloc") {
+        const std::string& sub = tokens.size() >= 2 ? tokens[1] : "";
+        if (sub.empty()) {
+            if (disk.delalloc_cache()) {
+                disk.print_delalloc_info();
+            } else {
+                std::cout << "未启用延迟分配\n";
+            }
+            return true;
+        }
+        if (sub != "on" && sub != "off" && sub != "flush") {
+            std::cout << "用法: delalloc [on|off|flush]\n";
+            return false;
+        }
+        bool ok = sub == "flush" ? disk.delalloc_flush() : disk.set_delalloc(sub == "on");
+        if (!ok) {
+            std::cout << "延迟分配操作失败\n";
+            return false;
+        }
+        std::cout << (sub == "flush" ? "脏页已回写" : sub == "on" ? "延迟分配已启用" : "延迟分配已关闭") << "\n";
     } else if (tokens[0] == "help") {
         print_help();
     } else if (tokens[0] == "exit") {
-        if (disk.isMounted()) {
-            disk.unmount();
-        }
-        exit(0);
+        quit = true;
     } else {
         std::cout << "未知命令，请输入help查看帮助\n";
+        return false;
     }
     return true;
-}
\ No newline at end of file
+}
+/**
+ * @brief 非交互执行命令脚本（不输出提示符与帮助）
+ * 空行与'#'开头的行跳过；参数格式错误的命令计为失败
+ * @param in 脚本输入（文件或标准输入）
+ * @param opt 执行选项
+ * @param st 输出统计
+ * @return 全部命令成功返回true
+ */
+bool CommandParser::run_script(std::istream& in, const ScriptOptions& opt, ScriptStats& st) {
+    st = ScriptStats();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string line;
+    while (!quit && std::getline(in, line)) {
+        st.lines++;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        if (opt.echo) std::cout << "> " << line << "\n";
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        bool ok;
+        try {
+            ok = execute_command(line);
+        } catch (const std::exception&) {
+            std::cout << "参数错误: " << line << "\n";
+            ok = false;
+        }
+        st.commands++;
+        if (opt.timing) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            char col[32];
+            snprintf(col, sizeof(col), "[%10.3f ms] ", ms);
+            std::cout << col << (ok ? "ok   " : "FAIL ") << line << "\n";
+        }
+        if (!ok) {
+            st.failed++;
+            if (st.first_error == 0) st.first_error = st.lines;
+            if (opt.stop_on_error) break;
+        }
+    }
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return st.failed == 0;
+}
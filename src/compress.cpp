@@ -0,0 +1,488 @@
+#include "../include/compress.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static_assert(sizeof(Inode) == INODE_SIZE, "inode大小必须保持不变");
+static_assert(COMPRESS_CLUSTER_BYTES == COMPRESS_CLUSTER_BLOCKS * BLOCK_SIZE, "簇字节数与块大小不一致");
+static_assert(16 % COMPRESS_CLUSTER_BLOCKS == 0, "直接块数必须是簇块数的整数倍");
+
+namespace {
+
+const uint32_t LZ_HASH_BITS = 12;    // 匹配查找表4096项
+const size_t LZ_MIN_MATCH = 4;
+const size_t LZ_LAST_LITERALS = 5;   // 块末尾至少5字节按字面量存放（LZ4格式要求）
+const size_t LZ_MF_LIMIT = 12;       // 最后一个匹配必须在距末尾12字节之前开始
+const size_t LZ_MAX_OFFSET = 65535;
+
+uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// 写入长度的扩展字节（每个255表示继续）
+uint8_t* put_length(uint8_t* op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/**
+ * @brief 输出一个序列：字面量 + （可选）匹配
+ * @return 新的输出位置；空间不足返回nullptr
+ */
+uint8_t* put_sequence(uint8_t* op, uint8_t* op_end, const uint8_t* lit, size_t lit_len, size_t offset, size_t match_len)
+{
+    size_t need = 1 + lit_len + lit_len / 255 + 1 + (offset ? 2 + match_len / 255 + 1 : 0);
+    if ((size_t)(op_end - op) < need) return nullptr;
+    uint8_t* token = op++;
+    *token = (uint8_t)(std::min<size_t>(lit_len, 15) << 4);
+    if (lit_len >= 15) op = put_length(op, lit_len - 15);
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+    if (offset) {
+        *op++ = (uint8_t)(offset & 0xFF);
+        *op++ = (uint8_t)(offset >> 8);
+        size_t ml = match_len - LZ_MIN_MATCH;
+        *token |= (uint8_t)std::min<size_t>(ml, 15);
+        if (ml >= 15) op = put_length(op, ml - 15);
+    }
+    return op;
+}
+
+// 簇的逻辑长度：文件大小决定尾簇的长度，超出文件末尾的簇为0
+uint32_t cluster_len(uint32_t file_size, uint32_t cluster)
+{
+    uint64_t start = (uint64_t)cluster * COMPRESS_CLUSTER_BYTES;
+    if (file_size <= start) return 0;
+    return (uint32_t)std::min<uint64_t>(COMPRESS_CLUSTER_BYTES, file_size - start);
+}
+
+}  // namespace
+
+size_t lz_compress(const char* src, size_t len, char* dst, size_t cap)
+{
+    const uint8_t* in = (const uint8_t*)src;
+    uint8_t* op = (uint8_t*)dst;
+    uint8_t* op_end = op + cap;
+    size_t anchor = 0;
+
+    if (len > LZ_MF_LIMIT) {
+        uint32_t table[1u << LZ_HASH_BITS];
+        memset(table, 0, sizeof(table));
+        size_t limit = len - LZ_MF_LIMIT;
+        size_t ip = 1;
+        while (ip < limit) {
+            uint32_t seq = read32(in + ip);
+            uint32_t h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+            size_t cand = table[h];
+            table[h] = (uint32_t)ip;
+            if (cand >= ip || ip - cand > LZ_MAX_OFFSET || read32(in + cand) != seq) {
+                ip += 1 + ((ip - anchor) >> 6);  // 连续未命中时加大步长，不可压缩的数据很快跳过
+                continue;
+            }
+            size_t match_end = ip + LZ_MIN_MATCH;
+            size_t match_limit = len - LZ_LAST_LITERALS;
+            while (match_end < match_limit && in[match_end] == in[cand + match_end - ip]) match_end++;
+            while (ip > anchor && cand > 0 && in[ip - 1] == in[cand - 1]) {  // 向前扩展
+                ip--;
+                cand--;
+            }
+            op = put_sequence(op, op_end, in + anchor, ip - anchor, ip - cand, match_end - ip);
+            if (!op) return 0;
+            ip = anchor = match_end;
+        }
+    }
+    op = put_sequence(op, op_end, in + anchor, len - anchor, 0, 0);
+    return op ? (size_t)(op - (uint8_t*)dst) : 0;
+}
+
+bool lz_decompress(const char* src, size_t len, char* dst, size_t out_len)
+{
+    const uint8_t* ip = (const uint8_t*)src;
+    const uint8_t* ip_end = ip + len;
+    uint8_t* out = (uint8_t*)dst;
+    size_t pos = 0;
+
+    while (ip < ip_end) {
+        uint8_t token = *ip++;
+        size_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= ip_end) return false;
+                b = *ip++;
+                lit_len += b;
+            } while (b == 255);
+        }
+        if ((size_t)(ip_end - ip) < lit_len || out_len - pos < lit_len) return false;
+        memcpy(out + pos, ip, lit_len);
+        ip += lit_len;
+        pos += lit_len;
+        if (ip == ip_end) break;  // 最后一个序列只有字面量
+
+        if (ip_end - ip < 2) return false;
+        size_t offset = ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        size_t match_len = token & 0x0F;
+        if (match_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= ip_end) return false;
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += LZ_MIN_MATCH;
+        if (offset == 0 || offset > pos || out_len - pos < match_len) return false;
+        // 匹配可能与输出重叠（offset小于长度时重复最近的字节），逐字节复制
+        const uint8_t* from = out + pos - offset;
+        for (size_t i = 0; i < match_len; i++) out[pos + i] = from[i];
+        pos += match_len;
+    }
+    return pos == out_len;
+}
+
+ClusterCache::ClusterCache(size_t capacity) : capacity(capacity) {}
+
+const std::vector<char>* ClusterCache::lookup(uint32_t inode_num, uint32_t cluster)
+{
+    auto it = index.find(make_key(inode_num, cluster));
+    if (it == index.end()) return nullptr;
+    lru.splice(lru.begin(), lru, it->second);
+    return &it->second->data;
+}
+
+void ClusterCache::insert(uint32_t inode_num, uint32_t cluster, const char* data, size_t len)
+{
+    uint64_t key = make_key(inode_num, cluster);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+    } else {
+        if (capacity == 0) return;
+        if (lru.size() >= capacity) {
+            index.erase(lru.back().key);
+            lru.pop_back();
+        }
+        lru.push_front(Entry());
+        lru.front().key = key;
+        index[key] = lru.begin();
+    }
+    lru.front().data.assign(data, data + len);
+}
+
+void ClusterCache::erase(uint32_t inode_num, uint32_t cluster)
+{
+    auto it = index.find(make_key(inode_num, cluster));
+    if (it == index.end()) return;
+    lru.erase(it->second);
+    index.erase(it);
+}
+
+void ClusterCache::invalidate(uint32_t inode_num)
+{
+    for (uint32_t c = 0; c < 16 / COMPRESS_CLUSTER_BLOCKS; c++) erase(inode_num, c);
+}
+
+void ClusterCache::clear()
+{
+    lru.clear();
+    index.clear();
+}
+
+/**
+ * @brief 读取压缩文件第cluster个簇中[from, from+len)的逻辑内容
+ * 原样存放的簇只读涉及的块；压缩的簇先查簇缓存，未命中时读出全部压缩块并解压后放入缓存；空洞读为0
+ * @param size 簇的逻辑长度（按文件当前大小计算）
+ */
+bool DiskFS::read_cluster(uint32_t inode_num, const Inode& inode, uint32_t cluster, uint32_t size, uint32_t from,
+                          uint32_t len, char* out)
+{
+    const uint32_t* slots = inode.blocks + cluster * COMPRESS_CLUSTER_BLOCKS;
+    uint32_t used = 0;
+    while (used < COMPRESS_CLUSTER_BLOCKS && slots[used] != 0) used++;
+    uint32_t raw_blocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    if (used == 0 || used >= raw_blocks) {
+        char block[BLOCK_SIZE];
+        for (uint32_t pos = from; pos < from + len;) {
+            uint32_t idx = pos / BLOCK_SIZE;
+            uint32_t in_block = pos % BLOCK_SIZE;
+            uint32_t n = std::min<uint32_t>(BLOCK_SIZE - in_block, from + len - pos);
+            if (slots[idx] == 0) {
+                memset(out + (pos - from), 0, n);
+            } else {
+                if (!read_block(slots[idx], block)) return false;
+                memcpy(out + (pos - from), block + in_block, n);
+            }
+            pos += n;
+        }
+        return true;
+    }
+
+    const std::vector<char>* data = cluster_cache.lookup(inode_num, cluster);
+    if (data && data->size() == size) {
+        compress_st.cache_hits++;
+    } else {
+        compress_st.cache_misses++;
+        std::vector<char> packed((size_t)used * BLOCK_SIZE);
+        for (uint32_t i = 0; i < used; i++) {
+            if (!read_block(slots[i], packed.data() + (size_t)i * BLOCK_SIZE)) return false;
+        }
+        ClusterHeader hdr;
+        memcpy(&hdr, packed.data(), sizeof(hdr));
+        std::vector<char> plain(size);
+        if (hdr.magic != CLUSTER_MAGIC || hdr.comp_len > packed.size() - sizeof(hdr) ||
+            !lz_decompress(packed.data() + sizeof(hdr), hdr.comp_len, plain.data(), size)) {
+            std::cerr << "读取失败：inode " << inode_num << " 的第" << cluster << "簇压缩数据损坏" << std::endl;
+            return false;
+        }
+        cluster_cache.insert(inode_num, cluster, plain.data(), size);
+        data = cluster_cache.lookup(inode_num, cluster);
+    }
+    memcpy(out, data->data() + from, len);
+    return true;
+}
+
+/**
+ * @brief 把簇的逻辑内容写回：能省下至少一块时压缩存放，否则原样存放
+ * 簇内已有的块按槽位顺序重用，多余的释放，不足的再分配；分配失败时簇保持原状
+ * @param size 簇的新逻辑长度
+ * @return 成功返回true；空间不足或IO失败返回false
+ */
+bool DiskFS::write_cluster(uint32_t inode_num, Inode& inode, uint32_t cluster, const char* data, uint32_t size)
+{
+    uint32_t* slots = inode.blocks + cluster * COMPRESS_CLUSTER_BLOCKS;
+    uint32_t raw_blocks = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    std::vector<char> packed;
+    size_t comp_len = 0;
+    if (raw_blocks > 1) {
+        size_t cap = (size_t)(raw_blocks - 1) * BLOCK_SIZE - sizeof(ClusterHeader);
+        packed.assign((size_t)(raw_blocks - 1) * BLOCK_SIZE, 0);
+        comp_len = lz_compress(data, size, packed.data() + sizeof(ClusterHeader), cap);
+    }
+    uint32_t need = raw_blocks;
+    const char* src = data;
+    size_t src_len = size;
+    if (comp_len > 0) {
+        ClusterHeader hdr = {CLUSTER_MAGIC, (uint32_t)comp_len};
+        memcpy(packed.data(), &hdr, sizeof(hdr));
+        src_len = sizeof(hdr) + comp_len;
+        need = (uint32_t)((src_len + BLOCK_SIZE - 1) / BLOCK_SIZE);
+        src = packed.data();
+    }
+
+    // 可原地改写的旧块；与克隆或快照共享的旧块不改写，写完后只减少引用（写时复制）
+    std::vector<uint32_t> have, shared;
+    for (uint32_t i = 0; i < COMPRESS_CLUSTER_BLOCKS; i++) {
+        if (slots[i] == 0) continue;
+        if (dedup && dedup->refs(slots[i]) > 1) {
+            shared.push_back(slots[i]);
+        } else {
+            have.push_back(slots[i]);
+        }
+    }
+    std::vector<uint32_t> layout(have.begin(), have.begin() + std::min<size_t>(have.size(), need));
+    while (layout.size() < need) {
+        int block_num = find_free_block();
+        if (block_num == -1) {
+            for (size_t i = have.size(); i < layout.size(); i++) set_block_bitmap(layout[i], false);
+            std::cerr << "写入失败：inode " << inode_num << " 的第" << cluster << "簇没有足够的空闲块" << std::endl;
+            return false;
+        }
+        set_block_bitmap(block_num, true);
+        layout.push_back((uint32_t)block_num);
+    }
+
+    char block[BLOCK_SIZE];
+    for (uint32_t i = 0; i < need; i++) {
+        size_t n = std::min<size_t>(BLOCK_SIZE, src_len - (size_t)i * BLOCK_SIZE);
+        memcpy(block, src + (size_t)i * BLOCK_SIZE, n);
+        memset(block + n, 0, BLOCK_SIZE - n);
+        if (!write_block(layout[i], block)) return false;
+    }
+    for (size_t i = need; i < have.size(); i++) release_block(have[i]);
+    for (uint32_t b : shared) release_block(b);
+    for (uint32_t i = 0; i < COMPRESS_CLUSTER_BLOCKS; i++) slots[i] = i < need ? layout[i] : 0;
+
+    compress_st.logical_bytes += size;
+    compress_st.stored_bytes += (uint64_t)need * BLOCK_SIZE;
+    if (comp_len > 0) {
+        compress_st.clusters_packed++;
+        cluster_cache.insert(inode_num, cluster, data, size);
+    } else {
+        compress_st.clusters_raw++;
+        cluster_cache.erase(inode_num, cluster);
+    }
+    return true;
+}
+
+/**
+ * @brief 读取压缩文件（read_file在inode带INODE_COMPRESSED标志时调用）：逐簇读取涉及的范围
+ */
+int DiskFS::compressed_read(uint32_t inode_num, const Inode& inode, char* buffer, size_t size, off_t offset)
+{
+    size_t done = 0;
+    while (done < size) {
+        uint64_t pos = (uint64_t)offset + done;
+        uint32_t c = (uint32_t)(pos / COMPRESS_CLUSTER_BYTES);
+        uint32_t in_cluster = (uint32_t)(pos % COMPRESS_CLUSTER_BYTES);
+        uint32_t csize = cluster_len(inode.size, c);
+        if (csize <= in_cluster) break;
+        uint32_t n = (uint32_t)std::min<size_t>(csize - in_cluster, size - done);
+        if (!read_cluster(inode_num, inode, c, csize, in_cluster, n, buffer + done)) return -1;
+        done += n;
+    }
+    return (int)done;
+}
+
+/**
+ * @brief 写入压缩文件（write_file在inode带INODE_COMPRESSED标志时调用）
+ * 涉及的簇整簇读-改-写（整簇覆盖时不读）并重新压缩；文件变长时原尾簇的逻辑长度随之改变，一并重写
+ * @return 写入的字节数；写到一半空间不足时返回已写入的部分，与普通文件一致
+ */
+int DiskFS::compressed_write(uint32_t inode_num, Inode& inode, const char* buffer, size_t size, off_t offset)
+{
+    const uint64_t max_size = 16 * (uint64_t)BLOCK_SIZE;
+    if ((uint64_t)offset >= max_size) return 0;
+    uint64_t end = std::min<uint64_t>((uint64_t)offset + size, max_size);
+    uint32_t new_size = (uint32_t)std::max<uint64_t>(inode.size, end);
+    uint32_t first = (uint32_t)(offset / COMPRESS_CLUSTER_BYTES);
+    uint32_t last = (uint32_t)((end - 1) / COMPRESS_CLUSTER_BYTES);
+    if (inode.size > 0 && new_size > inode.size) first = std::min(first, (inode.size - 1) / COMPRESS_CLUSTER_BYTES);
+
+    std::vector<char> cluster(COMPRESS_CLUSTER_BYTES);
+    uint64_t stored_end = 0;
+    for (uint32_t c = first; c <= last; c++) {
+        uint64_t start = (uint64_t)c * COMPRESS_CLUSTER_BYTES;
+        uint32_t old_len = cluster_len(inode.size, c);
+        uint32_t new_len = cluster_len(new_size, c);
+        uint64_t from = std::max<uint64_t>(offset, start);
+        uint64_t to = std::min<uint64_t>(end, start + new_len);
+        if (from > start || to < start + new_len) {  // 整簇覆盖时不必读出旧内容
+            memset(cluster.data(), 0, new_len);
+            if (old_len > 0 && !read_cluster(inode_num, inode, c, old_len, 0, old_len, cluster.data())) return -1;
+        }
+        if (to > from) memcpy(cluster.data() + (from - start), buffer + (from - offset), to - from);
+        if (!write_cluster(inode_num, inode, c, cluster.data(), new_len)) break;
+        stored_end = start + new_len;
+    }
+
+    if (stored_end > inode.size) inode.size = (uint32_t)stored_end;
+    inode.modify_time = time(nullptr);
+    write_inode(inode_num, inode);
+    uint64_t written_end = std::min(end, stored_end);
+    return written_end > (uint64_t)offset ? (int)(written_end - offset) : 0;
+}
+
+/**
+ * @brief 设置新建文件是否默认压缩（记录在超级块中，已有文件不受影响）
+ */
+bool DiskFS::set_compress(bool on)
+{
+    if (!isMounted()) {
+        std::cerr << "设置压缩失败：磁盘未挂载" << std::endl;
+        return false;
+    }
+    if (reject_read_only("设置压缩")) return false;
+    super_block.compress = on ? 1 : 0;
+    return write_super_block();
+}
+
+/**
+ * @brief 转换已有文件的存储方式：读出全部内容，按新方式写入新分配的块，一次写回inode后才释放原有块
+ * 转换期间新旧两份同时占用空间；空间不足或IO失败时回收新块，文件保持原样
+ * @param name 文件名
+ * @param on true表示改为压缩存放，false表示改为普通存放
+ * @return 成功返回true；文件不存在或重新写入失败返回false
+ */
+bool DiskFS::compress_file(const std::string& name, bool on)
+{
+    IoBatch batch(*this);
+    if (reject_read_only("压缩转换")) return false;
+    int inode_num = isMounted() ? find_entry(name) : -1;
+    Inode inode;
+    if (inode_num == -1 || !read_inode(inode_num, inode) || !inode.used || inode.type != 1) {
+        std::cerr << "压缩转换失败：文件 " << name << " 不存在" << std::endl;
+        return false;
+    }
+    if (((inode.flags & INODE_COMPRESSED) != 0) == on) return true;
+    if (!delalloc_flush(inode_num) || !read_inode(inode_num, inode)) return false;
+
+    std::vector<char> data(inode.size);
+    if (read_file(inode_num, data.data(), data.size(), 0) != (int)data.size()) {
+        std::cerr << "压缩转换失败：读取 " << name << " 失败" << std::endl;
+        return false;
+    }
+
+    // 新布局记在临时inode中，原有的块在提交前保持不动
+    Inode next = inode;
+    memset(next.blocks, 0, sizeof(next.blocks));
+    next.flags = on ? (inode.flags | INODE_COMPRESSED) : (inode.flags & ~INODE_COMPRESSED);
+    next.unwritten = 0;
+    cluster_cache.invalidate(inode_num);
+    bool ok = true;
+    if (on) {
+        for (uint32_t c = 0; ok && (size_t)c * COMPRESS_CLUSTER_BYTES < data.size(); c++) {
+            ok = write_cluster(inode_num, next, c, data.data() + (size_t)c * COMPRESS_CLUSTER_BYTES,
+                               cluster_len(inode.size, c));
+        }
+    } else {
+        char block[BLOCK_SIZE];
+        for (uint32_t i = 0; ok && (size_t)i * BLOCK_SIZE < data.size(); i++) {
+            size_t n = std::min<size_t>(BLOCK_SIZE, data.size() - (size_t)i * BLOCK_SIZE);
+            memcpy(block, data.data() + (size_t)i * BLOCK_SIZE, n);
+            memset(block + n, 0, BLOCK_SIZE - n);
+            if (dedup) {
+                ok = dedup_store(next.blocks[i], block);
+                continue;
+            }
+            int block_num = find_free_block();
+            if (block_num == -1) {
+                ok = false;
+                break;
+            }
+            set_block_bitmap(block_num, true);
+            if (!write_block(block_num, block)) {
+                set_block_bitmap(block_num, false);
+                ok = false;
+                break;
+            }
+            next.blocks[i] = (uint32_t)block_num;
+        }
+    }
+    if (!ok || !write_inode(inode_num, next)) {
+        for (uint32_t i = 0; i < 16; i++) {
+            if (next.blocks[i] != 0) release_block(next.blocks[i]);
+        }
+        cluster_cache.invalidate(inode_num);
+        std::cerr << "压缩转换失败：重新写入 " << name << " 失败（空间不足或IO错误），文件保持原样" << std::endl;
+        return false;
+    }
+    for (uint32_t i = 0; i < 16; i++) {
+        if (inode.blocks[i] != 0) release_block(inode.blocks[i]);
+    }
+    return batch.end();
+}
+
+void DiskFS::print_compress_info() const
+{
+    const CompressStats& st = compress_st;
+    std::cout << "压缩:\n";
+    std::cout << "  新建文件默认: " << (super_block.compress ? "压缩" : "不压缩") << "，簇大小: "
+              << COMPRESS_CLUSTER_BYTES / 1024 << "KB\n";
+    if (st.clusters_packed + st.clusters_raw == 0) return;
+    std::cout << "  写入簇: 压缩 " << st.clusters_packed << "，原样 " << st.clusters_raw << "，逻辑 "
+              << st.logical_bytes / 1024 << "KB -> 落盘 " << st.stored_bytes / 1024 << "KB（"
+              << (st.stored_bytes ? (double)st.logical_bytes / st.stored_bytes : 0.0) << "x）\n";
+    std::cout << "  簇缓存: 命中 " << st.cache_hits << "，解压 " << st.cache_misses << "\n";
+}
@@ -0,0 +1,249 @@
+#include "../include/checksum.h"
+#include <cstring>
+
+// CRC32C内核单独成一个编译单元，由Makefile按-O2编译（其余代码仍按默认选项），
+// 每块都要过一遍的校验在不优化时会占掉大半读吞吐
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace {
+
+const uint32_t CRC32C_POLY = 0x82F63B78u;  // Castagnoli多项式（反射形式）
+const size_t CRC_STRIPE = 1360;            // 三路交错时每段的字节数（8的倍数，三段覆盖4KB块的前4080字节）
+const size_t FOLD_BYTES = 256;             // 无进位乘法折叠时每轮处理的字节数（4个512位累加器）
+
+/**
+ * @brief 查表实现的8路切片表，寄存器后接CRC_STRIPE/2*CRC_STRIPE个0字节的移位表，以及折叠常数
+ */
+struct CrcTables
+{
+    uint32_t t[8][256];
+    uint32_t shift1[4][256];
+    uint32_t shift2[4][256];
+    // 把128位数据向后折叠n位的常数对{x^(n+32), x^(n-32)} mod P（低64位乘前一个，高64位乘后一个）
+    uint64_t fold128[2];
+    uint64_t fold256[2];
+    uint64_t fold384[2];
+    uint64_t fold512[2];
+    uint64_t fold2048[2];
+
+    CrcTables()
+    {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c >> 1) ^ (c & 1 ? CRC32C_POLY : 0);
+            t[0][i] = c;
+        }
+        for (int k = 1; k < 8; k++) {
+            for (uint32_t i = 0; i < 256; i++) t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+        }
+        build_shift(shift1, CRC_STRIPE);
+        build_shift(shift2, 2 * CRC_STRIPE);
+        build_fold(fold128, 128);
+        build_fold(fold256, 256);
+        build_fold(fold384, 384);
+        build_fold(fold512, 512);
+        build_fold(fold2048, 8 * FOLD_BYTES);
+    }
+
+    // 后接n个0字节对寄存器是线性变换：先算32个单位向量的像，再按字节组合成表
+    void build_shift(uint32_t (&out)[4][256], size_t n)
+    {
+        uint32_t basis[32];
+        for (int bit = 0; bit < 32; bit++) {
+            uint32_t c = 1u << bit;
+            for (size_t i = 0; i < n; i++) c = t[0][c & 0xff] ^ (c >> 8);
+            basis[bit] = c;
+        }
+        for (int j = 0; j < 4; j++) {
+            for (uint32_t b = 0; b < 256; b++) {
+                uint32_t c = 0;
+                for (int bit = 0; bit < 8; bit++) {
+                    if (b & (1u << bit)) c ^= basis[8 * j + bit];
+                }
+                out[j][b] = c;
+            }
+        }
+    }
+
+    // x^e mod P的反射形式（最高位表示x^0，每乘一次x右移一位）；左移一位抵消反射域乘积的一位错位
+    static uint64_t xpow(size_t e)
+    {
+        uint32_t c = 0x80000000u;
+        for (size_t i = 0; i < e; i++) c = (c >> 1) ^ (c & 1 ? CRC32C_POLY : 0);
+        return (uint64_t)c << 1;
+    }
+
+    static void build_fold(uint64_t (&out)[2], size_t bits)
+    {
+        out[0] = xpow(bits + 32);
+        out[1] = xpow(bits - 32);
+    }
+};
+
+const CrcTables& tables()
+{
+    static const CrcTables tb;
+    return tb;
+}
+
+inline uint64_t load64(const unsigned char* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t apply_shift(const uint32_t (&sh)[4][256], uint32_t c)
+{
+    return sh[0][c & 0xff] ^ sh[1][(c >> 8) & 0xff] ^ sh[2][(c >> 16) & 0xff] ^ sh[3][c >> 24];
+}
+
+// 以下各实现只更新CRC寄存器，不做首尾取反
+
+uint32_t table_update(uint32_t c, const unsigned char* p, size_t len)
+{
+    const CrcTables& tb = tables();
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t v = load64(p);
+        uint32_t lo = (uint32_t)v ^ c;
+        uint32_t hi = (uint32_t)(v >> 32);
+        c = tb.t[7][lo & 0xff] ^ tb.t[6][(lo >> 8) & 0xff] ^ tb.t[5][(lo >> 16) & 0xff] ^ tb.t[4][lo >> 24] ^
+            tb.t[3][hi & 0xff] ^ tb.t[2][(hi >> 8) & 0xff] ^ tb.t[1][(hi >> 16) & 0xff] ^ tb.t[0][hi >> 24];
+    }
+    for (; len > 0; p++, len--) c = tb.t[0][(c ^ *p) & 0xff] ^ (c >> 8);
+    return c;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+uint32_t sse42_update(uint32_t crc, const unsigned char* p, size_t len)
+{
+    const CrcTables& tb = tables();
+    uint64_t c0 = crc;
+    // 三段互不依赖的crc32指令链交错执行，结果按段长移位后合并
+    for (; len >= 3 * CRC_STRIPE; p += 3 * CRC_STRIPE, len -= 3 * CRC_STRIPE) {
+        uint64_t c1 = 0, c2 = 0;
+        for (size_t i = 0; i < CRC_STRIPE; i += 8) {
+            c0 = _mm_crc32_u64(c0, load64(p + i));
+            c1 = _mm_crc32_u64(c1, load64(p + CRC_STRIPE + i));
+            c2 = _mm_crc32_u64(c2, load64(p + 2 * CRC_STRIPE + i));
+        }
+        c0 = apply_shift(tb.shift2, (uint32_t)c0) ^ apply_shift(tb.shift1, (uint32_t)c1) ^ (uint32_t)c2;
+    }
+    for (; len >= 8; p += 8, len -= 8) c0 = _mm_crc32_u64(c0, load64(p));
+    uint32_t c = (uint32_t)c0;
+    for (; len > 0; p++, len--) c = _mm_crc32_u8(c, *p);
+    return c;
+}
+
+// 128位数据x向后折叠k对应的位数，再与其后的数据next合并
+__attribute__((target("pclmul")))
+inline __m128i fold_xmm(__m128i x, const uint64_t (&k)[2], __m128i next)
+{
+    __m128i kk = _mm_loadu_si128((const __m128i*)k);
+    return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, kk, 0x00), _mm_clmulepi64_si128(x, kk, 0x11)), next);
+}
+
+__attribute__((target("avx512f,vpclmulqdq")))
+inline __m512i fold_zmm(__m512i x, __m512i k, __m512i next)
+{
+    return _mm512_xor_si512(_mm512_xor_si512(_mm512_clmulepi64_epi128(x, k, 0x00), _mm512_clmulepi64_epi128(x, k, 0x11)),
+                            next);
+}
+
+/**
+ * @brief AVX-512 VPCLMULQDQ折叠：4个512位累加器每轮吃进256字节，按2048位的距离无进位乘法折叠，
+ *        结束时逐级折叠成128位，再用两条crc32指令归约（同余的128位数据与原数据的CRC相同）
+ */
+__attribute__((target("sse4.2,pclmul,avx512f,vpclmulqdq")))
+uint32_t vpclmul_update(uint32_t crc, const unsigned char* p, size_t len)
+{
+    if (len < FOLD_BYTES) return sse42_update(crc, p, len);
+    const CrcTables& tb = tables();
+    __m512i k2048 = _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_loadu_si128((const __m128i*)tb.fold2048));
+    __m512i k512 = _mm512_maskz_broadcast_i32x4(0xFFFF, _mm_loadu_si128((const __m128i*)tb.fold512));
+    // 初始寄存器值异或进前4字节，等价于从该值开始计算
+    __m512i a0 = _mm512_xor_si512(_mm512_loadu_si512(p), _mm512_zextsi128_si512(_mm_cvtsi32_si128((int)crc)));
+    __m512i a1 = _mm512_loadu_si512(p + 64);
+    __m512i a2 = _mm512_loadu_si512(p + 128);
+    __m512i a3 = _mm512_loadu_si512(p + 192);
+    for (p += FOLD_BYTES, len -= FOLD_BYTES; len >= FOLD_BYTES; p += FOLD_BYTES, len -= FOLD_BYTES) {
+        a0 = fold_zmm(a0, k2048, _mm512_loadu_si512(p));
+        a1 = fold_zmm(a1, k2048, _mm512_loadu_si512(p + 64));
+        a2 = fold_zmm(a2, k2048, _mm512_loadu_si512(p + 128));
+        a3 = fold_zmm(a3, k2048, _mm512_loadu_si512(p + 192));
+    }
+    a1 = fold_zmm(a0, k512, a1);
+    a2 = fold_zmm(a1, k512, a2);
+    a3 = fold_zmm(a2, k512, a3);
+    __m128i x = _mm512_maskz_extracti32x4_epi32(0xF, a3, 3);
+    x = fold_xmm(_mm512_maskz_extracti32x4_epi32(0xF, a3, 0), tb.fold384, x);
+    x = fold_xmm(_mm512_maskz_extracti32x4_epi32(0xF, a3, 1), tb.fold256, x);
+    x = fold_xmm(_mm512_maskz_extracti32x4_epi32(0xF, a3, 2), tb.fold128, x);
+    for (; len >= 16; p += 16, len -= 16) x = fold_xmm(x, tb.fold128, _mm_loadu_si128((const __m128i*)p));
+
+    uint64_t c = _mm_crc32_u64(0, (uint64_t)_mm_cvtsi128_si64(x));
+    c = _mm_crc32_u64(c, (uint64_t)_mm_extract_epi64(x, 1));
+    uint32_t r = (uint32_t)c;
+    for (; len > 0; p++, len--) r = _mm_crc32_u8(r, *p);
+    return r;
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+uint32_t armv8_update(uint32_t c, const unsigned char* p, size_t len)
+{
+    for (; len >= 8; p += 8, len -= 8) c = __crc32cd(c, load64(p));
+    for (; len > 0; p++, len--) c = __crc32cb(c, *p);
+    return c;
+}
+#endif
+
+typedef uint32_t (*CrcUpdate)(uint32_t, const unsigned char*, size_t);
+
+struct CrcImpl
+{
+    CrcUpdate update;
+    const char* name;
+};
+
+CrcImpl select_impl()
+{
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("vpclmulqdq")) {
+        return CrcImpl{vpclmul_update, "vpclmulqdq"};
+    }
+    if (__builtin_cpu_supports("sse4.2")) return CrcImpl{sse42_update, "sse4.2"};
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    return CrcImpl{armv8_update, "armv8-crc"};
+#endif
+    return CrcImpl{table_update, "table"};
+}
+
+const CrcImpl& impl()
+{
+    static const CrcImpl selected = select_impl();
+    return selected;
+}
+
+}  // namespace
+
+uint32_t crc32c(uint32_t crc, const void* data, size_t len)
+{
+    return ~impl().update(~crc, (const unsigned char*)data, len);
+}
+
+uint32_t crc32c_portable(uint32_t crc, const void* data, size_t len)
+{
+    return ~table_update(~crc, (const unsigned char*)data, len);
+}
+
+const char* crc32c_impl()
+{
+    return impl().name;
+}
@@ -0,0 +1,378 @@
+#include "../include/dedup.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static_assert(BLOCK_SIZE % 32 == 0, "指纹按32字节一组计算");
+
+namespace {
+
+const uint64_t FP_PRIME1 = 0x9E3779B185EBCA87ULL;
+const uint64_t FP_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t FP_PRIME3 = 0x165667B19E3779F9ULL;
+
+inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// 去重表占用的块数（表头 + 每个数据块一项）
+uint32_t table_blocks(uint32_t data_blocks)
+{
+    return (uint32_t)((sizeof(DedupHeader) + (uint64_t)data_blocks * sizeof(DedupEntry) + BLOCK_SIZE - 1) / BLOCK_SIZE);
+}
+
+}  // namespace
+
+uint64_t block_fingerprint(const char* data, size_t len)
+{
+    uint64_t acc[4] = {FP_PRIME1 + FP_PRIME2, FP_PRIME2, 0, 0 - FP_PRIME1};
+    for (size_t i = 0; i < len; i += 32) {
+        // 四路累加器互不依赖，编译器可展开为向量乘加
+        for (int lane = 0; lane < 4; lane++) {
+            uint64_t v;
+            memcpy(&v, data + i + lane * 8, sizeof(v));
+            acc[lane] = rotl64(acc[lane] + v * FP_PRIME2, 31) * FP_PRIME1;
+        }
+    }
+    uint64_t h = rotl64(acc[0], 1) + rotl64(acc[1], 7) + rotl64(acc[2], 12) + rotl64(acc[3], 18);
+    for (int lane = 0; lane < 4; lane++) {
+        h = (h ^ (rotl64(acc[lane] * FP_PRIME2, 31) * FP_PRIME1)) * FP_PRIME1 + FP_PRIME3;
+    }
+    h += len;
+    h ^= h >> 33;
+    h *= FP_PRIME2;
+    h ^= h >> 29;
+    h *= FP_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+DedupIndex::DedupIndex(uint32_t data_start, uint32_t data_blocks)
+    : data_start(data_start), entries(data_blocks), st()
+{
+    memset(entries.data(), 0, entries.size() * sizeof(DedupEntry));
+}
+
+int DedupIndex::find(uint64_t fp) const
+{
+    auto it = index.find(fp);
+    return it == index.end() ? -1 : (int)it->second;
+}
+
+uint32_t DedupIndex::drop_ref(uint32_t block)
+{
+    DedupEntry& e = entries[block - data_start];
+    if (e.refs > 0) e.refs--;
+    return e.refs;
+}
+
+void DedupIndex::set_allocated(uint32_t block, bool used)
+{
+    forget(block);
+    entries[block - data_start].refs = used ? 1 : 0;
+}
+
+void DedupIndex::record(uint32_t block, uint64_t fp)
+{
+    forget(block);
+    DedupEntry& e = entries[block - data_start];
+    e.fingerprint = fp;
+    e.has_fp = 1;
+    index.insert(std::make_pair(fp, block));
+}
+
+void DedupIndex::forget(uint32_t block)
+{
+    DedupEntry& e = entries[block - data_start];
+    if (!e.has_fp) return;
+    auto it = index.find(e.fingerprint);
+    if (it != index.end() && it->second == block) index.erase(it);
+    e.has_fp = 0;
+}
+
+void DedupIndex::rebuild_index()
+{
+    index.clear();
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        if (entries[i].refs > 0 && entries[i].has_fp) index.insert(std::make_pair(entries[i].fingerprint, data_start + i));
+    }
+}
+
+uint64_t DedupIndex::logical_blocks() const
+{
+    uint64_t n = 0;
+    for (const auto& e : entries) n += e.refs;
+    return n;
+}
+
+uint64_t DedupIndex::physical_blocks() const
+{
+    uint64_t n = 0;
+    for (const auto& e : entries) n += e.refs > 0;
+    return n;
+}
+
+size_t DedupIndex::memory_bytes() const
+{
+    return entries.capacity() * sizeof(DedupEntry) +
+           index.size() * (sizeof(std::pair<const uint64_t, uint32_t>) + sizeof(void*)) +
+           index.bucket_count() * sizeof(void*);
+}
+
+uint32_t DedupIndex::checksum(const DedupEntry* entries, size_t count)
+{
+    uint32_t h = 2166136261u;
+    const char* p = (const char*)entries;
+    for (size_t i = 0; i < count * sizeof(DedupEntry); i++) {
+        h ^= (uint8_t)p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief 设置下次格式化是否启用去重
+ */
+void DiskFS::set_dedup(bool on)
+{
+    dedup_on_format = on;
+}
+
+/**
+ * @brief 设置下次格式化是否启用块引用计数（不去重，只供克隆与快照写时复制）
+ */
+void DiskFS::set_cow(bool on)
+{
+    cow_on_format = on;
+}
+
+/**
+ * @brief 格式化时在数据区末尾预留去重表与快照目录（按set_dedup/set_cow的配置），超级块记录其位置
+ * 调用时数据区大小已确定；预留的块从可分配的数据块中扣除
+ */
+void DiskFS::dedup_create()
+{
+    dedup.reset();
+    snapshots.clear();
+    super_block.dedup_start = super_block.dedup_blocks = 0;
+    super_block.dedup_flags = dedup_on_format ? DEDUP_INLINE : 0;
+    super_block.snap_block = 0;
+    if (!dedup_on_format && !cow_on_format) return;
+    uint32_t blocks = table_blocks(super_block.data_blocks);
+    super_block.data_blocks -= blocks + 1;
+    super_block.free_blocks = super_block.data_blocks;
+    super_block.snap_block = super_block.data_start + super_block.data_blocks;
+    super_block.dedup_start = super_block.snap_block + 1;
+    super_block.dedup_blocks = blocks;
+    dedup.reset(new DedupIndex(super_block.data_start, super_block.data_blocks));
+    snapshots.assign(SNAP_MAX, SnapEntry());
+}
+
+/**
+ * @brief 挂载时加载去重表；表不干净或校验失败时由inode块指针与快照重建引用计数并重新计算指纹。
+ *        之后写入清除了干净标记的表头（只读挂载不写）
+ * @return 未启用去重或加载/重建成功返回true
+ */
+bool DiskFS::dedup_attach()
+{
+    dedup.reset();
+    if (super_block.dedup_blocks == 0) return true;
+    dedup.reset(new DedupIndex(super_block.data_start, super_block.data_blocks));
+    DedupIndex& dd = *dedup;
+
+    std::vector<char> table((size_t)super_block.dedup_blocks * BLOCK_SIZE);
+    if (!region_io(super_block.dedup_start, super_block.dedup_blocks, table, false)) {
+        dedup.reset();
+        return false;
+    }
+    DedupHeader hdr;
+    memcpy(&hdr, table.data(), sizeof(hdr));
+    const DedupEntry* saved = (const DedupEntry*)(table.data() + sizeof(DedupHeader));
+    if (memcmp(hdr.magic, DEDUP_MAGIC, sizeof(hdr.magic)) == 0 && hdr.clean == 1 &&
+        hdr.entry_count == dd.entries.size() && hdr.checksum == DedupIndex::checksum(saved, hdr.entry_count)) {
+        memcpy(dd.entries.data(), saved, dd.entries.size() * sizeof(DedupEntry));
+        dd.st.from_checkpoint = true;
+    } else {
+        // 重建：引用计数来自所有已用inode的块指针与快照持有的块，去重模式下普通文件的块重新计算指纹
+        char block[BLOCK_SIZE];
+        uint32_t data_end = super_block.data_start + super_block.data_blocks;
+        for (uint32_t n = 0; n < super_block.total_inodes; n++) {
+            Inode inode;
+            if (!read_inode(n, inode) || !inode.used) continue;
+            bool hashed = (super_block.dedup_flags & DEDUP_INLINE) && inode.type == 1 &&
+                          !(inode.flags & INODE_COMPRESSED);
+            for (uint32_t s = 0; s < 16; s++) {
+                uint32_t b = inode.blocks[s];
+                if (b < super_block.data_start || b >= data_end) continue;
+                DedupEntry& e = dd.entries[b - super_block.data_start];
+                e.refs++;
+                if (hashed && !e.has_fp && read_block(b, block)) {
+                    e.fingerprint = block_fingerprint(block, BLOCK_SIZE);
+                    e.has_fp = 1;
+                }
+            }
+        }
+        std::vector<uint32_t> held(dd.entries.size(), 0);
+        if (!snap_refs(held)) {
+            dedup.reset();
+            return false;
+        }
+        for (size_t i = 0; i < held.size(); i++) dd.entries[i].refs += held[i];
+    }
+    dd.rebuild_index();
+    if (read_only) return true;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, DEDUP_MAGIC, sizeof(hdr.magic));
+    hdr.entry_count = (uint32_t)dd.entries.size();
+    std::vector<char> head(BLOCK_SIZE, 0);
+    memcpy(head.data(), table.data(), BLOCK_SIZE);
+    memcpy(head.data(), &hdr, sizeof(hdr));
+    return region_io(super_block.dedup_start, 1, head, true);
+}
+
+/**
+ * @brief 卸载（以及格式化结束）时写入完整的去重表并标记为干净
+ */
+bool DiskFS::dedup_detach()
+{
+    if (!dedup) return true;
+    std::vector<char> table((size_t)super_block.dedup_blocks * BLOCK_SIZE, 0);
+    DedupHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, DEDUP_MAGIC, sizeof(hdr.magic));
+    hdr.clean = 1;
+    hdr.entry_count = (uint32_t)dedup->entries.size();
+    hdr.checksum = DedupIndex::checksum(dedup->entries.data(), dedup->entries.size());
+    memcpy(table.data(), &hdr, sizeof(hdr));
+    memcpy(table.data() + sizeof(hdr), dedup->entries.data(), dedup->entries.size() * sizeof(DedupEntry));
+    bool ok = region_io(super_block.dedup_start, super_block.dedup_blocks, table, true);
+    dedup.reset();
+    return ok;
+}
+
+/**
+ * @brief 去重（或引用计数）模式下写入文件的一个数据块
+ * @param slot inode中的块指针（0表示尚未分配），按写入结果更新
+ * @param buffer 块的完整新内容
+ * @return 成功返回true；无空闲块或IO失败返回false（slot保持不变）
+ */
+bool DiskFS::dedup_store(uint32_t& slot, const char* buffer)
+{
+    DedupIndex& dd = *dedup;
+    bool hashing = super_block.dedup_flags & DEDUP_INLINE;
+    uint64_t fp = 0;
+    uint32_t old = slot;
+
+    if (hashing) {
+        fp = block_fingerprint(buffer, BLOCK_SIZE);
+        dd.st.hashed++;
+        int cand = dd.find(fp);
+        if (cand >= 0) {
+            // 指纹命中：逐字节确认后共享（或判定为未变的覆盖）
+            char existing[BLOCK_SIZE];
+            if (!read_block((uint32_t)cand, existing)) return false;
+            if (memcmp(existing, buffer, BLOCK_SIZE) == 0) {
+                if ((uint32_t)cand == old) {
+                    dd.st.unchanged++;
+                    return true;
+                }
+                dd.add_ref((uint32_t)cand);
+                slot = (uint32_t)cand;
+                if (old != 0) release_block(old);
+                dd.st.dup_hits++;
+                return true;
+            }
+            dd.st.collisions++;
+        }
+    }
+
+    // 内容唯一（或不去重）：独占的旧块原地覆盖，共享的旧块写时复制
+    if (old != 0 && dd.refs(old) == 1) {
+        dd.forget(old);
+        if (!write_block(old, buffer)) return false;
+        if (hashing) dd.record(old, fp);
+        return true;
+    }
+    int block_num = find_free_block();
+    if (block_num == -1) return false;
+    set_block_bitmap(block_num, true);
+    if (!write_block(block_num, buffer)) {
+        set_block_bitmap(block_num, false);
+        return false;
+    }
+    if (hashing) dd.record(block_num, fp);
+    if (old != 0) {
+        release_block(old);
+        dd.st.cow_breaks++;
+    }
+    slot = (uint32_t)block_num;
+    return true;
+}
+
+/**
+ * @brief 文件不再引用某个数据块：去重模式下减少引用计数，降到0时才释放并通知块层
+ */
+void DiskFS::release_block(uint32_t block_num)
+{
+    if (dedup && dedup->drop_ref(block_num) > 0) return;
+    set_block_bitmap(block_num, false);
+    discard_block(block_num);
+}
+
+/**
+ * @brief 批量释放文件不再引用的块：按位图块分组清位，每个涉及的位图块与超级块只写一次
+ * @param blocks 块号（任意顺序，去重模式下只有引用计数降到0的块才真正释放）
+ * @return I/O失败返回false
+ */
+bool DiskFS::release_blocks(const std::vector<uint32_t>& blocks)
+{
+    std::vector<uint32_t> idxs;
+    for (uint32_t b : blocks) {
+        if (b < super_block.data_start || b >= super_block.data_start + super_block.data_blocks) continue;
+        if (dedup && dedup->drop_ref(b) > 0) continue;
+        if (dedup) dedup->set_allocated(b, false);
+        idxs.push_back(b - super_block.data_start);
+    }
+    if (idxs.empty()) return true;
+    std::sort(idxs.begin(), idxs.end());
+
+    const uint32_t bits_per_block = BLOCK_SIZE * 8;
+    char buffer[BLOCK_SIZE];
+    for (size_t k = 0; k < idxs.size();) {
+        uint32_t bm = idxs[k] / bits_per_block;
+        if (!read_block(super_block.block_bitmap + bm, buffer)) return false;
+        for (; k < idxs.size() && idxs[k] / bits_per_block == bm; k++) {
+            uint32_t bit = idxs[k] % bits_per_block;
+            if (buffer[bit / 8] & (1 << (bit % 8))) super_block.free_blocks++;
+            buffer[bit / 8] &= ~(1 << (bit % 8));
+        }
+        if (!write_block(super_block.block_bitmap + bm, buffer)) return false;
+    }
+    if (meta && idxs[0] < meta->block_hint) meta->block_hint = idxs[0];
+    if (!write_super_block()) return false;
+    for (uint32_t idx : idxs) discard_block(super_block.data_start + idx);
+    return true;
+}
+
+void DiskFS::print_dedup_info() const
+{
+    if (!dedup) return;
+    const DedupIndex& dd = *dedup;
+    uint64_t logical = dd.logical_blocks();
+    uint64_t physical = dd.physical_blocks();
+    bool hashing = super_block.dedup_flags & DEDUP_INLINE;
+    std::cout << (hashing ? "块去重:\n" : "块引用计数（写时复制）:\n");
+    std::cout << "  引用块: " << logical << "，物理块: " << physical << (hashing ? "，去重比: " : "，共享比: ")
+              << (physical ? (double)logical / physical : 1.0) << "，索引内存: " << dd.memory_bytes() / 1024
+              << "KB（去重表 " << super_block.dedup_blocks << " 块，"
+              << (dd.st.from_checkpoint ? "来自干净卸载" : "重建") << "）\n";
+    if (!hashing) {
+        std::cout << "  块写: 写时复制 " << dd.st.cow_breaks << "\n";
+        return;
+    }
+    std::cout << "  块写: 计算指纹 " << dd.st.hashed << "，共享 " << dd.st.dup_hits << "，未变跳过 " << dd.st.unchanged
+              << "，写时复制 " << dd.st.cow_breaks << "，指纹冲突 " << dd.st.collisions << "\n";
+}
@@ -0,0 +1,240 @@
+#include "../include/defrag.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+uint32_t count_extents(const uint32_t* blocks, uint32_t count)
+{
+    uint32_t extents = 0;
+    uint32_t prev = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (blocks[i] == 0) continue;
+        if (prev == 0 || blocks[i] != prev + 1) extents++;
+        prev = blocks[i];
+    }
+    return extents;
+}
+
+/**
+ * @brief 读取整个块位图（按数据区块数截断）
+ */
+bool DiskFS::read_block_bitmap(std::vector<uint8_t>& bitmap)
+{
+    uint32_t bytes = (super_block.data_blocks + 7) / 8;
+    uint32_t bitmap_blocks = (bytes + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    bitmap.assign((size_t)bitmap_blocks * BLOCK_SIZE, 0);
+    for (uint32_t i = 0; i < bitmap_blocks; i++) {
+        if (!read_block(super_block.block_bitmap + i, (char*)bitmap.data() + (size_t)i * BLOCK_SIZE)) return false;
+    }
+    bitmap.resize(bytes);
+    return true;
+}
+
+/**
+ * @brief 统计每个文件的区段数以及空闲空间的区段分布
+ */
+FragReport DiskFS::frag_report()
+{
+    FragReport rep = FragReport();
+    if (!isMounted()) return rep;
+    delalloc_flush();  // 延迟分配的块回写后才有块号
+
+    std::vector<DirEntry> entries = list_files();
+    for (const auto& entry : entries) {
+        Inode inode;
+        if (!read_inode(entry.inode_num, inode) || !inode.used || inode.type != 1) continue;
+        FileFrag ff;
+        ff.name = entry.name;
+        ff.inode_num = entry.inode_num;
+        ff.blocks = 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            if (inode.blocks[i] != 0) ff.blocks++;
+        }
+        ff.extents = count_extents(inode.blocks, 16);
+        rep.file_blocks += ff.blocks;
+        rep.file_extents += ff.extents;
+        if (ff.extents > 1) rep.fragmented_files++;
+        rep.files.push_back(ff);
+    }
+
+    std::vector<uint8_t> bitmap;
+    if (!read_block_bitmap(bitmap)) return rep;
+    uint32_t run = 0;
+    for (uint32_t i = 0; i < super_block.data_blocks; i++) {
+        if (bitmap[i / 8] & (1 << (i % 8))) {
+            run = 0;
+            continue;
+        }
+        if (run == 0) rep.free_extents++;
+        run++;
+        rep.free_blocks++;
+        rep.largest_free = std::max(rep.largest_free, run);
+    }
+    return rep;
+}
+
+/**
+ * @brief 把一个碎片化文件整体搬到第一段足够长的连续空闲区
+ * 新块先标记为已用并写入数据，再一次性写回inode，最后释放旧块；inode写入之前的任何失败都回滚新块
+ * @return 搬移的块数；文件已连续或没有足够长的连续空闲区返回0；I/O失败返回-1
+ */
+int DiskFS::relocate_file(uint32_t inode_num)
+{
+    Inode inode;
+    if (!read_inode(inode_num, inode) || !inode.used || inode.type != 1) return -1;
+    if (count_extents(inode.blocks, 16) <= 1) return 0;
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        if (inode.blocks[i] == 0) continue;
+        // 去重模式：含共享块的文件不搬移（搬移会让其他引用者的块指针失效）
+        if (dedup && dedup->refs(inode.blocks[i]) > 1) {
+            defrag_st.skipped++;
+            return 0;
+        }
+        count++;
+    }
+
+    // 首次适配：找第一段长度不小于count的连续空闲区
+    std::vector<uint8_t> bitmap;
+    if (!read_block_bitmap(bitmap)) return -1;
+    uint32_t run = 0;
+    int64_t target = -1;
+    for (uint32_t i = 0; i < super_block.data_blocks; i++) {
+        run = (bitmap[i / 8] & (1 << (i % 8))) ? 0 : run + 1;
+        if (run == count) {
+            target = (int64_t)super_block.data_start + i + 1 - count;
+            break;
+        }
+    }
+    if (target < 0) {
+        defrag_st.skipped++;
+        return 0;
+    }
+
+    IoBatch batch(*this);
+    Inode moved = inode;
+    std::vector<uint32_t> allocated;
+    char buffer[BLOCK_SIZE];
+    uint32_t next = (uint32_t)target;
+    for (uint32_t i = 0; i < 16; i++) {
+        if (inode.blocks[i] == 0) continue;
+        if (!set_block_bitmap(next, true)) break;
+        allocated.push_back(next);
+        if (!read_block(inode.blocks[i], buffer) || !write_block(next, buffer)) break;
+        moved.blocks[i] = next++;
+    }
+    if (next - (uint32_t)target != count || !write_inode(inode_num, moved)) {
+        std::cerr << "碎片整理失败：inode " << inode_num << " 搬移数据块失败，已回滚" << std::endl;
+        for (uint32_t b : allocated) set_block_bitmap(b, false);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < 16; i++) {
+        if (inode.blocks[i] == 0) continue;
+        // 指纹随块搬到新位置（先释放旧块，指纹索引才会指向新块）
+        const DedupEntry* e = dedup ? &dedup->entries[inode.blocks[i] - super_block.data_start] : nullptr;
+        bool carry = e && e->has_fp;
+        uint64_t fp = carry ? e->fingerprint : 0;
+        release_block(inode.blocks[i]);
+        if (carry) dedup->record(moved.blocks[i], fp);
+    }
+    defrag_st.files_moved++;
+    defrag_st.blocks_moved += count;
+    return (int)count;
+}
+
+/**
+ * @brief 在线整理：name非空时只整理该文件，否则按inode顺序从上次停下的位置继续整理全部文件
+ * @param budget 本次最多搬移的块数（0表示不限）；下一个文件会超出预算时停下，留给下次调用
+ *               （本次尚未搬移任何块时总会搬完一个文件，保证有进展）
+ * @return 本次搬移的块数；未挂载、文件不存在或I/O失败返回-1
+ */
+int DiskFS::defrag(const std::string& name, uint32_t budget)
+{
+    if (!isMounted()) {
+        std::cerr << "碎片整理失败：磁盘未挂载" << std::endl;
+        return -1;
+    }
+    if (reject_read_only("碎片整理")) return -1;
+    if (log) {
+        // 日志布局的逻辑块号不对应物理位置，连续性由日志追加与段清理保证
+        std::cout << "日志结构布局无需碎片整理" << std::endl;
+        return 0;
+    }
+    if (!delalloc_flush()) {
+        // 未回写的文件长度超出已分配的块，不能搬移
+        std::cerr << "碎片整理失败：延迟分配的脏页回写失败" << std::endl;
+        return -1;
+    }
+    if (!name.empty()) {
+        int inode_num = open_file(name);
+        if (inode_num == -1) {
+            std::cerr << "碎片整理失败：" << name << " 不存在" << std::endl;
+            return -1;
+        }
+        return relocate_file((uint32_t)inode_num);
+    }
+
+    std::vector<DirEntry> entries = list_files();
+    std::sort(entries.begin(), entries.end(),
+              [](const DirEntry& a, const DirEntry& b) { return a.inode_num < b.inode_num; });
+    size_t start = 0;
+    while (start < entries.size() && entries[start].inode_num < defrag_cursor) start++;
+
+    uint32_t moved = 0;
+    for (size_t k = 0; k < entries.size(); k++) {
+        size_t idx = (start + k) % entries.size();
+        uint32_t inode_num = entries[idx].inode_num;
+
+        Inode inode;
+        if (read_inode(inode_num, inode) && inode.used && inode.type == 1 && count_extents(inode.blocks, 16) > 1) {
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < 16; i++) {
+                if (inode.blocks[i] != 0) count++;
+            }
+            if (budget != 0 && moved != 0 && moved + count > budget) {
+                defrag_cursor = inode_num;
+                return (int)moved;
+            }
+            int ret = relocate_file(inode_num);
+            if (ret < 0) return -1;
+            moved += ret;
+        }
+
+        defrag_cursor = inode_num + 1;
+        if (idx + 1 == entries.size()) {
+            defrag_st.passes++;
+            defrag_cursor = 0;
+        }
+    }
+    return (int)moved;
+}
+
+/**
+ * @brief 打印碎片报告
+ */
+void DiskFS::print_frag_report()
+{
+    if (!isMounted()) {
+        std::cout << "请先挂载磁盘（使用mount命令）\n";
+        return;
+    }
+    FragReport rep = frag_report();
+
+    std::cout << "碎片报告:\n";
+    std::cout << "  " << std::left << std::setw(MAX_FILENAME) << "文件名" << std::right << std::setw(8) << "inode"
+              << std::setw(8) << "块数" << std::setw(8) << "区段" << std::setw(12) << "平均区段" << "\n";
+    for (const auto& ff : rep.files) {
+        std::cout << "  " << std::left << std::setw(MAX_FILENAME) << ff.name << std::right << std::setw(8)
+                  << ff.inode_num << std::setw(8) << ff.blocks << std::setw(8) << ff.extents << std::setw(12)
+                  << std::fixed << std::setprecision(2) << (ff.extents ? (double)ff.blocks / ff.extents : 0.0) << "\n";
+    }
+    std::cout << "  文件: " << rep.files.size() << " 个，碎片化 " << rep.fragmented_files << " 个，区段 "
+              << rep.file_extents << "，平均区段长度 " << std::fixed << std::setprecision(2) << rep.avg_run() << " 块\n";
+    std::cout << "  空闲: " << rep.free_blocks << " 块，区段 " << rep.free_extents << "，最大连续 " << rep.largest_free
+              << " 块，空闲碎片度 " << std::setprecision(1) << rep.free_fragmentation() * 100 << "%\n";
+    std::cout << "  整理: 已搬移 " << defrag_st.files_moved << " 个文件/" << defrag_st.blocks_moved << " 块，跳过 "
+              << defrag_st.skipped << "，完整扫描 " << defrag_st.passes << " 轮\n";
+}
@@ -0,0 +1,229 @@
+#include "../include/delalloc.h"
+#include "../include/disk_fs.h"
+#include <cstring>
+#include <iostream>
+
+char* DelallocCache::get(uint32_t inode_num, uint32_t block_idx, uint32_t free_blocks)
+{
+    auto file = files.find(inode_num);
+    if (file != files.end()) {
+        auto page = file->second.find(block_idx);
+        if (page != file->second.end()) {
+            st.rewrites++;
+            return page->second.data();
+        }
+    }
+    if (free_blocks <= reserved) return nullptr;
+    reserved++;
+    st.pages++;
+    std::vector<char>& page = files[inode_num][block_idx];
+    page.assign(BLOCK_SIZE, 0);
+    return page.data();
+}
+
+const char* DelallocCache::find(uint32_t inode_num, uint32_t block_idx) const
+{
+    auto file = files.find(inode_num);
+    if (file == files.end()) return nullptr;
+    auto page = file->second.find(block_idx);
+    return page == file->second.end() ? nullptr : page->second.data();
+}
+
+uint32_t DelallocCache::drop(uint32_t inode_num)
+{
+    auto file = files.find(inode_num);
+    if (file == files.end()) return 0;
+    uint32_t count = file->second.size();
+    reserved -= count;
+    st.dropped += count;
+    files.erase(file);
+    return count;
+}
+
+uint32_t DelallocCache::clear()
+{
+    uint32_t count = reserved;
+    files.clear();
+    reserved = 0;
+    return count;
+}
+
+uint32_t DelallocCache::truncate(uint32_t inode_num, uint32_t keep_blocks, uint32_t tail)
+{
+    auto file = files.find(inode_num);
+    if (file == files.end()) return 0;
+    std::map<uint32_t, std::vector<char>>& pages = file->second;
+    if (tail != 0 && keep_blocks > 0) {
+        auto last = pages.find(keep_blocks - 1);
+        if (last != pages.end()) memset(last->second.data() + tail, 0, BLOCK_SIZE - tail);
+    }
+    uint32_t count = 0;
+    for (auto page = pages.lower_bound(keep_blocks); page != pages.end(); count++) page = pages.erase(page);
+    reserved -= count;
+    st.dropped += count;
+    if (pages.empty()) files.erase(file);
+    return count;
+}
+
+/**
+ * @brief 启用或关闭延迟分配；关闭时先回写全部脏页
+ * @return 去重/引用计数模式下启用返回false
+ */
+bool DiskFS::set_delalloc(bool on)
+{
+    if (!on) {
+        bool ok = delalloc_flush();
+        delalloc.reset();
+        return ok;
+    }
+    if (dedup) {
+        std::cerr << "去重与引用计数模式下块由内容决定，不支持延迟分配" << std::endl;
+        return false;
+    }
+    if (!delalloc) delalloc.reset(new DelallocCache());
+    return true;
+}
+
+/**
+ * @brief 一次分配want个数据块：依次尝试goal起的连续区、第一段足够长的连续空闲区、按顺序拼接空闲块
+ * 整批只改写一次涉及的位图块与超级块
+ * @param goal 期望的起始块号（0表示没有期望）
+ * @param out 分配到的块号（升序）
+ * @param st 非空时累计分配出的区段数与位图块、超级块的写入次数
+ * @return 空闲块不足或I/O失败返回false
+ */
+bool DiskFS::alloc_blocks(uint32_t goal, uint32_t want, std::vector<uint32_t>& out, DelallocStats* st)
+{
+    std::vector<uint8_t> bitmap;
+    if (!read_block_bitmap(bitmap)) return false;
+    uint32_t total = super_block.data_blocks;
+    auto is_free = [&bitmap](uint32_t i) { return !(bitmap[i / 8] & (1 << (i % 8))); };
+
+    std::vector<uint32_t> idxs;
+    if (goal >= super_block.data_start && goal - super_block.data_start + want <= total) {
+        uint32_t g = goal - super_block.data_start;
+        uint32_t i = 0;
+        while (i < want && is_free(g + i)) i++;
+        if (i == want) {
+            for (i = 0; i < want; i++) idxs.push_back(g + i);
+        }
+    }
+    if (idxs.empty()) {
+        uint32_t run = 0;
+        for (uint32_t i = 0; i < total; i++) {
+            run = is_free(i) ? run + 1 : 0;
+            if (run == want) {
+                for (uint32_t j = i + 1 - want; j <= i; j++) idxs.push_back(j);
+                break;
+            }
+        }
+    }
+    if (idxs.empty()) {
+        for (uint32_t i = meta ? meta->block_hint : 0; i < total && idxs.size() < want; i++) {
+            if (is_free(i)) idxs.push_back(i);
+        }
+    }
+    if (idxs.size() < want) return false;
+
+    // 按位图块分组置位，每个涉及的位图块读写一次
+    const uint32_t bits_per_block = BLOCK_SIZE * 8;
+    char buffer[BLOCK_SIZE];
+    for (size_t k = 0; k < idxs.size();) {
+        uint32_t bm = idxs[k] / bits_per_block;
+        if (!read_block(super_block.block_bitmap + bm, buffer)) return false;
+        for (; k < idxs.size() && idxs[k] / bits_per_block == bm; k++) {
+            uint32_t bit = idxs[k] % bits_per_block;
+            buffer[bit / 8] |= (1 << (bit % 8));
+        }
+        if (!write_block(super_block.block_bitmap + bm, buffer)) return false;
+        if (st) st->meta_writes++;
+    }
+    super_block.free_blocks -= want;
+    if (st) st->meta_writes++;
+    if (!write_super_block()) return false;
+
+    out.clear();
+    for (size_t k = 0; k < idxs.size(); k++) {
+        if (st && (k == 0 || idxs[k] != idxs[k - 1] + 1)) st->runs++;
+        out.push_back(super_block.data_start + idxs[k]);
+    }
+    return true;
+}
+
+/**
+ * @brief 回写一个文件的全部脏页：一次分配、按块顺序写数据、写回一次inode
+ */
+bool DiskFS::delalloc_flush_file(uint32_t inode_num)
+{
+    std::map<uint32_t, std::vector<char>>& pages = delalloc->files[inode_num];
+    Inode inode;
+    if (pages.empty() || !read_inode(inode_num, inode) || !inode.used || inode.type != 1) {
+        delalloc->drop(inode_num);
+        return true;
+    }
+
+    // 紧接文件内前一个已分配块放置，顺序追加的文件保持连续
+    uint32_t first = pages.begin()->first;
+    uint32_t goal = 0;
+    for (uint32_t i = first; i > 0; i--) {
+        if (inode.blocks[i - 1] != 0) {
+            goal = inode.blocks[i - 1] + (first - (i - 1));
+            break;
+        }
+    }
+    uint32_t count = pages.size();
+    std::vector<uint32_t> blocks;
+    if (!alloc_blocks(goal, count, blocks, &delalloc->st)) {
+        std::cerr << "延迟分配回写失败：inode " << inode_num << " 无法分配 " << count << " 个数据块" << std::endl;
+        return false;
+    }
+
+    IoBatch batch(*this);
+    bool ok = true;
+    size_t k = 0;
+    for (const auto& page : pages) {
+        inode.blocks[page.first] = blocks[k];
+        if (!write_block(blocks[k], page.second.data())) ok = false;
+        k++;
+    }
+    delalloc->reserved -= count;
+    delalloc->st.allocated += count;
+    delalloc->files.erase(inode_num);
+    if (!write_inode(inode_num, inode)) ok = false;
+    if (!batch.end()) ok = false;
+    if (!ok) std::cerr << "延迟分配回写失败：inode " << inode_num << " 写入数据块失败" << std::endl;
+    return ok;
+}
+
+/**
+ * @brief 回写脏页
+ * @param inode_num 只回写该文件（-1表示全部）
+ * @return 没有脏页或全部回写成功返回true
+ */
+bool DiskFS::delalloc_flush(int inode_num)
+{
+    if (!delalloc || delalloc->files.empty() || !isMounted() || read_only) return true;
+    std::vector<uint32_t> targets;
+    for (const auto& file : delalloc->files) {
+        if (inode_num < 0 || file.first == (uint32_t)inode_num) targets.push_back(file.first);
+    }
+    if (targets.empty()) return true;
+    delalloc->st.flushes++;
+    IoBatch batch(*this);
+    bool ok = true;
+    for (uint32_t target : targets) {
+        if (!delalloc_flush_file(target)) ok = false;
+    }
+    return ok;
+}
+
+void DiskFS::print_delalloc_info() const
+{
+    if (!delalloc) return;
+    const DelallocStats& st = delalloc->st;
+    std::cout << "延迟分配:\n";
+    std::cout << "  脏页: " << delalloc->reserved << "（预留 " << delalloc->reserved << " 块，" << delalloc->files.size()
+              << " 个文件），累计建立 " << st.pages << "，覆盖写 " << st.rewrites << "，删除时丢弃 " << st.dropped << "\n";
+    std::cout << "  回写: " << st.flushes << " 次，分配 " << st.allocated << " 块 / " << st.runs << " 个区段，位图与超级块写入 "
+              << st.meta_writes << " 次（逐块分配需 " << st.allocated * 2 << " 次）\n";
+}
@@ -0,0 +1,104 @@
+#include "../include/device_model.h"
+#include "../include/ftl_model.h"
+#include "../include/disk_fs.h"
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+/**
+ * @brief 根据名称创建设备模型
+ * HDD默认7200转、每磁道1MB（约120MB/s），SSD默认8通道、读50us、编程200us，
+ * FTL默认预留7%空间（ftl为贪心GC，ftl-cb为成本-收益GC）
+ */
+DeviceModel* DeviceModel::create(const std::string& kind, uint32_t param)
+{
+    if (kind == "hdd") {
+        return new HddModel(param ? param : 7200, 1024 * 1024, (uint64_t)MAX_BLOCKS * BLOCK_SIZE);
+    }
+    if (kind == "ssd") {
+        return new SsdModel(param ? param : 8, 50 * 1000, 200 * 1000, BLOCK_SIZE);
+    }
+    if (kind == "ftl" || kind == "ftl-cb") {
+        return new FtlModel((uint64_t)MAX_BLOCKS * BLOCK_SIZE, param ? param : 7,
+                            kind == "ftl" ? FTL_GC_GREEDY : FTL_GC_COST_BENEFIT);
+    }
+    return nullptr;
+}
+
+HddModel::HddModel(uint32_t rpm, uint64_t track_bytes, uint64_t capacity)
+    : track_bytes(track_bytes),
+      total_tracks(std::max<uint64_t>(1, (capacity + track_bytes - 1) / track_bytes)),
+      rotation_ns(60ULL * 1000 * 1000 * 1000 / std::max<uint32_t>(rpm, 1)),
+      seek_min_ns(500 * 1000),
+      seek_max_ns(15 * 1000 * 1000),
+      head_pos(0)
+{
+}
+
+std::string HddModel::describe() const
+{
+    char buf[160];
+    snprintf(buf, sizeof(buf), "hdd: %llu转/分, 磁道%lluKB, 寻道%.1f~%.1fms",
+             (unsigned long long)(60ULL * 1000 * 1000 * 1000 / rotation_ns),
+             (unsigned long long)(track_bytes / 1024), seek_min_ns / 1e6, seek_max_ns / 1e6);
+    return buf;
+}
+
+/**
+ * @brief HDD服务时间 = 寻道时间 + 旋转延迟 + 传输时间
+ * - 紧接上次I/O结束位置的请求视为顺序流，无寻道和旋转延迟
+ * - 寻道时间按磁道距离的平方根在相邻/满行程之间插值；同磁道非连续访问只付旋转延迟
+ * - 旋转延迟取平均值（半圈），传输时间按每转传输一个磁道计算
+ */
+uint64_t HddModel::service(DeviceOp, uint64_t offset, uint64_t length, uint64_t)
+{
+    uint64_t cost = 0;
+    if (offset != head_pos) {
+        uint64_t from = head_pos / track_bytes;
+        uint64_t to = offset / track_bytes;
+        uint64_t distance = from > to ? from - to : to - from;
+        if (distance > 0) {
+            double frac = std::sqrt((double)distance / total_tracks);
+            cost += seek_min_ns + (uint64_t)((seek_max_ns - seek_min_ns) * frac);
+        }
+        cost += rotation_ns / 2;
+    }
+    cost += (uint64_t)((double)length / track_bytes * rotation_ns);
+    head_pos = offset + length;
+    return cost;
+}
+
+SsdModel::SsdModel(uint32_t channels, uint64_t read_ns, uint64_t program_ns, uint64_t page_bytes)
+    : read_ns(read_ns), program_ns(program_ns), page_bytes(page_bytes),
+      busy_until(std::max<uint32_t>(channels, 1), 0)
+{
+}
+
+std::string SsdModel::describe() const
+{
+    char buf[160];
+    snprintf(buf, sizeof(buf), "ssd: %zu通道, 页%lluKB, 读%.0fus, 编程%.0fus",
+             busy_until.size(), (unsigned long long)(page_bytes / 1024), read_ns / 1e3, program_ns / 1e3);
+    return buf;
+}
+
+/**
+ * @brief SSD服务时间：请求覆盖的每一页按页号分配到通道，
+ *        各通道串行处理自己的页、通道之间并行，请求在最后一页完成时完成
+ * 不足一页的写入（如单个inode）按整页编程计算
+ */
+uint64_t SsdModel::service(DeviceOp op, uint64_t offset, uint64_t length, uint64_t now_ns)
+{
+    if (length == 0) return 0;
+    uint64_t first = offset / page_bytes;
+    uint64_t last = (offset + length - 1) / page_bytes;
+    uint64_t latency = op == DEV_READ ? read_ns : program_ns;
+
+    uint64_t done = now_ns;
+    for (uint64_t page = first; page <= last; page++) {
+        uint64_t& busy = busy_until[page % busy_until.size()];
+        busy = std::max(busy, now_ns) + latency;
+        done = std::max(done, busy);
+    }
+    return done - now_ns;
+}
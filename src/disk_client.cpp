@@ -0,0 +1,193 @@
+#include "../include/disk_client.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+bool send_all(int fd, const char* data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool recv_all(int fd, char* data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = recv(fd, data, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+} // namespace
+
+DiskClient::DiskClient() : fd(-1), next_id(1) {}
+
+DiskClient::~DiskClient()
+{
+    disconnect();
+}
+
+bool DiskClient::connect_to(const std::string& socket_path)
+{
+    disconnect();
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) return false;
+    strcpy(addr.sun_path, socket_path.c_str());
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        std::cerr << "连接守护进程失败: " << socket_path << "（" << strerror(errno) << "）" << std::endl;
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void DiskClient::disconnect()
+{
+    if (fd >= 0) close(fd);
+    fd = -1;
+}
+
+/**
+ * @brief 发送一个请求并等待其应答
+ * @param data WRITE的负载（长度为req.length），其他请求为nullptr
+ */
+bool DiskClient::call(DaemonRequest& req, const char* data, int32_t& status, std::vector<char>& payload)
+{
+    if (fd < 0) return false;
+    req.magic = DAEMON_MAGIC;
+    req.id = next_id++;
+    DaemonResponse resp;
+    if (!send_all(fd, (const char*)&req, sizeof(req)) || (data && !send_all(fd, data, req.length)) ||
+        !recv_all(fd, (char*)&resp, sizeof(resp)) || resp.magic != DAEMON_MAGIC || resp.id != req.id ||
+        resp.length > DAEMON_MAX_PAYLOAD) {
+        std::cerr << "守护进程连接中断" << std::endl;
+        disconnect();
+        return false;
+    }
+    payload.resize(resp.length);
+    if (resp.length && !recv_all(fd, payload.data(), resp.length)) {
+        disconnect();
+        return false;
+    }
+    status = resp.status;
+    return true;
+}
+
+namespace {
+
+DaemonRequest make_request(DaemonOp op, const std::string& name = "")
+{
+    DaemonRequest req;
+    memset(&req, 0, sizeof(req));
+    req.op = op;
+    strncpy(req.name, name.c_str(), MAX_FILENAME - 1);
+    return req;
+}
+
+} // namespace
+
+bool DiskClient::ping()
+{
+    DaemonRequest req = make_request(DOP_PING);
+    int32_t status;
+    std::vector<char> payload;
+    return call(req, nullptr, status, payload) && status == 0;
+}
+
+bool DiskClient::set_class(const std::string& qos_class)
+{
+    if (qos_class.size() >= (size_t)MAX_FILENAME) return false;
+    DaemonRequest req = make_request(DOP_SET_CLASS, qos_class);
+    int32_t status;
+    std::vector<char> payload;
+    return call(req, nullptr, status, payload) && status == 0;
+}
+
+int DiskClient::create_file(const std::string& filename)
+{
+    if (filename.size() >= (size_t)MAX_FILENAME) return -1;
+    DaemonRequest req = make_request(DOP_CREATE, filename);
+    int32_t status;
+    std::vector<char> payload;
+    return call(req, nullptr, status, payload) ? status : -1;
+}
+
+int DiskClient::open_file(const std::string& filename)
+{
+    if (filename.size() >= (size_t)MAX_FILENAME) return -1;
+    DaemonRequest req = make_request(DOP_OPEN, filename);
+    int32_t status;
+    std::vector<char> payload;
+    return call(req, nullptr, status, payload) ? status : -1;
+}
+
+bool DiskClient::delete_file(const std::string& filename)
+{
+    if (filename.size() >= (size_t)MAX_FILENAME) return false;
+    DaemonRequest req = make_request(DOP_DELETE, filename);
+    int32_t status;
+    std::vector<char> payload;
+    return call(req, nullptr, status, payload) && status == 0;
+}
+
+int DiskClient::read_file(uint32_t inode_num, char* buffer, uint32_t size, uint32_t offset)
+{
+    DaemonRequest req = make_request(DOP_READ);
+    req.inode = inode_num;
+    req.offset = offset;
+    req.length = size;
+    int32_t status;
+    std::vector<char> payload;
+    if (!call(req, nullptr, status, payload)) return -1;
+    if (status > 0) memcpy(buffer, payload.data(), std::min<size_t>(status, payload.size()));
+    return status;
+}
+
+int DiskClient::write_file(uint32_t inode_num, const char* buffer, uint32_t size, uint32_t offset)
+{
+    if (size > DAEMON_MAX_PAYLOAD) return -1;
+    DaemonRequest req = make_request(DOP_WRITE);
+    req.inode = inode_num;
+    req.offset = offset;
+    req.length = size;
+    int32_t status;
+    std::vector<char> payload;
+    return call(req, buffer, status, payload) ? status : -1;
+}
+
+std::vector<DirEntry> DiskClient::list_files()
+{
+    std::vector<DirEntry> entries;
+    DaemonRequest req = make_request(DOP_LIST);
+    int32_t status;
+    std::vector<char> payload;
+    if (!call(req, nullptr, status, payload)) return entries;
+    const DaemonListEntry* items = (const DaemonListEntry*)payload.data();
+    for (size_t i = 0; i < payload.size() / sizeof(DaemonListEntry); i++) {
+        DirEntry entry;
+        memcpy(entry.name, items[i].name, MAX_FILENAME);
+        entry.inode_num = items[i].inode_num;
+        entry.valid = 1;
+        entries.push_back(entry);
+    }
+    return entries;
+}
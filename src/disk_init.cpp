@@ -1,4 +1,5 @@
 #include "../include/disk_fs.h"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <ctime>
@@ -8,7 +9,12 @@
  * @param path 磁盘文件的路径（如"disk.img"）
  * 初始化时磁盘未挂载，仅记录磁盘文件的路径供后续操作使用
  */
-DiskFS::DiskFS(const std::string& path) : disk_path(path), is_mounted(false) {}
+DiskFS::DiskFS(const std::string& path)
+    : disk_path(path), is_mounted(false), device_realtime(false), virtual_ns(0), batch_depth(0),
+      defrag_cursor(0), defrag_st(), stripe_unit_blocks(0), cluster_cache(COMPRESS_CACHE_CLUSTERS),
+      compress_st(), dedup_on_format(false), cow_on_format(false), read_only(false), csum_on_format(0),
+      tier_fast_size(0), tier_migrate_ms(TIER_MIGRATE_MS), image_lock_fd(-1),
+      mq_queues(0), mq_depth(MQ_DEFAULT_DEPTH) {}
 
 /**
  * @brief 析构函数：确保磁盘在对象销毁前正确卸载
@@ -27,8 +33,10 @@ DiskFS::~DiskFS()
  * @return 格式化成功返回true；文件打开失败或IO错误返回false
  * 格式化会清空磁盘原有数据，创建新的文件系统布局，是使用磁盘的前提
  */
-bool DiskFS::format() 
+bool DiskFS::format(bool log_structured) 
 {
+    STATS_OP_TIMER(STAT_OP_FORMAT);
+
     // 以读写+二进制模式打开磁盘文件；若文件不存在则创建
     disk_file.open(disk_path, std::ios::in | std::ios::out | std::ios::binary);
     if (!disk_file) {
@@ -36,6 +44,12 @@ bool DiskFS::format()
         disk_file.open(disk_path, std::ios::trunc | std::ios::out | std::ios::in | std::ios::binary);
         if (!disk_file) return false;  // 创建失败则返回错误
     }
+    // 格式化与任何挂载互斥（包括其他进程的共享只读挂载）
+    if (!lock_image(true)) {
+        disk_file.close();
+        return false;
+    }
+    IoBatch batch(*this);  // 格式化期间的块写合并提交
 
     /**
     * 计算文件系统各区域的块数（磁盘布局规划）
@@ -55,7 +69,7 @@ bool DiskFS::format()
     
     // 初始化超级块（文件系统的元数据核心）
     memset(&super_block, 0, sizeof(SuperBlock));  // 先清空所有字段
-    strcpy(super_block.magic, "SIMFSv1");  // 设置文件系统标识（用于挂载时验证）
+    strcpy(super_block.magic, log_structured ? LOG_FS_MAGIC : "SIMFSv1");  // 设置文件系统标识（用于挂载时验证）
     super_block.block_size = BLOCK_SIZE;   // 块大小（4KB）
     super_block.total_blocks = MAX_BLOCKS; // 总块数（由磁盘大小和块大小决定）
     super_block.inode_blocks = inode_area_size;  // inode区占用的块数
@@ -72,9 +86,43 @@ bool DiskFS::format()
     super_block.inode_start = super_block.inode_bitmap + inode_bitmap_size;   // inode区紧跟inode位图
     super_block.data_start = super_block.inode_start + inode_area_size;       // 数据区紧跟inode区
 
-    // 将初始化好的超级块写入磁盘（位置0）
-    disk_file.seekp(0);
-    disk_file.write((char*)&super_block, sizeof(SuperBlock));
+    meta.reset();
+    cluster_cache.clear();
+
+    // 条带化：之后的读写按条带单元分布到各成员文件
+    stripe.reset();
+    if (!stripe_create()) {
+        disk_file.close();
+        unlock_image();
+        return false;
+    }
+    // 冷热分层：之后元数据区与根目录写到快速层，其余块写到容量层
+    tier.reset();
+    if (!tier_create(log_structured)) {
+        stripe.reset();
+        disk_file.close();
+        unlock_image();
+        return false;
+    }
+
+    // 日志布局：逻辑块号与原地布局相同，但物理空间要容纳检查点区并为段清理留出余量，
+    // 可分配的数据块限制为日志容量的3/4
+    log.reset();
+    if (log_structured) {
+        log.reset(new LogState(MAX_BLOCKS, MAX_INODES));
+        uint32_t log_capacity = log->segments * LOG_SEG_BLOCKS;
+        super_block.data_blocks = std::min(super_block.data_blocks, log_capacity / 4 * 3);
+        super_block.free_blocks = super_block.data_blocks;
+    }
+    // 校验和与去重：在数据区末尾预留校验表与去重表（位图写入、根目录块分配之前建立）
+    csum_create();
+    dedup_create();
+
+    // 将初始化好的超级块写入磁盘（位置0），并清除旧文件系统留下的挂载检查点
+    write_super_block();
+    MountCheckpoint no_ckpt;
+    memset(&no_ckpt, 0, sizeof(no_ckpt));
+    raw_write(MOUNT_CKPT_OFFSET, (const char*)&no_ckpt, sizeof(no_ckpt));
 
     // 初始化块位图（全部置0，表示所有数据块空闲）
     char buffer[BLOCK_SIZE] = {0};  // 用0初始化缓冲区（0表示空闲）
@@ -93,15 +141,14 @@ bool DiskFS::format()
     // 标记根目录inode（0号）为已使用（根目录是文件系统的起点）
     set_inode_bitmap(0, true);
 
-    // 初始化所有inode为未使用状态（默认值）
+    // 初始化所有inode为未使用状态（默认值）；日志布局下未写过的inode本来就读为未使用
     Inode inode;
     memset(&inode, 0, sizeof(Inode));  // 清空inode结构
-    for (uint32_t i = 1; i < MAX_INODES; i++)
+    for (uint32_t i = 1; i < MAX_INODES && !log; i++)
     {
         inode.inode_num = i;  // 设置inode编号
         inode.used = 0;       // 标记为未使用
-        disk_file.seekp(get_inode_pos(i));  // 定位到该inode在磁盘中的位置
-        disk_file.write((char*)&inode, sizeof(Inode));  // 写入inode数据
+        write_inode(i, inode);  // 写入inode数据
     }
 
     // 为根目录分配一个数据块（存储目录项）
@@ -109,7 +156,13 @@ bool DiskFS::format()
     Inode root_inode;
 
     if (root_block == -1) {
+        log.reset();
+        dedup.reset();
+        csum.reset();
+        stripe.reset();
+        tier.reset();
         disk_file.close();
+        unlock_image();
         return false;  // 根目录块分配失败，格式化失败
     }
 
@@ -127,12 +180,8 @@ bool DiskFS::format()
     root_inode.blocks[0] = root_block;  // 根目录的数据块指针指向该块
     root_inode.size = BLOCK_SIZE;       // 根目录大小为1个块（4KB）
 
-    // 将初始化好的根目录inode写入磁盘
-    disk_file.seekp(get_inode_pos(0));
-    disk_file.write((char*)&root_inode, sizeof(Inode));
-
-    // 检查写入是否成功
-    if (disk_file.fail()) {
+    // 将初始化好的根目录inode写入磁盘，并检查写入是否成功
+    if (!write_inode(0, root_inode)) {
         std::cerr << "根目录inode写入失败！" << std::endl;
     } else {
         std::cerr << "根目录inode写入成功" << std::endl;
@@ -150,40 +199,133 @@ bool DiskFS::format()
     set_block_bitmap(root_block, true);  // 标记该块为已使用（更新块位图）
             
     write_block(root_block, buffer);  // 将根目录数据写入分配的块
-    
+    bool ok = dedup_detach();  // 写入初始的去重表、快照目录与校验表
+    snap_save();
+    ok = csum_detach() && ok;
+
+    // 日志布局：写缓冲落盘并写入检查点，挂载时从检查点加载映射表；
+    // 两个检查点区都要覆盖，否则镜像上旧文件系统序号更大的检查点会在挂载时被选中
+    if (log) {
+        log_flush();
+        log_checkpoint();
+        log_checkpoint();
+        log.reset();
+    }
+
+    // 派发批次中排队的写，再关闭后端（批次守卫析构时队列已空）
+    batch_depth = 0;
+    ok = flush_io() && ok;
+    stripe.reset();
+    tier_detach();
     disk_file.close();  // 格式化完成，关闭磁盘文件
-    return true;
+    SharedMeta::remove(disk_path);
+    unlock_image();
+    return ok;
 }
 
 /**
  * @brief 挂载磁盘：加载文件系统到内存，准备进行操作
- * @return 挂载成功返回true；文件打开失败或文件系统标识不匹配返回false
+ * @param preload true表示用大块顺序读预读位图、inode区与根目录（仅原地布局）
+ * @param read_only true表示只读挂载：以只读方式打开镜像，拒绝一切修改，卸载时不写回
+ * @param shared true表示共享只读挂载（隐含read_only）：元数据放在跨进程共享的内存段中，见shared_meta.h
+ * @return 挂载成功返回true；镜像正被冲突地挂载、文件打开失败或文件系统标识不匹配返回false
  * 挂载是使用磁盘前的必要步骤，会验证文件系统合法性并加载超级块到内存
  */
-bool DiskFS::mount()
+bool DiskFS::mount(bool preload, bool read_only, bool shared)
 {
+    STATS_OP_TIMER(STAT_OP_MOUNT);
+
     if (is_mounted) 
     {
         return true;  // 若已挂载，直接返回成功
     }
 
-    // 以读写+二进制模式打开磁盘文件
-    disk_file.open(disk_path, std::ios::in | std::ios::out | std::ios::binary);
+    // 进程间互斥：可写挂载独占镜像，只读挂载可以共存
+    read_only = read_only || shared;
+    if (!lock_image(!read_only)) return false;
+    if (!mount_image(preload, read_only, shared)) {
+        unlock_image();
+        return false;
+    }
+    if (!read_only) SharedMeta::remove(disk_path);  // 镜像将被修改，旧的共享段作废
+    return true;
+}
+
+bool DiskFS::mount_image(bool preload, bool read_only, bool shared_meta)
+{
+    // 以读写（只读挂载时为只读）+二进制模式打开磁盘文件
+    this->read_only = read_only;
+    std::ios::openmode mode = std::ios::in | std::ios::binary;
+    if (!read_only) mode |= std::ios::out;
+    disk_file.open(disk_path, mode);
     if (!disk_file) 
     {
+        this->read_only = false;
         return false;  // 打开失败
     }
 
-    // 读取超级块（位于磁盘0号块）到内存
-    disk_file.seekg(0);
-    disk_file.read((char*)&super_block, sizeof(SuperBlock));
-
-    // 验证文件系统标识（必须为"SIMFSv1"，确保是兼容的文件系统）
-    if (strncmp(super_block.magic, "SIMFSv1", 7) != 0) {
+    // 读取超级块（位于磁盘0号块）到内存，并验证文件系统标识（必须为"SIMFSv1"，确保是兼容的文件系统）
+    if (!raw_read(0, (char*)&super_block, sizeof(SuperBlock))) {
+        disk_file.close();
+        return false;
+    }
+    if (strncmp(super_block.magic, LOG_FS_MAGIC, 7) == 0) {
+        // 日志布局：从最新的有效检查点加载映射表与超级块计数
+        log.reset(new LogState(MAX_BLOCKS, MAX_INODES));
+    } else if (strncmp(super_block.magic, "SIMFSv1", 7) != 0) {
         disk_file.close();  // 标识不匹配，关闭文件
         return false;
     }
+    // 启用校验和时超级块带有自身的CRC32C
+    if (!csum_check_super()) {
+        log.reset();
+        disk_file.close();
+        return false;
+    }
+    // 条带化：按超级块记录的几何与条带表组装成员（日志布局的检查点也在条带集上）
+    if (!stripe_attach()) {
+        log.reset();
+        disk_file.close();
+        return false;
+    }
+    // 冷热分层：打开快速层，之后的元数据读写都在快速层上
+    if (!tier_attach()) {
+        log.reset();
+        disk_file.close();
+        this->read_only = false;
+        return false;
+    }
+    if (log) {
+        if (!log_load()) {
+            log.reset();
+            stripe.reset();
+            disk_file.close();
+            return false;
+        }
+    } else if (shared_meta ? !shared_attach() : !meta_attach(preload)) {
+        // 原地布局：加载挂载检查点（或重建目录索引），按需预读元数据；共享挂载时映射共享段
+        stripe.reset();
+        tier.reset();
+        disk_file.close();
+        this->read_only = false;
+        return false;
+    }
+    if (!csum_attach() || !snap_attach() || !dedup_attach()) {
+        log.reset();
+        meta.reset();
+        shared.reset();
+        csum.reset();
+        stripe.reset();
+        tier.reset();
+        disk_file.close();
+        this->read_only = false;
+        return false;
+    }
 
+    mq_attach();  // 多队列块层启动失败时仍用文件流读写
+
+    defrag_cursor = 0;
+    cluster_cache.clear();
     is_mounted = true;  // 标记为已挂载状态
     return true;
 }
@@ -195,13 +337,53 @@ bool DiskFS::mount()
  */
 bool DiskFS::unmount() 
 {
+    STATS_OP_TIMER(STAT_OP_UNMOUNT);
+
     if (!is_mounted) return true;  // 若未挂载，直接返回成功
 
-    // 将内存中的超级块写回磁盘（保存最新的元数据）
-    disk_file.seekp(0);
-    disk_file.write((char*)&super_block, sizeof(SuperBlock));
-    
+    // 只读挂载没有任何修改，只释放内存状态
+    if (read_only) {
+        log.reset();
+        meta.reset();
+        dedup.reset();
+        csum.reset();
+        mq.reset();
+        stripe.reset();
+        tier_detach();
+        shared.reset();
+        snap_view.clear();
+        disk_file.close();
+        unlock_image();
+        is_mounted = false;
+        read_only = false;
+        return true;
+    }
+
+    // 回写延迟分配的脏页，再派发调度队列中尚未落盘的写请求（包括未结束的批次）
+    bool ok = delalloc_flush();
+    if (delalloc && !delalloc->files.empty()) {
+        // 回写失败的脏页不能留到下一次挂载（可能是另一个镜像）再被读出
+        std::cerr << "卸载：" << delalloc->clear() << " 个延迟分配的脏页未能回写，已丢弃" << std::endl;
+    }
+    batch_depth = 0;
+    ok = flush_io() && ok;  // 派发失败时仍完成卸载，但报告失败
+    ok = dedup_detach() && ok;  // 写入去重表与校验表（日志布局下随写缓冲追加）
+    ok = csum_detach() && ok;
+
+    // 将内存中的超级块写回磁盘（保存最新的元数据）；日志布局下追加写缓冲并写检查点
+    if (log) {
+        ok = log_flush() && ok;
+        ok = log_checkpoint() && ok;
+        log.reset();
+    }
+    ok = write_super_block() && ok;
+    ok = meta_detach() && ok;  // 干净卸载：写入挂载检查点
+    mq.reset();
+    stripe.reset();
+    ok = tier_detach() && ok;  // 写入干净表头，0号块复制到容量层作为引导副本
     disk_file.close();  // 关闭磁盘文件
+    unlock_image();
     is_mounted = false;  // 标记为未挂载状态
-    return true;
+    if (!ok) std::cerr << "卸载：部分数据写入失败" << std::endl;
+    return ok;
 }
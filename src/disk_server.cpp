@@ -0,0 +1,425 @@
+#include "../include/disk_server.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+DiskServer::DiskServer(DiskFS& disk, const std::string& socket_path, uint32_t workers)
+    : disk(disk), socket_path(socket_path), worker_count(workers), listen_fd(-1), epoll_fd(-1), wake_fd(-1),
+      stopping(false), next_conn(1), next_batch(0), exec_batch(0)
+{
+    memset(&st, 0, sizeof(st));
+    class_jobs.resize(qos.class_count());
+    if (worker_count == 0) worker_count = std::thread::hardware_concurrency();
+    worker_count = std::max(1u, std::min(worker_count, 8u));
+}
+
+DiskServer::~DiskServer()
+{
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(job_mutex);
+        job_cv.notify_all();
+    }
+    for (auto& w : workers) w.join();
+    for (auto& kv : conns) close(kv.second.fd);
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(socket_path.c_str());
+    }
+    if (epoll_fd >= 0) close(epoll_fd);
+    if (wake_fd >= 0) close(wake_fd);
+}
+
+namespace {
+
+uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+bool DiskServer::set_qos(const std::vector<QosClassConfig>& classes)
+{
+    if (!workers.empty()) return false;
+    qos = QosScheduler(classes);
+    class_jobs.assign(qos.class_count(), std::deque<Job>());
+    return true;
+}
+
+/**
+ * @brief 创建监听套接字、epoll与eventfd，启动工作线程
+ * @return 成功返回true；套接字路径过长或绑定失败返回false
+ */
+bool DiskServer::start()
+{
+    if (!disk.isMounted()) {
+        std::cerr << "守护进程启动失败：磁盘未挂载" << std::endl;
+        return false;
+    }
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "守护进程启动失败：套接字路径过长" << std::endl;
+        return false;
+    }
+    strcpy(addr.sun_path, socket_path.c_str());
+    unlink(socket_path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0 || bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 128) != 0) {
+        std::cerr << "守护进程启动失败：无法监听 " << socket_path << "（" << strerror(errno) << "）" << std::endl;
+        return false;
+    }
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd < 0 || wake_fd < 0) {
+        std::cerr << "守护进程启动失败：" << strerror(errno) << std::endl;
+        return false;
+    }
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0;  // 0：监听套接字
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+    ev.data.u64 = UINT64_MAX;  // UINT64_MAX：eventfd
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+
+    for (uint32_t i = 0; i < worker_count; i++) {
+        workers.push_back(std::thread(&DiskServer::worker_loop, this));
+    }
+    return true;
+}
+
+void DiskServer::stop()
+{
+    stopping = true;
+    if (wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = write(wake_fd, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+/**
+ * @brief 事件循环：其他数据均为连接编号
+ */
+void DiskServer::run()
+{
+    epoll_event events[64];
+    while (!stopping) {
+        int n = epoll_wait(epoll_fd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            uint64_t id = events[i].data.u64;
+            if (id == 0) {
+                accept_clients();
+                continue;
+            }
+            if (id == UINT64_MAX) {
+                uint64_t count;
+                ssize_t r = read(wake_fd, &count, sizeof(count));
+                (void)r;
+                deliver_replies();
+                continue;
+            }
+            auto it = conns.find(id);
+            if (it == conns.end()) continue;
+            bool ok = true;
+            if (events[i].events & EPOLLIN) ok = read_client(id, it->second);
+            if (ok && (events[i].events & EPOLLOUT)) ok = flush_client(id, it->second);
+            if (ok && (events[i].events & (EPOLLHUP | EPOLLERR)) && !(events[i].events & EPOLLIN)) ok = false;
+            if (!ok) close_client(id);
+        }
+    }
+}
+
+void DiskServer::accept_clients()
+{
+    while (true) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        uint64_t id = next_conn++;
+        Connection c;
+        c.fd = fd;
+        c.out_pos = 0;
+        c.cls = 0;
+        conns[id] = c;
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = id;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        st.connections++;
+    }
+}
+
+/**
+ * @brief 读取客户端数据并切分出完整请求放入队列
+ * @return 连接关闭或协议错误返回false
+ */
+bool DiskServer::read_client(uint64_t id, Connection& c)
+{
+    char buf[64 * 1024];
+    while (true) {
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            c.in.insert(c.in.end(), buf, buf + n);
+            continue;
+        }
+        if (n == 0) return false;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        return false;
+    }
+
+    size_t pos = 0;
+    std::vector<Job> parsed;
+    while (c.in.size() - pos >= sizeof(DaemonRequest)) {
+        Job job;
+        job.conn = id;
+        memcpy(&job.req, &c.in[pos], sizeof(DaemonRequest));
+        uint32_t payload = job.req.op == DOP_WRITE ? job.req.length : 0;
+        if (job.req.magic != DAEMON_MAGIC || payload > DAEMON_MAX_PAYLOAD) {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            st.protocol_errors++;
+            return false;
+        }
+        if (job.req.op == DOP_SET_CLASS) {
+            // 之后的请求进入新类别；qos的类别表在启动后不再改变，可以不加锁查找
+            int cls = qos.find_class(std::string(job.req.name, strnlen(job.req.name, MAX_FILENAME)));
+            if (cls >= 0) c.cls = (uint32_t)cls;
+        }
+        job.cls = c.cls;
+        if (c.in.size() - pos < sizeof(DaemonRequest) + payload) break;
+        pos += sizeof(DaemonRequest);
+        job.payload.assign(c.in.begin() + pos, c.in.begin() + pos + payload);
+        job.bytes = job.req.op == DOP_READ ? std::min(job.req.length, DAEMON_MAX_PAYLOAD) : payload;
+        pos += payload;
+        parsed.push_back(std::move(job));
+    }
+    c.in.erase(c.in.begin(), c.in.begin() + pos);
+    if (!parsed.empty()) {
+        std::lock_guard<std::mutex> lock(job_mutex);
+        uint64_t now = now_ns();
+        for (auto& job : parsed) {
+            job.enqueue_ns = now;
+            qos.enqueue(job.cls, job.bytes);
+            class_jobs[job.cls].push_back(std::move(job));
+        }
+        job_cv.notify_all();
+    }
+    return true;
+}
+
+/**
+ * @brief 尽量发送未发送的应答；发不完时关注EPOLLOUT
+ */
+bool DiskServer::flush_client(uint64_t id, Connection& c)
+{
+    while (c.out_pos < c.out.size()) {
+        ssize_t n = send(c.fd, &c.out[c.out_pos], c.out.size() - c.out_pos, MSG_NOSIGNAL);
+        if (n > 0) {
+            c.out_pos += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return false;
+    }
+    if (c.out_pos == c.out.size()) {
+        c.out.clear();
+        c.out_pos = 0;
+    }
+    epoll_event ev;
+    ev.events = EPOLLIN | (c.out.empty() ? 0u : (uint32_t)EPOLLOUT);
+    ev.data.u64 = id;
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c.fd, &ev);
+    return true;
+}
+
+void DiskServer::deliver_replies()
+{
+    std::vector<Reply> ready;
+    {
+        std::lock_guard<std::mutex> lock(reply_mutex);
+        ready.swap(replies);
+    }
+    std::vector<uint64_t> touched;
+    for (auto& r : ready) {
+        auto it = conns.find(r.conn);
+        if (it == conns.end()) continue;  // 客户端已断开
+        it->second.out.insert(it->second.out.end(), r.data.begin(), r.data.end());
+        touched.push_back(r.conn);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (uint64_t id : touched) {
+        auto it = conns.find(id);
+        if (!flush_client(id, it->second)) close_client(id);
+    }
+}
+
+void DiskServer::close_client(uint64_t id)
+{
+    auto it = conns.find(id);
+    if (it == conns.end()) return;
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    close(it->second.fd);
+    conns.erase(it);
+}
+
+/**
+ * @brief 工作线程：按QoS顺序一次取走所有可派发的请求，在一个I/O批次内执行
+ * 全部类别都被限流时，等到最早可派发的时间再取
+ */
+void DiskServer::worker_loop()
+{
+    while (true) {
+        std::vector<Job> batch;
+        uint64_t seq;
+        {
+            std::unique_lock<std::mutex> lock(job_mutex);
+            while (true) {
+                if (stopping) return;
+                uint64_t wait_ns = 0;
+                while (batch.size() < DAEMON_MAX_BATCH) {
+                    int cls = qos.dequeue(now_ns(), wait_ns);
+                    if (cls < 0) break;
+                    batch.push_back(std::move(class_jobs[cls].front()));
+                    class_jobs[cls].pop_front();
+                }
+                if (!batch.empty()) break;
+                if (qos.queued() == 0) {
+                    job_cv.wait(lock);
+                } else {
+                    job_cv.wait_for(lock, std::chrono::nanoseconds(wait_ns));
+                }
+            }
+            seq = next_batch++;
+        }
+
+        // 批次按取出顺序执行并交付应答，同一连接的请求不会乱序
+        std::vector<Reply> done(batch.size());
+        {
+            std::unique_lock<std::mutex> lock(fs_mutex);
+            fs_cv.wait(lock, [this, seq]() { return exec_batch == seq; });
+            disk.begin_batch();
+            for (size_t i = 0; i < batch.size(); i++) execute(batch[i], done[i]);
+            disk.end_batch();
+            {
+                std::lock_guard<std::mutex> reply_lock(reply_mutex);
+                for (auto& r : done) replies.push_back(r);
+            }
+            exec_batch++;
+            fs_cv.notify_all();
+        }
+        {
+            std::lock_guard<std::mutex> lock(job_mutex);
+            uint64_t now = now_ns();
+            for (const auto& job : batch) qos.complete(job.cls, job.bytes, now - job.enqueue_ns);
+        }
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            st.batches++;
+            st.requests += batch.size();
+            st.max_batch = std::max<uint64_t>(st.max_batch, batch.size());
+            for (const auto& r : done) {
+                if (((const DaemonResponse*)r.data.data())->status < 0) st.failed++;
+            }
+        }
+        uint64_t one = 1;
+        ssize_t n = write(wake_fd, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+/**
+ * @brief 执行一个请求（调用者持有fs_mutex）
+ */
+void DiskServer::execute(const Job& job, Reply& reply)
+{
+    const DaemonRequest& req = job.req;
+    std::string name(req.name, strnlen(req.name, MAX_FILENAME));
+    reply.conn = job.conn;
+    reply.data.assign(sizeof(DaemonResponse), 0);
+    int32_t status = -1;
+
+    switch (req.op) {
+    case DOP_PING:
+        status = 0;
+        break;
+    case DOP_CREATE:
+        status = disk.create_file(name);
+        break;
+    case DOP_OPEN:
+        status = disk.open_file(name);
+        break;
+    case DOP_DELETE:
+        status = disk.delete_file(name) ? 0 : -1;
+        break;
+    case DOP_READ: {
+        uint32_t len = std::min(req.length, DAEMON_MAX_PAYLOAD);
+        reply.data.resize(sizeof(DaemonResponse) + len);
+        status = disk.read_file(req.inode, &reply.data[sizeof(DaemonResponse)], len, req.offset);
+        reply.data.resize(sizeof(DaemonResponse) + std::max(status, 0));
+        break;
+    }
+    case DOP_WRITE:
+        status = disk.write_file(req.inode, job.payload.data(), job.payload.size(), req.offset);
+        break;
+    case DOP_SET_CLASS:
+        status = qos.find_class(name) >= 0 ? 0 : -1;
+        break;
+    case DOP_LIST: {
+        status = 0;
+        for (const auto& entry : disk.list_files()) {
+            if (entry.inode_num == 0) continue;
+            DaemonListEntry e;
+            memset(&e, 0, sizeof(e));
+            e.inode_num = entry.inode_num;
+            memcpy(e.name, entry.name, MAX_FILENAME);
+            const char* p = (const char*)&e;
+            reply.data.insert(reply.data.end(), p, p + sizeof(e));
+            status++;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    DaemonResponse resp;
+    resp.magic = DAEMON_MAGIC;
+    resp.id = req.id;
+    resp.status = status;
+    resp.length = reply.data.size() - sizeof(DaemonResponse);
+    memcpy(reply.data.data(), &resp, sizeof(resp));
+}
+
+ServerStats DiskServer::stats()
+{
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return st;
+}
+
+void DiskServer::print_stats()
+{
+    ServerStats s = stats();
+    std::cout << "守护进程统计: 连接 " << s.connections << "，请求 " << s.requests << "（失败 " << s.failed << "），批次 "
+              << s.batches << "（平均 " << (s.batches ? (double)s.requests / s.batches : 0.0) << "，最大 " << s.max_batch
+              << "），协议错误 " << s.protocol_errors << "，工作线程 " << worker_count << "\n";
+    std::lock_guard<std::mutex> lock(job_mutex);
+    qos.print_stats();
+}
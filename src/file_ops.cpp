@@ -12,33 +12,28 @@
  */
 int DiskFS::create_file(const std::string& name)
 {
+    STATS_OP_TIMER(STAT_OP_CREATE);
+    TraceScope trace(tracer, TRACE_CREATE, -1, 0, 0);
+    IoBatch batch(*this);
+
     // 前置条件检查：磁盘已挂载，文件名长度合法（不含终止符不超过MAX_FILENAME-1）
     if (!isMounted() || name.empty() || name.length() >= MAX_FILENAME) 
     {
         std::cerr << "创建文件失败：磁盘未挂载或文件名无效" << std::endl;
         return -1;
     }
+    if (reject_read_only("创建文件")) return -1;
 
-    // 清除文件流错误状态，避免之前的错误影响当前操作
-    disk_file.clear();
-
-    // 检查文件是否已存在（遍历根目录目录项）
-    std::vector<DirEntry> dir_list = list_files();
-    for (const auto& entry : dir_list) 
+    // 检查文件是否已存在（有目录索引时查索引，否则遍历根目录目录项）
+    if (find_entry(name) != -1)
     {
-        if (entry.valid && name == entry.name) 
-        {
-            std::cerr << "创建文件失败：" << name << " 已存在" << std::endl;
-            return -1;
-        }
+        std::cerr << "创建文件失败：" << name << " 已存在" << std::endl;
+        return -1;
     }
 
     // 读取根目录inode（0号inode），并检查读取结果
     Inode root_inode;
-    disk_file.seekg(get_inode_pos(0));
-    disk_file.read((char*)&root_inode, sizeof(Inode));
-
-    if (disk_file.fail() || root_inode.type != 2) {  // 检查读取失败或类型错误
+    if (!read_inode(0, root_inode) || root_inode.type != 2) {  // 检查读取失败或类型错误
         std::cerr << "创建文件失败：根目录inode无效" << std::endl;
         return -1;
     }
@@ -52,6 +47,7 @@ int DiskFS::create_file(const std::string& name)
 
     // 分配空闲inode
     int inode_num = find_free_inode();
+    trace.set_inode(inode_num);
     if (inode_num == -1) {
         std::cerr << "创建文件失败：无空闲inode" << std::endl;
         return -1;
@@ -66,11 +62,10 @@ int DiskFS::create_file(const std::string& name)
     new_inode.create_time = now;
     new_inode.modify_time = now;
     new_inode.size = 0;  // 初始大小为0
+    new_inode.flags = super_block.compress ? INODE_COMPRESSED : 0;  // 按超级块的默认值决定是否压缩
 
     // 写入新inode到磁盘，并检查操作结果
-    disk_file.seekp(get_inode_pos(inode_num));
-    disk_file.write((char*)&new_inode, sizeof(Inode));
-    if (disk_file.fail()) {
+    if (!write_inode(inode_num, new_inode)) {
         std::cerr << "创建文件失败：写入inode " << inode_num << " 失败" << std::endl;
         return -1;  // 写入失败，不标记位图，避免inode泄露
     }
@@ -118,9 +113,7 @@ int DiskFS::create_file(const std::string& name)
 
     // 更新根目录inode的修改时间，并写回磁盘
     root_inode.modify_time = now;
-    disk_file.seekp(get_inode_pos(0));
-    disk_file.write((char*)&root_inode, sizeof(Inode));
-    if (disk_file.fail()) {
+    if (!write_inode(0, root_inode)) {
         std::cerr << "警告：根目录修改时间更新失败，但文件已创建" << std::endl;
         // 此处不返回-1，因为文件已成功创建，仅元数据有小问题
     }
@@ -136,17 +129,15 @@ int DiskFS::create_file(const std::string& name)
  * 打开文件本质是通过文件名找到inode，后续操作通过inode编号进行
  */
 int DiskFS::open_file(const std::string& name) {
+    STATS_OP_TIMER(STAT_OP_OPEN);
+    TraceScope trace(tracer, TRACE_OPEN, -1, 0, 0);
+
     if (!isMounted()) return -1;  // 未挂载则无法操作
 
-    // 获取根目录中的所有文件条目
-    std::vector<DirEntry> entries = list_files();
-    // 遍历目录项，寻找文件名匹配且有效的条目
-    for (const auto& entry : entries) {
-        if (entry.valid && name == entry.name) {
-            return entry.inode_num;  // 返回对应的inode编号
-        }
-    }
-    return -1;  // 未找到文件
+    // 在根目录中查找文件名（有目录索引时不遍历目录）
+    int inode_num = find_entry(name);
+    if (inode_num != -1) trace.set_inode(inode_num);
+    return inode_num;
 }
 
 /**
@@ -158,23 +149,26 @@ int DiskFS::open_file(const std::string& name) {
  * @return 成功返回实际读取的字节数；0表示已到文件末尾；-1表示失败（参数无效等）
  */
 int DiskFS::read_file(int inode_num, char* buffer, size_t size, off_t offset) {
+    STATS_OP_TIMER(STAT_OP_READ);
+    TraceScope trace(tracer, TRACE_READ, inode_num, (uint32_t)offset, (uint32_t)size);
+
     // 检查前置条件：磁盘已挂载，inode编号有效
     if (!isMounted() || inode_num < 0 || (uint32_t)inode_num >= super_block.total_inodes) 
         return -1;
 
     // 读取目标文件的inode信息
     Inode inode;
-    disk_file.seekg(get_inode_pos(inode_num));
-    disk_file.read((char*)&inode, sizeof(Inode));
     // 检查inode状态：必须是已使用的普通文件（类型1）
-    if (!inode.used || inode.type != 1) return -1;
+    if (!read_inode(inode_num, inode) || !inode.used || inode.type != 1) return -1;
 
+    // 偏移量已到达或超出文件大小，无数据可读（空洞与脏页只在文件长度以内有效）
+    if ((uint64_t)offset >= inode.size) return 0;
     // 计算实际可读取的字节数（不能超过文件大小 - 偏移量）
     size_t max_read = inode.size - offset;
-    if (max_read <= 0) return 0;  // 偏移量已超出文件大小，无数据可读
     size_t read_size = std::min(size, max_read);  // 取期望大小和最大可读取的较小值
 
     if (read_size == 0) return 0;  // 无需读取
+    if (inode.flags & INODE_COMPRESSED) return compressed_read(inode_num, inode, buffer, read_size, offset);
 
     // 读取数据：按块读取，处理跨块情况
     char block_buffer[BLOCK_SIZE];  // 临时存储块数据的缓冲区
@@ -188,11 +182,18 @@ int DiskFS::read_file(int inode_num, char* buffer, size_t size, off_t offset) {
         if (block_idx >= 16) break;
 
         uint32_t block_num = inode.blocks[block_idx];  // 数据块编号
-        // 若块编号无效（未分配），读取失败
-        if (block_num == 0) break;
-
-        // 读取该数据块到临时缓冲区
-        if (!read_block(block_num, block_buffer)) return -1;
+        if (block_num == 0) {
+            // 延迟分配的块由内存中的脏页服务；否则是文件长度以内的空洞（截断扩展或越过末尾写入留下），读出为0
+            const char* page = delalloc ? delalloc->find(inode_num, block_idx) : nullptr;
+            if (page) memcpy(block_buffer, page, BLOCK_SIZE);
+            else memset(block_buffer, 0, BLOCK_SIZE);
+        } else if (inode.unwritten & (1u << block_idx)) {
+            // fallocate预留、尚未写入的块：不读磁盘上的残留内容
+            memset(block_buffer, 0, BLOCK_SIZE);
+        } else if (!read_block(block_num, block_buffer)) {
+            // 读取该数据块到临时缓冲区
+            return -1;
+        }
 
         // 计算在块内的偏移量（当前偏移量 % 块大小）
         off_t in_block_offset = current_offset % BLOCK_SIZE;
@@ -220,17 +221,20 @@ int DiskFS::read_file(int inode_num, char* buffer, size_t size, off_t offset) {
  * @return 成功返回实际写入的字节数；-1表示失败（参数无效等）
  */
 int DiskFS::write_file(int inode_num, const char* buffer, size_t size, off_t offset) {
+    STATS_OP_TIMER(STAT_OP_WRITE);
+    TraceScope trace(tracer, TRACE_WRITE, inode_num, (uint32_t)offset, (uint32_t)size);
+    IoBatch batch(*this);
+
     // 检查前置条件：磁盘已挂载，inode编号有效，缓冲区非空且有数据可写
     if (!isMounted() || inode_num < 0 || (uint32_t)inode_num >= super_block.total_inodes || 
-        buffer == nullptr || size == 0) 
+        buffer == nullptr || size == 0 || reject_read_only("写入文件")) 
         return -1;
 
     // 读取目标文件的inode信息
     Inode inode;
-    disk_file.seekg(get_inode_pos(inode_num));
-    disk_file.read((char*)&inode, sizeof(Inode));
     // 检查inode状态：必须是已使用的普通文件（类型1）
-    if (!inode.used || inode.type != 1) return -1;
+    if (!read_inode(inode_num, inode) || !inode.used || inode.type != 1) return -1;
+    if (inode.flags & INODE_COMPRESSED) return compressed_write(inode_num, inode, buffer, size, offset);
 
     // 写入数据：按块写入，处理跨块和新块分配
     char block_buffer[BLOCK_SIZE];  // 临时存储块数据的缓冲区
@@ -245,16 +249,32 @@ int DiskFS::write_file(int inode_num, const char* buffer, size_t size, off_t off
         if (block_idx >= 16) break;
 
         int block_num = inode.blocks[block_idx];  // 数据块编号
-        // 若块未分配，尝试分配新块
+        if (block_num == 0 && delalloc && !dedup) {
+            // 延迟分配：只写入内存中的脏页并预留一块空闲计数，回写时再分配物理块
+            char* page = delalloc->get(inode_num, block_idx, super_block.free_blocks);
+            if (!page) break;  // 空闲块已全部预留
+            size_t in_page = current_offset % BLOCK_SIZE;
+            size_t n = std::min((size_t)BLOCK_SIZE - in_page, size - bytes_written);
+            memcpy(page + in_page, buffer + bytes_written, n);
+            bytes_written += n;
+            current_offset += n;
+            continue;
+        }
+        // 若块未分配，尝试分配新块（去重或引用计数模式下由dedup_store决定）
         if (block_num == 0) {
-            block_num = find_free_block();  // 查找空闲块
-            if (block_num == -1) break;     // 无空闲块，写入失败
-            inode.blocks[block_idx] = (uint32_t)block_num;  // 更新inode的块指针
-            set_block_bitmap(block_num, true);    // 标记块为已使用
+            if (!dedup) {
+                block_num = find_free_block();  // 查找空闲块
+                if (block_num == -1) break;     // 无空闲块，写入失败
+                inode.blocks[block_idx] = (uint32_t)block_num;  // 更新inode的块指针
+                set_block_bitmap(block_num, true);    // 标记块为已使用
+            }
             // 初始化新块为0（避免残留数据）
             memset(block_buffer, 0, BLOCK_SIZE);
-        } else {
-            // 若块已分配，先读取原有数据（避免覆盖）
+        } else if (inode.unwritten & (1u << block_idx)) {
+            // 预留未写入的块：按全0处理，写入后转为普通块
+            memset(block_buffer, 0, BLOCK_SIZE);
+        } else if (current_offset % BLOCK_SIZE != 0 || size - bytes_written < (size_t)BLOCK_SIZE) {
+            // 若块已分配且只写入其中一部分，先读取原有数据（避免覆盖）；整块覆盖时无需读取
             if (!read_block(block_num, block_buffer)) return -1;
         }
 
@@ -268,8 +288,13 @@ int DiskFS::write_file(int inode_num, const char* buffer, size_t size, off_t off
 
         // 将数据从用户缓冲区复制到块缓冲区
         memcpy(block_buffer + in_block_offset, buffer + bytes_written, write_to_block);
-        // 将更新后的块数据写回磁盘
-        if (!write_block(block_num, block_buffer)) return -1;
+        // 将更新后的块数据写回磁盘；去重或引用计数模式下共享已有块、原地写或写时复制（克隆与快照共享的块不被改写）
+        if (dedup) {
+            if (!dedup_store(inode.blocks[block_idx], block_buffer)) break;
+        } else if (!write_block(block_num, block_buffer)) {
+            return -1;
+        }
+        inode.unwritten &= ~(1u << block_idx);
 
         bytes_written += write_to_block;   // 更新已写入字节数
         current_offset += write_to_block;  // 更新当前偏移量
@@ -282,8 +307,10 @@ int DiskFS::write_file(int inode_num, const char* buffer, size_t size, off_t off
     // 更新文件修改时间
     inode.modify_time = now;
     // 将更新后的inode写回磁盘
-    disk_file.seekp(get_inode_pos(inode_num));
-    disk_file.write((char*)&inode, sizeof(Inode));
+    write_inode(inode_num, inode);
+    if (delalloc && delalloc->reserved > DELALLOC_MAX_PAGES && !delalloc_flush()) return -1;
+    // 排队的写在批次结束时派发，派发失败说明数据没有落盘
+    if (!batch.end()) return -1;
 
     return bytes_written;  // 返回实际写入的字节数
 }
@@ -294,13 +321,15 @@ int DiskFS::write_file(int inode_num, const char* buffer, size_t size, off_t off
  * @return 成功返回true；失败返回false（文件不存在/未挂载等）
  */
 bool DiskFS::delete_file(const std::string& name) {
-    if (!isMounted()) return false;  // 未挂载则无法操作
+    STATS_OP_TIMER(STAT_OP_DELETE);
+    TraceScope trace(tracer, TRACE_DELETE, -1, 0, 0);
+    IoBatch batch(*this);
+
+    if (!isMounted() || reject_read_only("删除文件")) return false;  // 未挂载或只读挂载则无法操作
 
     // 读取根目录inode（0号）
     Inode root_inode;
-    disk_file.seekg(get_inode_pos(0));
-    disk_file.read((char*)&root_inode, sizeof(Inode));
-    if (root_inode.type != 2) return false;  // 根目录必须是目录类型
+    if (!read_inode(0, root_inode) || root_inode.type != 2) return false;  // 根目录必须是目录类型
 
     // 读取根目录数据块，查找目标文件的目录项
     char buffer[BLOCK_SIZE];
@@ -320,26 +349,29 @@ bool DiskFS::delete_file(const std::string& name) {
     }
 
     if (target_inode == -1) return false;  // 未找到文件
+    trace.set_inode(target_inode);
 
     // 读取目标文件的inode
     Inode file_inode;
-    disk_file.seekg(get_inode_pos(target_inode));
-    disk_file.read((char*)&file_inode, sizeof(Inode));
-    if (!file_inode.used || file_inode.type != 1) return false;  // 必须是已使用的文件
+    if (!read_inode(target_inode, file_inode) || !file_inode.used || file_inode.type != 1) return false;  // 必须是已使用的文件
+
+    // 尚未分配物理块的脏页直接丢弃，释放预留
+    if (delalloc) delalloc->drop(target_inode);
 
     // 释放文件占用的数据块（遍历inode的块指针）
     for (uint32_t i = 0; i < 16; i++) {
         uint32_t block_num = file_inode.blocks[i];
         if (block_num != 0) {
-            set_block_bitmap(block_num, false);  // 标记块为空闲
+            release_block(block_num);  // 标记块为空闲并通知块层（共享块只减少引用）
             file_inode.blocks[i] = 0;  // 清空块指针
         }
     }
 
+    cluster_cache.invalidate(target_inode);
+
     // 标记inode为未使用
     file_inode.used = 0;
-    disk_file.seekp(get_inode_pos(target_inode));
-    disk_file.write((char*)&file_inode, sizeof(Inode));
+    write_inode(target_inode, file_inode);
     set_inode_bitmap(target_inode, false);  // 更新inode位图
 
     // 从根目录中移除该文件的目录项（标记为无效）
@@ -348,26 +380,158 @@ bool DiskFS::delete_file(const std::string& name) {
 
     // 更新根目录的修改时间
     root_inode.modify_time = time(nullptr);
-    disk_file.seekp(get_inode_pos(0));
-    disk_file.write((char*)&root_inode, sizeof(Inode));
+    write_inode(0, root_inode);
 
     return true;
 }
 
+/**
+ * @brief 截断或扩展文件：新长度之后的块整批释放，最后一个不完整块的尾部清零
+ * @param inode_num 目标文件的inode编号
+ * @param new_size 新的文件大小（字节，不超过16个直接块；大于原大小时只扩展长度，扩出部分读出为0）
+ * @return 成功返回释放的块数；-1表示失败（参数无效、压缩文件或I/O失败）
+ */
+int DiskFS::truncate_file(int inode_num, uint32_t new_size)
+{
+    STATS_OP_TIMER(STAT_OP_TRUNCATE);
+    TraceScope trace(tracer, TRACE_TRUNCATE, inode_num, new_size, 0);
+    IoBatch batch(*this);
+    if (!isMounted() || inode_num < 0 || (uint32_t)inode_num >= super_block.total_inodes ||
+        reject_read_only("截断文件"))
+        return -1;
+    Inode inode;
+    if (!read_inode(inode_num, inode) || !inode.used || inode.type != 1) {
+        std::cerr << "截断文件失败：inode " << inode_num << " 不是文件" << std::endl;
+        return -1;
+    }
+    if (new_size > 16 * BLOCK_SIZE) {
+        std::cerr << "截断文件失败：长度超出直接块范围（" << 16 * BLOCK_SIZE << " 字节）" << std::endl;
+        return -1;
+    }
+    if (inode.flags & INODE_COMPRESSED) {
+        std::cerr << "截断文件失败：压缩文件按簇存放，请先用compress off转换" << std::endl;
+        return -1;
+    }
+
+    uint32_t keep = (new_size + BLOCK_SIZE - 1) / BLOCK_SIZE;  // 保留的块数
+    uint32_t tail = new_size % BLOCK_SIZE;                      // 最后一块中保留的字节数（0表示整块）
+    if (delalloc) delalloc->truncate(inode_num, keep, tail);
+
+    // 缩短到块中间时把该块尾部清零，之后再扩展时读出为0（未写入的块本来就读出为0）
+    uint32_t last = keep - 1;
+    if (new_size < inode.size && tail != 0 && inode.blocks[last] != 0 && !(inode.unwritten & (1u << last))) {
+        char buffer[BLOCK_SIZE];
+        if (!read_block(inode.blocks[last], buffer)) return -1;
+        memset(buffer + tail, 0, BLOCK_SIZE - tail);
+        if (dedup) {
+            if (!dedup_store(inode.blocks[last], buffer)) return -1;  // 共享块先写时复制
+        } else if (!write_block(inode.blocks[last], buffer)) {
+            return -1;
+        }
+    }
+
+    std::vector<uint32_t> freed;
+    for (uint32_t i = keep; i < 16; i++) {
+        if (inode.blocks[i] != 0) freed.push_back(inode.blocks[i]);
+        inode.blocks[i] = 0;
+        inode.unwritten &= ~(1u << i);
+    }
+    inode.size = new_size;
+    inode.modify_time = time(nullptr);
+    // 先写回inode再释放块，中途失败时最多泄漏块而不会出现两个文件共用一块
+    if (!write_inode(inode_num, inode) || !release_blocks(freed) || !batch.end()) {
+        std::cerr << "截断文件失败：inode " << inode_num << " 写回失败" << std::endl;
+        return -1;
+    }
+    return freed.size();
+}
+
+/**
+ * @brief 预分配文件空间：为范围内尚未分配的块一次分配一段连续空闲区，并标记为未写入（读出为0，首次写入时转换）
+ * @param inode_num 目标文件的inode编号
+ * @param offset 起始偏移（字节）
+ * @param len 长度（字节），offset+len不超过16个直接块；超出原大小时文件长度随之扩展
+ * @return 成功返回新预留的块数（范围内已有块或脏页的不重复预留）；-1表示失败（参数无效、空间不足等）
+ */
+int DiskFS::fallocate_file(int inode_num, uint32_t offset, uint32_t len)
+{
+    STATS_OP_TIMER(STAT_OP_FALLOCATE);
+    TraceScope trace(tracer, TRACE_FALLOCATE, inode_num, offset, len);
+    IoBatch batch(*this);
+    if (!isMounted() || inode_num < 0 || (uint32_t)inode_num >= super_block.total_inodes ||
+        reject_read_only("预分配"))
+        return -1;
+    Inode inode;
+    if (!read_inode(inode_num, inode) || !inode.used || inode.type != 1) {
+        std::cerr << "预分配失败：inode " << inode_num << " 不是文件" << std::endl;
+        return -1;
+    }
+    if (len == 0 || (uint64_t)offset + len > 16 * BLOCK_SIZE) {
+        std::cerr << "预分配失败：范围为空或超出直接块范围（" << 16 * BLOCK_SIZE << " 字节）" << std::endl;
+        return -1;
+    }
+    if (dedup || (inode.flags & INODE_COMPRESSED)) {
+        std::cerr << "预分配失败：" << (dedup ? "去重与引用计数模式下块由内容决定" : "压缩文件按簇存放")
+                  << "，不支持预分配" << std::endl;
+        return -1;
+    }
+
+    uint32_t first = offset / BLOCK_SIZE;
+    uint32_t end = (offset + len + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<uint32_t> idxs;
+    for (uint32_t i = first; i < end; i++) {
+        if (inode.blocks[i] == 0 && !(delalloc && delalloc->find(inode_num, i))) idxs.push_back(i);
+    }
+    if (!idxs.empty()) {
+        // 不能占用延迟分配已预留的空闲块
+        uint32_t reserved = delalloc ? delalloc->reserved : 0;
+        if (super_block.free_blocks < reserved + idxs.size()) {
+            std::cerr << "预分配失败：空闲块不足（需要 " << idxs.size() << " 块）" << std::endl;
+            return -1;
+        }
+        // 紧接文件内前一个已分配块放置，与已有数据保持连续
+        uint32_t goal = 0;
+        for (uint32_t i = idxs[0]; i > 0; i--) {
+            if (inode.blocks[i - 1] != 0) {
+                goal = inode.blocks[i - 1] + (idxs[0] - (i - 1));
+                break;
+            }
+        }
+        std::vector<uint32_t> blocks;
+        if (!alloc_blocks(goal, idxs.size(), blocks)) {
+            std::cerr << "预分配失败：无法分配 " << idxs.size() << " 个数据块" << std::endl;
+            return -1;
+        }
+        for (size_t k = 0; k < idxs.size(); k++) {
+            inode.blocks[idxs[k]] = blocks[k];
+            inode.unwritten |= 1u << idxs[k];
+        }
+    }
+    if (offset + len > inode.size) inode.size = offset + len;
+    inode.modify_time = time(nullptr);
+    // 排队的inode写在批次结束时派发，派发失败说明预留没有落盘
+    if (!write_inode(inode_num, inode) || !batch.end()) {
+        std::cerr << "预分配失败：inode " << inode_num << " 写回失败" << std::endl;
+        return -1;
+    }
+    return idxs.size();
+}
+
 /**
  * @brief 列出根目录中的所有文件（有效目录项）
  * @return 包含所有有效目录项的向量（不含"."目录）
  */
 std::vector<DirEntry> DiskFS::list_files() {
+    STATS_OP_TIMER(STAT_OP_LIST);
+    TraceScope trace(tracer, TRACE_LIST, -1, 0, 0);
+
     std::vector<DirEntry> entries;  // 存储结果的向量
 
     if (!isMounted()) return entries;  // 未挂载则返回空
 
     // 读取根目录inode（0号）
     Inode root_inode;
-    disk_file.seekg(get_inode_pos(0));
-    disk_file.read((char*)&root_inode, sizeof(Inode));
-    if (root_inode.type != 2) return entries;  // 根目录必须是目录类型
+    if (!read_inode(0, root_inode) || root_inode.type != 2) return entries;  // 根目录必须是目录类型
 
     // 读取根目录数据块
     char buffer[BLOCK_SIZE];
@@ -417,19 +581,27 @@ void DiskFS::print_info()
     std::cout << "  总inode数: " << super_block.total_inodes << "\n";
     std::cout << "  已使用inode数: " << super_block.total_inodes - super_block.free_inodes << "\n";
     std::cout << "  空闲inode数: " << super_block.free_inodes << "\n";
+    print_log_info();
+    print_meta_info();
+    print_shared_info();
+    print_stripe_info();
+    print_tier_info();
+    print_mq_info();
+    print_delalloc_info();
+    print_compress_info();
+    print_dedup_info();
+    print_csum_info();
 }
 
 int DiskFS::get_file_size(int inode_num) {
+    STATS_OP_TIMER(STAT_OP_STAT);
+
     if (!is_mounted || inode_num < 0 || (uint32_t)inode_num >= super_block.total_inodes) {
         return -1;
     }
 
     Inode inode;
-    uint32_t pos = get_inode_pos(inode_num);
-    disk_file.seekg(pos);
-    disk_file.read((char*)&inode, sizeof(Inode));
-    
-    if (!disk_file.good() || !inode.used) {
+    if (!read_inode(inode_num, inode) || !inode.used) {
         return -1;
     }
 
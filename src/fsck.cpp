@@ -0,0 +1,362 @@
+#include "../include/fsck.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <thread>
+
+namespace {
+
+const size_t FSCK_READ_CHUNK = 1024 * 1024;  // 顺序读元数据区的单次I/O大小
+const uint32_t FSCK_MAX_THREADS = 8;
+const uint32_t FSCK_MIN_INODES_PER_THREAD = 64;
+
+typedef std::pair<uint32_t, uint32_t> Slot;  // (inode编号, 块指针下标)
+
+/**
+ * @brief 单个扫描线程的结果
+ */
+struct ScanResult
+{
+    std::vector<uint64_t> refs;    // 本线程范围内的块引用位图（数据区相对下标）
+    std::vector<Slot> dup_slots;   // 线程内重复引用的块指针（第一次之后的引用）
+    std::vector<Slot> bad_slots;   // 越界的块指针
+};
+
+/**
+ * @brief 盘上按字节存放的位图转为64位字（小端主机上第i位仍是第i位）
+ */
+std::vector<uint64_t> to_words(const std::vector<uint8_t>& bytes, size_t nbits)
+{
+    std::vector<uint64_t> words((nbits + 63) / 64, 0);
+    memcpy(words.data(), bytes.data(), std::min(bytes.size(), words.size() * sizeof(uint64_t)));
+    if (nbits % 64) words.back() &= (1ULL << (nbits % 64)) - 1;
+    return words;
+}
+
+inline bool test_bit(const std::vector<uint64_t>& words, uint32_t i)
+{
+    return (words[i / 64] >> (i % 64)) & 1;
+}
+
+inline void set_bit(std::vector<uint64_t>& words, uint32_t i)
+{
+    words[i / 64] |= 1ULL << (i % 64);
+}
+
+/**
+ * @brief 扫描[begin, end)范围内的活inode，记录块引用（线程函数，只读共享数据）
+ * @param shared 为true时（去重模式）多次引用同一块是合法的，不记为重复
+ */
+void scan_inodes(const char* table, const std::vector<uint8_t>& live, uint32_t begin, uint32_t end,
+                 uint32_t data_start, uint32_t data_blocks, bool shared, ScanResult& out)
+{
+    out.refs.assign((data_blocks + 63) / 64, 0);
+    for (uint32_t n = begin; n < end; n++) {
+        if (!live[n]) continue;
+        Inode inode;
+        memcpy(&inode, table + (size_t)n * sizeof(Inode), sizeof(Inode));
+        for (uint32_t s = 0; s < 16; s++) {
+            uint32_t b = inode.blocks[s];
+            if (b == 0) continue;
+            if (b < data_start || b >= data_start + data_blocks) {
+                out.bad_slots.push_back(Slot(n, s));
+            } else if (!shared && test_bit(out.refs, b - data_start)) {
+                out.dup_slots.push_back(Slot(n, s));
+            } else {
+                set_bit(out.refs, b - data_start);
+            }
+        }
+    }
+}
+
+} // namespace
+
+uint64_t bitmap_popcount(const uint64_t* words, size_t nbits)
+{
+    size_t n = nbits / 64;
+    uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    size_t i = 0;
+    // 四路展开，使各路计数互不依赖
+    for (; i + 4 <= n; i += 4) {
+        c0 += __builtin_popcountll(words[i]);
+        c1 += __builtin_popcountll(words[i + 1]);
+        c2 += __builtin_popcountll(words[i + 2]);
+        c3 += __builtin_popcountll(words[i + 3]);
+    }
+    for (; i < n; i++) c0 += __builtin_popcountll(words[i]);
+    if (nbits % 64) c0 += __builtin_popcountll(words[n] & ((1ULL << (nbits % 64)) - 1));
+    return c0 + c1 + c2 + c3;
+}
+
+void bitmap_diff(const uint64_t* a, const uint64_t* b, size_t nbits, uint32_t& only_a, uint32_t& only_b)
+{
+    only_a = only_b = 0;
+    size_t words = (nbits + 63) / 64;
+    for (size_t i = 0; i < words; i++) {
+        uint64_t mask = (i + 1 == words && nbits % 64) ? (1ULL << (nbits % 64)) - 1 : ~0ULL;
+        uint64_t x = (a[i] ^ b[i]) & mask;  // 绝大多数字相同，异或为0时直接跳过
+        if (x == 0) continue;
+        only_a += __builtin_popcountll(x & a[i]);
+        only_b += __builtin_popcountll(x & b[i]);
+    }
+}
+
+/**
+ * @brief 一致性检查（需已挂载）
+ * @param rep 输出检查结果
+ * @param repair true表示就地修复发现的问题
+ * @param threads 扫描线程数（0表示按CPU核数，最多8个）
+ * @return 检查完成返回true；未挂载或元数据读取失败返回false
+ */
+bool DiskFS::fsck(FsckReport& rep, bool repair, uint32_t threads)
+{
+    rep = FsckReport();
+    if (!isMounted()) {
+        std::cerr << "一致性检查失败：磁盘未挂载" << std::endl;
+        return false;
+    }
+    if (repair && reject_read_only("一致性修复")) return false;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    IoBatch batch(*this);
+    // 脏页先分配块，否则文件大小超出已分配的块；排队的写派发后才对下面的直接读可见
+    if (!delalloc_flush() || !flush_io()) return false;
+
+    const uint32_t total_inodes = super_block.total_inodes;
+    const uint32_t data_blocks = super_block.data_blocks;
+    const uint32_t data_start = super_block.data_start;
+
+    // 1. 大块顺序读入元数据区（日志布局没有固定位置，逐个经映射读取）
+    auto read_region = [this](uint32_t first, uint32_t count, std::vector<uint8_t>& out) {
+        out.assign((size_t)count * BLOCK_SIZE, 0);
+        if (log) {
+            for (uint32_t i = 0; i < count; i++) {
+                if (!read_block(first + i, (char*)out.data() + (size_t)i * BLOCK_SIZE)) return false;
+            }
+            return true;
+        }
+        for (size_t off = 0; off < out.size(); off += FSCK_READ_CHUNK) {
+            size_t len = std::min(FSCK_READ_CHUNK, out.size() - off);
+            if (!raw_read((uint64_t)first * BLOCK_SIZE + off, (char*)out.data() + off, len)) return false;
+        }
+        return true;
+    };
+
+    std::vector<char> table((size_t)total_inodes * sizeof(Inode), 0);
+    if (log) {
+        for (uint32_t n = 0; n < total_inodes; n++) {
+            Inode inode;
+            if (read_inode(n, inode)) memcpy(&table[(size_t)n * sizeof(Inode)], &inode, sizeof(Inode));
+        }
+    } else {
+        for (size_t off = 0; off < table.size(); off += FSCK_READ_CHUNK) {
+            size_t len = std::min(FSCK_READ_CHUNK, table.size() - off);
+            if (!raw_read(get_inode_pos(0) + off, &table[off], len)) return false;
+        }
+    }
+
+    uint32_t block_bitmap_blocks = ((data_blocks + 7) / 8 + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    uint32_t inode_bitmap_blocks = ((total_inodes + 7) / 8 + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<uint8_t> disk_block_bytes, disk_inode_bytes;
+    if (!read_region(super_block.block_bitmap, block_bitmap_blocks, disk_block_bytes) ||
+        !read_region(super_block.inode_bitmap, inode_bitmap_blocks, disk_inode_bytes)) {
+        return false;
+    }
+    std::vector<uint64_t> disk_blocks = to_words(disk_block_bytes, data_blocks);
+    std::vector<uint64_t> disk_inodes = to_words(disk_inode_bytes, total_inodes);
+
+    // 2. 根目录决定活inode
+    auto inode_at = [&table](uint32_t n) {
+        Inode inode;
+        memcpy(&inode, &table[(size_t)n * sizeof(Inode)], sizeof(Inode));
+        return inode;
+    };
+    Inode root = inode_at(0);
+    if (!root.used || root.type != 2 || root.blocks[0] < data_start || root.blocks[0] >= data_start + data_blocks) {
+        std::cerr << "一致性检查失败：根目录inode损坏" << std::endl;
+        return false;
+    }
+    char dir_buffer[BLOCK_SIZE];
+    if (!read_block(root.blocks[0], dir_buffer)) return false;
+    DirEntry* dir_entries = (DirEntry*)dir_buffer;
+    std::vector<uint8_t> live(total_inodes, 0);
+    std::vector<size_t> dangling;
+    live[0] = 1;
+    for (size_t i = 1; i < BLOCK_SIZE / sizeof(DirEntry); i++) {
+        if (!dir_entries[i].valid) continue;
+        uint32_t n = dir_entries[i].inode_num;
+        Inode inode;
+        if (n == 0 || n >= total_inodes || !(inode = inode_at(n)).used || inode.type != 1) {
+            dangling.push_back(i);
+            continue;
+        }
+        live[n] = 1;
+    }
+
+    // 3. 并行扫描inode区，各线程生成局部引用位图
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, FSCK_MAX_THREADS);
+    threads = std::max(1u, std::min(threads, total_inodes / FSCK_MIN_INODES_PER_THREAD));
+    std::vector<ScanResult> results(threads);
+    std::vector<std::thread> workers;
+    uint32_t per_thread = (total_inodes + threads - 1) / threads;
+    for (uint32_t t = 0; t < threads; t++) {
+        uint32_t begin = std::min(total_inodes, t * per_thread);
+        uint32_t end = std::min(total_inodes, begin + per_thread);
+        workers.push_back(std::thread(scan_inodes, table.data(), std::cref(live), begin, end, data_start,
+                                      data_blocks, dedup != nullptr, std::ref(results[t])));
+    }
+    for (auto& w : workers) w.join();
+
+    // 4. 按inode顺序合并：与已合并位图重叠的位是跨线程的重复引用，保留编号较小inode的引用
+    //    （去重模式下共享是合法的，不检查重叠）
+    std::vector<uint64_t> refs(disk_blocks.size(), 0);
+    std::set<Slot> clear_slots;
+    for (uint32_t t = 0; t < threads; t++) {
+        ScanResult& r = results[t];
+        std::vector<uint64_t> overlap(refs.size(), 0);
+        if (!dedup) {
+            for (size_t i = 0; i < refs.size(); i++) overlap[i] = refs[i] & r.refs[i];
+        }
+        uint64_t cross = bitmap_popcount(overlap.data(), data_blocks);
+        if (cross) {
+            // 少见路径：找出本线程范围内引用了重叠块的指针
+            uint32_t begin = t * per_thread;
+            uint32_t end = std::min(total_inodes, begin + per_thread);
+            for (uint32_t n = begin; n < end; n++) {
+                if (!live[n]) continue;
+                Inode inode = inode_at(n);
+                for (uint32_t s = 0; s < 16; s++) {
+                    uint32_t b = inode.blocks[s];
+                    if (b >= data_start && b < data_start + data_blocks && test_bit(overlap, b - data_start)) {
+                        clear_slots.insert(Slot(n, s));
+                    }
+                }
+            }
+        }
+        for (size_t i = 0; i < refs.size(); i++) refs[i] |= r.refs[i];
+        rep.dup_blocks += (uint32_t)(r.dup_slots.size() + cross);
+        rep.bad_pointers += (uint32_t)r.bad_slots.size();
+        clear_slots.insert(r.dup_slots.begin(), r.dup_slots.end());
+        clear_slots.insert(r.bad_slots.begin(), r.bad_slots.end());
+    }
+
+    // 快照持有的块（元数据块与快照inode表引用的块）同样是已用块
+    std::vector<uint32_t> snap_counts;
+    if (dedup) {
+        snap_counts.assign(data_blocks, 0);
+        if (!snap_refs(snap_counts)) return false;
+        for (uint32_t i = 0; i < data_blocks; i++) {
+            if (snap_counts[i]) set_bit(refs, i);
+        }
+    }
+
+    // 5. 与盘上位图逐字比较
+    std::vector<uint8_t> live_bytes((total_inodes + 7) / 8, 0);
+    for (uint32_t n = 0; n < total_inodes; n++) {
+        if (live[n]) live_bytes[n / 8] |= 1 << (n % 8);
+    }
+    std::vector<uint64_t> live_words = to_words(live_bytes, total_inodes);
+    bitmap_diff(disk_blocks.data(), refs.data(), data_blocks, rep.orphan_blocks, rep.missing_blocks);
+    bitmap_diff(disk_inodes.data(), live_words.data(), total_inodes, rep.orphan_inodes, rep.missing_inodes);
+
+    // 去重与引用计数模式：逐块统计引用数（含快照），与去重表的引用计数比较（位图已不一致的块上面已计入）
+    std::vector<uint32_t> ref_counts;
+    if (dedup) {
+        ref_counts.swap(snap_counts);
+        for (uint32_t n = 0; n < total_inodes; n++) {
+            if (!live[n]) continue;
+            Inode inode = inode_at(n);
+            for (uint32_t s = 0; s < 16; s++) {
+                uint32_t b = inode.blocks[s];
+                if (b >= data_start && b < data_start + data_blocks) ref_counts[b - data_start]++;
+            }
+        }
+        for (uint32_t i = 0; i < data_blocks; i++) {
+            if (test_bit(disk_blocks, i) == test_bit(refs, i) && dedup->entries[i].refs != ref_counts[i]) {
+                rep.refcount_errors++;
+            }
+        }
+    }
+
+    rep.threads = threads;
+    rep.inodes_scanned = total_inodes;
+    rep.live_inodes = (uint32_t)bitmap_popcount(live_words.data(), total_inodes);
+    rep.referenced_blocks = (uint32_t)bitmap_popcount(refs.data(), data_blocks);
+    rep.dangling_entries = (uint32_t)dangling.size();
+    rep.sb_free_blocks = super_block.free_blocks;
+    rep.sb_free_inodes = super_block.free_inodes;
+    rep.free_blocks = data_blocks - rep.referenced_blocks;
+    rep.free_inodes = total_inodes - rep.live_inodes;
+
+    // 6. 就地修复
+    if (repair && rep.errors() > 0) {
+        bool ok = true;
+        if (!dangling.empty()) {
+            for (size_t i : dangling) dir_entries[i].valid = 0;
+            ok = write_block(root.blocks[0], dir_buffer) && ok;
+        }
+        uint32_t current = total_inodes;
+        Inode inode;
+        for (const Slot& slot : clear_slots) {
+            if (slot.first != current) {
+                if (current != total_inodes) ok = write_inode(current, inode) && ok;
+                current = slot.first;
+                inode = inode_at(current);
+            }
+            inode.blocks[slot.second] = 0;
+        }
+        if (current != total_inodes) ok = write_inode(current, inode) && ok;
+
+        std::vector<uint8_t> block_out((size_t)block_bitmap_blocks * BLOCK_SIZE, 0);
+        memcpy(block_out.data(), refs.data(), std::min(block_out.size(), refs.size() * sizeof(uint64_t)));
+        for (uint32_t i = 0; i < block_bitmap_blocks; i++) {
+            ok = write_block(super_block.block_bitmap + i, (const char*)block_out.data() + (size_t)i * BLOCK_SIZE) && ok;
+        }
+        std::vector<uint8_t> inode_out((size_t)inode_bitmap_blocks * BLOCK_SIZE, 0);
+        memcpy(inode_out.data(), live_bytes.data(), live_bytes.size());
+        for (uint32_t i = 0; i < inode_bitmap_blocks; i++) {
+            ok = write_block(super_block.inode_bitmap + i, (const char*)inode_out.data() + (size_t)i * BLOCK_SIZE) && ok;
+        }
+        for (uint32_t i = 0; i < data_blocks; i++) {
+            if (test_bit(disk_blocks, i) && !test_bit(refs, i)) discard_block(data_start + i);
+        }
+
+        if (dedup) {
+            for (uint32_t i = 0; i < data_blocks; i++) dedup->entries[i].refs = ref_counts[i];
+            dedup->rebuild_index();
+        }
+        if (meta) meta->block_hint = meta->inode_hint = 0;  // 位图被整体改写，分配提示从头开始
+        cluster_cache.clear();  // 坏指针可能已被清除，缓存的簇不再可信
+        super_block.free_blocks = rep.free_blocks;
+        super_block.free_inodes = rep.free_inodes;
+        ok = write_super_block() && ok;
+        rep.repaired = ok;
+        if (!ok) std::cerr << "一致性检查：部分修复写入失败" << std::endl;
+    }
+
+    rep.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void print_fsck_report(const FsckReport& rep)
+{
+    std::cout << "一致性检查（" << rep.threads << "线程，" << rep.inodes_scanned << "个inode，耗时 "
+              << rep.seconds * 1000 << " ms）:\n";
+    std::cout << "  有效inode: " << rep.live_inodes << "，引用数据块: " << rep.referenced_blocks << "\n";
+    std::cout << "  越界块指针: " << rep.bad_pointers << "，重复引用: " << rep.dup_blocks << "，引用计数错误: "
+              << rep.refcount_errors << "\n";
+    std::cout << "  块位图: 孤儿块 " << rep.orphan_blocks << "，缺失块 " << rep.missing_blocks << "\n";
+    std::cout << "  inode位图: 孤儿inode " << rep.orphan_inodes << "，缺失inode " << rep.missing_inodes
+              << "，无效目录项 " << rep.dangling_entries << "\n";
+    std::cout << "  空闲块: 超级块 " << rep.sb_free_blocks << " / 实际 " << rep.free_blocks << "，空闲inode: 超级块 "
+              << rep.sb_free_inodes << " / 实际 " << rep.free_inodes << "\n";
+    if (rep.errors() == 0) {
+        std::cout << "  结果: 一致\n";
+    } else {
+        std::cout << "  结果: 发现 " << rep.errors() << " 处问题" << (rep.repaired ? "，已修复" : "（使用fsck fix修复）")
+                  << "\n";
+    }
+}
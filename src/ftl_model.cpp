@@ -0,0 +1,230 @@
+#include "../include/ftl_model.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @brief 构造FTL并预处理（precondition）：逻辑空间全部顺序写满一遍
+ * 磁盘镜像覆盖全部逻辑地址，预处理后直接进入稳态，覆盖写很快就会触发GC
+ */
+FtlModel::FtlModel(uint64_t logical_bytes, uint32_t op_percent, FtlGcPolicy policy)
+    : policy(policy), op_percent(op_percent),
+      logical_pages((uint32_t)((logical_bytes + BLOCK_SIZE - 1) / BLOCK_SIZE)),
+      read_ns(50 * 1000), program_ns(200 * 1000), erase_ns(2 * 1000 * 1000),
+      active(-1), write_seq(0), busy_until(8, 0)
+{
+    uint32_t logical_blocks = (logical_pages + PAGES_PER_BLOCK - 1) / PAGES_PER_BLOCK;
+    uint32_t spare = (uint32_t)((uint64_t)logical_blocks * op_percent / 100);
+    physical_blocks = logical_blocks + std::max(spare, GC_RESERVE + 1);
+
+    l2p.assign(logical_pages, -1);
+    p2l.assign((size_t)physical_blocks * PAGES_PER_BLOCK, -1);
+    blk_valid.assign(physical_blocks, 0);
+    blk_written.assign(physical_blocks, 0);
+    blk_erase.assign(physical_blocks, 0);
+    blk_stamp.assign(physical_blocks, 0);
+    for (uint32_t b = physical_blocks; b > 0; b--) free_blocks.push_back(b - 1);
+
+    for (uint32_t lpn = 0; lpn < logical_pages; lpn++) program_page(lpn);
+    memset(&st, 0, sizeof(st));
+}
+
+std::string FtlModel::describe() const
+{
+    char buf[200];
+    snprintf(buf, sizeof(buf), "%s: %zu通道, 擦除块%uKB, 预留%u%%, GC=%s, 读%.0fus, 编程%.0fus, 擦除%.1fms",
+             name(), busy_until.size(), PAGES_PER_BLOCK * BLOCK_SIZE / 1024, op_percent,
+             policy == FTL_GC_GREEDY ? "greedy" : "cost-benefit",
+             read_ns / 1e3, program_ns / 1e3, erase_ns / 1e6);
+    return buf;
+}
+
+/**
+ * @brief FTL统计报告（写放大、GC停顿、擦除次数分布）
+ */
+std::string FtlModel::report() const
+{
+    uint32_t min_erase, max_erase;
+    double avg_erase;
+    erase_range(min_erase, max_erase, avg_erase);
+
+    char buf[400];
+    snprintf(buf, sizeof(buf),
+             "  写放大: %.3f（主机写 %llu 页，闪存编程 %llu 页，discard %llu 页）\n"
+             "  GC: %llu 次，搬移 %llu 页，停顿 %.3f ms，静态均衡 %llu 次\n"
+             "  擦除: %llu 次，单块擦除次数 最小 %u / 平均 %.2f / 最大 %u\n",
+             write_amplification(), (unsigned long long)st.host_pages, (unsigned long long)st.flash_pages,
+             (unsigned long long)st.trimmed, (unsigned long long)st.gc_runs, (unsigned long long)st.gc_moved,
+             st.gc_stall_ns / 1e6, (unsigned long long)st.wl_moves, (unsigned long long)st.erases,
+             min_erase, avg_erase, max_erase);
+    return buf;
+}
+
+double FtlModel::write_amplification() const
+{
+    return st.host_pages ? (double)st.flash_pages / st.host_pages : 0.0;
+}
+
+void FtlModel::erase_range(uint32_t& min_erase, uint32_t& max_erase, double& avg_erase) const
+{
+    min_erase = *std::min_element(blk_erase.begin(), blk_erase.end());
+    max_erase = *std::max_element(blk_erase.begin(), blk_erase.end());
+    uint64_t sum = 0;
+    for (uint32_t e : blk_erase) sum += e;
+    avg_erase = (double)sum / physical_blocks;
+}
+
+/**
+ * @brief 动态磨损均衡：从空闲块中取擦除次数最少的块
+ */
+uint32_t FtlModel::take_free_block()
+{
+    size_t best = 0;
+    for (size_t i = 1; i < free_blocks.size(); i++) {
+        if (blk_erase[free_blocks[i]] < blk_erase[free_blocks[best]]) best = i;
+    }
+    uint32_t block = free_blocks[best];
+    free_blocks[best] = free_blocks.back();
+    free_blocks.pop_back();
+    return block;
+}
+
+/**
+ * @brief 把逻辑页追加写入当前开放块，旧物理页失效
+ */
+void FtlModel::program_page(uint32_t lpn)
+{
+    int32_t old = l2p[lpn];
+    if (old >= 0) {
+        p2l[old] = -1;
+        blk_valid[old / PAGES_PER_BLOCK]--;
+    }
+    if (active < 0 || blk_written[active] == PAGES_PER_BLOCK) {
+        active = (int32_t)take_free_block();
+    }
+    int32_t ppn = active * PAGES_PER_BLOCK + blk_written[active]++;
+    l2p[lpn] = ppn;
+    p2l[ppn] = (int32_t)lpn;
+    blk_valid[active]++;
+    blk_stamp[active] = ++write_seq;
+    st.flash_pages++;
+}
+
+/**
+ * @brief 选择GC受害块（只考虑已写满的非开放块）
+ * 擦除次数差超过阈值时优先回收擦除次数最少的块，把其中的冷数据搬走（静态磨损均衡）
+ * @return 受害块编号；没有可回收的块返回-1
+ */
+int FtlModel::pick_victim()
+{
+    uint32_t min_erase, max_erase;
+    double avg_erase;
+    erase_range(min_erase, max_erase, avg_erase);
+    bool level = max_erase - min_erase > WL_THRESHOLD;
+
+    int victim = -1;
+    double best = -1;
+    for (uint32_t b = 0; b < physical_blocks; b++) {
+        if ((int32_t)b == active || blk_written[b] != PAGES_PER_BLOCK) continue;
+        double score;
+        if (level) {
+            score = (double)(max_erase - blk_erase[b]);
+        } else if (policy == FTL_GC_GREEDY) {
+            score = (double)(PAGES_PER_BLOCK - blk_valid[b]);
+        } else {
+            double u = (double)blk_valid[b] / PAGES_PER_BLOCK;
+            double age = (double)(write_seq - blk_stamp[b]);
+            score = u == 0 ? 1e300 : (1 - u) / (2 * u) * age;
+        }
+        if (score > best) {
+            best = score;
+            victim = (int)b;
+        }
+    }
+    if (level && victim >= 0) st.wl_moves++;
+    return victim;
+}
+
+/**
+ * @brief 回收一个块：搬移有效页后擦除，放回空闲列表
+ * @return 本次回收的耗时（读+编程每个有效页，再加一次擦除）
+ */
+uint64_t FtlModel::collect()
+{
+    int victim = pick_victim();
+    if (victim < 0) return 0;
+
+    uint64_t moved = 0;
+    for (uint32_t i = 0; i < PAGES_PER_BLOCK; i++) {
+        int32_t lpn = p2l[(size_t)victim * PAGES_PER_BLOCK + i];
+        if (lpn < 0) continue;
+        program_page((uint32_t)lpn);
+        moved++;
+    }
+    blk_written[victim] = 0;
+    blk_valid[victim] = 0;
+    blk_erase[victim]++;
+    free_blocks.push_back((uint32_t)victim);
+
+    uint64_t ns = moved * (read_ns + program_ns) + erase_ns;
+    st.gc_runs++;
+    st.gc_moved += moved;
+    st.erases++;
+    st.gc_stall_ns += ns;
+    return ns;
+}
+
+/**
+ * @brief FTL服务时间：页按物理擦除块分配到通道，通道内串行、通道间并行
+ * 写入前空闲块不足时先做前台GC，GC耗时使本次写整体推迟
+ * 不足一页的写入（如单个inode）按整页编程计算
+ */
+uint64_t FtlModel::service(DeviceOp op, uint64_t offset, uint64_t length, uint64_t now_ns)
+{
+    if (length == 0) return 0;
+    uint64_t first = offset / BLOCK_SIZE;
+    uint64_t last = std::min<uint64_t>((offset + length - 1) / BLOCK_SIZE, logical_pages - 1);
+
+    uint64_t start = now_ns;
+    uint64_t done = now_ns;
+    for (uint64_t lpn = first; lpn <= last; lpn++) {
+        int32_t ppn;
+        uint64_t latency;
+        if (op == DEV_READ) {
+            ppn = l2p[lpn] >= 0 ? l2p[lpn] : (int32_t)lpn;
+            latency = read_ns;
+        } else {
+            for (uint32_t guard = 0; free_blocks.size() <= GC_RESERVE && guard < physical_blocks; guard++) {
+                uint64_t ns = collect();
+                if (ns == 0) break;
+                start += ns;
+            }
+            st.host_pages++;
+            program_page((uint32_t)lpn);
+            ppn = l2p[lpn];
+            latency = program_ns;
+        }
+        uint64_t& busy = busy_until[(ppn / PAGES_PER_BLOCK) % busy_until.size()];
+        busy = std::max(busy, start) + latency;
+        done = std::max(done, busy);
+    }
+    return done - now_ns;
+}
+
+/**
+ * @brief discard（TRIM）：取消完整覆盖的逻辑页的映射，GC不再搬移这些页
+ */
+void FtlModel::discard(uint64_t offset, uint64_t length)
+{
+    uint64_t first = (offset + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    uint64_t end = std::min<uint64_t>((offset + length) / BLOCK_SIZE, logical_pages);
+    for (uint64_t lpn = first; lpn < end; lpn++) {
+        int32_t ppn = l2p[lpn];
+        if (ppn < 0) continue;
+        p2l[ppn] = -1;
+        blk_valid[ppn / PAGES_PER_BLOCK]--;
+        l2p[lpn] = -1;
+        st.trimmed++;
+    }
+}
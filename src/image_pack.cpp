@@ -0,0 +1,255 @@
+#include "../include/image_pack.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief 在一个描述符上完整地读写一段（处理短读写与EINTR）
+ */
+static bool transfer(int fd, uint64_t offset, char* buf, size_t len, bool is_write)
+{
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = is_write ? pwrite(fd, buf + done, len - done, offset + done)
+                             : pread(fd, buf + done, len - done, offset + done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+static uint32_t pack_checksum(PackHeader header, const std::vector<PackChunk>& index)
+{
+    header.checksum = 0;
+    uint32_t crc = crc32c(0, &header, sizeof(header));
+    return index.empty() ? crc : crc32c(crc, index.data(), index.size() * sizeof(PackChunk));
+}
+
+void print_pack_stats(const char* what, const PackStats& st)
+{
+    std::cout << what << ": 镜像 " << std::fixed << std::setprecision(2) << st.image_bytes / 1048576.0 << " MB，打包 "
+              << st.blocks << " 块（" << st.runs << " 个区段，" << st.chunks << " 个索引项";
+    if (st.read_ios) std::cout << "，" << st.read_ios << " 次顺序读";
+    std::cout << "），包文件 " << st.pack_bytes / 1048576.0 << " MB（镜像的 "
+              << (st.image_bytes ? 100.0 * st.pack_bytes / st.image_bytes : 0.0) << "%），耗时 " << st.seconds * 1000
+              << " ms\n";
+}
+
+/**
+ * @brief 由包文件重建稀疏镜像
+ * @param pack_path 包文件路径
+ * @param image_path 目标镜像路径（已存在时被覆盖）
+ * @return 成功返回true；包文件无效、数据校验失败、镜像正被挂载或I/O失败返回false
+ */
+bool import_image(const std::string& pack_path, const std::string& image_path, PackStats& st)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    memset(&st, 0, sizeof(st));
+    int in = ::open(pack_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        std::cerr << "导入镜像失败：无法打开包文件 " << pack_path << std::endl;
+        return false;
+    }
+    PackHeader header;
+    std::vector<PackChunk> index;
+    struct stat sb;
+    bool ok = fstat(in, &sb) == 0 && transfer(in, 0, (char*)&header, sizeof(header), false) &&
+              memcmp(header.magic, PACK_MAGIC, sizeof(header.magic)) == 0 && header.block_size == BLOCK_SIZE;
+    // 包头未经校验，先按包文件大小检查索引项数再分配
+    ok = ok && sizeof(header) + (uint64_t)header.chunk_count * sizeof(PackChunk) <= (uint64_t)sb.st_size;
+    if (ok) {
+        index.resize(header.chunk_count);
+        ok = (index.empty() || transfer(in, sizeof(header), (char*)index.data(), index.size() * sizeof(PackChunk), false)) &&
+             pack_checksum(header, index) == header.checksum;
+    }
+    if (!ok) {
+        std::cerr << "导入镜像失败：包文件 " << pack_path << " 无效" << std::endl;
+        ::close(in);
+        return false;
+    }
+
+    // 与挂载、格式化互斥：目标镜像正被使用时拒绝覆盖（目标不存在时无需加锁）
+    int lock_fd = ::open(image_path.c_str(), O_RDWR | O_CLOEXEC);
+    if ((lock_fd < 0 && errno != ENOENT) || (lock_fd >= 0 && flock(lock_fd, LOCK_EX | LOCK_NB) != 0)) {
+        std::cerr << "导入镜像失败：" << image_path << (lock_fd < 0 ? " 无法打开" : " 正被挂载") << std::endl;
+        if (lock_fd >= 0) ::close(lock_fd);
+        ::close(in);
+        return false;
+    }
+    // 先写入临时文件，全部校验通过并落盘后再替换目标，损坏的包不会破坏原镜像
+    std::string tmp_path = image_path + ".tmp";
+    int out = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    ok = out >= 0 && ftruncate(out, (off_t)header.image_size) == 0;  // 未写入的块成为空洞
+    std::vector<char> stored, raw;
+    uint32_t prev_end = UINT32_MAX;
+    for (const PackChunk& c : index) {
+        if (!ok) break;
+        uint64_t pos = (uint64_t)c.start_block * BLOCK_SIZE;
+        if (c.raw_len == 0 || c.raw_len > PACK_CHUNK_BLOCKS * BLOCK_SIZE || c.stored_len > c.raw_len ||
+            pos + c.raw_len > header.image_size) {
+            ok = false;
+            break;
+        }
+        stored.resize(c.stored_len);
+        raw.resize(c.raw_len);
+        ok = transfer(in, c.offset, stored.data(), stored.size(), false);
+        if (ok && c.stored_len < c.raw_len) {
+            ok = lz_decompress(stored.data(), stored.size(), raw.data(), raw.size());
+        } else if (ok) {
+            raw.swap(stored);
+        }
+        ok = ok && crc32c(0, raw.data(), raw.size()) == c.crc && transfer(out, pos, raw.data(), raw.size(), true);
+        if (c.start_block != prev_end) st.runs++;
+        prev_end = c.start_block + (c.raw_len + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        st.blocks += (c.raw_len + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    }
+    ok = ok && fsync(out) == 0;
+    if (out >= 0) ::close(out);
+    ok = ok && std::rename(tmp_path.c_str(), image_path.c_str()) == 0;
+    if (!ok) std::remove(tmp_path.c_str());
+    st.pack_bytes = sb.st_size;
+    ::close(in);
+    if (lock_fd >= 0) ::close(lock_fd);  // 关闭即释放flock
+    if (!ok) {
+        std::cerr << "导入镜像失败：数据块校验或写入失败，目标镜像未改动" << std::endl;
+        return false;
+    }
+    SharedMeta::remove(image_path);  // 镜像内容已替换，旧的共享段作废
+    st.image_bytes = header.image_size;
+    st.chunks = index.size();
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+/**
+ * @brief 导出紧凑镜像：元数据区、已分配的数据块与数据区之后的预留区，按区段大块顺序读取
+ * @param pack_path 包文件路径
+ * @param compress true表示压缩数据
+ * @return 成功返回true；未挂载、布局不支持或I/O失败返回false
+ */
+bool DiskFS::export_image(const std::string& pack_path, bool compress, PackStats& st)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    memset(&st, 0, sizeof(st));
+    if (!isMounted()) {
+        std::cerr << "导出镜像失败：磁盘未挂载" << std::endl;
+        return false;
+    }
+    if (log || stripe || tier) {
+        std::cerr << "导出镜像只支持单镜像的原地布局" << std::endl;
+        return false;
+    }
+    // 脏页与排队的写先落盘，之后直接按块号读取镜像
+    if (!delalloc_flush() || !flush_io()) return false;
+    struct stat sb;
+    if (stat(disk_path.c_str(), &sb) != 0) return false;
+    st.image_bytes = sb.st_size;
+    uint32_t file_blocks = (uint32_t)std::min<uint64_t>((st.image_bytes + BLOCK_SIZE - 1) / BLOCK_SIZE,
+                                                        super_block.total_blocks);
+
+    // 1. 需要打包的区段：元数据区、位图中已分配的数据块、数据区之后的预留区（截断到镜像文件长度）
+    std::vector<uint8_t> bitmap;
+    if (!read_block_bitmap(bitmap)) return false;
+    std::vector<std::pair<uint32_t, uint32_t>> runs;
+    auto add_run = [&runs, file_blocks](uint32_t first, uint32_t count) {
+        if (first >= file_blocks || count == 0) return;
+        count = std::min(count, file_blocks - first);
+        if (!runs.empty() && runs.back().first + runs.back().second == first) {
+            runs.back().second += count;
+        } else {
+            runs.push_back(std::make_pair(first, count));
+        }
+    };
+    add_run(0, super_block.data_start);
+    for (uint32_t i = 0; i < super_block.data_blocks;) {
+        if (!(bitmap[i / 8] & (1 << (i % 8)))) {
+            i++;
+            continue;
+        }
+        uint32_t j = i;
+        while (j < super_block.data_blocks && (bitmap[j / 8] & (1 << (j % 8)))) j++;
+        add_run(super_block.data_start + i, j - i);
+        i = j;
+    }
+    uint32_t data_end = super_block.data_start + super_block.data_blocks;
+    add_run(data_end, super_block.total_blocks - data_end);
+
+    // 2. 按PACK_CHUNK_BLOCKS切分出索引项，包头与索引先占位，数据写完后回填
+    std::vector<PackChunk> index;
+    for (const auto& run : runs) {
+        for (uint32_t b = 0; b < run.second; b += PACK_CHUNK_BLOCKS) {
+            PackChunk c;
+            memset(&c, 0, sizeof(c));
+            c.start_block = run.first + b;
+            uint64_t pos = (uint64_t)c.start_block * BLOCK_SIZE;
+            c.raw_len = (uint32_t)std::min<uint64_t>((uint64_t)std::min(PACK_CHUNK_BLOCKS, run.second - b) * BLOCK_SIZE,
+                                                     st.image_bytes - pos);
+            index.push_back(c);
+        }
+    }
+    int out = ::open(pack_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        std::cerr << "导出镜像失败：无法创建 " << pack_path << std::endl;
+        return false;
+    }
+    uint64_t offset = sizeof(PackHeader) + index.size() * sizeof(PackChunk);
+
+    // 3. 每个区段按PACK_READ_BLOCKS块顺序读，切成索引项逐项压缩写出
+    bool ok = true;
+    std::vector<char> piece, packed(PACK_CHUNK_BLOCKS * BLOCK_SIZE);
+    size_t next = 0;
+    for (const auto& run : runs) {
+        for (uint32_t b = 0; ok && b < run.second; b += PACK_READ_BLOCKS) {
+            uint64_t pos = (uint64_t)(run.first + b) * BLOCK_SIZE;
+            size_t len = (size_t)std::min<uint64_t>((uint64_t)std::min(PACK_READ_BLOCKS, run.second - b) * BLOCK_SIZE,
+                                                    st.image_bytes - pos);
+            piece.resize(len);
+            ok = raw_read(pos, piece.data(), len);
+            st.read_ios++;
+            for (size_t done = 0; ok && done < len; next++) {
+                PackChunk& c = index[next];
+                const char* raw = piece.data() + done;
+                c.crc = crc32c(0, raw, c.raw_len);
+                size_t n = compress ? lz_compress(raw, c.raw_len, packed.data(), c.raw_len - 1) : 0;
+                c.offset = offset;
+                c.stored_len = n > 0 ? (uint32_t)n : c.raw_len;
+                ok = transfer(out, offset, n > 0 ? packed.data() : const_cast<char*>(raw), c.stored_len, true);
+                offset += c.stored_len;
+                done += c.raw_len;
+            }
+        }
+        st.blocks += run.second;
+    }
+
+    PackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+    header.flags = compress ? PACK_COMPRESSED : 0;
+    header.block_size = BLOCK_SIZE;
+    header.image_size = st.image_bytes;
+    header.chunk_count = index.size();
+    header.checksum = pack_checksum(header, index);
+    ok = ok && transfer(out, 0, (char*)&header, sizeof(header), true) &&
+         (index.empty() || transfer(out, sizeof(header), (char*)index.data(), index.size() * sizeof(PackChunk), true));
+    ::close(out);
+    if (!ok) {
+        std::cerr << "导出镜像失败：读取镜像或写入包文件失败" << std::endl;
+        std::remove(pack_path.c_str());
+        return false;
+    }
+    st.pack_bytes = offset;
+    st.runs = runs.size();
+    st.chunks = index.size();
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
@@ -0,0 +1,265 @@
+#include "../include/io_scheduler.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+
+uint64_t steady_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+IoScheduler::IoScheduler()
+    : pol(IOSCHED_NONE), max_depth(128), max_merge(64), write_expire_ns(500ULL * 1000 * 1000),
+      next_seq(0), oldest_deadline(UINT64_MAX), head(0)
+{
+    reset_stats();
+}
+
+const char* IoScheduler::policy_name(SchedPolicy policy)
+{
+    switch (policy) {
+    case IOSCHED_NOOP: return "noop";
+    case IOSCHED_CLOOK: return "clook";
+    case IOSCHED_DEADLINE: return "deadline";
+    default: return "none";
+    }
+}
+
+/**
+ * @brief 设置调度策略（调用前队列必须已派发清空）
+ * @param max_depth 队列深度上限（0表示保持当前值）
+ */
+void IoScheduler::set_policy(SchedPolicy policy, uint32_t depth)
+{
+    pol = policy;
+    if (depth > 0) max_depth = depth;
+}
+
+void IoScheduler::reset_stats()
+{
+    memset(&st, 0, sizeof(st));
+}
+
+/**
+ * @brief 写请求入队；同一块已有未派发的写时直接覆盖（写吸收）
+ */
+void IoScheduler::queue_write(uint32_t block, const char* data)
+{
+    auto it = pending.find(block);
+    if (it != pending.end()) {
+        memcpy(it->second.data.data(), data, BLOCK_SIZE);
+        st.absorbed++;
+        return;
+    }
+
+    Pending& req = pending[block];
+    req.seq = next_seq++;
+    req.deadline_ns = steady_ns() + write_expire_ns;
+    req.data.assign(data, data + BLOCK_SIZE);
+    oldest_deadline = std::min(oldest_deadline, req.deadline_ns);
+    st.queued++;
+    st.max_depth = std::max<uint64_t>(st.max_depth, pending.size());
+}
+
+bool IoScheduler::lookup(uint32_t block, char* out)
+{
+    auto it = pending.find(block);
+    if (it == pending.end()) return false;
+    memcpy(out, it->second.data.data(), BLOCK_SIZE);
+    st.read_hits++;
+    return true;
+}
+
+void IoScheduler::cancel(uint32_t block)
+{
+    pending.erase(block);
+}
+
+bool IoScheduler::should_dispatch() const
+{
+    if (pending.size() >= max_depth) return true;
+    return pol == IOSCHED_DEADLINE && !pending.empty() && steady_ns() >= oldest_deadline;
+}
+
+/**
+ * @brief 把一个请求追加到派发序列：与上一段首尾相接且未超过合并上限时合并，否则新开一段
+ */
+void IoScheduler::append_run(std::vector<IoRun>& runs, uint32_t block, const Pending& req)
+{
+    if (!runs.empty()) {
+        IoRun& last = runs.back();
+        if (last.start + last.count == block && last.count < max_merge) {
+            last.data.insert(last.data.end(), req.data.begin(), req.data.end());
+            last.count++;
+            st.merged++;
+            return;
+        }
+    }
+    IoRun run;
+    run.start = block;
+    run.count = 1;
+    run.data = req.data;
+    runs.push_back(run);
+}
+
+/**
+ * @brief 按策略确定派发顺序，合并相邻块，清空队列
+ * - noop：按到达顺序
+ * - clook：从head起按块号递增，到最大块号后回绕到最小块号
+ * - deadline：已超时的请求按到达顺序优先，其余按clook
+ */
+void IoScheduler::drain(std::vector<IoRun>& runs)
+{
+    runs.clear();
+    if (pending.empty()) return;
+
+    st.drains++;
+    st.depth_sum += pending.size();
+
+    typedef std::map<uint32_t, Pending>::iterator Iter;
+    std::vector<Iter> order;
+    order.reserve(pending.size());
+
+    if (pol == IOSCHED_NOOP) {
+        for (Iter it = pending.begin(); it != pending.end(); ++it) order.push_back(it);
+        std::sort(order.begin(), order.end(), [](Iter a, Iter b) { return a->second.seq < b->second.seq; });
+    } else {
+        std::vector<Iter> expired;
+        uint64_t now = steady_ns();
+        Iter split = pending.lower_bound(head);
+        for (Iter it = split; it != pending.end(); ++it) order.push_back(it);
+        for (Iter it = pending.begin(); it != split; ++it) order.push_back(it);
+
+        if (pol == IOSCHED_DEADLINE) {
+            std::vector<Iter> rest;
+            for (Iter it : order) {
+                (it->second.deadline_ns <= now ? expired : rest).push_back(it);
+            }
+            std::sort(expired.begin(), expired.end(), [](Iter a, Iter b) { return a->second.seq < b->second.seq; });
+            st.expired += expired.size();
+            order.swap(expired);
+            order.insert(order.end(), rest.begin(), rest.end());
+        }
+    }
+
+    for (Iter it : order) {
+        append_run(runs, it->first, it->second);
+    }
+    st.dispatched += runs.size();
+    head = runs.back().start + runs.back().count;
+
+    pending.clear();
+    oldest_deadline = UINT64_MAX;
+}
+
+/**
+ * @brief 派发队列中的全部写请求（每个合并段一次连续写）
+ * @return 全部写入成功返回true
+ */
+bool DiskFS::flush_io()
+{
+    if (scheduler.empty()) return true;
+    if (!csum_write_intents()) return false;  // 校验表先于所改写的块落盘
+
+    std::vector<IoRun> runs;
+    scheduler.drain(runs);
+    bool ok = true;
+    if (mq) {
+        // 多队列块层：全部合并段一次入环，只唤醒一次硬件队列
+        std::vector<MqRequest> reqs;
+        for (IoRun& run : runs) {
+            reqs.push_back({(uint64_t)run.start * BLOCK_SIZE, run.data.data(), run.data.size(), true});
+            account_device(DEV_WRITE, reqs.back().offset, reqs.back().len);
+        }
+        ok = mq->submit(reqs.data(), reqs.size());
+    } else {
+        for (const IoRun& run : runs) {
+            if (!raw_write((uint64_t)run.start * BLOCK_SIZE, run.data.data(), run.data.size())) {
+                ok = false;
+            }
+        }
+    }
+    if (!ok) {
+        std::cerr << "I/O调度：派发写请求失败" << std::endl;
+    }
+    return ok;
+}
+
+/**
+ * @brief 开始一个批次：批次内的块写先排队，批次结束时统一派发（可嵌套）
+ */
+void DiskFS::begin_batch()
+{
+    batch_depth++;
+}
+
+/**
+ * @brief 结束批次：最外层批次结束时派发队列（日志布局下追加写缓冲）
+ * @return 派发成功（或仍在外层批次内）返回true
+ */
+bool DiskFS::end_batch()
+{
+    if (batch_depth > 0) batch_depth--;
+    if (batch_depth > 0) return true;
+    if (log) {
+        bool ok = log_flush();
+        // 空闲清理：干净段偏少时每个批次顺带清理一段，避免在空间耗尽时集中清理
+        if (ok && log->clean_segments() < LOG_IDLE_WATER) log_clean(1);
+        return ok && csum_sync();
+    }
+    return flush_io() && csum_sync();
+}
+
+/**
+ * @brief 设置I/O调度策略，切换前先派发已排队的请求
+ * @param name "noop"、"clook"、"deadline"或"none"
+ * @param max_depth 队列深度上限（0表示保持当前值）
+ * @return 策略名称有效返回true
+ */
+bool DiskFS::set_scheduler(const std::string& name, uint32_t max_depth)
+{
+    SchedPolicy policy;
+    if (name == "none") {
+        policy = IOSCHED_NONE;
+    } else if (name == "noop") {
+        policy = IOSCHED_NOOP;
+    } else if (name == "clook") {
+        policy = IOSCHED_CLOOK;
+    } else if (name == "deadline") {
+        policy = IOSCHED_DEADLINE;
+    } else {
+        return false;
+    }
+    if (!flush_io()) return false;
+    scheduler.set_policy(policy, max_depth);
+    scheduler.reset_stats();
+    return true;
+}
+
+/**
+ * @brief 打印调度器的合并与队列深度统计
+ */
+void DiskFS::print_scheduler_stats() const
+{
+    const SchedStats& st = scheduler.stats();
+    char line[160];
+    std::cout << "I/O调度器: " << IoScheduler::policy_name(scheduler.policy()) << "\n";
+    snprintf(line, sizeof(line), "  入队写请求: %llu（被覆盖 %llu，合并 %llu）\n",
+             (unsigned long long)st.queued, (unsigned long long)st.absorbed, (unsigned long long)st.merged);
+    std::cout << line;
+    snprintf(line, sizeof(line), "  派发I/O: %llu（%llu批，超时派发 %llu）\n",
+             (unsigned long long)st.dispatched, (unsigned long long)st.drains, (unsigned long long)st.expired);
+    std::cout << line;
+    snprintf(line, sizeof(line), "  队列深度: 平均 %.1f，最大 %llu；读命中队列 %llu\n",
+             st.drains ? (double)st.depth_sum / st.drains : 0.0,
+             (unsigned long long)st.max_depth, (unsigned long long)st.read_hits);
+    std::cout << line;
+}
@@ -0,0 +1,351 @@
+#include "../include/io_stats.h"
+#include "../include/disk_fs.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+
+static const char* const OP_NAMES[STAT_OP_COUNT] = {
+    "format", "mount", "unmount", "create_file", "open_file",
+    "read_file", "write_file", "delete_file", "list_files", "get_file_size",
+    "truncate_file", "fallocate_file",
+};
+
+static const char* const COUNTER_NAMES[STAT_COUNTER_COUNT] = {
+    "block_reads", "block_writes", "bytes_read", "bytes_written",
+    "bitmap_scans", "cache_hits", "cache_misses", "device_ns",
+    "csum_verified", "csum_errors",
+};
+
+const char* stat_op_name(int op)
+{
+    return (op >= 0 && op < STAT_OP_COUNT) ? OP_NAMES[op] : "unknown";
+}
+
+const char* stat_counter_name(int counter)
+{
+    return (counter >= 0 && counter < STAT_COUNTER_COUNT) ? COUNTER_NAMES[counter] : "unknown";
+}
+
+/**
+ * @brief 计算样本所在的桶：小于2^HIST_SUB_BITS的值各占一个桶，
+ *        更大的值按最高位所在的2的幂区间分组，区间内再按次高的HIST_SUB_BITS位细分
+ */
+int LatencyHistogram::bucket_index(uint64_t ns)
+{
+    if (ns < (uint64_t)HIST_SUB_BUCKETS) return (int)ns;
+    int msb = 63 - __builtin_clzll(ns);
+    int sub = (int)((ns >> (msb - HIST_SUB_BITS)) & (HIST_SUB_BUCKETS - 1));
+    return (msb - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS + sub;
+}
+
+/**
+ * @brief 桶的上界（桶内最大可能值）
+ */
+uint64_t LatencyHistogram::bucket_upper(int idx)
+{
+    if (idx < HIST_SUB_BUCKETS) return (uint64_t)idx;
+    int msb = idx / HIST_SUB_BUCKETS + HIST_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(idx % HIST_SUB_BUCKETS);
+    uint64_t low = (1ULL << msb) | (sub << (msb - HIST_SUB_BITS));
+    return low + (1ULL << (msb - HIST_SUB_BITS)) - 1;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)(p * count);
+    if (rank >= count) rank = count - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen > rank) return bucket_upper(i);
+    }
+    return max();
+}
+
+uint64_t LatencyHistogram::max() const
+{
+    for (int i = HIST_BUCKETS - 1; i >= 0; i--) {
+        if (buckets[i]) return bucket_upper(i);
+    }
+    return 0;
+}
+
+#ifndef DISKFS_NO_STATS
+
+namespace {
+
+/**
+ * @brief 线程私有的计数槽：仅所属线程写入，汇总线程只读
+ * 使用relaxed的load+store代替fetch_add，避免带锁前缀的原子指令
+ */
+struct HistSlot
+{
+    std::atomic<uint64_t> buckets[HIST_BUCKETS];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum_ns;
+};
+
+struct ThreadSlot
+{
+    std::atomic<uint64_t> counters[STAT_COUNTER_COUNT];
+    HistSlot latency[STAT_OP_COUNT];
+    HistSlot device[STAT_OP_COUNT];
+};
+
+/**
+ * @brief 全局登记表：存活线程的计数槽、已退出线程的累计值、重置基线
+ * 刻意不析构，避免进程退出时与线程局部对象的析构顺序问题
+ */
+struct Registry
+{
+    std::mutex lock;
+    std::vector<ThreadSlot*> slots;
+    StatsSnapshot retired;
+    StatsSnapshot baseline;
+};
+
+Registry& registry()
+{
+    static Registry* reg = new Registry();
+    return *reg;
+}
+
+inline void bump(std::atomic<uint64_t>& a, uint64_t n)
+{
+    a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void accumulate_hist(LatencyHistogram& h, const HistSlot& slot)
+{
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        h.buckets[b] += slot.buckets[b].load(std::memory_order_relaxed);
+    }
+    h.count += slot.count.load(std::memory_order_relaxed);
+    h.sum_ns += slot.sum_ns.load(std::memory_order_relaxed);
+}
+
+void accumulate(StatsSnapshot& out, const ThreadSlot& slot)
+{
+    for (int c = 0; c < STAT_COUNTER_COUNT; c++) {
+        out.counters[c] += slot.counters[c].load(std::memory_order_relaxed);
+    }
+    for (int op = 0; op < STAT_OP_COUNT; op++) {
+        accumulate_hist(out.latency[op], slot.latency[op]);
+        accumulate_hist(out.device_latency[op], slot.device[op]);
+    }
+}
+
+void add_hist(LatencyHistogram& h, const LatencyHistogram& s, bool subtract)
+{
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        h.buckets[b] = subtract ? h.buckets[b] - s.buckets[b] : h.buckets[b] + s.buckets[b];
+    }
+    h.count = subtract ? h.count - s.count : h.count + s.count;
+    h.sum_ns = subtract ? h.sum_ns - s.sum_ns : h.sum_ns + s.sum_ns;
+}
+
+void add_snapshot(StatsSnapshot& out, const StatsSnapshot& in, bool subtract)
+{
+    for (int c = 0; c < STAT_COUNTER_COUNT; c++) {
+        out.counters[c] = subtract ? out.counters[c] - in.counters[c] : out.counters[c] + in.counters[c];
+    }
+    for (int op = 0; op < STAT_OP_COUNT; op++) {
+        add_hist(out.latency[op], in.latency[op], subtract);
+        add_hist(out.device_latency[op], in.device_latency[op], subtract);
+    }
+}
+
+void record_hist(HistSlot& slot, uint64_t ns)
+{
+    bump(slot.buckets[LatencyHistogram::bucket_index(ns)], 1);
+    bump(slot.count, 1);
+    bump(slot.sum_ns, ns);
+}
+
+/**
+ * @brief 线程局部持有者：首次使用时登记计数槽，线程退出时并入retired
+ */
+struct SlotHolder
+{
+    ThreadSlot* slot;
+
+    SlotHolder() : slot(new ThreadSlot())
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> guard(reg.lock);
+        reg.slots.push_back(slot);
+    }
+
+    ~SlotHolder()
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> guard(reg.lock);
+        accumulate(reg.retired, *slot);
+        reg.slots.erase(std::remove(reg.slots.begin(), reg.slots.end(), slot), reg.slots.end());
+        delete slot;
+    }
+};
+
+inline ThreadSlot& local_slot()
+{
+    thread_local SlotHolder holder;
+    return *holder.slot;
+}
+
+thread_local int op_depth = 0;         // 当前线程嵌套的公共操作层数
+thread_local uint64_t device_acc = 0;  // 当前线程累计的模拟服务时间
+std::atomic<bool> device_enabled(false);
+
+} // namespace
+
+void IoStats::add(StatCounter counter, uint64_t n)
+{
+    bump(local_slot().counters[counter], n);
+}
+
+void IoStats::record(StatOp op, uint64_t ns)
+{
+    record_hist(local_slot().latency[op], ns);
+}
+
+void IoStats::add_device_time(uint64_t ns)
+{
+    device_acc += ns;
+    bump(local_slot().counters[STAT_DEVICE_NS], ns);
+}
+
+void IoStats::set_device_enabled(bool enabled)
+{
+    device_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void IoStats::snapshot(StatsSnapshot& out)
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    out = reg.retired;
+    for (ThreadSlot* slot : reg.slots) {
+        accumulate(out, *slot);
+    }
+    add_snapshot(out, reg.baseline, true);
+}
+
+void IoStats::reset()
+{
+    StatsSnapshot current;
+    snapshot(current);
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    add_snapshot(reg.baseline, current, false);
+}
+
+OpTimer::OpTimer(StatOp op) : op(op), outermost(op_depth++ == 0), device_start(device_acc)
+{
+    if (outermost) start = std::chrono::steady_clock::now();
+}
+
+OpTimer::~OpTimer()
+{
+    op_depth--;
+    if (outermost) {
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        IoStats::record(op, ns);
+        if (device_enabled.load(std::memory_order_relaxed)) {
+            record_hist(local_slot().device[op], device_acc - device_start);
+        }
+    }
+}
+
+#else
+
+void IoStats::add(StatCounter, uint64_t) {}
+void IoStats::record(StatOp, uint64_t) {}
+void IoStats::add_device_time(uint64_t) {}
+void IoStats::set_device_enabled(bool) {}
+void IoStats::snapshot(StatsSnapshot& out) { memset(&out, 0, sizeof(out)); }
+void IoStats::reset() {}
+
+#endif // DISKFS_NO_STATS
+
+/**
+ * @brief 获取统计快照（进程内所有DiskFS实例共享同一份统计）
+ */
+StatsSnapshot DiskFS::get_stats() const
+{
+    csum_report();
+    StatsSnapshot snap;
+    IoStats::snapshot(snap);
+    return snap;
+}
+
+/**
+ * @brief 清零统计（以当前值为基线）
+ */
+void DiskFS::reset_stats()
+{
+    csum_report();  // 攒下的次数属于清零之前
+    IoStats::reset();
+    scheduler.reset_stats();
+}
+
+/**
+ * @brief 打印I/O计数与各操作的延迟分布
+ */
+void DiskFS::print_stats() const
+{
+#ifdef DISKFS_NO_STATS
+    std::cout << "统计功能未编译（DISKFS_NO_STATS）\n";
+#else
+    StatsSnapshot snap = get_stats();
+
+    std::cout << "I/O计数:\n";
+    for (int c = 0; c < STAT_COUNTER_COUNT; c++) {
+        std::cout << "  " << stat_counter_name(c) << ": " << snap.counters[c] << "\n";
+    }
+
+    std::cout << "操作延迟(纳秒):\n";
+    char line[160];
+    snprintf(line, sizeof(line), "  %-14s %10s %10s %10s %10s %10s %10s\n",
+             "op", "count", "avg", "p50", "p99", "p999", "max");
+    std::cout << line;
+    for (int op = 0; op < STAT_OP_COUNT; op++) {
+        const LatencyHistogram& h = snap.latency[op];
+        if (h.count == 0) continue;
+        snprintf(line, sizeof(line), "  %-14s %10llu %10llu %10llu %10llu %10llu %10llu\n",
+                 stat_op_name(op), (unsigned long long)h.count,
+                 (unsigned long long)(h.sum_ns / h.count),
+                 (unsigned long long)h.percentile(0.50), (unsigned long long)h.percentile(0.99),
+                 (unsigned long long)h.percentile(0.999), (unsigned long long)h.max());
+        std::cout << line;
+    }
+
+    if (device) {
+        std::cout << "设备模型: " << device->describe() << (device_realtime ? "（实时等待）" : "（虚拟时间）") << "\n";
+        snprintf(line, sizeof(line), "  虚拟时钟: %.3f ms\n", virtual_ns / 1e6);
+        std::cout << line << device->report();
+        std::cout << "模拟服务时间(纳秒):\n";
+        snprintf(line, sizeof(line), "  %-14s %10s %10s %10s %10s %10s %10s\n",
+                 "op", "count", "avg", "p50", "p99", "p999", "max");
+        std::cout << line;
+        for (int op = 0; op < STAT_OP_COUNT; op++) {
+            const LatencyHistogram& h = snap.device_latency[op];
+            if (h.count == 0) continue;
+            snprintf(line, sizeof(line), "  %-14s %10llu %10llu %10llu %10llu %10llu %10llu\n",
+                     stat_op_name(op), (unsigned long long)h.count,
+                     (unsigned long long)(h.sum_ns / h.count),
+                     (unsigned long long)h.percentile(0.50), (unsigned long long)h.percentile(0.99),
+                     (unsigned long long)h.percentile(0.999), (unsigned long long)h.max());
+            std::cout << line;
+        }
+    }
+#endif
+    if (scheduler.enabled()) {
+        print_scheduler_stats();
+    }
+}
@@ -0,0 +1,251 @@
+#include "../include/io_trace.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const size_t TRACE_BATCH = 1024;  // 线程缓冲区积累多少条记录后交给后台线程
+
+static_assert(sizeof(TraceRecord) == 24, "追踪记录保持24字节定长");
+
+std::atomic<uint64_t> next_generation(1);
+
+/**
+ * @brief 线程局部缓存：记住本线程在哪个追踪器（及哪一代）登记过的缓冲区
+ */
+struct LocalBufferCache
+{
+    const void* owner;
+    uint64_t generation;
+    void* buffer;
+};
+
+thread_local LocalBufferCache local_cache = {nullptr, 0, nullptr};
+thread_local uint32_t local_inode = TRACE_NO_INODE;
+thread_local int scope_depth = 0;  // 嵌套的追踪范围层数（仅最外层写记录）
+
+uint64_t steady_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+IoTracer::IoTracer() : active(false), written(0), generation(0), epoch_ns(0), out(nullptr), stopping(false) {}
+
+IoTracer::~IoTracer()
+{
+    stop();
+}
+
+/**
+ * @brief 开始追踪：创建追踪文件并写入文件头，启动后台落盘线程
+ * @param path 追踪文件路径（已存在则覆盖）
+ * @return 成功返回true；已在追踪或文件创建失败返回false
+ */
+bool IoTracer::start(const std::string& path)
+{
+    if (enabled()) return false;
+
+    out = fopen(path.c_str(), "wb");
+    if (!out) return false;
+
+    TraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    if (fwrite(&header, sizeof(header), 1, out) != 1) {
+        fclose(out);
+        out = nullptr;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(buffers_lock);
+        buffers.clear();
+    }
+    generation = next_generation.fetch_add(1);
+    epoch_ns = steady_ns();
+    written.store(0, std::memory_order_relaxed);
+    stopping = false;
+    flusher = std::thread(&IoTracer::flush_loop, this);
+    active.store(true, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief 停止追踪：先关闭开关，再在各缓冲区的锁内取走剩余记录，
+ *        等待后台线程写完后关闭文件
+ */
+void IoTracer::stop()
+{
+    if (!enabled()) return;
+    active.store(false, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> guard(buffers_lock);
+        for (auto& buf : buffers) {
+            std::lock_guard<std::mutex> buf_guard(buf->lock);
+            if (!buf->records.empty()) enqueue(buf->records);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(queue_lock);
+        stopping = true;
+    }
+    queue_cv.notify_one();
+    flusher.join();
+
+    fclose(out);
+    out = nullptr;
+}
+
+uint64_t IoTracer::now_ns() const
+{
+    return steady_ns() - epoch_ns;
+}
+
+uint32_t IoTracer::current_inode()
+{
+    return local_inode;
+}
+
+/**
+ * @brief 获取本线程的缓冲区，首次使用时向追踪器登记
+ */
+IoTracer::ThreadBuffer& IoTracer::local_buffer()
+{
+    if (local_cache.owner != this || local_cache.generation != generation) {
+        std::shared_ptr<ThreadBuffer> buf = std::make_shared<ThreadBuffer>();
+        buf->records.reserve(TRACE_BATCH);
+        std::lock_guard<std::mutex> guard(buffers_lock);
+        if (buffers.size() == TRACE_THREAD_OVERFLOW) {
+            std::cerr << "I/O追踪：登记的线程超过" << TRACE_THREAD_OVERFLOW << "个，其余线程的记录使用编号"
+                      << TRACE_THREAD_OVERFLOW << std::endl;
+        }
+        buf->thread_id = (uint16_t)std::min<size_t>(buffers.size(), TRACE_THREAD_OVERFLOW);
+        buffers.push_back(buf);
+        local_cache.owner = this;
+        local_cache.generation = generation;
+        local_cache.buffer = buf.get();
+    }
+    return *static_cast<ThreadBuffer*>(local_cache.buffer);
+}
+
+void IoTracer::record(uint8_t op, uint32_t block, uint32_t length, uint32_t inode)
+{
+    if (!enabled()) return;
+    record_at(op, block, length, inode, now_ns());
+}
+
+void IoTracer::record_at(uint8_t op, uint32_t block, uint32_t length, uint32_t inode, uint64_t timestamp_ns)
+{
+    if (!enabled()) return;
+    ThreadBuffer& buf = local_buffer();
+
+    std::lock_guard<std::mutex> guard(buf.lock);
+    // 在缓冲区锁内再次检查，保证stop()取走缓冲区后不会再有记录写入
+    if (!enabled()) return;
+
+    TraceRecord rec;
+    rec.timestamp_ns = timestamp_ns;
+    rec.block = block;
+    rec.length = length;
+    rec.inode = inode;
+    rec.op = op;
+    rec.thread = buf.thread_id;
+    rec.reserved = 0;
+    buf.records.push_back(rec);
+
+    if (buf.records.size() >= TRACE_BATCH) {
+        enqueue(buf.records);
+    }
+}
+
+/**
+ * @brief 将一批记录移交给后台线程（batch被清空并重新预留空间）
+ */
+void IoTracer::enqueue(std::vector<TraceRecord>& batch)
+{
+    {
+        std::lock_guard<std::mutex> guard(queue_lock);
+        queue.push_back(std::vector<TraceRecord>());
+        queue.back().swap(batch);
+    }
+    batch.reserve(TRACE_BATCH);
+    queue_cv.notify_one();
+}
+
+/**
+ * @brief 后台落盘线程：取出队列中的批次写入追踪文件，直到停止且队列为空
+ */
+void IoTracer::flush_loop()
+{
+    std::unique_lock<std::mutex> guard(queue_lock);
+    while (true) {
+        queue_cv.wait(guard, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty() && stopping) break;
+
+        std::vector<TraceRecord> batch;
+        batch.swap(queue.front());
+        queue.pop_front();
+
+        guard.unlock();
+        size_t n = fwrite(batch.data(), sizeof(TraceRecord), batch.size(), out);
+        written.fetch_add(n, std::memory_order_relaxed);
+        guard.lock();
+    }
+    fflush(out);
+}
+
+TraceScope::TraceScope(IoTracer& tracer, uint8_t op, int inode, uint32_t offset, uint32_t length)
+    : tracer(tracer), active(scope_depth++ == 0 && tracer.enabled()), op(op),
+      inode(inode < 0 ? TRACE_NO_INODE : (uint32_t)inode), offset(offset), length(length),
+      saved_inode(local_inode), start_ns(0)
+{
+    if (active) {
+        start_ns = tracer.now_ns();
+        local_inode = this->inode;
+    }
+}
+
+TraceScope::~TraceScope()
+{
+    scope_depth--;
+    if (active) {
+        local_inode = saved_inode;
+        tracer.record_at(op, offset, length, inode, start_ns);  // active表示构造时已记下开始时间
+    }
+}
+
+void TraceScope::set_inode(int inode)
+{
+    this->inode = inode < 0 ? TRACE_NO_INODE : (uint32_t)inode;
+    if (active) local_inode = this->inode;
+}
+
+/**
+ * @brief 开始记录I/O追踪（块读写与公共文件操作）
+ * @param path 追踪文件路径
+ * @return 成功返回true；已在追踪或文件无法创建返回false
+ */
+bool DiskFS::start_trace(const std::string& path)
+{
+    return tracer.start(path);
+}
+
+/**
+ * @brief 停止追踪并刷出所有缓冲记录
+ * @return 本次追踪写入的记录数
+ */
+uint64_t DiskFS::stop_trace()
+{
+    tracer.stop();
+    return tracer.records_written();
+}
@@ -1,31 +1,155 @@
 #include "../include/disk_fs.h"
 #include "../include/command_parser.h"
+#include "../include/disk_server.h"
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <cstdlib>
+#include <cstring>
 #include <cassert>
+#include <csignal>
 
-int main(int argc, char* argv[]) 
+static void print_usage(const char* prog)
 {
-    if (argc != 2) {
-        std::cerr << "用法: " << argv[0] << " <磁盘文件>\n";
-        std::cerr << "测试模式: " << argv[0] << " <磁盘文件> --test\n";
+    std::cerr << "用法: " << prog << " <磁盘文件>\n";
+    std::cerr << "测试模式: " << prog << " <磁盘文件> --test\n";
+    std::cerr << "脚本模式: " << prog << " <磁盘文件> --script <脚本文件|-> [--timing] [--keep-going] [--echo]\n";
+    std::cerr << "  -：从标准输入读取命令；--timing：每条命令后输出耗时列；\n";
+    std::cerr << "  --keep-going：命令失败后继续执行（默认在第一条失败命令处停止）；--echo：执行前回显命令\n";
+    std::cerr << "守护进程: " << prog << " <磁盘文件> --serve <套接字路径> [--workers N] [--preload] [--qos 类别配置]\n";
+    std::cerr << "  类别配置：名称:权重[:IOPS上限[:MB/s上限]]，逗号分隔，如 interactive:8,bulk:1:0:20\n";
+}
+
+static DiskServer* g_server = nullptr;
+
+static void on_stop_signal(int)
+{
+    if (g_server) g_server->stop();
+}
+
+/**
+ * @brief 守护进程模式：挂载一次镜像，为本机客户端服务，收到SIGINT/SIGTERM后卸载退出
+ */
+static int run_serve_mode(DiskFS& disk, const char* socket_path, uint32_t workers, bool preload, const char* qos_spec)
+{
+    std::vector<QosClassConfig> classes;
+    if (qos_spec && !parse_qos_spec(qos_spec, classes)) {
+        std::cerr << "QoS类别配置格式错误: " << qos_spec << "\n";
+        return 1;
+    }
+    if (!disk.mount(preload)) {
+        std::cerr << "挂载失败，无法启动守护进程\n";
+        return 1;
+    }
+    int rc = 1;
+    {
+        DiskServer server(disk, socket_path, workers);
+        if (server.set_qos(classes) && server.start()) {
+            g_server = &server;
+            signal(SIGINT, on_stop_signal);
+            signal(SIGTERM, on_stop_signal);
+            std::cerr << "守护进程已启动: " << socket_path << "\n";
+            server.run();
+            g_server = nullptr;
+            server.print_stats();
+            rc = 0;
+        }
+    }
+    disk.unmount();
+    return rc;
+}
+
+/**
+ * @brief 脚本模式：不输出提示符与帮助，失败时返回非0退出码
+ */
+static int run_script_mode(DiskFS& disk, const char* script, const ScriptOptions& opt)
+{
+    std::ifstream file;
+    if (strcmp(script, "-") != 0) {
+        file.open(script);
+        if (!file) {
+            std::cerr << "无法打开脚本文件: " << script << "\n";
+            return 1;
+        }
+    }
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+
+    CommandParser parser(disk);
+    ScriptStats st;
+    bool ok = parser.run_script(file.is_open() ? static_cast<std::istream&>(file) : std::cin, opt, st);
+    std::cout.flush();
+    if (disk.isMounted()) {
+        disk.unmount();
+    }
+    std::cerr << "脚本执行完成: " << st.commands << " 条命令，失败 " << st.failed << "，耗时 " << st.seconds * 1000
+              << " ms";
+    if (st.first_error) std::cerr << "，第一条失败命令在第 " << st.first_error << " 行";
+    std::cerr << "\n";
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        print_usage(argv[0]);
         return 1;
     }
 
     DiskFS disk(argv[1]);
+    if (argc > 2) {
+        const char* script = nullptr;
+        const char* socket_path = nullptr;
+        uint32_t workers = 0;
+        bool preload = false;
+        const char* qos_spec = nullptr;
+        ScriptOptions opt = {false, true, false};
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+                script = argv[++i];
+            } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+                socket_path = argv[++i];
+            } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+                workers = (uint32_t)atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--qos") == 0 && i + 1 < argc) {
+                qos_spec = argv[++i];
+            } else if (strcmp(argv[i], "--preload") == 0) {
+                preload = true;
+            } else if (strcmp(argv[i], "--timing") == 0) {
+                opt.timing = true;
+            } else if (strcmp(argv[i], "--keep-going") == 0) {
+                opt.stop_on_error = false;
+            } else if (strcmp(argv[i], "--echo") == 0) {
+                opt.echo = true;
+            } else {
+                script = socket_path = nullptr;
+                break;
+            }
+        }
+        if (socket_path) return run_serve_mode(disk, socket_path, workers, preload, qos_spec);
+        if (!script) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return run_script_mode(disk, script, opt);
+    }
+
     CommandParser parser(disk);
     parser.print_help();
 
     std::string command;
-    while (true) {
+    while (!parser.exit_requested()) {
         std::cout << "\n> ";
-        std::getline(std::cin, command);
-        if (command == "exit") break;
-        parser.execute_command(command);
+        if (!std::getline(std::cin, command)) break;
+        try {
+            parser.execute_command(command);
+        } catch (const std::exception&) {
+            std::cout << "参数错误，请输入help查看帮助\n";
+        }
     }
 
     if (disk.isMounted()) {
         disk.unmount();
     }
     return 0;
-}
\ No newline at end of file
+}
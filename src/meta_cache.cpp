@@ -0,0 +1,252 @@
+#include "../include/meta_cache.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static_assert(MOUNT_CKPT_OFFSET >= sizeof(SuperBlock), "挂载检查点不能与超级块重叠");
+static_assert(MOUNT_CKPT_OFFSET + sizeof(MountCheckpoint) <= BLOCK_SIZE, "挂载检查点必须放在0号块内");
+static_assert(MOUNT_CKPT_MAX_ENTRIES >= BLOCK_SIZE / sizeof(DirEntry), "目录索引容量不足");
+
+MetaCache::MetaCache(uint32_t first_block, uint32_t inode_start, uint32_t end_block)
+    : first_block(first_block), inode_start(inode_start), end_block(end_block),
+      dir_block(0), block_hint(0), inode_hint(0), mount_count(0)
+{
+    memset(&st, 0, sizeof(st));
+}
+
+bool MetaCache::lookup_block(uint32_t block_num, char* buffer)
+{
+    if (!st.preloaded) return false;
+    if (block_num >= first_block && block_num < end_block) {
+        memcpy(buffer, &region[(size_t)(block_num - first_block) * BLOCK_SIZE], BLOCK_SIZE);
+    } else if (block_num == dir_block && !dir_data.empty()) {
+        memcpy(buffer, dir_data.data(), BLOCK_SIZE);
+    } else {
+        return false;
+    }
+    st.block_hits++;
+    return true;
+}
+
+void MetaCache::update_block(uint32_t block_num, const char* buffer)
+{
+    if (st.preloaded && block_num >= first_block && block_num < end_block) {
+        memcpy(&region[(size_t)(block_num - first_block) * BLOCK_SIZE], buffer, BLOCK_SIZE);
+    }
+    if (block_num == dir_block) {
+        if (st.preloaded) dir_data.assign(buffer, buffer + BLOCK_SIZE);
+        index_dir(buffer);
+    }
+}
+
+bool MetaCache::lookup_inode(uint32_t inode_num, char* buffer, size_t len)
+{
+    if (!st.preloaded) return false;
+    size_t pos = (size_t)(inode_start - first_block) * BLOCK_SIZE + (size_t)inode_num * len;
+    if (pos + len > region.size()) return false;
+    memcpy(buffer, &region[pos], len);
+    st.inode_hits++;
+    return true;
+}
+
+void MetaCache::update_inode(uint32_t inode_num, const char* buffer, size_t len)
+{
+    if (!st.preloaded) return;
+    size_t pos = (size_t)(inode_start - first_block) * BLOCK_SIZE + (size_t)inode_num * len;
+    if (pos + len <= region.size()) memcpy(&region[pos], buffer, len);
+}
+
+uint32_t MetaCache::name_hash(const char* name)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < (size_t)MAX_FILENAME && name[i]; i++) {
+        h ^= (uint8_t)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief 由根目录块重建目录索引（跳过0号"."目录项）
+ */
+void MetaCache::index_dir(const char* dir)
+{
+    index.clear();
+    const DirEntry* entries = (const DirEntry*)dir;
+    for (uint32_t i = 1; i < BLOCK_SIZE / sizeof(DirEntry); i++) {
+        if (!entries[i].valid) continue;
+        char name[MAX_FILENAME];
+        memcpy(name, entries[i].name, MAX_FILENAME);
+        name[MAX_FILENAME - 1] = '\0';
+        DirIndexEntry e = {name_hash(name), i, entries[i].inode_num};
+        index.insert(std::make_pair(e.hash, e));
+    }
+}
+
+int MetaCache::find(const std::string& name, const char* dir, uint32_t& inode_num)
+{
+    const DirEntry* entries = (const DirEntry*)dir;
+    auto range = index.equal_range(name_hash(name.c_str()));
+    for (auto it = range.first; it != range.second; ++it) {
+        const DirEntry& entry = entries[it->second.slot];
+        if (entry.valid && entry.inode_num == it->second.inode_num && name == entry.name) {
+            inode_num = entry.inode_num;
+            st.index_hits++;
+            return (int)it->second.slot;
+        }
+    }
+    return -1;
+}
+
+void MetaCache::save(MountCheckpoint& ckpt) const
+{
+    ckpt.mount_count = mount_count;
+    ckpt.dir_block = dir_block;
+    ckpt.block_hint = block_hint;
+    ckpt.inode_hint = inode_hint;
+    ckpt.entry_count = 0;
+    for (const auto& kv : index) {
+        if (ckpt.entry_count == MOUNT_CKPT_MAX_ENTRIES) break;
+        ckpt.entries[ckpt.entry_count++] = kv.second;
+    }
+}
+
+void MetaCache::load(const MountCheckpoint& ckpt)
+{
+    mount_count = ckpt.mount_count;
+    dir_block = ckpt.dir_block;
+    block_hint = ckpt.block_hint;
+    inode_hint = ckpt.inode_hint;
+    index.clear();
+    for (uint32_t i = 0; i < ckpt.entry_count && i < MOUNT_CKPT_MAX_ENTRIES; i++) {
+        index.insert(std::make_pair(ckpt.entries[i].hash, ckpt.entries[i]));
+    }
+}
+
+uint32_t MetaCache::checksum(const MountCheckpoint& ckpt)
+{
+    MountCheckpoint copy = ckpt;
+    copy.checksum = 0;
+    uint32_t h = 2166136261u;
+    const char* p = (const char*)&copy;
+    for (size_t i = 0; i < sizeof(copy); i++) {
+        h ^= (uint8_t)p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief 挂载时建立元数据副本：加载或重建目录索引与分配提示，按需预读，然后清除干净标记（只读挂载不写）
+ * @param preload true表示预读位图、inode区与根目录块
+ * @return 成功返回true；读取根目录失败返回false
+ */
+bool DiskFS::meta_attach(bool preload)
+{
+    meta.reset(new MetaCache(super_block.block_bitmap, super_block.inode_start, super_block.data_start));
+    MetaCache& mc = *meta;
+
+    // 1. 预读：位图与inode区在磁盘上连续，一次顺序读完
+    if (preload) {
+        mc.region.assign((size_t)(mc.end_block - mc.first_block) * BLOCK_SIZE, 0);
+        if (!raw_read((uint64_t)mc.first_block * BLOCK_SIZE, mc.region.data(), mc.region.size())) {
+            meta.reset();
+            return false;
+        }
+        mc.st.preloaded = true;
+        mc.st.preload_bytes = mc.region.size();
+        mc.st.preload_ios = 1;
+    }
+
+    // 2. 干净卸载留下的检查点可直接使用，否则由根目录重建索引
+    MountCheckpoint ckpt;
+    bool have_ckpt = raw_read(MOUNT_CKPT_OFFSET, (char*)&ckpt, sizeof(ckpt)) &&
+                     memcmp(ckpt.magic, MOUNT_CKPT_MAGIC, sizeof(ckpt.magic)) == 0 && ckpt.clean == 1 &&
+                     ckpt.checksum == MetaCache::checksum(ckpt);
+    if (have_ckpt) {
+        mc.load(ckpt);
+        mc.st.from_checkpoint = true;
+    }
+    if (!have_ckpt || preload) {
+        Inode root;
+        if (!read_inode(0, root) || root.type != 2 || root.blocks[0] == 0) {
+            meta.reset();
+            return false;
+        }
+        mc.dir_block = root.blocks[0];
+        std::vector<char> dir(BLOCK_SIZE);
+        if (!raw_read((uint64_t)mc.dir_block * BLOCK_SIZE, dir.data(), BLOCK_SIZE)) {
+            meta.reset();
+            return false;
+        }
+        if (preload) {
+            mc.dir_data = dir;
+            mc.st.preload_bytes += BLOCK_SIZE;
+            mc.st.preload_ios++;
+        }
+        if (!have_ckpt) mc.index_dir(dir.data());
+    }
+
+    // 3. 清除干净标记：本次挂载期间崩溃的话，下次挂载不会信任旧检查点（只读挂载不改动镜像）
+    if (read_only) return true;
+    mc.mount_count++;
+    memset(&ckpt, 0, sizeof(ckpt));
+    memcpy(ckpt.magic, MOUNT_CKPT_MAGIC, sizeof(ckpt.magic));
+    ckpt.mount_count = mc.mount_count;
+    ckpt.checksum = MetaCache::checksum(ckpt);
+    return raw_write(MOUNT_CKPT_OFFSET, (const char*)&ckpt, sizeof(ckpt));
+}
+
+/**
+ * @brief 干净卸载：写入目录索引与分配提示，释放元数据副本
+ */
+bool DiskFS::meta_detach()
+{
+    if (!meta) return true;
+    MountCheckpoint ckpt;
+    memset(&ckpt, 0, sizeof(ckpt));
+    memcpy(ckpt.magic, MOUNT_CKPT_MAGIC, sizeof(ckpt.magic));
+    meta->save(ckpt);
+    ckpt.clean = 1;
+    ckpt.checksum = MetaCache::checksum(ckpt);
+    meta.reset();
+    return raw_write(MOUNT_CKPT_OFFSET, (const char*)&ckpt, sizeof(ckpt));
+}
+
+/**
+ * @brief 按文件名查找根目录中的文件
+ * 有目录索引时只读根目录块确认候选项（预读后命中内存），否则遍历目录
+ * @return 文件的inode编号；不存在返回-1
+ */
+int DiskFS::find_entry(const std::string& name)
+{
+    if (shared) {
+        uint32_t inode_num;
+        int slot = shared->find(name, inode_num);
+        if (slot != -2) return slot >= 0 ? (int)inode_num : -1;  // 共享段失效时改为遍历目录
+    }
+    if (meta && meta->dir_block != 0) {
+        char dir[BLOCK_SIZE];
+        uint32_t inode_num;
+        if (!read_block(meta->dir_block, dir)) return -1;
+        return meta->find(name, dir, inode_num) >= 0 ? (int)inode_num : -1;
+    }
+    std::vector<DirEntry> entries = list_files();
+    for (const auto& entry : entries) {
+        if (entry.valid && name == entry.name) return entry.inode_num;
+    }
+    return -1;
+}
+
+void DiskFS::print_meta_info() const
+{
+    if (!meta) return;
+    const MetaStats& st = meta->st;
+    std::cout << "快速挂载:\n";
+    std::cout << "  预读: " << (st.preloaded ? "是" : "否") << "（" << st.preload_ios << "次I/O，"
+              << st.preload_bytes / 1024 << "KB），目录索引来自: " << (st.from_checkpoint ? "挂载检查点" : "重建")
+              << "，累计挂载: " << meta->mount_count << "\n";
+    std::cout << "  内存命中: 块 " << st.block_hits << "，inode " << st.inode_hits << "，目录索引 " << st.index_hits
+              << "\n";
+}
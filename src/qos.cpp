@@ -0,0 +1,167 @@
+#include "../include/qos.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+TokenBucket::TokenBucket(uint64_t rate)
+    : rate((double)rate), burst(std::max(1.0, rate * QOS_BURST_SECONDS)), tokens(burst), last_ns(0)
+{
+}
+
+void TokenBucket::refill(uint64_t now_ns)
+{
+    if (now_ns > last_ns) {
+        tokens = std::min(burst, tokens + (now_ns - last_ns) * rate / 1e9);
+    }
+    last_ns = now_ns;
+}
+
+bool TokenBucket::ready(uint64_t now_ns)
+{
+    if (rate == 0) return true;
+    refill(now_ns);
+    return tokens > 0;
+}
+
+void TokenBucket::take(uint64_t amount)
+{
+    if (rate != 0) tokens -= (double)amount;
+}
+
+uint64_t TokenBucket::wait_ns(uint64_t now_ns)
+{
+    if (rate == 0) return 0;
+    refill(now_ns);
+    return tokens > 0 ? 0 : (uint64_t)((-tokens) * 1e9 / rate) + 1;
+}
+
+QosScheduler::QosScheduler() : QosScheduler(std::vector<QosClassConfig>()) {}
+
+QosScheduler::QosScheduler(const std::vector<QosClassConfig>& configs) : vtime(0), total_queued(0)
+{
+    std::vector<QosClassConfig> all = configs;
+    bool has_default = false;
+    for (const auto& c : all) has_default = has_default || c.name == "default";
+    if (!has_default) {
+        QosClassConfig def = {"default", 1, 0, 0};
+        all.insert(all.begin(), def);
+    }
+    std::stable_partition(all.begin(), all.end(), [](const QosClassConfig& c) { return c.name == "default"; });
+    for (const auto& c : all) {
+        ClassState cs;
+        cs.cfg = c;
+        cs.cfg.weight = std::max(1u, c.weight);
+        cs.iops = TokenBucket(c.iops_limit);
+        cs.bandwidth = TokenBucket(c.bytes_limit);
+        cs.last_finish = 0;
+        memset(&cs.st, 0, sizeof(cs.st));
+        classes.push_back(cs);
+    }
+}
+
+int QosScheduler::find_class(const std::string& name) const
+{
+    for (size_t i = 0; i < classes.size(); i++) {
+        if (classes[i].cfg.name == name) return (int)i;
+    }
+    return -1;
+}
+
+void QosScheduler::enqueue(uint32_t cls, uint64_t bytes)
+{
+    ClassState& c = classes[cls];
+    Tag tag;
+    tag.bytes = bytes;
+    tag.start = std::max(vtime, c.last_finish);
+    tag.throttled = false;
+    c.last_finish = tag.start + (double)(bytes + QOS_OP_COST) / c.cfg.weight;
+    c.tags.push_back(tag);
+    total_queued++;
+}
+
+int QosScheduler::dequeue(uint64_t now_ns, uint64_t& wait_ns)
+{
+    wait_ns = 0;
+    int best = -1;
+    for (size_t i = 0; i < classes.size(); i++) {
+        ClassState& c = classes[i];
+        if (c.tags.empty()) continue;
+        if (!c.iops.ready(now_ns) || !c.bandwidth.ready(now_ns)) {
+            uint64_t w = std::max(c.iops.wait_ns(now_ns), c.bandwidth.wait_ns(now_ns));
+            if (wait_ns == 0 || w < wait_ns) wait_ns = w;
+            if (!c.tags.front().throttled) {
+                c.tags.front().throttled = true;
+                c.st.throttled++;
+            }
+            continue;
+        }
+        if (best < 0 || c.tags.front().start < classes[best].tags.front().start) best = (int)i;
+    }
+    if (best < 0) return -1;
+    ClassState& c = classes[best];
+    Tag tag = c.tags.front();
+    c.tags.pop_front();
+    c.iops.take(1);
+    c.bandwidth.take(tag.bytes);
+    vtime = tag.start;
+    total_queued--;
+    wait_ns = 0;
+    return best;
+}
+
+void QosScheduler::complete(uint32_t cls, uint64_t bytes, uint64_t latency_ns)
+{
+    QosClassStats& st = classes[cls].st;
+    st.requests++;
+    st.bytes += bytes;
+    st.latency.buckets[LatencyHistogram::bucket_index(latency_ns)]++;
+    st.latency.count++;
+    st.latency.sum_ns += latency_ns;
+}
+
+void QosScheduler::print_stats() const
+{
+    char line[200];
+    snprintf(line, sizeof(line), "  %-12s %6s %10s %10s %10s %10s %10s %10s\n", "class", "weight", "limit", "requests",
+             "KB", "throttled", "p50(us)", "p99(us)");
+    std::cout << line;
+    for (const auto& c : classes) {
+        std::string limit = "-";
+        if (c.cfg.iops_limit || c.cfg.bytes_limit) {
+            limit = (c.cfg.iops_limit ? std::to_string(c.cfg.iops_limit) : std::string("-")) + "/" +
+                    (c.cfg.bytes_limit ? std::to_string(c.cfg.bytes_limit >> 20) + "M" : std::string("-"));
+        }
+        snprintf(line, sizeof(line), "  %-12s %6u %10s %10llu %10llu %10llu %10.1f %10.1f\n", c.cfg.name.c_str(),
+                 c.cfg.weight, limit.c_str(), (unsigned long long)c.st.requests, (unsigned long long)(c.st.bytes >> 10),
+                 (unsigned long long)c.st.throttled, c.st.latency.percentile(0.50) / 1e3,
+                 c.st.latency.percentile(0.99) / 1e3);
+        std::cout << line;
+    }
+}
+
+bool parse_qos_spec(const std::string& spec, std::vector<QosClassConfig>& out)
+{
+    out.clear();
+    std::stringstream classes(spec);
+    std::string item;
+    while (std::getline(classes, item, ',')) {
+        std::stringstream fields(item);
+        std::string field;
+        std::vector<std::string> parts;
+        while (std::getline(fields, field, ':')) parts.push_back(field);
+        if (parts.empty() || parts.size() > 4 || parts[0].empty()) return false;
+        QosClassConfig c = {parts[0], 1, 0, 0};
+        try {
+            if (parts.size() >= 2) c.weight = (uint32_t)std::stoul(parts[1]);
+            if (parts.size() >= 3) c.iops_limit = std::stoull(parts[2]);
+            if (parts.size() >= 4) c.bytes_limit = std::stoull(parts[3]) << 20;
+        } catch (const std::exception&) {
+            return false;
+        }
+        if (c.weight == 0) return false;
+        out.push_back(c);
+    }
+    return !out.empty();
+}
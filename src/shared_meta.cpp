@@ -0,0 +1,296 @@
+#include "../include/shared_meta.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+SharedMeta::SharedMeta(uint32_t block_size, uint32_t first_block, uint32_t inode_start, uint32_t end_block)
+    : block_size(block_size), first_block(first_block), inode_start(inode_start), end_block(end_block), fd(-1),
+      seg_size(0), header(nullptr), region(nullptr), dir(nullptr), attach_seq(0)
+{
+    memset(&st, 0, sizeof(st));
+}
+
+SharedMeta::~SharedMeta()
+{
+    if (header) munmap(header, seg_size);
+    if (fd >= 0) ::close(fd);
+}
+
+/**
+ * @brief 共享段名：/simdisk-<设备号>-<inode号>（同一镜像文件的不同路径得到同一段）
+ */
+std::string SharedMeta::segment_name(const std::string& image_path)
+{
+    struct stat sb;
+    if (stat(image_path.c_str(), &sb) != 0) return "";
+    char name[64];
+    snprintf(name, sizeof(name), "/simdisk-%llx-%llx", (unsigned long long)sb.st_dev, (unsigned long long)sb.st_ino);
+    return name;
+}
+
+void SharedMeta::remove(const std::string& image_path)
+{
+    std::string name = segment_name(image_path);
+    if (!name.empty()) shm_unlink(name.c_str());
+}
+
+/**
+ * @brief 映射共享段；段无效（新建、构建中途退出）或镜像指纹不符时调用loader构建
+ * @param name 共享段名
+ * @param stamp 镜像指纹
+ * @param loader 读盘填充元数据区与根目录块
+ * @return 成功返回true；共享内存不可用或loader失败返回false
+ * 构建与登记期间持有段上的flock，其他挂载者等待；读者读取时不加锁
+ */
+bool SharedMeta::attach(const std::string& name, uint64_t stamp, const Loader& loader)
+{
+    seg_name = name;
+    size_t meta_bytes = (size_t)(end_block - first_block) * block_size;
+    size_t head = (sizeof(SharedHeader) + 63) / 64 * 64;
+    seg_size = head + meta_bytes + block_size;
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "共享段 " << name << " 打开失败（" << strerror(errno) << "）" << std::endl;
+        return false;
+    }
+    int rc;
+    while ((rc = flock(fd, LOCK_EX)) != 0 && errno == EINTR) {
+    }
+    struct stat sb;
+    void* p = MAP_FAILED;
+    if (rc == 0 && fstat(fd, &sb) == 0 && (sb.st_size >= (off_t)seg_size || ftruncate(fd, seg_size) == 0)) {
+        p = mmap(nullptr, seg_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (p == MAP_FAILED) {
+        std::cerr << "共享段 " << name << " 映射失败（" << strerror(errno) << "）" << std::endl;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    header = (SharedHeader*)p;
+    region = (char*)p + head;
+    dir = region + meta_bytes;
+
+    uint32_t seq = header->seq.load(std::memory_order_relaxed);
+    bool valid = (seq & 1) == 0 && memcmp(header->magic, SHARED_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->stamp == stamp && header->first_block == first_block &&
+                 header->inode_start == inode_start && header->end_block == end_block;
+    if (!valid) {
+        // 序号先置为奇数：仍映射着旧内容的读者据此发现段已重建
+        if ((seq & 1) == 0) seq++;
+        header->seq.store(seq, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memset(header->magic, 0, sizeof(header->magic));
+        uint32_t dir_block = 0;
+        bool ok = loader(region, dir, dir_block);
+        if (ok) {
+            // 目录索引按哈希排序，读者二分查找（跳过0号"."目录项）
+            const DirEntry* entries = (const DirEntry*)dir;
+            uint32_t n = 0;
+            for (uint32_t i = 1; i < block_size / sizeof(DirEntry) && n < MOUNT_CKPT_MAX_ENTRIES; i++) {
+                if (!entries[i].valid) continue;
+                char fname[MAX_FILENAME];
+                memcpy(fname, entries[i].name, MAX_FILENAME);
+                fname[MAX_FILENAME - 1] = '\0';
+                DirIndexEntry e = {MetaCache::name_hash(fname), i, entries[i].inode_num};
+                header->entries[n++] = e;
+            }
+            std::sort(header->entries, header->entries + n,
+                      [](const DirIndexEntry& a, const DirIndexEntry& b) { return a.hash < b.hash; });
+            header->entry_count = n;
+            header->stamp = stamp;
+            header->first_block = first_block;
+            header->inode_start = inode_start;
+            header->end_block = end_block;
+            header->dir_block = dir_block;
+            header->builds++;
+            memcpy(header->magic, SHARED_MAGIC, sizeof(header->magic));
+        }
+        header->seq.store(seq + 1, std::memory_order_release);
+        if (!ok) {
+            flock(fd, LOCK_UN);
+            return false;
+        }
+        st.built = true;
+    }
+    header->attaches.fetch_add(1);
+    attach_seq = header->seq.load(std::memory_order_acquire);
+    flock(fd, LOCK_UN);
+    return true;
+}
+
+/**
+ * @brief 开始一次无锁读取：等待序号为偶数
+ * @return 可以读取返回true；段在挂载后被重建或一直处于构建中返回false
+ */
+bool SharedMeta::begin_read(uint32_t& seq)
+{
+    for (uint32_t tries = 0; tries < SHARED_READ_RETRIES; tries++) {
+        seq = header->seq.load(std::memory_order_acquire);
+        if ((seq & 1) == 0) {
+            if (seq == attach_seq) return true;
+            break;
+        }
+        st.retries++;
+        std::this_thread::yield();
+    }
+    st.stale++;
+    return false;
+}
+
+/**
+ * @brief 结束一次无锁读取：序号不变说明读到的内容一致
+ */
+bool SharedMeta::end_read(uint32_t seq)
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->seq.load(std::memory_order_relaxed) == seq) return true;
+    st.retries++;
+    return false;
+}
+
+bool SharedMeta::read_consistent(const char* src, char* out, size_t len)
+{
+    uint32_t seq;
+    do {
+        if (!begin_read(seq)) return false;
+        memcpy(out, src, len);
+    } while (!end_read(seq));
+    return true;
+}
+
+bool SharedMeta::lookup_block(uint32_t block_num, char* buffer)
+{
+    const char* src;
+    if (block_num >= first_block && block_num < end_block) {
+        src = region + (size_t)(block_num - first_block) * block_size;
+    } else if (block_num == header->dir_block) {
+        src = dir;
+    } else {
+        return false;
+    }
+    if (!read_consistent(src, buffer, block_size)) return false;
+    st.block_hits++;
+    return true;
+}
+
+bool SharedMeta::lookup_inode(uint32_t inode_num, char* buffer, size_t len)
+{
+    size_t pos = (size_t)(inode_start - first_block) * block_size + (size_t)inode_num * len;
+    if (pos + len > (size_t)(end_block - first_block) * block_size) return false;
+    if (!read_consistent(region + pos, buffer, len)) return false;
+    st.inode_hits++;
+    return true;
+}
+
+int SharedMeta::find(const std::string& name, uint32_t& inode_num)
+{
+    if (name.size() >= (size_t)MAX_FILENAME) return -1;
+    uint32_t hash = MetaCache::name_hash(name.c_str());
+    const DirEntry* entries = (const DirEntry*)dir;
+    uint32_t seq;
+    int slot;
+    do {
+        if (!begin_read(seq)) return -2;
+        slot = -1;
+        const DirIndexEntry* first = header->entries;
+        const DirIndexEntry* last = first + std::min(header->entry_count, MOUNT_CKPT_MAX_ENTRIES);
+        const DirIndexEntry* e = std::lower_bound(
+            first, last, hash, [](const DirIndexEntry& a, uint32_t h) { return a.hash < h; });
+        for (; e != last && e->hash == hash; ++e) {
+            if (e->slot >= block_size / sizeof(DirEntry)) break;
+            const DirEntry& entry = entries[e->slot];
+            if (entry.valid && entry.inode_num == e->inode_num &&
+                strncmp(entry.name, name.c_str(), MAX_FILENAME) == 0) {
+                inode_num = entry.inode_num;
+                slot = (int)e->slot;
+                break;
+            }
+        }
+    } while (!end_read(seq));
+    if (slot >= 0) st.index_hits++;
+    return slot;
+}
+
+/**
+ * @brief 对镜像文件加flock：可写挂载与格式化加独占锁，只读挂载加共享锁（均不等待）
+ * @return 加锁成功返回true；镜像正被其他挂载以冲突方式使用时返回false
+ */
+bool DiskFS::lock_image(bool exclusive)
+{
+    unlock_image();
+    image_lock_fd = ::open(disk_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (image_lock_fd < 0) return true;  // 镜像尚不存在（格式化时创建），无需互斥
+    if (flock(image_lock_fd, (exclusive ? LOCK_EX : LOCK_SH) | LOCK_NB) == 0) return true;
+    std::cerr << (exclusive ? "镜像正被其他进程或实例挂载，拒绝写入" : "镜像正被其他进程或实例可写挂载") << std::endl;
+    ::close(image_lock_fd);
+    image_lock_fd = -1;
+    return false;
+}
+
+void DiskFS::unlock_image()
+{
+    if (image_lock_fd < 0) return;
+    ::close(image_lock_fd);  // 关闭即释放flock
+    image_lock_fd = -1;
+}
+
+/**
+ * @brief 共享只读挂载：映射（必要时构建）共享元数据段，代替进程内的元数据副本
+ * 共享内存不可用时回退到进程内缓存（不预读）
+ */
+bool DiskFS::shared_attach()
+{
+    if (log) {
+        std::cerr << "共享只读挂载只支持原地布局" << std::endl;
+        return false;
+    }
+    struct stat sb;
+    if (stat(disk_path.c_str(), &sb) != 0) return false;
+    struct {
+        int64_t size;
+        int64_t mtime_sec;
+        int64_t mtime_nsec;
+    } file_id = {(int64_t)sb.st_size, (int64_t)sb.st_mtim.tv_sec, (int64_t)sb.st_mtim.tv_nsec};
+    uint64_t stamp = ((uint64_t)crc32c(0, &super_block, sizeof(SuperBlock)) << 32) | crc32c(0, &file_id, sizeof(file_id));
+
+    shared.reset(new SharedMeta(BLOCK_SIZE, super_block.block_bitmap, super_block.inode_start, super_block.data_start));
+    auto loader = [this](char* region, char* dir, uint32_t& dir_block) {
+        // 位图与inode区在磁盘上连续，一次顺序读完；根目录inode是inode区的第一项
+        uint32_t first = super_block.block_bitmap;
+        if (!raw_read((uint64_t)first * BLOCK_SIZE, region, (size_t)(super_block.data_start - first) * BLOCK_SIZE)) {
+            return false;
+        }
+        const Inode* root = (const Inode*)(region + (size_t)(super_block.inode_start - first) * BLOCK_SIZE);
+        if (root->type != 2 || root->blocks[0] == 0) return false;
+        dir_block = root->blocks[0];
+        return raw_read((uint64_t)dir_block * BLOCK_SIZE, dir, BLOCK_SIZE);
+    };
+    std::string name = SharedMeta::segment_name(disk_path);
+    if (name.empty() || !shared->attach(name, stamp, loader)) {
+        shared.reset();
+        std::cerr << "共享元数据段不可用，改用进程内缓存" << std::endl;
+        return meta_attach(false);
+    }
+    return true;
+}
+
+void DiskFS::print_shared_info() const
+{
+    if (!shared) return;
+    const SharedStats& st = shared->st;
+    std::cout << "共享只读挂载:\n";
+    std::cout << "  共享段: " << shared->name() << "，" << shared->bytes() / 1024 << "KB，本进程"
+              << (st.built ? "构建" : "复用") << "，累计挂载读者: " << shared->readers() << "\n";
+    std::cout << "  命中: 块 " << st.block_hits << "，inode " << st.inode_hits << "，目录索引 " << st.index_hits
+              << "；重试 " << st.retries << "，失效后读盘 " << st.stale << "\n";
+}
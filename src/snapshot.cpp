@@ -0,0 +1,340 @@
+#include "../include/snapshot.h"
+#include "../include/disk_fs.h"
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+static_assert(sizeof(Inode) == INODE_SIZE, "inode区按INODE_SIZE连续存放");
+static_assert(SNAP_INODE_BLOCKS * BLOCK_SIZE == MAX_INODES * INODE_SIZE, "快照按块复制整个inode区");
+static_assert(SNAP_NAME_LEN == MAX_FILENAME, "快照名与文件名长度一致");
+static_assert(sizeof(SnapCatalog) <= BLOCK_SIZE, "快照目录占一块");
+
+namespace {
+
+// 对inode表中全部已用文件的数据块调用fn（跳过根目录：当前根目录块与快照的根目录副本各自独立）
+template <typename Fn>
+void for_each_file_block(const std::vector<Inode>& table, uint32_t data_start, uint32_t data_end, Fn fn)
+{
+    for (size_t n = 1; n < table.size(); n++) {
+        if (!table[n].used) continue;
+        for (uint32_t s = 0; s < 16; s++) {
+            uint32_t b = table[n].blocks[s];
+            if (b >= data_start && b < data_end) fn(b);
+        }
+    }
+}
+
+}  // namespace
+
+/**
+ * @brief 修改类操作开头调用：只读挂载时报告并返回true
+ */
+bool DiskFS::reject_read_only(const char* op) const
+{
+    if (!read_only) return false;
+    std::cerr << op << "失败：磁盘以只读方式挂载" << std::endl;
+    return true;
+}
+
+/**
+ * @brief 克隆与快照操作的前置检查：已挂载、可写且以cow或dedup格式化
+ */
+bool DiskFS::snap_check(const char* op) const
+{
+    if (!is_mounted) {
+        std::cerr << op << "失败：磁盘未挂载" << std::endl;
+        return false;
+    }
+    if (reject_read_only(op)) return false;
+    if (!dedup) {
+        std::cerr << op << "失败：需要块引用计数（使用format cow或format dedup格式化）" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 挂载时读入快照目录（未启用引用计数时为空）
+ */
+bool DiskFS::snap_attach()
+{
+    snapshots.clear();
+    if (super_block.snap_block == 0) return true;
+    std::vector<char> block;
+    if (!region_io(super_block.snap_block, 1, block, false)) return false;
+    const SnapCatalog* cat = (const SnapCatalog*)block.data();
+    if (memcmp(cat->magic, SNAP_MAGIC, sizeof(cat->magic)) != 0) {
+        std::cerr << "挂载失败：快照目录损坏" << std::endl;
+        return false;
+    }
+    snapshots.assign(cat->entries, cat->entries + SNAP_MAX);
+    return true;
+}
+
+/**
+ * @brief 写入快照目录（创建、删除快照以及格式化时调用）
+ */
+bool DiskFS::snap_save()
+{
+    if (super_block.snap_block == 0) return true;
+    std::vector<char> block(BLOCK_SIZE, 0);
+    SnapCatalog* cat = (SnapCatalog*)block.data();
+    memcpy(cat->magic, SNAP_MAGIC, sizeof(cat->magic));
+    for (uint32_t i = 0; i < SNAP_MAX && i < snapshots.size(); i++) cat->entries[i] = snapshots[i];
+    return region_io(super_block.snap_block, 1, block, true);
+}
+
+int DiskFS::snap_find(const std::string& name) const
+{
+    for (size_t i = 0; i < snapshots.size(); i++) {
+        if (snapshots[i].valid && name == snapshots[i].name) return (int)i;
+    }
+    return -1;
+}
+
+/**
+ * @brief 读取快照的inode表（快照元数据块是普通数据块，读取时照常校验）
+ */
+bool DiskFS::snap_load(const SnapEntry& snap, std::vector<Inode>& table)
+{
+    table.assign(super_block.total_inodes, Inode());
+    char* out = (char*)table.data();
+    for (uint32_t i = 0; i < SNAP_INODE_BLOCKS; i++) {
+        if (!read_block(snap.meta[i], out + (size_t)i * BLOCK_SIZE)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 累加全部快照持有的块引用：元数据块各1个，快照inode表中每个文件块指针1个
+ * @param counts 按数据区相对下标的引用数（调用方预先分配data_blocks项）
+ */
+bool DiskFS::snap_refs(std::vector<uint32_t>& counts)
+{
+    uint32_t data_start = super_block.data_start;
+    uint32_t data_end = data_start + super_block.data_blocks;
+    for (const SnapEntry& snap : snapshots) {
+        if (!snap.valid) continue;
+        std::vector<Inode> table;
+        if (!snap_load(snap, table)) {
+            std::cerr << "读取快照 " << snap.name << " 的inode表失败" << std::endl;
+            return false;
+        }
+        for (uint32_t i = 0; i < SNAP_META_BLOCKS; i++) {
+            if (snap.meta[i] >= data_start && snap.meta[i] < data_end) counts[snap.meta[i] - data_start]++;
+        }
+        for_each_file_block(table, data_start, data_end, [&](uint32_t b) { counts[b - data_start]++; });
+    }
+    return true;
+}
+
+/**
+ * @brief 读取当前的整个inode区（原地布局一次顺序读，日志布局逐个经映射读取）
+ */
+bool DiskFS::read_inode_table(std::vector<Inode>& table)
+{
+    table.assign(super_block.total_inodes, Inode());
+    if (log) {
+        for (uint32_t n = 0; n < super_block.total_inodes; n++) {
+            if (!read_inode(n, table[n])) return false;
+        }
+        return true;
+    }
+    std::vector<char> region;
+    if (!region_io(super_block.inode_start, SNAP_INODE_BLOCKS, region, false)) return false;
+    memcpy(table.data(), region.data(), table.size() * sizeof(Inode));
+    return true;
+}
+
+/**
+ * @brief 克隆文件（reflink）：新文件共享源文件的全部数据块，只写一个inode
+ * @param src 源文件名
+ * @param dst 新文件名（不能已存在）
+ * @return 新文件的inode编号；失败返回-1
+ */
+int DiskFS::clone_file(const std::string& src, const std::string& dst)
+{
+    IoBatch batch(*this);
+    if (!snap_check("克隆文件")) return -1;
+    int src_num = find_entry(src);
+    Inode src_inode;
+    if (src_num == -1 || !read_inode(src_num, src_inode) || !src_inode.used || src_inode.type != 1) {
+        std::cerr << "克隆文件失败：" << src << " 不存在" << std::endl;
+        return -1;
+    }
+    int dst_num = create_file(dst);
+    Inode dst_inode;
+    if (dst_num == -1 || !read_inode(dst_num, dst_inode)) return -1;
+
+    uint32_t data_end = super_block.data_start + super_block.data_blocks;
+    for (uint32_t s = 0; s < 16; s++) {
+        uint32_t b = src_inode.blocks[s];
+        bool valid = b >= super_block.data_start && b < data_end;
+        dst_inode.blocks[s] = valid ? b : 0;
+        if (valid) dedup->add_ref(b);
+    }
+    dst_inode.size = src_inode.size;
+    dst_inode.flags = src_inode.flags;
+    dst_inode.modify_time = time(nullptr);
+    if (!write_inode(dst_num, dst_inode)) {
+        std::cerr << "克隆文件失败：写入inode " << dst_num << " 失败" << std::endl;
+        return -1;
+    }
+    return dst_num;
+}
+
+/**
+ * @brief 创建快照：复制inode区与根目录块（SNAP_META_BLOCKS块），快照对每个文件数据块持有一个引用
+ */
+bool DiskFS::snapshot_create(const std::string& name)
+{
+    IoBatch batch(*this);
+    if (!snap_check("创建快照")) return false;
+    if (name.empty() || name.length() >= SNAP_NAME_LEN) {
+        std::cerr << "创建快照失败：名称无效" << std::endl;
+        return false;
+    }
+    if (snap_find(name) != -1) {
+        std::cerr << "创建快照失败：" << name << " 已存在" << std::endl;
+        return false;
+    }
+    size_t slot = 0;
+    while (slot < snapshots.size() && snapshots[slot].valid) slot++;
+    if (slot == snapshots.size()) {
+        std::cerr << "创建快照失败：快照数已达上限 " << SNAP_MAX << std::endl;
+        return false;
+    }
+
+    std::vector<Inode> table;
+    char dir[BLOCK_SIZE];
+    if (!read_inode_table(table) || !read_block(table[0].blocks[0], dir)) return false;
+
+    SnapEntry snap;
+    memset(&snap, 0, sizeof(snap));
+    for (uint32_t i = 0; i < SNAP_META_BLOCKS; i++) {
+        int b = find_free_block();
+        if (b == -1) {
+            for (uint32_t j = 0; j < i; j++) set_block_bitmap(snap.meta[j], false);
+            std::cerr << "创建快照失败：没有足够的空闲块" << std::endl;
+            return false;
+        }
+        set_block_bitmap(b, true);
+        snap.meta[i] = (uint32_t)b;
+    }
+    // 快照的根目录inode指向自己的目录副本
+    table[0].blocks[0] = snap.meta[SNAP_INODE_BLOCKS];
+    const char* bytes = (const char*)table.data();
+    bool ok = true;
+    for (uint32_t i = 0; i < SNAP_INODE_BLOCKS; i++) {
+        ok = write_block(snap.meta[i], bytes + (size_t)i * BLOCK_SIZE) && ok;
+    }
+    ok = write_block(snap.meta[SNAP_INODE_BLOCKS], dir) && ok;
+    if (!ok) {
+        for (uint32_t i = 0; i < SNAP_META_BLOCKS; i++) release_block(snap.meta[i]);
+        std::cerr << "创建快照失败：写入快照元数据失败" << std::endl;
+        return false;
+    }
+
+    uint32_t data_end = super_block.data_start + super_block.data_blocks;
+    for_each_file_block(table, super_block.data_start, data_end, [this](uint32_t b) { dedup->add_ref(b); });
+    for (size_t n = 1; n < table.size(); n++) snap.files += table[n].used && table[n].type == 1;
+    strncpy(snap.name, name.c_str(), SNAP_NAME_LEN - 1);
+    snap.valid = 1;
+    snap.create_time = time(nullptr);
+    snapshots[slot] = snap;
+    return snap_save();
+}
+
+/**
+ * @brief 删除快照：先从快照目录移除，再释放它持有的引用（中途失败只会留下fsck可回收的块）
+ */
+bool DiskFS::snapshot_delete(const std::string& name)
+{
+    IoBatch batch(*this);
+    if (!snap_check("删除快照")) return false;
+    int idx = snap_find(name);
+    if (idx == -1) {
+        std::cerr << "删除快照失败：" << name << " 不存在" << std::endl;
+        return false;
+    }
+    SnapEntry snap = snapshots[idx];
+    std::vector<Inode> table;
+    if (!snap_load(snap, table)) return false;
+    memset(&snapshots[idx], 0, sizeof(SnapEntry));
+    if (!snap_save()) return false;
+
+    uint32_t data_end = super_block.data_start + super_block.data_blocks;
+    for_each_file_block(table, super_block.data_start, data_end, [this](uint32_t b) { release_block(b); });
+    for (uint32_t i = 0; i < SNAP_META_BLOCKS; i++) release_block(snap.meta[i]);
+    return true;
+}
+
+/**
+ * @brief 回滚到快照：inode区与根目录换成快照的副本，只调整引用计数（快照保留，可再次回滚）
+ */
+bool DiskFS::snapshot_rollback(const std::string& name)
+{
+    IoBatch batch(*this);
+    if (!snap_check("回滚快照")) return false;
+    int idx = snap_find(name);
+    if (idx == -1) {
+        std::cerr << "回滚快照失败：" << name << " 不存在" << std::endl;
+        return false;
+    }
+    std::vector<Inode> snap, live;
+    char dir[BLOCK_SIZE];
+    if (!snap_load(snapshots[idx], snap) || !read_inode_table(live) ||
+        !read_block(snapshots[idx].meta[SNAP_INODE_BLOCKS], dir)) {
+        return false;
+    }
+
+    // 先为快照的内容增加引用，再释放当前内容的引用：两边共享的块不会中途降到0
+    uint32_t data_start = super_block.data_start;
+    uint32_t data_end = data_start + super_block.data_blocks;
+    for_each_file_block(snap, data_start, data_end, [this](uint32_t b) { dedup->add_ref(b); });
+    for_each_file_block(live, data_start, data_end, [this](uint32_t b) { release_block(b); });
+
+    // 根目录继续使用当前的目录块，内容换成快照的目录副本（目录索引随块写更新）
+    uint32_t dir_block = live[0].blocks[0];
+    snap[0].blocks[0] = dir_block;
+    bool ok = write_block(dir_block, dir);
+    for (uint32_t n = 0; n < super_block.total_inodes; n++) {
+        if (memcmp(&snap[n], &live[n], sizeof(Inode)) == 0) continue;
+        ok = write_inode(n, snap[n]) && ok;
+        if (n > 0 && snap[n].used != live[n].used) ok = set_inode_bitmap(n, snap[n].used) && ok;
+    }
+    cluster_cache.clear();
+    if (!ok) std::cerr << "回滚快照：部分元数据写入失败" << std::endl;
+    return ok;
+}
+
+std::vector<SnapEntry> DiskFS::list_snapshots() const
+{
+    std::vector<SnapEntry> out;
+    for (const SnapEntry& snap : snapshots) {
+        if (snap.valid) out.push_back(snap);
+    }
+    return out;
+}
+
+/**
+ * @brief 只读挂载快照：之后inode从快照的inode表读取，文件名在快照的根目录副本中查找
+ */
+bool DiskFS::mount_snapshot(const std::string& name)
+{
+    if (is_mounted) {
+        std::cerr << "挂载快照失败：请先卸载磁盘" << std::endl;
+        return false;
+    }
+    if (!mount(false, true)) return false;
+    int idx = snap_find(name);
+    std::vector<Inode> table;
+    if (idx == -1 || !snap_load(snapshots[idx], table)) {
+        std::cerr << "挂载快照失败：" << name << " 不存在或无法读取" << std::endl;
+        unmount();
+        return false;
+    }
+    snap_view.swap(table);
+    meta.reset();  // 目录索引属于当前文件系统
+    return true;
+}
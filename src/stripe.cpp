@@ -0,0 +1,274 @@
+#include "../include/stripe.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <random>
+#include <unistd.h>
+
+static_assert(STRIPE_TABLE_OFFSET >= MOUNT_CKPT_OFFSET + sizeof(MountCheckpoint), "条带表不能与挂载检查点重叠");
+static_assert(STRIPE_TABLE_OFFSET + sizeof(StripeTable) <= BLOCK_SIZE, "条带表必须放在0号块内");
+
+StripeSet::StripeSet(uint32_t block_size, uint32_t unit_blocks, uint64_t total_blocks)
+    : block_size(block_size), unit(std::max(1u, unit_blocks)), unit_bytes((uint64_t)unit * block_size),
+      total_blocks(total_blocks), member_size(0), parallel(0), writing(false), outstanding(0), failed(false),
+      stopping(false)
+{
+}
+
+StripeSet::~StripeSet()
+{
+    close_all();
+}
+
+void StripeSet::close_all()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        task_cv.notify_all();
+    }
+    for (Member* m : members) {
+        if (m->worker.joinable()) m->worker.join();
+        if (m->fd >= 0) ::close(m->fd);
+        delete m;
+    }
+    members.clear();
+}
+
+/**
+ * @brief 打开全部成员文件并启动各成员的工作线程
+ * @param paths 成员路径（0号为主镜像）
+ * @param set_id 条带集编号
+ * @param create true：格式化时调用，设置成员文件大小并写入标签；false：挂载时调用，校验标签
+ * @return 成功返回true；打开失败或标签不匹配返回false
+ */
+bool StripeSet::open(const std::vector<std::string>& paths, uint64_t set_id, bool create)
+{
+    uint64_t group = (uint64_t)unit * paths.size();
+    member_size = (total_blocks + group - 1) / group * unit_bytes;
+
+    for (uint32_t i = 0; i < paths.size(); i++) {
+        Member* m = new Member();
+        m->path = paths[i];
+        m->ios = 0;
+        m->fd = ::open(paths[i].c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0644);
+        members.push_back(m);
+        if (m->fd < 0) {
+            std::cerr << "条带成员 " << paths[i] << " 打开失败（" << strerror(errno) << "）" << std::endl;
+            close_all();
+            return false;
+        }
+
+        StripeLabel label;
+        if (create) {
+            memset(&label, 0, sizeof(label));
+            memcpy(label.magic, STRIPE_MAGIC, sizeof(label.magic));
+            label.set_id = set_id;
+            label.index = i;
+            label.count = paths.size();
+            label.unit_blocks = unit;
+            if (ftruncate(m->fd, member_size + sizeof(label)) != 0 ||
+                pwrite(m->fd, &label, sizeof(label), member_size) != (ssize_t)sizeof(label)) {
+                std::cerr << "条带成员 " << paths[i] << " 初始化失败（" << strerror(errno) << "）" << std::endl;
+                close_all();
+                return false;
+            }
+        } else if (pread(m->fd, &label, sizeof(label), member_size) != (ssize_t)sizeof(label) ||
+                   memcmp(label.magic, STRIPE_MAGIC, sizeof(label.magic)) != 0 || label.set_id != set_id ||
+                   label.index != i || label.count != paths.size() || label.unit_blocks != unit) {
+            std::cerr << "条带成员 " << paths[i] << " 不属于该条带集或序号不符" << std::endl;
+            close_all();
+            return false;
+        }
+    }
+    stopping = false;
+    for (Member* m : members) {
+        m->worker = std::thread(&StripeSet::worker_loop, this, m);
+    }
+    return true;
+}
+
+bool StripeSet::read(uint64_t pos, char* buffer, size_t len)
+{
+    return io(pos, buffer, len, false);
+}
+
+bool StripeSet::write(uint64_t pos, const char* buffer, size_t len)
+{
+    return io(pos, const_cast<char*>(buffer), len, true);
+}
+
+/**
+ * @brief 把逻辑I/O按条带单元拆成各成员的子I/O；涉及多个成员时并行执行
+ */
+bool StripeSet::io(uint64_t pos, char* buffer, size_t len, bool is_write)
+{
+    uint32_t n = members.size();
+    std::vector<uint32_t> involved;
+    while (len > 0) {
+        uint64_t su = pos / unit_bytes;
+        uint64_t in_unit = pos % unit_bytes;
+        size_t chunk = (size_t)std::min<uint64_t>(len, unit_bytes - in_unit);
+        Member* m = members[su % n];
+        if (m->pending.empty()) involved.push_back(su % n);
+        Segment seg = {(su / n) * unit_bytes + in_unit, buffer, chunk};
+        m->pending.push_back(seg);
+        pos += chunk;
+        buffer += chunk;
+        len -= chunk;
+    }
+    if (involved.empty()) return true;
+
+    if (involved.size() == 1) {
+        Member* m = members[involved[0]];
+        bool ok = run_segments(m->fd, m->pending, is_write);
+        m->ios += m->pending.size();
+        m->pending.clear();
+        return ok;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    writing = is_write;
+    failed = false;
+    outstanding = involved.size();
+    for (uint32_t i : involved) {
+        Member* m = members[i];
+        m->ios += m->pending.size();
+        m->tasks.push_back(std::move(m->pending));
+        m->pending.clear();
+    }
+    task_cv.notify_all();
+    done_cv.wait(lock, [this]() { return outstanding == 0; });
+    parallel++;
+    return !failed;
+}
+
+bool StripeSet::run_segments(int fd, const std::vector<Segment>& segs, bool is_write)
+{
+    for (const Segment& seg : segs) {
+        size_t done = 0;
+        while (done < seg.len) {
+            ssize_t n = is_write ? pwrite(fd, seg.buf + done, seg.len - done, seg.offset + done)
+                                 : pread(fd, seg.buf + done, seg.len - done, seg.offset + done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            done += n;
+        }
+    }
+    return true;
+}
+
+void StripeSet::worker_loop(Member* m)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        task_cv.wait(lock, [this, m]() { return !m->tasks.empty() || stopping; });
+        if (m->tasks.empty()) return;
+        std::vector<Segment> segs = std::move(m->tasks.front());
+        m->tasks.pop_front();
+        bool is_write = writing;
+        lock.unlock();
+        bool ok = run_segments(m->fd, segs, is_write);
+        lock.lock();
+        if (!ok) failed = true;
+        outstanding--;
+        if (outstanding == 0) done_cv.notify_all();
+    }
+}
+
+/**
+ * @brief 设置下次格式化使用的条带配置
+ * @param members 0号镜像（构造时给出的路径）之外的成员路径，为空表示单镜像
+ * @param unit_blocks 条带单元（块）
+ * @return 成员数或路径长度超出限制返回false
+ */
+bool DiskFS::set_stripe(const std::vector<std::string>& members, uint32_t unit_blocks)
+{
+    if (members.size() + 1 > STRIPE_MAX_MEMBERS || (!members.empty() && unit_blocks == 0)) {
+        std::cerr << "条带配置无效：最多" << STRIPE_MAX_MEMBERS << "个成员，单元至少1块" << std::endl;
+        return false;
+    }
+    for (const auto& path : members) {
+        if (path.empty() || path.size() >= STRIPE_PATH_MAX || path == disk_path) {
+            std::cerr << "条带成员路径无效: " << path << std::endl;
+            return false;
+        }
+    }
+    stripe_members = members;
+    stripe_unit_blocks = unit_blocks;
+    return true;
+}
+
+/**
+ * @brief 格式化时按set_stripe的配置创建条带集，在超级块与条带表中记录几何
+ * 单镜像时写入空条带表，清除旧条带集留下的记录
+ */
+bool DiskFS::stripe_create()
+{
+    StripeTable table;
+    memset(&table, 0, sizeof(table));
+    super_block.stripe_count = stripe_members.empty() ? 0 : stripe_members.size() + 1;
+    super_block.stripe_unit = stripe_members.empty() ? 0 : stripe_unit_blocks;
+    if (super_block.stripe_count > 1) {
+        std::random_device rd;
+        memcpy(table.magic, STRIPE_MAGIC, sizeof(table.magic));
+        table.count = super_block.stripe_count;
+        table.unit_blocks = super_block.stripe_unit;
+        table.set_id = ((uint64_t)rd() << 32) ^ rd() ^ (uint64_t)time(nullptr);
+        std::vector<std::string> paths(1, disk_path);
+        for (size_t i = 0; i < stripe_members.size(); i++) {
+            strncpy(table.paths[i + 1], stripe_members[i].c_str(), STRIPE_PATH_MAX - 1);
+            paths.push_back(stripe_members[i]);
+        }
+        disk_file.flush();
+        stripe.reset(new StripeSet(BLOCK_SIZE, table.unit_blocks, super_block.total_blocks));
+        if (!stripe->open(paths, table.set_id, true)) {
+            stripe.reset();
+            return false;
+        }
+    }
+    return raw_write(STRIPE_TABLE_OFFSET, (const char*)&table, sizeof(table));
+}
+
+/**
+ * @brief 挂载时按超级块中的条带几何与0号块内的条带表打开全部成员并校验标签
+ * @return 单镜像或组装成功返回true
+ */
+bool DiskFS::stripe_attach()
+{
+    if (super_block.stripe_count <= 1) return true;
+    StripeTable table;
+    if (!raw_read(STRIPE_TABLE_OFFSET, (char*)&table, sizeof(table)) ||
+        memcmp(table.magic, STRIPE_MAGIC, sizeof(table.magic)) != 0 || table.count != super_block.stripe_count ||
+        table.count > STRIPE_MAX_MEMBERS || table.unit_blocks != super_block.stripe_unit) {
+        std::cerr << "挂载失败：条带表无效" << std::endl;
+        return false;
+    }
+    std::vector<std::string> paths(1, disk_path);
+    for (uint32_t i = 1; i < table.count; i++) {
+        table.paths[i][STRIPE_PATH_MAX - 1] = '\0';
+        paths.push_back(table.paths[i]);
+    }
+    stripe.reset(new StripeSet(BLOCK_SIZE, table.unit_blocks, super_block.total_blocks));
+    if (!stripe->open(paths, table.set_id, false)) {
+        stripe.reset();
+        return false;
+    }
+    return true;
+}
+
+void DiskFS::print_stripe_info() const
+{
+    if (!stripe) return;
+    std::cout << "条带化:\n";
+    std::cout << "  成员: " << stripe->count() << "，单元: " << stripe->unit_blocks() << " 块（"
+              << stripe->unit_blocks() * BLOCK_SIZE / 1024 << "KB），每成员 " << stripe->member_bytes() / (1024 * 1024)
+              << "MB，并行I/O: " << stripe->parallel_ios() << "\n";
+    for (uint32_t i = 0; i < stripe->count(); i++) {
+        std::cout << "  [" << i << "] " << stripe->member_path(i) << "，子I/O " << stripe->member_ios(i) << "\n";
+    }
+}
@@ -0,0 +1,512 @@
+#include "../include/tier.h"
+#include "../include/disk_fs.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(TIER_INFO_OFFSET >= STRIPE_TABLE_OFFSET + sizeof(StripeTable), "分层信息不能与条带表重叠");
+static_assert(TIER_INFO_OFFSET + sizeof(TierInfo) <= BLOCK_SIZE, "分层信息必须放在0号块内");
+
+/**
+ * @brief 在一个后端文件上完整地读写一段（处理短读写与EINTR）
+ */
+static bool transfer(int fd, uint64_t offset, char* buf, size_t len, bool is_write)
+{
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = is_write ? pwrite(fd, buf + done, len - done, offset + done)
+                             : pread(fd, buf + done, len - done, offset + done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+TierSet::TierSet(uint32_t block_size, uint32_t total_blocks, uint32_t pinned_blocks, uint32_t fast_blocks)
+    : block_size(block_size), total_blocks(total_blocks), pinned_blocks(pinned_blocks), fast_blocks(fast_blocks),
+      table_blocks(0), slow_fd(-1), fast_fd(-1), set_id(0), loaded_clean(true), read_only(false), st(),
+      stopping(false)
+{
+}
+
+TierSet::~TierSet()
+{
+    close(false);
+}
+
+/**
+ * @brief 计算快速层的映射表块数与槽位数
+ * @return 快速层除固定区与映射表外至少还有一个槽位时返回true
+ */
+bool TierSet::layout(uint32_t pinned_blocks, uint32_t fast_blocks, uint32_t block_size, uint32_t& table_blocks,
+                     uint32_t& slots)
+{
+    if (fast_blocks < pinned_blocks + 2) return false;
+    uint32_t avail = fast_blocks - pinned_blocks;
+    table_blocks = 1;
+    while (table_blocks < avail &&
+           sizeof(TierHeader) + (uint64_t)(avail - table_blocks) * sizeof(uint32_t) > (uint64_t)table_blocks * block_size) {
+        table_blocks++;
+    }
+    slots = avail - table_blocks;
+    return slots > 0;
+}
+
+/**
+ * @brief 打开容量层与快速层文件
+ * @param set_id 分层集编号（写入/校验快速层表头）
+ * @param create true：格式化时调用，清空快速层并写入空映射表；false：挂载时调用，校验表头并加载槽位映射
+ * @param read_only 只读打开两层文件，不写表头、不迁移
+ * @return 成功返回true；打开失败、快速层太小或表头不匹配返回false
+ */
+bool TierSet::open(const std::string& capacity_path, const std::string& fast_path, uint64_t set_id, bool create,
+                   bool read_only)
+{
+    uint32_t slots = 0;
+    if (!layout(pinned_blocks, fast_blocks, block_size, table_blocks, slots)) {
+        std::cerr << "快速层太小：至少需要 " << pinned_blocks + 2 << " 块" << std::endl;
+        return false;
+    }
+    this->set_id = set_id;
+    this->read_only = read_only;
+    fast_file = fast_path;
+    int flags = (read_only ? O_RDONLY : O_RDWR) | O_CLOEXEC;
+    slow_fd = ::open(capacity_path.c_str(), flags);
+    fast_fd = ::open(fast_path.c_str(), flags | (create ? O_CREAT : 0), 0644);
+    if (slow_fd < 0 || fast_fd < 0) {
+        std::cerr << "分层文件 " << (slow_fd < 0 ? capacity_path : fast_path) << " 打开失败（" << strerror(errno)
+                  << "）" << std::endl;
+        close(false);
+        return false;
+    }
+
+    slot_block.assign(slots, 0);
+    slot_dirty.assign(slots, 0);
+    block_slot.assign(total_blocks, -1);
+    heat.assign(total_blocks, 0);
+    free_slots.clear();
+    st = TierStats();
+
+    std::vector<char> table((size_t)table_blocks * block_size, 0);
+    TierHeader* header = (TierHeader*)table.data();
+    uint32_t* entries = (uint32_t*)(table.data() + sizeof(TierHeader));
+    if (create) {
+        // 快速层清零到指定大小；容量层至少覆盖全部逻辑块，读未写过的块时不会越过文件末尾
+        struct stat sb;
+        if (ftruncate(fast_fd, 0) != 0 || ftruncate(fast_fd, (off_t)fast_blocks * block_size) != 0 ||
+            fstat(slow_fd, &sb) != 0 ||
+            (sb.st_size < (off_t)total_blocks * block_size && ftruncate(slow_fd, (off_t)total_blocks * block_size) != 0)) {
+            std::cerr << "分层文件初始化失败（" << strerror(errno) << "）" << std::endl;
+            close(false);
+            return false;
+        }
+        memcpy(header->magic, TIER_MAGIC, sizeof(header->magic));
+        header->set_id = set_id;
+        header->clean = 0;
+        header->pinned_blocks = pinned_blocks;
+        header->slots = slots;
+        if (!transfer(fast_fd, (uint64_t)pinned_blocks * block_size, table.data(), table.size(), true)) {
+            std::cerr << "快速层映射表写入失败" << std::endl;
+            close(false);
+            return false;
+        }
+    } else {
+        if (!transfer(fast_fd, (uint64_t)pinned_blocks * block_size, table.data(), table.size(), false) ||
+            memcmp(header->magic, TIER_MAGIC, sizeof(header->magic)) != 0 || header->set_id != set_id ||
+            header->pinned_blocks != pinned_blocks || header->slots != slots) {
+            std::cerr << "快速层 " << fast_path << " 不属于该文件系统或大小不符" << std::endl;
+            close(false);
+            return false;
+        }
+        loaded_clean = header->clean == 1;
+        for (uint32_t s = 0; s < slots; s++) {
+            uint32_t b = entries[s];
+            if (b == 0) continue;
+            if (b < pinned_blocks || b >= total_blocks || block_slot[b] >= 0) {
+                std::cerr << "快速层映射表损坏（槽位 " << s << "）" << std::endl;
+                close(false);
+                return false;
+            }
+            slot_block[s] = b;
+            slot_dirty[s] = 1;  // 是否比容量层新没有持久化，一律按脏块处理，降级时写回
+            block_slot[b] = s;
+        }
+    }
+    for (uint32_t s = slots; s-- > 0;) {
+        if (slot_block[s] == 0) free_slots.push_back(s);
+    }
+    // 挂载期间表头标记为未干净卸载
+    if (!read_only && !create && !save_header(false)) {
+        close(false);
+        return false;
+    }
+    return true;
+}
+
+bool TierSet::read(uint64_t pos, char* buffer, size_t len, size_t& fast_len)
+{
+    return io(pos, buffer, len, false, fast_len);
+}
+
+bool TierSet::write(uint64_t pos, const char* buffer, size_t len, size_t& fast_len)
+{
+    return io(pos, const_cast<char*>(buffer), len, true, fast_len);
+}
+
+uint64_t TierSet::slot_pos(uint32_t slot) const
+{
+    return ((uint64_t)pinned_blocks + table_blocks + slot) * block_size;
+}
+
+/**
+ * @brief 把逻辑I/O按块路由到两层：固定区与驻留块走快速层，其余走容量层；
+ * 同一文件上偏移连续的相邻块合并为一次子I/O
+ */
+bool TierSet::io(uint64_t pos, char* buffer, size_t len, bool is_write, size_t& fast_len)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    fast_len = 0;
+    int run_fd = -1;
+    uint64_t run_off = 0;
+    char* run_buf = buffer;
+    size_t run_len = 0;
+    while (len > 0) {
+        uint64_t block = pos / block_size;
+        uint32_t in_block = pos % block_size;
+        size_t chunk = std::min<size_t>(len, block_size - in_block);
+        int fd = slow_fd;
+        uint64_t off = pos;
+        if (block < pinned_blocks) {
+            fd = fast_fd;
+        } else if (block < total_blocks) {
+            if (heat[block] < UINT16_MAX) heat[block]++;
+            st.data_accesses++;
+            int32_t slot = block_slot[block];
+            if (slot >= 0) {
+                fd = fast_fd;
+                off = slot_pos(slot) + in_block;
+                if (is_write) slot_dirty[slot] = 1;
+                st.data_hits++;
+            }
+        }
+        if (fd == fast_fd) fast_len += chunk;
+
+        if (run_len > 0 && fd == run_fd && off == run_off + run_len) {
+            run_len += chunk;
+        } else {
+            if (run_len > 0) {
+                if (!transfer(run_fd, run_off, run_buf, run_len, is_write)) return false;
+                (run_fd == fast_fd ? st.fast_ios : st.slow_ios)++;
+            }
+            run_fd = fd;
+            run_off = off;
+            run_buf = buffer;
+            run_len = chunk;
+        }
+        pos += chunk;
+        buffer += chunk;
+        len -= chunk;
+    }
+    if (run_len == 0) return true;
+    if (!transfer(run_fd, run_off, run_buf, run_len, is_write)) return false;
+    (run_fd == fast_fd ? st.fast_ios : st.slow_ios)++;
+    return true;
+}
+
+/**
+ * @brief 块被释放：内容不再需要，清零热度并直接腾出其槽位（不写回）
+ */
+void TierSet::discard(uint32_t block)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (block < pinned_blocks || block >= total_blocks) return;
+    heat[block] = 0;
+    int32_t slot = block_slot[block];
+    if (slot < 0 || read_only) return;
+    block_slot[block] = -1;
+    slot_block[slot] = 0;
+    slot_dirty[slot] = 0;
+    free_slots.push_back(slot);
+    save_slot(slot);
+}
+
+bool TierSet::save_slot(uint32_t slot)
+{
+    uint64_t off = (uint64_t)pinned_blocks * block_size + sizeof(TierHeader) + (uint64_t)slot * sizeof(uint32_t);
+    return transfer(fast_fd, off, (char*)&slot_block[slot], sizeof(uint32_t), true);
+}
+
+bool TierSet::save_header(bool clean)
+{
+    TierHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TIER_MAGIC, sizeof(header.magic));
+    header.set_id = set_id;
+    header.clean = clean ? 1 : 0;
+    header.pinned_blocks = pinned_blocks;
+    header.slots = slot_block.size();
+    return transfer(fast_fd, (uint64_t)pinned_blocks * block_size, (char*)&header, sizeof(header), true);
+}
+
+bool TierSet::move_block(int from_fd, uint64_t from, int to_fd, uint64_t to)
+{
+    std::vector<char> buf(block_size);
+    return transfer(from_fd, from, buf.data(), block_size, false) && transfer(to_fd, to, buf.data(), block_size, true);
+}
+
+/**
+ * @brief 执行一轮迁移：热度达到阈值的容量层块按热度从高到低提升到快速层；
+ * 没有空闲槽位时替换最冷的驻留块（其热度的2倍仍低于候选块才替换，避免来回搬移），结束后全部热度减半
+ * @param max_moves 本轮最多提升的块数
+ * @return 本轮提升的块数
+ * 候选块在锁外选出，每次搬移单独加锁并重新确认，前台I/O只在单次搬移期间等待
+ * 顺序保证异常退出后映射表总是可用：提升先复制数据再登记槽位，降级先写回再清除槽位
+ */
+uint32_t TierSet::migrate(uint32_t max_moves)
+{
+    if (read_only || fast_fd < 0) return 0;
+    std::vector<uint32_t> candidates;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (uint32_t b = pinned_blocks; b < total_blocks; b++) {
+            if (block_slot[b] < 0 && heat[b] >= TIER_PROMOTE_HEAT) candidates.push_back(b);
+        }
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [this](uint32_t a, uint32_t b) { return heat[a] > heat[b]; });
+        if (candidates.size() > max_moves) candidates.resize(max_moves);
+    }
+
+    uint32_t moved = 0;
+    for (uint32_t b : candidates) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (block_slot[b] >= 0 || heat[b] < TIER_PROMOTE_HEAT) continue;
+        uint32_t slot;
+        if (!free_slots.empty()) {
+            slot = free_slots.back();
+            free_slots.pop_back();
+        } else {
+            uint32_t victim_slot = 0;
+            for (uint32_t s = 1; s < slot_block.size(); s++) {
+                if (heat[slot_block[s]] < heat[slot_block[victim_slot]]) victim_slot = s;
+            }
+            uint32_t victim = slot_block[victim_slot];
+            if ((uint32_t)heat[victim] * 2 >= heat[b]) break;  // 其余候选更冷，本轮结束
+            if (slot_dirty[victim_slot] &&
+                !move_block(fast_fd, slot_pos(victim_slot), slow_fd, (uint64_t)victim * block_size)) {
+                break;
+            }
+            if (slot_dirty[victim_slot]) st.writebacks++;
+            block_slot[victim] = -1;
+            slot_block[victim_slot] = 0;
+            slot_dirty[victim_slot] = 0;
+            save_slot(victim_slot);
+            st.demotions++;
+            slot = victim_slot;
+        }
+        if (!move_block(slow_fd, (uint64_t)b * block_size, fast_fd, slot_pos(slot))) {
+            free_slots.push_back(slot);
+            break;
+        }
+        slot_block[slot] = b;
+        slot_dirty[slot] = 0;
+        block_slot[b] = slot;
+        save_slot(slot);
+        st.promotions++;
+        moved++;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& h : heat) h >>= 1;
+    st.passes++;
+    return moved;
+}
+
+void TierSet::start_migrator(uint32_t interval_ms)
+{
+    if (read_only || interval_ms == 0 || migrator.joinable()) return;
+    stopping = false;
+    migrator = std::thread(&TierSet::migrator_loop, this, interval_ms);
+}
+
+void TierSet::migrator_loop(uint32_t interval_ms)
+{
+    std::unique_lock<std::mutex> lock(thread_mutex);
+    while (!stopping) {
+        thread_cv.wait_for(lock, std::chrono::milliseconds(interval_ms), [this]() { return stopping; });
+        if (stopping) break;
+        lock.unlock();
+        migrate(TIER_MOVES_PER_PASS);
+        lock.lock();
+    }
+}
+
+void TierSet::stop_migrator()
+{
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex);
+        stopping = true;
+    }
+    thread_cv.notify_all();
+    if (migrator.joinable()) migrator.join();
+}
+
+/**
+ * @brief 停止迁移线程并关闭两层文件
+ * @param clean true：写入干净卸载的表头，并把快速层的0号块复制到容量层作为下次挂载的引导副本
+ * @return 写入成功（或无需写入）返回true
+ */
+bool TierSet::close(bool clean)
+{
+    stop_migrator();
+    bool ok = true;
+    if (clean && !read_only && fast_fd >= 0 && slow_fd >= 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ok = save_header(true) && move_block(fast_fd, 0, slow_fd, 0);
+    }
+    if (slow_fd >= 0) ::close(slow_fd);
+    if (fast_fd >= 0) ::close(fast_fd);
+    slow_fd = fast_fd = -1;
+    return ok;
+}
+
+uint32_t TierSet::resident() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return slot_block.size() - free_slots.size();
+}
+
+TierStats TierSet::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return st;
+}
+
+/**
+ * @brief 设置下次格式化使用的快速层
+ * @param fast_path 快速层文件路径（为空表示不分层）
+ * @param fast_blocks 快速层块数（固定区 + 映射表 + 热块槽位）
+ * @param migrate_ms 后台迁移间隔（毫秒，0表示只在tier migrate时迁移；挂载时生效）
+ * @return 路径无效返回false
+ */
+bool DiskFS::set_tier(const std::string& fast_path, uint32_t fast_blocks, uint32_t migrate_ms)
+{
+    if (!fast_path.empty() && (fast_path.size() >= TIER_PATH_MAX || fast_path == disk_path || fast_blocks == 0)) {
+        std::cerr << "分层配置无效: " << fast_path << std::endl;
+        return false;
+    }
+    tier_fast_path = fast_path;
+    tier_fast_size = fast_path.empty() ? 0 : fast_blocks;
+    tier_migrate_ms = migrate_ms;
+    return true;
+}
+
+/**
+ * @brief 格式化时按set_tier的配置创建分层集，在超级块与分层信息中记录快速层
+ * 不分层时写入空的分层信息，清除旧分层集留下的记录；日志布局与条带化不支持分层
+ */
+bool DiskFS::tier_create(bool log_structured)
+{
+    TierInfo info;
+    memset(&info, 0, sizeof(info));
+    super_block.tier_fast_blocks = 0;
+    if (!tier_fast_path.empty()) {
+        if (log_structured || stripe) {
+            std::cerr << "冷热分层只支持单镜像的原地布局" << std::endl;
+            return false;
+        }
+        std::random_device rd;
+        memcpy(info.magic, TIER_MAGIC, sizeof(info.magic));
+        info.set_id = ((uint64_t)rd() << 32) ^ rd() ^ (uint64_t)time(nullptr);
+        strncpy(info.fast_path, tier_fast_path.c_str(), TIER_PATH_MAX - 1);
+        super_block.tier_fast_blocks = tier_fast_size;
+        disk_file.flush();
+        tier.reset(new TierSet(BLOCK_SIZE, super_block.total_blocks, super_block.data_start + 1, tier_fast_size));
+        if (!tier->open(disk_path, tier_fast_path, info.set_id, true, false)) {
+            tier.reset();
+            return false;
+        }
+        tier_device.reset(DeviceModel::create("ssd", 0));
+    }
+    return raw_write(TIER_INFO_OFFSET, (const char*)&info, sizeof(info));
+}
+
+/**
+ * @brief 挂载时按容量层0号块（引导副本）中的分层信息打开快速层，并从快速层重新读取最新的超级块
+ * @return 不分层或组装成功返回true
+ */
+bool DiskFS::tier_attach()
+{
+    if (super_block.tier_fast_blocks == 0) return true;
+    TierInfo info;
+    if (!raw_read(TIER_INFO_OFFSET, (char*)&info, sizeof(info)) ||
+        memcmp(info.magic, TIER_MAGIC, sizeof(info.magic)) != 0) {
+        std::cerr << "挂载失败：分层信息无效" << std::endl;
+        return false;
+    }
+    info.fast_path[TIER_PATH_MAX - 1] = '\0';
+    tier.reset(new TierSet(BLOCK_SIZE, super_block.total_blocks, super_block.data_start + 1,
+                           super_block.tier_fast_blocks));
+    if (!tier->open(disk_path, info.fast_path, info.set_id, false, read_only)) {
+        tier.reset();
+        return false;
+    }
+    tier_device.reset(DeviceModel::create("ssd", 0));
+    // 引导副本只在干净卸载时更新，计数等以快速层上的超级块为准
+    if (!raw_read(0, (char*)&super_block, sizeof(SuperBlock)) || !csum_check_super() ||
+        super_block.tier_fast_blocks == 0) {
+        std::cerr << "挂载失败：快速层上的超级块无效" << std::endl;
+        tier.reset();
+        return false;
+    }
+    tier->start_migrator(tier_migrate_ms);
+    return true;
+}
+
+/**
+ * @brief 关闭分层集：写入干净表头与引导副本（只读挂载只关闭文件）
+ */
+bool DiskFS::tier_detach()
+{
+    if (!tier) return true;
+    bool ok = tier->close(!read_only);
+    tier.reset();
+    return ok;
+}
+
+/**
+ * @brief 立即执行一轮迁移
+ * @return 提升的块数；未分层或只读挂载返回-1
+ */
+int DiskFS::tier_migrate()
+{
+    if (!tier) {
+        std::cerr << "未启用冷热分层" << std::endl;
+        return -1;
+    }
+    if (reject_read_only("迁移")) return -1;
+    if (!flush_io()) return -1;  // 排队的写先落到当前所在的层
+    return tier->migrate(TIER_MOVES_PER_PASS);
+}
+
+void DiskFS::print_tier_info() const
+{
+    if (!tier) return;
+    TierStats s = tier->stats();
+    std::cout << "冷热分层:\n";
+    std::cout << "  快速层: " << tier->fast_path() << "，固定区 " << tier->pinned() << " 块（超级块、位图、inode区、根目录），热块槽位 "
+              << tier->resident() << "/" << tier->slot_count() << (tier->recovered() ? "（上次未干净卸载）" : "") << "\n";
+    std::cout << "  数据块访问: " << s.data_accesses << "，快速层命中率: " << std::fixed << std::setprecision(1)
+              << (s.data_accesses ? 100.0 * s.data_hits / s.data_accesses : 0.0) << "%，子I/O 快速层 " << s.fast_ios
+              << " / 容量层 " << s.slow_ios << "\n";
+    std::cout << "  提升: " << s.promotions << "，降级: " << s.demotions << "（写回 " << s.writebacks << "），迁移轮数: " << s.passes
+              << "\n";
+}
@@ -1,7 +1,21 @@
 #include "../include/disk_fs.h"
+#include "../include/ftl_model.h"
+#include "../include/command_parser.h"
+#include "../include/disk_server.h"
+#include "../include/disk_client.h"
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
 
 bool run_tests(DiskFS& disk) 
 {
@@ -86,6 +100,981 @@ bool run_tests(DiskFS& disk)
     std::cout << "测试" << test_count << "(卸载): " << (unmount_ok ? "通过" : "失败") << std::endl;
     if (unmount_ok) pass_count++;
 
+    // 测试11: I/O统计（块读写计数与操作延迟直方图）
+    test_count++;
+    StatsSnapshot stats = disk.get_stats();
+    bool stats_ok = stats.counters[STAT_BLOCK_WRITES] > 0 && stats.counters[STAT_BLOCK_READS] > 0 &&
+                    stats.latency[STAT_OP_WRITE].count >= 1 && stats.latency[STAT_OP_READ].count >= 1 &&
+                    stats.latency[STAT_OP_READ].percentile(0.99) > 0;
+#ifdef DISKFS_NO_STATS
+    stats_ok = true;  // 统计被编译掉时不检查
+#endif
+    std::cout << "测试" << test_count << "(I/O统计): " << (stats_ok ? "通过" : "失败") << std::endl;
+    if (stats_ok) pass_count++;
+
+    // 测试12: I/O追踪（文件操作与块读写记录落盘，文件头有效）
+    test_count++;
+    bool trace_ok = disk.mount() && disk.start_trace("test_trace.bin");
+    int trace_inode = disk.create_file("trace.txt");
+    trace_ok = trace_ok && trace_inode != -1 &&
+               disk.write_file(trace_inode, content.c_str(), content.size(), 0) == (int)content.size();
+    uint64_t trace_records = disk.stop_trace();
+    trace_ok = trace_ok && trace_records >= 3;
+    FILE* trace_file = fopen("test_trace.bin", "rb");
+    TraceHeader trace_header;
+    trace_ok = trace_ok && trace_file && fread(&trace_header, sizeof(trace_header), 1, trace_file) == 1 &&
+               memcmp(trace_header.magic, TRACE_MAGIC, sizeof(trace_header.magic)) == 0 &&
+               trace_header.version == TRACE_VERSION;
+    if (trace_file) fclose(trace_file);
+    remove("test_trace.bin");
+    disk.delete_file("trace.txt");
+    disk.unmount();
+    std::cout << "测试" << test_count << "(I/O追踪): " << (trace_ok ? "通过" : "失败") << std::endl;
+    if (trace_ok) pass_count++;
+
+    // 测试13: HDD设备模型（碎片化文件的模拟读取时间高于连续文件）
+    test_count++;
+    bool device_ok = disk.mount() && disk.set_device_model("hdd");
+    int contig = disk.create_file("contig.bin");
+    int frag_a = disk.create_file("frag_a.bin");
+    int frag_b = disk.create_file("frag_b.bin");
+    std::vector<char> block_data(BLOCK_SIZE * 8, 'd');
+    device_ok = device_ok && contig != -1 && frag_a != -1 && frag_b != -1 &&
+                disk.write_file(contig, block_data.data(), block_data.size(), 0) == (int)block_data.size();
+    for (int i = 0; i < 8 && device_ok; i++) {
+        // 交替写入两个文件，使它们的数据块相互穿插
+        device_ok = disk.write_file(frag_a, block_data.data(), BLOCK_SIZE, (off_t)i * BLOCK_SIZE) == BLOCK_SIZE &&
+                    disk.write_file(frag_b, block_data.data(), BLOCK_SIZE, (off_t)i * BLOCK_SIZE) == BLOCK_SIZE;
+    }
+    uint64_t t0 = disk.virtual_time_ns();
+    disk.read_file(contig, block_data.data(), block_data.size(), 0);
+    uint64_t t1 = disk.virtual_time_ns();
+    disk.read_file(frag_a, block_data.data(), block_data.size(), 0);
+    uint64_t t2 = disk.virtual_time_ns();
+    device_ok = device_ok && (t1 - t0) > 0 && (t2 - t1) > (t1 - t0);
+    disk.set_device_model("none");
+    disk.delete_file("contig.bin");
+    disk.delete_file("frag_a.bin");
+    disk.delete_file("frag_b.bin");
+    disk.unmount();
+    std::cout << "测试" << test_count << "(HDD设备模型): " << (device_ok ? "通过" : "失败") << std::endl;
+    if (device_ok) pass_count++;
+
+    // 测试14: I/O调度（批次内逐块写入的相邻块被合并，批次内可读到排队数据，卸载后数据落盘）
+    test_count++;
+    bool sched_ok = disk.mount() && disk.set_scheduler("clook");
+    int sched_inode = disk.create_file("sched.bin");
+    std::vector<char> sched_data(BLOCK_SIZE * 8);
+    for (size_t i = 0; i < sched_data.size(); i++) sched_data[i] = (char)('a' + i / BLOCK_SIZE);
+    disk.begin_batch();
+    for (int i = 0; i < 8 && sched_ok; i++) {
+        sched_ok = disk.write_file(sched_inode, sched_data.data() + i * BLOCK_SIZE, BLOCK_SIZE,
+                                   (off_t)i * BLOCK_SIZE) == BLOCK_SIZE;
+    }
+    std::vector<char> sched_read(sched_data.size());
+    sched_ok = sched_ok && disk.read_file(sched_inode, sched_read.data(), sched_read.size(), 0) == (int)sched_read.size() &&
+               sched_read == sched_data && disk.scheduler_stats().read_hits > 0;
+    sched_ok = disk.end_batch() && sched_ok;
+    const SchedStats& sched_stats = disk.scheduler_stats();
+    sched_ok = sched_ok && sched_stats.merged > 0 && sched_stats.dispatched < sched_stats.queued &&
+               sched_stats.absorbed > 0;
+    disk.unmount();
+    std::fill(sched_read.begin(), sched_read.end(), 0);
+    sched_ok = sched_ok && disk.mount() &&
+               disk.read_file(disk.open_file("sched.bin"), sched_read.data(), sched_read.size(), 0) == (int)sched_read.size() &&
+               sched_read == sched_data;
+    disk.set_scheduler("none");
+    disk.delete_file("sched.bin");
+    disk.unmount();
+    std::cout << "测试" << test_count << "(I/O调度合并): " << (sched_ok ? "通过" : "失败") << std::endl;
+    if (sched_ok) pass_count++;
+
+    // 测试15: FTL模型（覆盖写触发GC与擦除，删除文件后discard生效；全盘随机写的写放大>1）
+    test_count++;
+    bool ftl_ok = disk.mount() && disk.set_device_model("ftl");
+    const FtlModel* ftl = dynamic_cast<const FtlModel*>(disk.device_model());
+    int ftl_inode = disk.create_file("ftl.bin");
+    std::vector<char> ftl_data(BLOCK_SIZE * 16, 'f');
+    ftl_ok = ftl_ok && ftl && ftl_inode != -1;
+    for (int i = 0; i < 200 && ftl_ok; i++) {
+        ftl_ok = disk.write_file(ftl_inode, ftl_data.data(), ftl_data.size(), 0) == (int)ftl_data.size();
+    }
+    ftl_ok = ftl_ok && ftl->stats().gc_runs > 0 && ftl->stats().erases > 0 && ftl->write_amplification() >= 1.0;
+    disk.delete_file("ftl.bin");
+    ftl_ok = ftl_ok && ftl->stats().trimmed >= 16;
+    disk.set_device_model("none");
+    disk.unmount();
+    FtlModel random_ftl((uint64_t)MAX_BLOCKS * BLOCK_SIZE, 7, FTL_GC_GREEDY);
+    uint64_t ftl_now = 0;
+    for (uint32_t i = 0; i < 5000; i++) {
+        uint32_t lba = (i * 2654435761u) % MAX_BLOCKS;  // 乘法散列打散写入位置
+        ftl_now += random_ftl.service(DEV_WRITE, (uint64_t)lba * BLOCK_SIZE, BLOCK_SIZE, ftl_now);
+    }
+    ftl_ok = ftl_ok && random_ftl.stats().gc_moved > 0 && random_ftl.write_amplification() > 1.0;
+    std::cout << "测试" << test_count << "(FTL写放大): " << (ftl_ok ? "通过" : "失败") << std::endl;
+    if (ftl_ok) pass_count++;
+
+    // 测试16: 日志结构布局（覆盖写后重新挂载、清理段回收有效数据并使段变干净、清理后数据不变，最后恢复原地布局）
+    test_count++;
+    bool log_ok = disk.format(true) && disk.mount() && disk.is_log_structured();
+    std::vector<int> log_inodes;
+    std::vector<char> log_data(BLOCK_SIZE * 4);
+    for (int f = 0; f < 8 && log_ok; f++) {
+        int inode = disk.create_file("log" + std::to_string(f));
+        memset(log_data.data(), 'A' + f, log_data.size());
+        log_ok = inode != -1 && disk.write_file(inode, log_data.data(), log_data.size(), 0) == (int)log_data.size();
+        log_inodes.push_back(inode);
+    }
+    for (int i = 0; i < 400 && log_ok; i++) {
+        // 反复覆盖前两个文件的单个块，使早期的段只剩少量有效数据
+        memset(log_data.data(), 'a' + i % 26, BLOCK_SIZE);
+        log_ok = disk.write_file(log_inodes[i % 2], log_data.data(), BLOCK_SIZE, (off_t)(i / 2 % 4) * BLOCK_SIZE) == BLOCK_SIZE;
+    }
+    log_ok = log_ok && disk.log_stats() && disk.log_stats()->appends > 0;
+    log_ok = log_ok && disk.unmount() && disk.mount();
+    // 清理一段：被选中段的有效数据（含inode）全部搬走，干净段数增加
+    const LogState* log_st = log_ok ? disk.log_state() : nullptr;
+    int log_victim = log_st ? log_st->pick_victim() : -1;
+    uint32_t log_clean_before = log_st ? log_st->clean_segments() : 0;
+    log_ok = log_victim >= 0 && disk.clean_segments(1) == 1 && log_st->seg_live[log_victim] == 0 &&
+             log_st->clean_segments() > log_clean_before && log_st->st.cleaner_moved > 0;
+    log_ok = log_ok && disk.clean_segments(100) > 0 && disk.unmount() && disk.mount();
+    for (int f = 0; f < 8 && log_ok; f++) {
+        log_ok = disk.read_file(disk.open_file("log" + std::to_string(f)), log_data.data(), log_data.size(), 0) ==
+                 (int)log_data.size();
+        for (int b = 0; b < 4 && log_ok; b++) {
+            // 前两个文件的每个块取最后一次覆盖的内容，其余文件保持初始内容
+            char expect = 'A' + f;
+            if (f < 2) {
+                int last = 399;
+                while (last % 2 != f || last / 2 % 4 != b) last--;
+                expect = 'a' + last % 26;
+            }
+            log_ok = log_data[(size_t)b * BLOCK_SIZE] == expect;
+        }
+    }
+    disk.unmount();
+    disk.format();
+    std::cout << "测试" << test_count << "(日志结构布局): " << (log_ok ? "通过" : "失败") << std::endl;
+    if (log_ok) pass_count++;
+
+    // 测试17: 碎片整理（交替写入的两个文件按预算逐个整理为单个区段，数据不变，HDD顺序读变快）
+    test_count++;
+    bool defrag_ok = disk.mount() && disk.set_device_model("hdd");
+    int frag_x = disk.create_file("frag_x.bin");
+    int frag_y = disk.create_file("frag_y.bin");
+    std::vector<char> frag_data(BLOCK_SIZE * 8);
+    for (size_t i = 0; i < frag_data.size(); i++) frag_data[i] = (char)('0' + i / BLOCK_SIZE);
+    for (int i = 0; i < 8 && defrag_ok; i++) {
+        defrag_ok = frag_x != -1 && frag_y != -1 &&
+                    disk.write_file(frag_x, frag_data.data() + i * BLOCK_SIZE, BLOCK_SIZE, (off_t)i * BLOCK_SIZE) == BLOCK_SIZE &&
+                    disk.write_file(frag_y, frag_data.data() + i * BLOCK_SIZE, BLOCK_SIZE, (off_t)i * BLOCK_SIZE) == BLOCK_SIZE;
+    }
+    FragReport frag_before = disk.frag_report();
+    defrag_ok = defrag_ok && frag_before.fragmented_files == 2 && frag_before.avg_run() < 2;
+    std::vector<char> frag_read(frag_data.size());
+    uint64_t d0 = disk.virtual_time_ns();
+    disk.read_file(frag_x, frag_read.data(), frag_read.size(), 0);
+    uint64_t d1 = disk.virtual_time_ns();
+    defrag_ok = defrag_ok && disk.defrag("", 8) == 8 && disk.frag_report().fragmented_files == 1 &&
+                disk.defrag() == 8 && disk.frag_report().fragmented_files == 0;
+    uint64_t d2 = disk.virtual_time_ns();
+    std::fill(frag_read.begin(), frag_read.end(), 0);
+    defrag_ok = defrag_ok && disk.read_file(frag_x, frag_read.data(), frag_read.size(), 0) == (int)frag_read.size() &&
+                frag_read == frag_data;
+    uint64_t d3 = disk.virtual_time_ns();
+    defrag_ok = defrag_ok && (d3 - d2) < (d1 - d0);
+    disk.set_device_model("none");
+    disk.unmount();
+    std::fill(frag_read.begin(), frag_read.end(), 0);
+    defrag_ok = defrag_ok && disk.mount() &&
+                disk.read_file(disk.open_file("frag_y.bin"), frag_read.data(), frag_read.size(), 0) == (int)frag_read.size() &&
+                frag_read == frag_data;
+    disk.delete_file("frag_x.bin");
+    disk.delete_file("frag_y.bin");
+    disk.unmount();
+    std::cout << "测试" << test_count << "(碎片整理): " << (defrag_ok ? "通过" : "失败") << std::endl;
+    if (defrag_ok) pass_count++;
+
+    // 测试18: 一致性检查（篡改位图与空闲计数后检出孤儿块和计数偏差，修复后再次检查一致，文件数据不变）
+    test_count++;
+    bool fsck_ok = disk.mount();
+    int fsck_inode = disk.create_file("fsck.bin");
+    fsck_ok = fsck_ok && fsck_inode != -1 &&
+              disk.write_file(fsck_inode, frag_data.data(), frag_data.size(), 0) == (int)frag_data.size();
+    FsckReport fsck_rep;
+    fsck_ok = fsck_ok && disk.fsck(fsck_rep, false, 4) && fsck_rep.errors() == 0 && fsck_rep.threads == 4;
+    disk.unmount();
+    {
+        // 直接改写镜像：数据区后部的8个空闲块标记为已用，超级块空闲块数少记5
+        std::fstream img("test_disk.img", std::ios::in | std::ios::out | std::ios::binary);
+        SuperBlock sb;
+        img.read((char*)&sb, sizeof(sb));
+        sb.free_blocks -= 5;
+        img.seekp(0);
+        img.write((const char*)&sb, sizeof(sb));
+        img.seekp((std::streamoff)sb.block_bitmap * BLOCK_SIZE + 1000);
+        img.put((char)0xFF);
+    }
+    fsck_ok = fsck_ok && disk.mount() && disk.fsck(fsck_rep, false, 4) && fsck_rep.orphan_blocks == 8 &&
+              fsck_rep.sb_free_blocks + 5 == fsck_rep.free_blocks && !fsck_rep.repaired;
+    fsck_ok = fsck_ok && disk.fsck(fsck_rep, true) && fsck_rep.repaired &&
+              disk.fsck(fsck_rep, false) && fsck_rep.errors() == 0;
+    disk.unmount();
+    std::fill(frag_read.begin(), frag_read.end(), 0);
+    fsck_ok = fsck_ok && disk.mount() && disk.fsck(fsck_rep) && fsck_rep.errors() == 0 &&
+              disk.read_file(disk.open_file("fsck.bin"), frag_read.data(), frag_read.size(), 0) == (int)frag_read.size() &&
+              frag_read == frag_data;
+    disk.delete_file("fsck.bin");
+    disk.unmount();
+    std::cout << "测试" << test_count << "(一致性检查): " << (fsck_ok ? "通过" : "失败") << std::endl;
+    if (fsck_ok) pass_count++;
+
+    // 测试19: 快速挂载（干净卸载后从挂载检查点加载目录索引，预读后元数据读取命中内存，挂载期间干净标记被清除）
+    test_count++;
+    bool meta_ok = disk.mount();
+    for (int f = 0; f < 6 && meta_ok; f++) {
+        int inode = disk.create_file("meta" + std::to_string(f));
+        meta_ok = inode != -1 && disk.write_file(inode, frag_data.data(), BLOCK_SIZE, 0) == BLOCK_SIZE;
+    }
+    meta_ok = meta_ok && disk.delete_file("meta5") && disk.unmount() && disk.mount(true) && disk.meta_stats() &&
+              disk.meta_stats()->preloaded && disk.meta_stats()->from_checkpoint;
+    MountCheckpoint mount_ckpt;
+    {
+        std::ifstream img("test_disk.img", std::ios::binary);
+        img.seekg(MOUNT_CKPT_OFFSET);
+        meta_ok = meta_ok && img.read((char*)&mount_ckpt, sizeof(mount_ckpt)) && mount_ckpt.clean == 0;
+    }
+    for (int f = 0; f < 5 && meta_ok; f++) {
+        std::fill(frag_read.begin(), frag_read.end(), 0);
+        meta_ok = disk.read_file(disk.open_file("meta" + std::to_string(f)), frag_read.data(), BLOCK_SIZE, 0) == BLOCK_SIZE &&
+                  memcmp(frag_read.data(), frag_data.data(), BLOCK_SIZE) == 0;
+    }
+    meta_ok = meta_ok && disk.open_file("meta5") == -1 && disk.create_file("meta0") == -1 &&
+              disk.meta_stats()->index_hits >= 5 && disk.meta_stats()->block_hits > 0 && disk.meta_stats()->inode_hits > 0 &&
+              disk.fsck(fsck_rep) && fsck_rep.errors() == 0;
+    for (int f = 0; f < 5; f++) disk.delete_file("meta" + std::to_string(f));
+    meta_ok = meta_ok && disk.unmount() && disk.mount() && disk.meta_stats()->from_checkpoint &&
+              disk.open_file("meta0") == -1 && disk.unmount();
+    std::cout << "测试" << test_count << "(快速挂载): " << (meta_ok ? "通过" : "失败") << std::endl;
+    if (meta_ok) pass_count++;
+
+    // 测试20: 批量导入/导出（目录树展平导入，超过单文件上限的文件跳过，导出后与主机原文件逐字节一致）
+    test_count++;
+    mkdir("test_import_dir", 0755);
+    mkdir("test_import_dir/sub", 0755);
+    const char* bulk_names[] = {"a.txt", "sub/x", "sub/full", "sub/empty", "sub/big"};
+    const size_t bulk_sizes[] = {10000, 3 * BLOCK_SIZE, 16 * BLOCK_SIZE, 0, 70000};
+    std::vector<std::vector<char>> bulk_data;
+    for (int f = 0; f < 5; f++) {
+        std::vector<char> data(bulk_sizes[f]);
+        for (size_t i = 0; i < data.size(); i++) data[i] = (char)(i * 7 + f);
+        std::ofstream out(std::string("test_import_dir/") + bulk_names[f], std::ios::binary);
+        out.write(data.data(), data.size());
+        bulk_data.push_back(data);
+    }
+    BulkStats bulk_st;
+    bool bulk_ok = disk.mount() && disk.import_path("test_import_dir", "", bulk_st, 2) && bulk_st.files == 4 &&
+                   bulk_st.failed == 1 && bulk_st.threads == 2 && disk.open_file("sub_x") != -1 &&
+                   disk.open_file("sub_big") == -1 && disk.export_path("*", "test_export_dir", bulk_st, 2) &&
+                   bulk_st.files == 4 && bulk_st.failed == 0;
+    const char* bulk_flat[] = {"a.txt", "sub_x", "sub_full", "sub_empty"};
+    for (int f = 0; f < 4; f++) {
+        std::ifstream in(std::string("test_export_dir/") + bulk_flat[f], std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        bulk_ok = bulk_ok && data == bulk_data[f];
+        std::remove((std::string("test_export_dir/") + bulk_flat[f]).c_str());
+        disk.delete_file(bulk_flat[f]);
+    }
+    for (int f = 0; f < 5; f++) std::remove((std::string("test_import_dir/") + bulk_names[f]).c_str());
+    rmdir("test_import_dir/sub");
+    rmdir("test_import_dir");
+    rmdir("test_export_dir");
+    bulk_ok = bulk_ok && disk.fsck(fsck_rep) && fsck_rep.errors() == 0 && disk.unmount();
+    std::cout << "测试" << test_count << "(批量导入导出): " << (bulk_ok ? "通过" : "失败") << std::endl;
+    if (bulk_ok) pass_count++;
+
+    // 测试21: 脚本模式（跳过空行与注释，默认在第一条失败命令处停止，--keep-going继续执行，exit结束脚本）
+    test_count++;
+    const char* script_text =
+        "# 脚本测试\n"
+        "mount\n"
+        "\n"
+        "create script.txt\n"
+        "write 1 hello script\n"
+        "open no_such_file\n"
+        "delete script.txt\n"
+        "read abc 10\n"
+        "exit\n"
+        "ls\n";
+    std::cout.setstate(std::ios::failbit);  // 屏蔽命令输出
+    CommandParser strict_parser(disk);
+    ScriptOptions script_opt = {false, true, false};
+    ScriptStats script_st;
+    std::istringstream strict_in(script_text);
+    bool script_ok = !strict_parser.run_script(strict_in, script_opt, script_st) && script_st.commands == 4 &&
+                     script_st.failed == 1 && script_st.first_error == 6 && disk.open_file("script.txt") != -1 &&
+                     !strict_parser.exit_requested() && disk.delete_file("script.txt");
+    disk.unmount();
+    CommandParser lenient_parser(disk);
+    script_opt.stop_on_error = false;
+    std::istringstream lenient_in(script_text);
+    script_ok = script_ok && !lenient_parser.run_script(lenient_in, script_opt, script_st) &&
+                script_st.commands == 7 && script_st.failed == 2 && script_st.first_error == 6 &&
+                lenient_parser.exit_requested() && disk.open_file("script.txt") == -1;
+    std::cout.clear();
+    disk.unmount();
+    std::cout << "测试" << test_count << "(脚本模式): " << (script_ok ? "通过" : "失败") << std::endl;
+    if (script_ok) pass_count++;
+
+    // 测试22: 守护进程（多个客户端并发创建、写入、读回与删除，请求按批次执行）
+    test_count++;
+    bool daemon_ok = disk.mount();
+    DiskServer server(disk, "test_disk.sock", 2);
+    daemon_ok = daemon_ok && server.start();
+    std::thread server_thread;
+    if (daemon_ok) server_thread = std::thread([&server]() { server.run(); });
+    std::vector<int> client_ok(4, 0);
+    std::vector<std::thread> clients;
+    for (int c = 0; c < 4 && daemon_ok; c++) {
+        clients.push_back(std::thread([&, c]() {
+            DiskClient client;
+            std::string name = "client" + std::to_string(c);
+            std::vector<char> data(3 * BLOCK_SIZE, (char)('a' + c)), back(3 * BLOCK_SIZE);
+            bool ok = client.connect_to("test_disk.sock") && client.ping();
+            int inode = ok ? client.create_file(name) : -1;
+            ok = inode != -1 && client.create_file(name) == -1 &&
+                 client.write_file(inode, data.data(), data.size(), 0) == (int)data.size() &&
+                 client.open_file(name) == inode &&
+                 client.read_file(inode, back.data(), back.size(), 0) == (int)back.size() && back == data;
+            client_ok[c] = ok;
+        }));
+    }
+    for (auto& t : clients) t.join();
+    DiskClient lister;
+    daemon_ok = daemon_ok && lister.connect_to("test_disk.sock") && lister.list_files().size() == 4;
+    for (int c = 0; c < 4; c++) {
+        daemon_ok = daemon_ok && client_ok[c] && lister.delete_file("client" + std::to_string(c));
+    }
+    daemon_ok = daemon_ok && lister.list_files().empty() && lister.open_file("client0") == -1;
+    lister.disconnect();
+    server.stop();
+    if (server_thread.joinable()) server_thread.join();
+    daemon_ok = daemon_ok && server.stats().connections == 5 && server.stats().batches > 0 &&
+                server.stats().requests == 4 * 6 + 7 && server.stats().protocol_errors == 0;
+    disk.unmount();
+    std::cout << "测试" << test_count << "(守护进程): " << (daemon_ok ? "通过" : "失败") << std::endl;
+    if (daemon_ok) pass_count++;
+
+    // 测试23: QoS（类别配置解析、加权公平排队让交互请求越过积压的批量请求、令牌桶限制IOPS、守护进程切换类别）
+    test_count++;
+    std::vector<QosClassConfig> qos_classes;
+    bool qos_ok = !parse_qos_spec("bad:0", qos_classes) && parse_qos_spec("interactive:8,bulk:1:100:1", qos_classes) &&
+                  qos_classes.size() == 2 && qos_classes[1].iops_limit == 100 && qos_classes[1].bytes_limit == (1u << 20);
+    QosScheduler wfq(qos_classes);
+    int qos_interactive = wfq.find_class("interactive");
+    int qos_bulk = wfq.find_class("bulk");
+    qos_ok = qos_ok && wfq.class_count() == 3 && wfq.find_class("default") == 0 && qos_interactive > 0 && qos_bulk > 0;
+    QosScheduler fair(std::vector<QosClassConfig>{{"interactive", 8, 0, 0}, {"bulk", 1, 0, 0}});
+    for (int i = 0; i < 50; i++) fair.enqueue(fair.find_class("bulk"), 16 * BLOCK_SIZE);
+    for (int i = 0; i < 5; i++) fair.enqueue(fair.find_class("interactive"), BLOCK_SIZE);
+    uint64_t qos_wait = 0;
+    int last_interactive = -1;
+    for (int i = 0; i < 55 && qos_ok; i++) {
+        int cls = fair.dequeue(0, qos_wait);
+        qos_ok = cls > 0;
+        if (cls == fair.find_class("interactive")) last_interactive = i;
+    }
+    qos_ok = qos_ok && last_interactive >= 0 && last_interactive <= 5 && fair.queued() == 0 &&
+             fair.dequeue(0, qos_wait) == -1 && qos_wait == 0;
+    // 100 IOPS上限、桶容量10：模拟1秒内按1ms步进，最多派发约10+100个请求
+    QosScheduler limited(std::vector<QosClassConfig>{{"lim", 1, 100, 0}});
+    for (int i = 0; i < 200; i++) limited.enqueue(1, BLOCK_SIZE);
+    int qos_served = 0;
+    for (uint64_t ms = 0; ms <= 1000; ms++) {
+        while (limited.dequeue(1000000000ull + ms * 1000000, qos_wait) == 1) qos_served++;
+    }
+    // 每个被延后的请求只计一次（不随轮询次数增长）：超过桶容量的请求才被延后
+    qos_ok = qos_ok && qos_served >= 105 && qos_served <= 111 && limited.stats(1).throttled > 0 &&
+             limited.stats(1).throttled <= (uint64_t)qos_served - 10 + 1 && qos_wait > 0;
+    limited.complete(1, BLOCK_SIZE, 5000);
+    qos_ok = qos_ok && limited.stats(1).requests == 1 && limited.stats(1).latency.count == 1;
+    qos_ok = qos_ok && disk.mount();
+    {
+        DiskServer qos_server(disk, "test_disk.sock", 1);
+        qos_ok = qos_ok && qos_server.set_qos(qos_classes) && qos_server.start();
+        std::thread qos_thread;
+        if (qos_ok) qos_thread = std::thread([&qos_server]() { qos_server.run(); });
+        DiskClient qos_client;
+        qos_ok = qos_ok && qos_client.connect_to("test_disk.sock") && qos_client.set_class("bulk") &&
+                 !qos_client.set_class("nope") && qos_client.ping() && qos_client.list_files().empty();
+        qos_client.disconnect();
+        qos_server.stop();
+        if (qos_thread.joinable()) qos_thread.join();
+        qos_ok = qos_ok && qos_server.stats().requests == 4;
+    }
+    disk.unmount();
+    std::cout << "测试" << test_count << "(QoS): " << (qos_ok ? "通过" : "失败") << std::endl;
+    if (qos_ok) pass_count++;
+
+    // 测试24: 条带化（3个成员、单元4块；跨成员的大块I/O（预读、日志段）并行执行，重新挂载时按超级块与条带表组装，成员不配套时拒绝挂载）
+    test_count++;
+    std::vector<std::string> stripe_members = {"test_stripe1.img", "test_stripe2.img"};
+    std::vector<char> stripe_data(16 * BLOCK_SIZE), stripe_back(16 * BLOCK_SIZE);
+    for (size_t i = 0; i < stripe_data.size(); i++) stripe_data[i] = (char)(i * 13 / 7);
+    bool stripe_ok = !disk.set_stripe(std::vector<std::string>(8, "x.img"), 4) && disk.set_stripe(stripe_members, 4);
+    for (int log_mode = 0; log_mode < 2 && stripe_ok; log_mode++) {
+        stripe_ok = disk.format(log_mode == 1) && disk.mount() && disk.stripe_set() && disk.stripe_set()->count() == 3;
+        int inode = stripe_ok ? disk.create_file("striped.bin") : -1;
+        stripe_ok = inode != -1 &&
+                    disk.write_file(inode, stripe_data.data(), stripe_data.size(), 0) == (int)stripe_data.size() &&
+                    disk.unmount() && disk.mount(true) && disk.stripe_set() && disk.stripe_set()->unit_blocks() == 4;
+        std::fill(stripe_back.begin(), stripe_back.end(), 0);
+        stripe_ok = stripe_ok &&
+                    disk.read_file(disk.open_file("striped.bin"), stripe_back.data(), stripe_back.size(), 0) ==
+                        (int)stripe_back.size() &&
+                    stripe_back == stripe_data && disk.stripe_set()->parallel_ios() > 0 &&
+                    disk.stripe_set()->member_ios(1) > 0 && disk.stripe_set()->member_ios(2) > 0;
+        if (!log_mode) stripe_ok = stripe_ok && disk.fsck(fsck_rep) && fsck_rep.errors() == 0;
+        disk.unmount();
+    }
+    {
+        // 每个成员的数据区为 ceil(总块数/(4×3))×4 块，其后是成员标签
+        std::ifstream member("test_stripe2.img", std::ios::binary | std::ios::ate);
+        uint64_t member_blocks = (MAX_BLOCKS + 11) / 12 * 4;
+        stripe_ok = stripe_ok && (uint64_t)member.tellg() == member_blocks * BLOCK_SIZE + sizeof(StripeLabel);
+    }
+    {
+        // 用1号成员覆盖2号成员：标签中的成员序号不符，挂载失败
+        std::ifstream src("test_stripe1.img", std::ios::binary);
+        std::ofstream dst("test_stripe2.img", std::ios::binary | std::ios::trunc);
+        dst << src.rdbuf();
+    }
+    stripe_ok = stripe_ok && !disk.mount() && !disk.isMounted();
+    stripe_ok = stripe_ok && disk.set_stripe(std::vector<std::string>(), 0) && disk.format() && disk.mount() &&
+                !disk.stripe_set() && disk.unmount();
+    std::remove("test_stripe1.img");
+    std::remove("test_stripe2.img");
+    std::cout << "测试" << test_count << "(条带化): " << (stripe_ok ? "通过" : "失败") << std::endl;
+    if (stripe_ok) pass_count++;
+
+    // 测试25: 透明压缩（编解码往返；可压缩数据按簇压缩存放、局部覆盖与小块读、重新挂载后读回；不可压缩数据原样存放；已有文件转换）
+    test_count++;
+    std::vector<char> text(16 * BLOCK_SIZE);
+    {
+        std::string lines;
+        for (int i = 0; lines.size() < text.size(); i++) {
+            lines += "2026-10-18 08:00:" + std::to_string(i % 60) + " INFO worker-" + std::to_string(i % 7) +
+                     " request id=" + std::to_string(i * 7919 % 100000) + " status=200\n";
+        }
+        memcpy(text.data(), lines.data(), text.size());
+    }
+    std::vector<char> noise(16 * BLOCK_SIZE), text_back(16 * BLOCK_SIZE), lz_buf(20 * BLOCK_SIZE);
+    uint32_t lcg = 12345;
+    for (auto& c : noise) c = (char)((lcg = lcg * 1103515245 + 12345) >> 24);
+    size_t lz_len = lz_compress(text.data(), text.size(), lz_buf.data(), lz_buf.size());
+    bool compress_ok = lz_len > 0 && lz_len < text.size() / 3 &&
+                       lz_decompress(lz_buf.data(), lz_len, text_back.data(), text.size()) && text_back == text &&
+                       lz_compress(noise.data(), noise.size(), lz_buf.data(), noise.size() - 1) == 0;
+    for (int log_mode = 0; log_mode < 2 && compress_ok; log_mode++) {
+        compress_ok = disk.format(log_mode == 1) && disk.mount() && disk.set_compress(true);
+        int text_inode = compress_ok ? disk.create_file("log.txt") : -1;
+        int noise_inode = compress_ok ? disk.create_file("noise.bin") : -1;
+        compress_ok = text_inode != -1 && noise_inode != -1 &&
+                      disk.write_file(text_inode, text.data(), text.size(), 0) == (int)text.size() &&
+                      disk.write_file(noise_inode, noise.data(), noise.size(), 0) == (int)noise.size() &&
+                      disk.write_file(text_inode, "HELLO", 5, 1000) == 5;
+        memcpy(&text[1000], "HELLO", 5);
+        uint64_t hits = disk.compress_stats().cache_hits;
+        char small[64];
+        compress_ok = compress_ok && disk.read_file(text_inode, small, sizeof(small), 30000) == (int)sizeof(small) &&
+                      memcmp(small, &text[30000], sizeof(small)) == 0 && disk.compress_stats().cache_hits > hits &&
+                      disk.compress_stats().clusters_packed > 0 && disk.compress_stats().clusters_raw > 0;
+        // 文本簇压缩后只占几块，随机数据原样占满16块
+        compress_ok = compress_ok && disk.frag_report().file_blocks <= 16 + 5 && disk.unmount() && disk.mount();
+        std::fill(text_back.begin(), text_back.end(), 0);
+        compress_ok = compress_ok && disk.read_file(text_inode, text_back.data(), text_back.size(), 0) == (int)text.size() &&
+                      text_back == text &&
+                      disk.read_file(noise_inode, text_back.data(), text_back.size(), 0) == (int)noise.size() &&
+                      memcmp(text_back.data(), noise.data(), noise.size()) == 0;
+        memcpy(&text[1000], "2026-", 5);
+        if (!log_mode) compress_ok = compress_ok && disk.fsck(fsck_rep) && fsck_rep.errors() == 0;
+        disk.unmount();
+    }
+    compress_ok = compress_ok && disk.format() && disk.mount();
+    int plain_inode = compress_ok ? disk.create_file("plain.txt") : -1;
+    compress_ok = plain_inode != -1 && disk.write_file(plain_inode, text.data(), 40000, 0) == 40000 &&
+                  disk.frag_report().file_blocks == 10 && disk.compress_file("plain.txt", true) &&
+                  disk.frag_report().file_blocks < 10;
+    std::fill(text_back.begin(), text_back.end(), 0);
+    compress_ok = compress_ok && disk.read_file(plain_inode, text_back.data(), text_back.size(), 0) == 40000 &&
+                  memcmp(text_back.data(), text.data(), 40000) == 0 && disk.compress_file("plain.txt", false) &&
+                  disk.frag_report().file_blocks == 10 &&
+                  disk.read_file(plain_inode, text_back.data(), text_back.size(), 0) == 40000 &&
+                  memcmp(text_back.data(), text.data(), 40000) == 0 && disk.delete_file("plain.txt") &&
+                  disk.fsck(fsck_rep) && fsck_rep.errors() == 0;
+    disk.unmount();
+    std::cout << "测试" << test_count << "(透明压缩): " << (compress_ok ? "通过" : "失败") << std::endl;
+    if (compress_ok) pass_count++;
+
+    // 测试26: 块去重（相同内容的块共享、覆盖共享块时写时复制、内容未变的覆盖跳过；删除按引用计数释放；
+    //         干净卸载后从去重表加载，异常退出后由inode重建引用计数）
+    test_count++;
+    std::vector<char> dd_data(8 * BLOCK_SIZE), dd_back(8 * BLOCK_SIZE);
+    for (size_t i = 0; i < dd_data.size(); i++) dd_data[i] = (char)(i / BLOCK_SIZE * 31 + i % 251);
+    disk.set_dedup(true);
+    bool dedup_ok = true;
+    for (int log_mode = 0; log_mode < 2 && dedup_ok; log_mode++) {
+        dedup_ok = disk.format(log_mode == 1) && disk.mount() && disk.is_deduplicated();
+        int a = dedup_ok ? disk.create_file("a.bin") : -1;
+        int b = dedup_ok ? disk.create_file("b.bin") : -1;
+        dedup_ok = a != -1 && b != -1 &&
+                   disk.write_file(a, dd_data.data(), dd_data.size(), 0) == (int)dd_data.size() &&
+                   disk.write_file(b, dd_data.data(), dd_data.size(), 0) == (int)dd_data.size();
+        const DedupIndex* dd = disk.dedup_index();
+        dedup_ok = dedup_ok && dd->st.dup_hits == 8 && dd->physical_blocks() == 1 + 8 && dd->logical_blocks() == 1 + 16 &&
+                   disk.write_file(b, "XY", 2, 100) == 2 && dd->st.cow_breaks == 1 &&
+                   disk.write_file(a, dd_data.data(), dd_data.size(), 0) == (int)dd_data.size() &&
+                   dd->st.unchanged == 8 && dd->physical_blocks() == 1 + 9;
+        dedup_ok = dedup_ok && disk.unmount() && disk.mount() && (dd = disk.dedup_index()) &&
+                   dd->st.from_checkpoint && dd->physical_blocks() == 1 + 9 && disk.delete_file("a.bin") &&
+                   dd->physical_blocks() == 1 + 8;
+        memcpy(&dd_data[100], "XY", 2);
+        std::fill(dd_back.begin(), dd_back.end(), 0);
+        dedup_ok = dedup_ok && disk.read_file(disk.open_file("b.bin"), dd_back.data(), dd_back.size(), 0) ==
+                                   (int)dd_back.size() &&
+                   dd_back == dd_data;
+        for (size_t i = 100; i < 102; i++) dd_data[i] = (char)(i % 251);
+        if (!log_mode) {
+            // 挂载期间复制镜像（去重表为脏），作为异常退出后的镜像重新挂载
+            dedup_ok = dedup_ok && disk.fsck(fsck_rep) && fsck_rep.errors() == 0 && disk.unmount() && disk.mount();
+            {
+                std::ifstream src("test_disk.img", std::ios::binary);
+                std::ofstream dst("test_dedup_crash.img", std::ios::binary | std::ios::trunc);
+                dst << src.rdbuf();
+            }
+            DiskFS crashed("test_dedup_crash.img");
+            dedup_ok = dedup_ok && crashed.mount() && crashed.dedup_index() &&
+                       !crashed.dedup_index()->st.from_checkpoint &&
+                       crashed.dedup_index()->physical_blocks() == 1 + 8 &&
+                       crashed.dedup_index()->logical_blocks() == 1 + 8 && crashed.fsck(fsck_rep) &&
+                       fsck_rep.errors() == 0;
+            int c = dedup_ok ? crashed.create_file("c.bin") : -1;
+            dedup_ok = c != -1 && crashed.write_file(c, dd_data.data() + BLOCK_SIZE, BLOCK_SIZE, 0) == BLOCK_SIZE &&
+                       crashed.dedup_index()->st.dup_hits == 1 && crashed.unmount();
+            std::remove("test_dedup_crash.img");
+        }
+        disk.unmount();
+    }
+    disk.set_dedup(false);
+    dedup_ok = dedup_ok && disk.format() && disk.mount() && !disk.is_deduplicated() && disk.unmount();
+    std::cout << "测试" << test_count << "(块去重): " << (dedup_ok ? "通过" : "失败") << std::endl;
+    if (dedup_ok) pass_count++;
+
+    // 测试27: 块校验和（CRC32C标准值、加速实现与查表实现一致；篡改数据块、inode、超级块后读取或挂载失败并计数，
+    //         整块重写后恢复；异常退出后沿用表中的校验和，只重新登记改写过的块；日志布局下重新挂载后校验通过）
+    test_count++;
+    std::vector<char> crc_buf(BLOCK_SIZE + 8);
+    for (size_t i = 0; i < crc_buf.size(); i++) crc_buf[i] = (char)(i * 2654435761u >> 13);
+    bool csum_ok = crc32c(0, "123456789", 9) == 0xE3069283u && crc32c_portable(0, "123456789", 9) == 0xE3069283u;
+    for (size_t n : {0, 1, 7, 8, 100, 255, 256, 300, 4093, 4096, 4103}) {
+        csum_ok = csum_ok && crc32c(3, crc_buf.data() + 1, n) == crc32c_portable(3, crc_buf.data() + 1, n);
+    }
+    auto flip_byte = [](const char* path, uint64_t pos) {
+        std::fstream img(path, std::ios::in | std::ios::out | std::ios::binary);
+        char c = 0;
+        img.seekg(pos);
+        img.get(c);
+        img.seekp(pos);
+        img.put((char)(c ^ 0x5a));
+    };
+    std::vector<char> cs_data(3 * BLOCK_SIZE), cs_back(3 * BLOCK_SIZE);
+    for (size_t i = 0; i < cs_data.size(); i++) cs_data[i] = (char)('a' + i % 23);
+    disk.set_checksums(CSUM_META | CSUM_DATA);
+    for (int log_mode = 0; log_mode < 2 && csum_ok; log_mode++) {
+        csum_ok = disk.format(log_mode == 1) && disk.mount();
+        int inode = csum_ok ? disk.create_file("sum.bin") : -1;
+        csum_ok = inode != -1 && disk.write_file(inode, cs_data.data(), cs_data.size(), 0) == (int)cs_data.size() &&
+                  disk.unmount() && disk.mount() && disk.checksum_table() &&
+                  disk.checksum_table()->st.from_checkpoint &&
+                  disk.read_file(inode, cs_back.data(), cs_back.size(), 0) == (int)cs_back.size() && cs_back == cs_data &&
+                  disk.checksum_table()->st.verified >= 4 && disk.checksum_table()->st.errors == 0;
+        if (!log_mode && csum_ok) {
+            // 原地布局：文件的第一个数据块紧跟根目录块
+            SuperBlock sb;
+            std::ifstream img("test_disk.img", std::ios::binary);
+            img.read((char*)&sb, sizeof(sb));
+            img.close();
+            disk.unmount();
+            flip_byte("test_disk.img", (uint64_t)(sb.data_start + 1) * BLOCK_SIZE + 10);
+            csum_ok = disk.mount() && disk.read_file(inode, cs_back.data(), cs_back.size(), 0) == -1 &&
+                      disk.checksum_table()->st.errors == 1 &&
+                      disk.write_file(inode, cs_data.data(), BLOCK_SIZE, 0) == BLOCK_SIZE &&
+                      disk.read_file(inode, cs_back.data(), cs_back.size(), 0) == (int)cs_back.size() &&
+                      cs_back == cs_data && disk.fsck(fsck_rep) && fsck_rep.errors() == 0 && disk.unmount();
+            uint64_t inode_pos = (uint64_t)sb.inode_start * BLOCK_SIZE + (uint64_t)inode * sizeof(Inode) + 4;
+            flip_byte("test_disk.img", inode_pos);
+            csum_ok = csum_ok && disk.mount() && disk.get_file_size(inode) == -1 && disk.unmount();
+            flip_byte("test_disk.img", inode_pos);
+            flip_byte("test_disk.img", 12);
+            csum_ok = csum_ok && !disk.mount();
+            flip_byte("test_disk.img", 12);
+            csum_ok = csum_ok && disk.mount() && disk.get_file_size(inode) == (int)cs_data.size();
+
+            // 挂载期间改写第二个块后复制镜像，作为异常退出后的镜像：篡改未改写的第三个块仍能发现，
+            // 改写过的第二个块与inode重新登记
+            std::vector<char> cs_new(BLOCK_SIZE, 'z');
+            csum_ok = csum_ok && disk.write_file(inode, cs_new.data(), BLOCK_SIZE, BLOCK_SIZE) == BLOCK_SIZE;
+            {
+                std::ifstream src("test_disk.img", std::ios::binary);
+                std::ofstream dst("test_csum_crash.img", std::ios::binary | std::ios::trunc);
+                dst << src.rdbuf();
+            }
+            flip_byte("test_csum_crash.img", (uint64_t)(sb.data_start + 3) * BLOCK_SIZE + 10);
+            DiskFS crashed("test_csum_crash.img");
+            csum_ok = csum_ok && crashed.mount() && crashed.checksum_table()->st.from_checkpoint &&
+                      crashed.checksum_table()->st.unclean &&
+                      crashed.read_file(inode, cs_back.data(), BLOCK_SIZE, BLOCK_SIZE) == BLOCK_SIZE &&
+                      std::equal(cs_new.begin(), cs_new.end(), cs_back.begin()) &&
+                      crashed.checksum_table()->st.adopted == 2 && crashed.checksum_table()->st.errors == 0 &&
+                      crashed.read_file(inode, cs_back.data(), cs_back.size(), 0) == -1 &&
+                      crashed.checksum_table()->st.errors == 1 && crashed.unmount();
+            std::remove("test_csum_crash.img");
+        }
+        disk.unmount();
+    }
+    disk.set_checksums(0);
+    csum_ok = csum_ok && disk.format() && disk.mount() && !disk.checksum_table() && disk.unmount();
+    std::cout << "测试" << test_count << "(块校验和): " << (csum_ok ? "通过" : "失败") << std::endl;
+    if (csum_ok) pass_count++;
+
+    // 测试28: 写时复制克隆与快照（克隆只增加引用，覆盖共享块时复制；快照只读挂载看到创建时的内容，
+    //         回滚恢复文件与目录，删除后引用全部归还；异常退出后重建的引用计数包含快照）
+    test_count++;
+    std::vector<char> cw_data(3 * BLOCK_SIZE), cw_zz, cw_back(3 * BLOCK_SIZE);
+    for (size_t i = 0; i < cw_data.size(); i++) cw_data[i] = (char)('A' + i % 26);
+    cw_zz = cw_data;
+    memcpy(cw_zz.data(), "ZZ", 2);
+    disk.set_cow(true);
+    bool cow_ok = true;
+    for (int log_mode = 0; log_mode < 2 && cow_ok; log_mode++) {
+        cow_ok = disk.format(log_mode == 1) && disk.mount() && disk.is_refcounted() && !disk.is_deduplicated();
+        int a = cow_ok ? disk.create_file("a.bin") : -1;
+        cow_ok = a != -1 && disk.write_file(a, cw_data.data(), cw_data.size(), 0) == (int)cw_data.size();
+        int b = cow_ok ? disk.clone_file("a.bin", "b.bin") : -1;
+        const DedupIndex* dd = disk.dedup_index();
+        cow_ok = b != -1 && dd->physical_blocks() == 1 + 3 && dd->logical_blocks() == 1 + 6 &&
+                 disk.write_file(a, "ZZ", 2, 0) == 2 && dd->st.cow_breaks == 1 && dd->physical_blocks() == 1 + 4 &&
+                 disk.read_file(b, cw_back.data(), cw_back.size(), 0) == (int)cw_back.size() && cw_back == cw_data;
+        cow_ok = cow_ok && disk.snapshot_create("s1") && !disk.snapshot_create("s1") &&
+                 disk.list_snapshots().size() == 1 && disk.list_snapshots()[0].files == 2 &&
+                 disk.write_file(a, cw_data.data(), BLOCK_SIZE, 0) == BLOCK_SIZE && dd->st.cow_breaks == 2 &&
+                 disk.delete_file("b.bin") && disk.fsck(fsck_rep) && fsck_rep.errors() == 0;
+        if (!log_mode && cow_ok) {
+            // 挂载期间复制镜像（引用计数表为脏），重建的引用计数须包含快照持有的块
+            {
+                std::ifstream src("test_disk.img", std::ios::binary);
+                std::ofstream dst("test_cow_crash.img", std::ios::binary | std::ios::trunc);
+                dst << src.rdbuf();
+            }
+            DiskFS crashed("test_cow_crash.img");
+            cow_ok = crashed.mount() && !crashed.dedup_index()->st.from_checkpoint && crashed.fsck(fsck_rep) &&
+                     fsck_rep.errors() == 0 && crashed.unmount();
+            std::remove("test_cow_crash.img");
+        }
+        std::fill(cw_back.begin(), cw_back.end(), 0);
+        cow_ok = cow_ok && disk.unmount() && disk.mount_snapshot("s1") && disk.is_read_only() &&
+                 disk.read_file(a, cw_back.data(), cw_back.size(), 0) == (int)cw_back.size() && cw_back == cw_zz &&
+                 disk.open_file("b.bin") == b && disk.write_file(a, "x", 1, 0) == -1 && disk.create_file("c.bin") == -1 &&
+                 disk.unmount();
+        cow_ok = cow_ok && disk.mount() && !disk.is_read_only() && disk.open_file("b.bin") == -1 &&
+                 disk.snapshot_rollback("s1") && disk.open_file("b.bin") == b &&
+                 disk.read_file(b, cw_back.data(), cw_back.size(), 0) == (int)cw_back.size() && cw_back == cw_data &&
+                 disk.read_file(a, cw_back.data(), cw_back.size(), 0) == (int)cw_back.size() && cw_back == cw_zz &&
+                 disk.fsck(fsck_rep) && fsck_rep.errors() == 0 && disk.snapshot_delete("s1") &&
+                 disk.list_snapshots().empty() && disk.fsck(fsck_rep) && fsck_rep.errors() == 0 &&
+                 dd->physical_blocks() == 1 + 4 && disk.unmount() && disk.mount() &&
+                 disk.dedup_index()->st.from_checkpoint;
+        disk.unmount();
+    }
+    disk.set_cow(false);
+    cow_ok = cow_ok && disk.format() && disk.mount() && disk.create_file("a.bin") != -1 &&
+             disk.clone_file("a.bin", "b.bin") == -1 && !disk.snapshot_create("s1") && disk.unmount();
+    std::cout << "测试" << test_count << "(写时复制克隆与快照): " << (cow_ok ? "通过" : "失败") << std::endl;
+    if (cow_ok) pass_count++;
+
+    // 测试29: 冷热分层（元数据固定在快速层；反复读取的块迁移后由快速层服务，映射重新挂载后保留；
+    //         槽位用尽时替换更冷的块并写回脏数据；只读挂载不迁移）
+    test_count++;
+    std::vector<char> tr_data(3 * BLOCK_SIZE), tr_back(3 * BLOCK_SIZE);
+    for (size_t i = 0; i < tr_data.size(); i++) tr_data[i] = (char)('a' + i % 19);
+    bool tier_ok = disk.set_tier("test_tier.fast", 24 + 3 + 1 + 1 + 2, 0) && disk.format() && disk.mount() &&
+                   disk.tier_set() && disk.tier_set()->slot_count() == 2;
+    int tf = tier_ok ? disk.create_file("t.bin") : -1;
+    tier_ok = tf != -1 && disk.write_file(tf, tr_data.data(), tr_data.size(), 0) == (int)tr_data.size() &&
+              disk.tier_set()->stats().fast_ios > 0 && disk.tier_set()->stats().data_hits == 0;
+    for (int i = 0; i < 4 && tier_ok; i++) {
+        tier_ok = disk.read_file(tf, tr_back.data(), tr_back.size(), 0) == (int)tr_back.size();
+    }
+    tier_ok = tier_ok && disk.tier_migrate() == 2 && disk.tier_set()->resident() == 2 &&
+              disk.read_file(tf, tr_back.data(), tr_back.size(), 0) == (int)tr_back.size() && tr_back == tr_data &&
+              disk.tier_set()->stats().data_hits == 2 && disk.unmount();
+    if (tier_ok) {
+        // 干净卸载后容量层的0号块是最新超级块的引导副本
+        SuperBlock boot;
+        std::ifstream img("test_disk.img", std::ios::binary);
+        img.read((char*)&boot, sizeof(boot));
+        tier_ok = boot.tier_fast_blocks == 31 && boot.free_blocks + 3 == boot.data_blocks - 1;
+    }
+    for (size_t i = 0; i < tr_data.size(); i++) tr_data[i] = (char)('A' + i % 23);
+    tier_ok = tier_ok && disk.mount() && disk.tier_set()->resident() == 2 && !disk.tier_set()->recovered() &&
+              disk.write_file(tf, tr_data.data(), tr_data.size(), 0) == (int)tr_data.size();
+    for (int i = 0; i < 12 && tier_ok; i++) {
+        tier_ok = disk.read_file(tf, tr_back.data(), BLOCK_SIZE, 2 * BLOCK_SIZE) == BLOCK_SIZE;
+    }
+    tier_ok = tier_ok && disk.tier_migrate() == 1 && disk.tier_set()->stats().demotions == 1 &&
+              disk.tier_set()->stats().writebacks == 1 && disk.unmount() && disk.mount() &&
+              disk.read_file(tf, tr_back.data(), tr_back.size(), 0) == (int)tr_back.size() && tr_back == tr_data &&
+              disk.fsck(fsck_rep) && fsck_rep.errors() == 0 && disk.unmount();
+    tier_ok = tier_ok && disk.mount(false, true) && disk.tier_set() &&
+              disk.read_file(tf, tr_back.data(), tr_back.size(), 0) == (int)tr_back.size() && tr_back == tr_data &&
+              disk.tier_migrate() == -1 && disk.unmount();
+    tier_ok = tier_ok && disk.set_tier("", 0) && disk.format() && disk.mount() && !disk.tier_set() && disk.unmount();
+    std::remove("test_tier.fast");
+    std::cout << "测试" << test_count << "(冷热分层): " << (tier_ok ? "通过" : "失败") << std::endl;
+    if (tier_ok) pass_count++;
+
+    // 测试30: 共享只读挂载（第一个读者构建共享段，其他实例与子进程直接复用；存在读者时可写挂载被拒绝，
+    //         镜像修改后共享段重建）
+    test_count++;
+    bool share_ok = disk.format() && disk.mount();
+    std::vector<int> sh_inodes;
+    for (int i = 0; i < 3 && share_ok; i++) {
+        std::string name = "share" + std::to_string(i) + ".txt";
+        sh_inodes.push_back(disk.create_file(name));
+        share_ok = sh_inodes.back() != -1 && disk.write_file(sh_inodes.back(), name.c_str(), name.size(), 0) == (int)name.size();
+    }
+    share_ok = share_ok && disk.unmount();
+    {
+        DiskFS r1("test_disk.img"), r2("test_disk.img");
+        char sh_buf[16] = {0};
+        share_ok = share_ok && r1.mount(false, true, true) && r1.shared_meta() && r1.shared_meta()->st.built &&
+                   r2.mount(false, false, true) && r2.is_read_only() && !r2.shared_meta()->st.built &&
+                   r2.shared_meta()->readers() == 2 && r2.open_file("share1.txt") == sh_inodes[1] &&
+                   r2.open_file("nosuch.txt") == -1 && r2.read_file(sh_inodes[1], sh_buf, 10, 0) == 10 &&
+                   std::string(sh_buf) == "share1.txt" && r2.shared_meta()->st.index_hits == 1 &&
+                   r2.shared_meta()->st.inode_hits > 0 && !disk.mount() && !disk.format();
+        pid_t child = share_ok ? fork() : -1;
+        if (child == 0) {
+            DiskFS r3("test_disk.img");
+            bool ok = r3.mount(false, true, true) && !r3.shared_meta()->st.built && r3.open_file("share2.txt") == sh_inodes[2] &&
+                      r3.unmount();
+            _exit(ok ? 0 : 1);
+        }
+        int status = -1;
+        share_ok = share_ok && child > 0 && waitpid(child, &status, 0) == child && WIFEXITED(status) &&
+                   WEXITSTATUS(status) == 0 && r1.unmount() && r2.unmount();
+    }
+    share_ok = share_ok && disk.mount() && disk.delete_file("share0.txt") && disk.unmount() &&
+               disk.mount(false, true, true) && disk.shared_meta()->st.built && disk.open_file("share0.txt") == -1 &&
+               disk.open_file("share2.txt") == sh_inodes[2] && disk.unmount();
+    SharedMeta::remove("test_disk.img");
+    std::cout << "测试" << test_count << "(共享只读挂载): " << (share_ok ? "通过" : "失败") << std::endl;
+    if (share_ok) pass_count++;
+
+    // 测试31: 多队列块层（多个线程各用自己的软件队列并发读写，退出线程的队列被复用；DiskFS的块读写与调度器派发
+    //         经过硬件队列，批量派发一次入环；挂载中可以关闭）
+    test_count++;
+    bool mq_ok = false;
+    {
+        std::ofstream mq_img("test_mq.img", std::ios::binary | std::ios::trunc);
+        std::vector<char> zero(64 * BLOCK_SIZE, 0);
+        mq_img.write(zero.data(), zero.size());
+    }
+    {
+        BlockMq bmq(2, 8);
+        mq_ok = bmq.open("test_mq.img", false);
+        std::vector<std::thread> workers;
+        std::vector<int> thread_ok(4, 0);
+        for (int t = 0; t < 4 && mq_ok; t++) {
+            workers.emplace_back([&bmq, &thread_ok, t]() {
+                // 每个线程写自己的16个块（一次批量提交，超过环深度），再逐块读回校验
+                std::vector<char> data(16 * BLOCK_SIZE), back(BLOCK_SIZE);
+                std::vector<MqRequest> reqs;
+                for (int i = 0; i < 16; i++) {
+                    memset(&data[i * BLOCK_SIZE], 'a' + t * 4 + i % 4, BLOCK_SIZE);
+                    reqs.push_back({(uint64_t)(i * 4 + t) * BLOCK_SIZE, &data[i * BLOCK_SIZE], (size_t)BLOCK_SIZE, true});
+                }
+                bool ok = bmq.submit(reqs.data(), reqs.size());
+                for (int round = 0; round < 50 && ok; round++) {
+                    int i = (round * 7) % 16;
+                    ok = bmq.read((uint64_t)(i * 4 + t) * BLOCK_SIZE, back.data(), BLOCK_SIZE) &&
+                         memcmp(back.data(), &data[i * BLOCK_SIZE], BLOCK_SIZE) == 0;
+                }
+                thread_ok[t] = ok;
+            });
+        }
+        for (auto& w : workers) w.join();
+        for (int t = 0; t < 4 && mq_ok; t++) mq_ok = thread_ok[t] == 1;
+        mq_ok = mq_ok && bmq.sw_queue_count() == 4 && bmq.batched_submits() == 4 &&
+                bmq.queue_stats(0).requests == 2 * (16 + 50) && bmq.queue_stats(1).requests == 2 * (16 + 50) &&
+                bmq.queue_stats(0).errors == 0;
+        // 先后启动的短命线程复用已退出线程归还的软件队列，不会累积到上限后退回同步读写
+        for (int t = 0; t < 100 && mq_ok; t++) {
+            int one_ok = 0;
+            std::thread([&bmq, &one_ok]() {
+                char buf[BLOCK_SIZE];
+                one_ok = bmq.read(0, buf, BLOCK_SIZE);
+            }).join();
+            mq_ok = one_ok == 1;
+        }
+        mq_ok = mq_ok && bmq.sw_queue_count() == 4;
+    }
+    std::remove("test_mq.img");
+    std::vector<char> mq_data(6 * BLOCK_SIZE), mq_back(6 * BLOCK_SIZE);
+    for (size_t i = 0; i < mq_data.size(); i++) mq_data[i] = (char)('0' + i % 37);
+    mq_ok = mq_ok && disk.set_block_mq(2) && disk.format() && disk.mount() && disk.block_mq() &&
+            disk.set_scheduler("clook");
+    int mf = mq_ok ? disk.create_file("mq.bin") : -1;
+    disk.begin_batch();
+    mq_ok = mf != -1 && disk.write_file(mf, mq_data.data(), mq_data.size(), 0) == (int)mq_data.size();
+    mq_ok = disk.end_batch() && mq_ok && disk.block_mq()->batched_submits() > 0 &&
+            disk.read_file(mf, mq_back.data(), mq_back.size(), 0) == (int)mq_back.size() && mq_back == mq_data &&
+            disk.unmount() && disk.mount() && disk.block_mq() &&
+            disk.read_file(mf, mq_back.data(), mq_back.size(), 0) == (int)mq_back.size() && mq_back == mq_data &&
+            disk.fsck(fsck_rep) && fsck_rep.errors() == 0 && disk.set_block_mq(0) && !disk.block_mq() &&
+            disk.read_file(mf, mq_back.data(), mq_back.size(), 0) == (int)mq_back.size() && mq_back == mq_data &&
+            disk.unmount();
+    disk.set_scheduler("none");
+    std::cout << "测试" << test_count << "(多队列块层): " << (mq_ok ? "通过" : "失败") << std::endl;
+    if (mq_ok) pass_count++;
+
+    // 测试32: 延迟块分配（写入只建脏页并预留；删除的短命文件不分配；回写时每个文件一段连续区，
+    //         整批只写一次位图与超级块；追加的块紧接文件末尾）
+    test_count++;
+    std::vector<char> da_block(BLOCK_SIZE), da_back(9 * BLOCK_SIZE);
+    bool da_ok = disk.format() && disk.mount() && disk.set_delalloc(true);
+    int da = da_ok ? disk.create_file("a.bin") : -1;
+    int db = da_ok ? disk.create_file("b.bin") : -1;
+    // 两个文件交替追加：立即分配时块号相互穿插，延迟分配时各自连续
+    for (int i = 0; i < 8 && da_ok; i++) {
+        memset(da_block.data(), 'a' + i, BLOCK_SIZE);
+        da_ok = disk.write_file(da, da_block.data(), BLOCK_SIZE, i * BLOCK_SIZE) == BLOCK_SIZE &&
+                disk.write_file(db, da_block.data(), BLOCK_SIZE, i * BLOCK_SIZE) == BLOCK_SIZE;
+    }
+    int dt = da_ok ? disk.create_file("tmp.bin") : -1;
+    const DelallocCache* dc = disk.delalloc_cache();
+    da_ok = da_ok && dt != -1 && disk.write_file(dt, da_block.data(), BLOCK_SIZE, 0) == BLOCK_SIZE &&
+            disk.write_file(dt, "x", 1, 100) == 1 && dc->reserved == 17 && dc->st.rewrites == 1 &&
+            disk.delete_file("tmp.bin") && dc->reserved == 16 && dc->st.dropped == 1 && dc->st.allocated == 0 &&
+            disk.read_file(db, da_back.data(), 8 * BLOCK_SIZE, 0) == 8 * BLOCK_SIZE && da_back[7 * BLOCK_SIZE] == 'h' &&
+            disk.read_file(db, da_back.data(), BLOCK_SIZE, 8 * BLOCK_SIZE) == 0;
+    // 越过文件末尾的读取不返回数据（小文件只有10字节，后面的空块不算文件内容）
+    int de = da_ok ? disk.create_file("e.bin") : -1;
+    da_ok = da_ok && de != -1 && disk.write_file(de, "0123456789", 10, 0) == 10 &&
+            disk.read_file(de, da_back.data(), 50, 8192) == 0 && disk.read_file(de, da_back.data(), 50, 10) == 0 &&
+            disk.read_file(de, da_back.data(), 50, 0) == 10 && disk.delete_file("e.bin");
+    FragReport da_frag = disk.frag_report();  // 先回写全部脏页
+    da_ok = da_ok && dc->reserved == 0 && dc->st.allocated == 16 && dc->st.runs == 2 && dc->st.meta_writes == 4 &&
+            da_frag.file_blocks == 16 && da_frag.fragmented_files == 0;
+    memset(da_block.data(), 'z', BLOCK_SIZE);
+    da_ok = da_ok && disk.write_file(db, da_block.data(), BLOCK_SIZE, 8 * BLOCK_SIZE) == BLOCK_SIZE &&
+            disk.delalloc_flush(db) && dc->st.runs == 3 && disk.frag_report().fragmented_files == 0 && disk.unmount() &&
+            disk.mount() && disk.read_file(db, da_back.data(), da_back.size(), 0) == (int)da_back.size() &&
+            da_back[0] == 'a' && da_back[7 * BLOCK_SIZE] == 'h' && da_back[8 * BLOCK_SIZE] == 'z' &&
+            disk.fsck(fsck_rep) && fsck_rep.errors() == 0 && disk.set_delalloc(false) && !disk.delalloc_cache() &&
+            disk.unmount();
+    std::cout << "测试" << test_count << "(延迟块分配): " << (da_ok ? "通过" : "失败") << std::endl;
+    if (da_ok) pass_count++;
+
+    // 测试33: 紧凑镜像打包（只导出元数据与已分配的块；导入得到稀疏镜像且内容一致；损坏的包被拒绝且不破坏已有镜像）
+    test_count++;
+    std::vector<char> pk_data(5 * BLOCK_SIZE), pk_back(5 * BLOCK_SIZE);
+    for (size_t i = 0; i < pk_data.size(); i++) pk_data[i] = (char)('a' + i % 7);
+    bool pack_ok = disk.format() && disk.mount();
+    int pk = pack_ok ? disk.create_file("pack.bin") : -1;
+    pack_ok = pk != -1 && disk.write_file(pk, pk_data.data(), pk_data.size(), 0) == (int)pk_data.size() &&
+              disk.unmount() && disk.mount(false, true);
+    PackStats pk_raw, pk_lz, pk_in;
+    pack_ok = pack_ok && disk.export_image("test_pack.raw", false, pk_raw) && disk.export_image("test_pack.lz", true, pk_lz) &&
+              disk.unmount();
+    // 元数据区（data_start块）+ 根目录块 + 5个数据块
+    pack_ok = pack_ok && pk_raw.blocks == 27 + 1 + 5 && pk_raw.runs == 1 && pk_raw.pack_bytes < pk_raw.image_bytes / 10 &&
+              pk_lz.blocks == pk_raw.blocks && pk_lz.pack_bytes < pk_raw.pack_bytes;
+    struct stat pk_sb;
+    pack_ok = pack_ok && import_image("test_pack.lz", "test_import.img", pk_in) && pk_in.blocks == pk_lz.blocks &&
+              pk_in.image_bytes == pk_lz.image_bytes && stat("test_import.img", &pk_sb) == 0 &&
+              (uint64_t)pk_sb.st_size == pk_lz.image_bytes && (uint64_t)pk_sb.st_blocks * 512 < pk_lz.image_bytes / 10;
+    {
+        DiskFS imported("test_import.img");
+        pack_ok = pack_ok && imported.mount() && imported.open_file("pack.bin") == pk &&
+                  imported.read_file(pk, pk_back.data(), pk_back.size(), 0) == (int)pk_back.size() && pk_back == pk_data &&
+                  imported.fsck(fsck_rep) && fsck_rep.errors() == 0 && !import_image("test_pack.raw", "test_import.img", pk_in) &&
+                  imported.unmount();
+    }
+    {
+        // 改动包中最后一个字节（数据区），CRC32C校验失败
+        std::fstream pk_file("test_pack.raw", std::ios::in | std::ios::out | std::ios::binary);
+        pk_file.seekp(-1, std::ios::end);
+        pk_file.put('#');
+    }
+    // 损坏的包导入到已有镜像上：导入失败，原镜像不变
+    pack_ok = pack_ok && import_image("test_pack.raw", "test_import.img", pk_in) == false;
+    {
+        DiskFS imported("test_import.img");
+        pack_ok = pack_ok && imported.mount() && imported.open_file("pack.bin") == pk &&
+                  imported.read_file(pk, pk_back.data(), pk_back.size(), 0) == (int)pk_back.size() && pk_back == pk_data &&
+                  imported.unmount();
+    }
+    {
+        // 索引项数被改大的包头在分配索引之前被拒绝
+        std::fstream pk_file("test_pack.lz", std::ios::in | std::ios::out | std::ios::binary);
+        uint32_t huge = 0xFFFFFFFF;
+        pk_file.seekp(offsetof(PackHeader, chunk_count));
+        pk_file.write((const char*)&huge, sizeof(huge));
+    }
+    pack_ok = pack_ok && import_image("test_pack.lz", "test_import.img", pk_in) == false;
+    std::remove("test_pack.raw");
+    std::remove("test_pack.lz");
+    std::remove("test_import.img");
+    std::cout << "测试" << test_count << "(紧凑镜像打包): " << (pack_ok ? "通过" : "失败") << std::endl;
+    if (pack_ok) pass_count++;
+
+    // 测试34: 截断与预分配（截断整批释放尾部块、尾部清零；预分配一段连续区且读出为0，写入后转换并持久化）
+    test_count++;
+    std::vector<char> ta_data(10 * BLOCK_SIZE, 'x'), ta_back(10 * BLOCK_SIZE);
+    bool ta_ok = disk.format() && disk.mount();
+    int ta_f = ta_ok ? disk.create_file("t.bin") : -1;
+    ta_ok = ta_f != -1 && disk.write_file(ta_f, ta_data.data(), ta_data.size(), 0) == (int)ta_data.size() &&
+            disk.fsck(fsck_rep);
+    uint32_t ta_free = fsck_rep.free_blocks;
+    // 缩短到第3块中间：释放7块，第3块尾部清零；再扩展到4块，扩出部分与空洞读出为0
+    ta_ok = ta_ok && disk.truncate_file(ta_f, 2 * BLOCK_SIZE + 100) == 7 && disk.fsck(fsck_rep) &&
+            fsck_rep.errors() == 0 && fsck_rep.free_blocks == ta_free + 7 &&
+            disk.read_file(ta_f, ta_back.data(), ta_back.size(), 0) == 2 * BLOCK_SIZE + 100 &&
+            disk.read_file(ta_f, ta_back.data(), 50, 3 * BLOCK_SIZE) == 0 &&
+            disk.truncate_file(ta_f, 4 * BLOCK_SIZE) == 0 &&
+            disk.read_file(ta_f, ta_back.data(), ta_back.size(), 0) == 4 * BLOCK_SIZE &&
+            disk.read_file(ta_f, ta_back.data(), 50, 4 * BLOCK_SIZE) == 0 &&
+            ta_back[2 * BLOCK_SIZE + 99] == 'x' && ta_back[2 * BLOCK_SIZE + 100] == 0 && ta_back[4 * BLOCK_SIZE - 1] == 0;
+    // 新文件预分配6块：落在刚释放、仍有旧内容的连续区上，读出仍为0
+    int ta_g = ta_ok ? disk.create_file("g.bin") : -1;
+    ta_ok = ta_g != -1 && disk.fallocate_file(ta_g, 0, 6 * BLOCK_SIZE) == 6 && disk.frag_report().fragmented_files == 0 &&
+            disk.read_file(ta_g, ta_back.data(), ta_back.size(), 0) == 6 * BLOCK_SIZE &&
+            std::count(ta_back.begin(), ta_back.begin() + 6 * BLOCK_SIZE, 0) == 6 * BLOCK_SIZE &&
+            disk.write_file(ta_g, "hi", 2, BLOCK_SIZE + 10) == 2 && disk.fallocate_file(ta_g, 0, 6 * BLOCK_SIZE) == 0 &&
+            disk.unmount() && disk.mount() && disk.read_file(ta_g, ta_back.data(), ta_back.size(), 0) == 6 * BLOCK_SIZE &&
+            ta_back[BLOCK_SIZE + 10] == 'h' && ta_back[BLOCK_SIZE + 11] == 'i' &&
+            std::count(ta_back.begin(), ta_back.begin() + 6 * BLOCK_SIZE, 0) == 6 * BLOCK_SIZE - 2 &&
+            disk.truncate_file(ta_g, 0) == 6 && disk.fsck(fsck_rep) && fsck_rep.errors() == 0 &&
+            fsck_rep.free_blocks == ta_free + 7 && disk.fallocate_file(ta_g, 0, 17 * BLOCK_SIZE) == -1 && disk.unmount();
+#ifndef DISKFS_NO_STATS
+    StatsSnapshot ta_stats = disk.get_stats();  // 截断与预分配也计入操作延迟
+    ta_ok = ta_ok && ta_stats.latency[STAT_OP_TRUNCATE].count >= 3 && ta_stats.latency[STAT_OP_FALLOCATE].count >= 3;
+#endif
+    std::cout << "测试" << test_count << "(截断与预分配): " << (ta_ok ? "通过" : "失败") << std::endl;
+    if (ta_ok) pass_count++;
+
     std::cout << "\n===== 测试总结 =====" << std::endl;
     std::cout << "总测试数: " << test_count << std::endl;
     std::cout << "通过数: " << pass_count << std::endl;
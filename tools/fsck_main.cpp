@@ -0,0 +1,51 @@
+#include "../include/disk_fs.h"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+/**
+ * 一致性检查工具：挂载磁盘镜像并运行fsck
+ * 退出码：0表示一致，1表示发现问题且已修复，4表示发现问题未修复，8表示无法检查
+ */
+
+static void print_usage(const char* prog)
+{
+    std::cerr << "用法: " << prog << " <磁盘文件> [--fix] [--threads <N>]\n"
+              << "  默认只检查不修改；--fix就地修复位图、空闲计数、坏块指针与无效目录项\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 8;
+    }
+    std::string image = argv[1];
+    bool repair = false;
+    uint32_t threads = 0;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--fix") {
+            repair = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else {
+            print_usage(argv[0]);
+            return 8;
+        }
+    }
+
+    DiskFS disk(image);
+    if (!disk.mount()) {
+        std::cerr << "无法挂载磁盘: " << image << "\n";
+        return 8;
+    }
+    FsckReport rep;
+    bool ok = disk.fsck(rep, repair, threads);
+    disk.unmount();
+    if (!ok) return 8;
+
+    print_fsck_report(rep);
+    if (rep.errors() == 0) return 0;
+    return rep.repaired ? 1 : 4;
+}
@@ -0,0 +1,49 @@
+#include "../include/disk_fs.h"
+#include <iostream>
+#include <string>
+
+/**
+ * 镜像打包工具：导出只含元数据与已分配块的紧凑包文件，或由包文件重建稀疏镜像
+ * 退出码：0表示成功，1表示失败，2表示参数错误
+ */
+
+static void print_usage(const char* prog)
+{
+    std::cerr << "用法: " << prog << " export-image <磁盘文件> <包文件> [--compress]\n"
+              << "      " << prog << " import-image <包文件> <磁盘文件>\n"
+              << "  export-image以只读方式挂载镜像，可与其他只读挂载同时进行；import-image覆盖目标镜像\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    std::string cmd = argv[1];
+    PackStats st;
+    if (cmd == "export-image") {
+        bool compress = argc >= 5 && std::string(argv[4]) == "--compress";
+        if (argc > 5 || (argc == 5 && !compress)) {
+            print_usage(argv[0]);
+            return 2;
+        }
+        DiskFS disk(argv[2]);
+        if (!disk.mount(false, true)) {
+            std::cerr << "无法挂载磁盘: " << argv[2] << "\n";
+            return 1;
+        }
+        bool ok = disk.export_image(argv[3], compress, st);
+        disk.unmount();
+        if (!ok) return 1;
+        print_pack_stats("导出镜像", st);
+        return 0;
+    }
+    if (cmd == "import-image" && argc == 4) {
+        if (!import_image(argv[2], argv[3], st)) return 1;
+        print_pack_stats("导入镜像", st);
+        return 0;
+    }
+    print_usage(argv[0]);
+    return 2;
+}
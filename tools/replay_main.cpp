@@ -0,0 +1,236 @@
+#include "../include/disk_fs.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * 追踪回放工具：读取DiskFS生成的二进制追踪文件，在全新格式化的磁盘上重新发起文件操作
+ * - 按时间戳排序后回放公共文件操作（create/open/read/write/delete/list）
+ * - 块读写记录不直接回放（它们由文件操作重新产生），仅用于对比回放前后的块I/O次数
+ * - 默认尽可能快地回放；--timed按记录的时间间隔回放（--speed可加速）
+ */
+
+/**
+ * @brief 读取追踪文件中的全部记录
+ * @return 成功返回true；文件不存在或格式不匹配返回false
+ */
+static bool load_trace(const std::string& path, std::vector<TraceRecord>& records)
+{
+    FILE* in = fopen(path.c_str(), "rb");
+    if (!in) return false;
+
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 ||
+        memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != TRACE_VERSION || header.record_size != sizeof(TraceRecord)) {
+        fclose(in);
+        return false;
+    }
+
+    TraceRecord rec;
+    while (fread(&rec, sizeof(rec), 1, in) == 1) {
+        records.push_back(rec);
+    }
+    fclose(in);
+
+    // 各线程的记录按批次落盘，文件内并非严格有序；文件操作记录的是开始时间，
+    // 稳定排序后其内部产生的块记录会排在它之后
+    std::stable_sort(records.begin(), records.end(), [](const TraceRecord& a, const TraceRecord& b) {
+        return a.timestamp_ns < b.timestamp_ns;
+    });
+    return true;
+}
+
+/**
+ * @brief 回放上下文：追踪中的inode到回放磁盘inode的映射
+ */
+struct ReplayState
+{
+    DiskFS* disk;
+    std::map<uint32_t, int> inode_map;       // 追踪inode -> 回放inode
+    std::vector<char> buffer;                // 读写缓冲区
+    uint64_t ops = 0;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+};
+
+static std::string replay_name(uint32_t traced_inode)
+{
+    char name[MAX_FILENAME];
+    snprintf(name, sizeof(name), "r%u", traced_inode);
+    return name;
+}
+
+/**
+ * @brief 获取追踪inode对应的回放inode；追踪开始前已存在的文件按需创建
+ * @param min_size 文件至少需要的大小（读取追踪开始前写入的数据时预先填充）
+ */
+static int resolve_inode(ReplayState& st, uint32_t traced, size_t min_size)
+{
+    auto it = st.inode_map.find(traced);
+    if (it != st.inode_map.end()) return it->second;
+
+    int inode = st.disk->create_file(replay_name(traced));
+    if (inode == -1) return -1;
+    st.inode_map[traced] = inode;
+    if (min_size > 0) {
+        std::vector<char> fill(min_size, 'p');
+        st.disk->write_file(inode, fill.data(), fill.size(), 0);
+    }
+    return inode;
+}
+
+/**
+ * @brief 回放一条文件操作记录
+ */
+static void replay_one(ReplayState& st, const TraceRecord& rec)
+{
+    bool ok = true;
+    switch (rec.op) {
+    case TRACE_CREATE: {
+        if (rec.inode == TRACE_NO_INODE) return;  // 追踪中创建失败的操作
+        int inode = st.disk->create_file(replay_name(rec.inode));
+        ok = inode != -1;
+        if (ok) st.inode_map[rec.inode] = inode;
+        break;
+    }
+    case TRACE_OPEN:
+        if (rec.inode == TRACE_NO_INODE) return;
+        ok = resolve_inode(st, rec.inode, 0) != -1;
+        break;
+    case TRACE_READ:
+    case TRACE_WRITE: {
+        if (rec.inode == TRACE_NO_INODE) return;
+        size_t end = (size_t)rec.block + rec.length;
+        int inode = resolve_inode(st, rec.inode, rec.op == TRACE_READ ? end : 0);
+        if (st.buffer.size() < rec.length) st.buffer.resize(rec.length, 'w');
+        int ret = -1;
+        if (inode != -1) {
+            ret = rec.op == TRACE_READ
+                ? st.disk->read_file(inode, st.buffer.data(), rec.length, rec.block)
+                : st.disk->write_file(inode, st.buffer.data(), rec.length, rec.block);
+        }
+        ok = ret >= 0;
+        if (ok) st.bytes += ret;
+        break;
+    }
+    case TRACE_DELETE: {
+        if (rec.inode == TRACE_NO_INODE) return;
+        auto it = st.inode_map.find(rec.inode);
+        ok = it != st.inode_map.end() && st.disk->delete_file(replay_name(rec.inode));
+        if (it != st.inode_map.end()) st.inode_map.erase(it);
+        break;
+    }
+    case TRACE_LIST:
+        st.disk->list_files();
+        break;
+    case TRACE_TRUNCATE:
+    case TRACE_FALLOCATE: {
+        if (rec.inode == TRACE_NO_INODE) return;
+        int inode = resolve_inode(st, rec.inode, 0);
+        ok = inode != -1 && (rec.op == TRACE_TRUNCATE ? st.disk->truncate_file(inode, rec.block)
+                                                      : st.disk->fallocate_file(inode, rec.block, rec.length)) >= 0;
+        break;
+    }
+    default:
+        return;  // 块记录不回放
+    }
+    st.ops++;
+    if (!ok) st.errors++;
+}
+
+static void print_usage(const char* prog)
+{
+    std::cerr << "用法: " << prog << " <追踪文件> <磁盘文件> [--timed] [--speed <倍数>]\n"
+              << "  回放前会格式化磁盘文件；默认尽可能快地回放，--timed按记录的时间间隔回放\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    std::string trace_path = argv[1];
+    std::string image = argv[2];
+    bool timed = false;
+    double speed = 1.0;
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--timed") {
+            timed = true;
+        } else if (arg == "--speed" && i + 1 < argc) {
+            speed = atof(argv[++i]);
+            if (speed <= 0) speed = 1.0;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<TraceRecord> records;
+    if (!load_trace(trace_path, records)) {
+        std::cerr << "无法读取追踪文件: " << trace_path << "\n";
+        return 1;
+    }
+
+    uint64_t traced_block_io = 0;
+    for (const auto& rec : records) {
+        if (rec.op == TRACE_BLOCK_READ || rec.op == TRACE_BLOCK_WRITE) traced_block_io++;
+    }
+
+    DiskFS disk(image);
+    if (!disk.format() || !disk.mount()) {
+        std::cerr << "无法格式化或挂载磁盘: " << image << "\n";
+        return 1;
+    }
+
+    ReplayState st;
+    st.disk = &disk;
+
+    // 回放期间屏蔽库内部的提示输出
+    std::streambuf* old_out = std::cout.rdbuf(nullptr);
+    std::streambuf* old_err = std::cerr.rdbuf(nullptr);
+
+    disk.reset_stats();
+    uint64_t first_ts = records.empty() ? 0 : records.front().timestamp_ns;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& rec : records) {
+        if (timed && rec.op != TRACE_BLOCK_READ && rec.op != TRACE_BLOCK_WRITE) {
+            auto due = start + std::chrono::nanoseconds((uint64_t)((rec.timestamp_ns - first_ts) / speed));
+            std::this_thread::sleep_until(due);
+        }
+        replay_one(st, rec);
+    }
+    double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count() / 1e9;
+    StatsSnapshot stats = disk.get_stats();
+    disk.unmount();
+
+    std::cout.rdbuf(old_out);
+    std::cerr.rdbuf(old_err);
+
+    uint64_t replayed_block_io = stats.counters[STAT_BLOCK_READS] + stats.counters[STAT_BLOCK_WRITES];
+    char line[256];
+    std::cout << "回放完成:\n";
+    snprintf(line, sizeof(line), "  追踪记录数: %zu（块I/O %llu）\n", records.size(),
+             (unsigned long long)traced_block_io);
+    std::cout << line;
+    snprintf(line, sizeof(line), "  回放操作数: %llu（失败 %llu）\n",
+             (unsigned long long)st.ops, (unsigned long long)st.errors);
+    std::cout << line;
+    snprintf(line, sizeof(line), "  回放块I/O: %llu\n", (unsigned long long)replayed_block_io);
+    std::cout << line;
+    snprintf(line, sizeof(line), "  耗时: %.6f 秒，%.1f ops/s，%.2f MB/s\n", seconds,
+             seconds > 0 ? st.ops / seconds : 0.0,
+             seconds > 0 ? st.bytes / seconds / (1024 * 1024) : 0.0);
+    std::cout << line;
+    return 0;
+}